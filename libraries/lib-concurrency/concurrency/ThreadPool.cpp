@@ -0,0 +1,179 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ * SPDX-FileName: ThreadPool.cpp
+ */
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+
+namespace audacity::concurrency
+{
+ThreadPool::ThreadPool(size_t threadCount)
+{
+   if (threadCount == 0)
+      threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+   mThreads.reserve(threadCount);
+
+   for (size_t i = 0; i < threadCount; ++i)
+      mThreads.emplace_back([this] { Run(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+   {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStopping = true;
+   }
+
+   mCondition.notify_all();
+
+   for (auto& thread : mThreads)
+      thread.join();
+}
+
+ThreadPool& ThreadPool::Get()
+{
+   static ThreadPool pool;
+   return pool;
+}
+
+size_t ThreadPool::GetThreadCount() const noexcept
+{
+   return mThreads.size();
+}
+
+void ThreadPool::Enqueue(std::function<void()> task)
+{
+   {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mTasks.push_back(std::move(task));
+   }
+
+   mCondition.notify_one();
+}
+
+void ThreadPool::Run()
+{
+   while (true)
+   {
+      std::function<void()> task;
+
+      {
+         std::unique_lock<std::mutex> lock(mMutex);
+         mCondition.wait(
+            lock, [this] { return mStopping || !mTasks.empty(); });
+
+         if (mTasks.empty())
+            return;
+
+         task = std::move(mTasks.front());
+         mTasks.pop_front();
+      }
+
+      task();
+   }
+}
+
+void ParallelFor(
+   ThreadPool& pool, size_t count, const std::function<void(size_t)>& function)
+{
+   std::vector<std::future<void>> results;
+   results.reserve(count);
+
+   for (size_t i = 0; i < count; ++i)
+      results.push_back(pool.Async([&function, i] { function(i); }));
+
+   std::exception_ptr exception;
+
+   for (auto& result : results)
+   {
+      try
+      {
+         result.get();
+      }
+      catch (...)
+      {
+         if (!exception)
+            exception = std::current_exception();
+      }
+   }
+
+   if (exception)
+      std::rethrow_exception(exception);
+}
+
+bool ParallelFor(
+   ThreadPool& pool, size_t count, size_t waveSize,
+   const std::function<bool(size_t, const std::atomic<bool>&)>& function,
+   const std::function<bool()>& poll,
+   const std::function<bool(size_t, size_t)>& finishWave)
+{
+   using namespace std::chrono_literals;
+
+   std::atomic<bool> cancelled { false };
+   waveSize = std::max<size_t>(1, waveSize);
+
+   for (size_t first = 0; first < count; first += waveSize)
+   {
+      const auto last = std::min(count, first + waveSize);
+
+      std::vector<std::future<bool>> results;
+      results.reserve(last - first);
+
+      for (auto i = first; i < last; ++i)
+         results.push_back(pool.Async(
+            [&function, &cancelled, i]
+            {
+               return !cancelled.load(std::memory_order_relaxed) &&
+                      function(i, cancelled);
+            }));
+
+      // Wait for all of the wave, before any exception can propagate
+      bool success = true;
+      std::exception_ptr exception;
+
+      for (auto& result : results)
+      {
+         while (result.wait_for(100ms) != std::future_status::ready)
+         {
+            if (success && !poll())
+            {
+               success   = false;
+               cancelled = true;
+            }
+         }
+
+         try
+         {
+            if (!result.get())
+            {
+               success   = false;
+               cancelled = true;
+            }
+         }
+         catch (...)
+         {
+            if (!exception)
+               exception = std::current_exception();
+            success   = false;
+            cancelled = true;
+         }
+      }
+
+      if (exception)
+         std::rethrow_exception(exception);
+
+      if (!success || !poll())
+         return false;
+
+      if (finishWave && !finishWave(first, last))
+         return false;
+   }
+
+   return true;
+}
+} // namespace audacity::concurrency
@@ -0,0 +1,103 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ * SPDX-FileName: ThreadPool.h
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace audacity::concurrency
+{
+//! A fixed set of worker threads taking tasks from one queue
+/*!
+ Tasks run in no particular order.  A task must not block waiting for
+ another task of the same pool, which could deadlock when all workers are
+ busy; wait for results in the thread that enqueued the tasks.
+ */
+class CONCURRENCY_API ThreadPool final
+{
+public:
+   //! @param threadCount if zero, one thread for each hardware thread
+   explicit ThreadPool(size_t threadCount = 0);
+
+   ThreadPool(const ThreadPool&)            = delete;
+   ThreadPool& operator=(const ThreadPool&) = delete;
+
+   //! Finishes tasks already queued, then joins the threads
+   ~ThreadPool();
+
+   //! The pool shared by all of the application, one thread for each
+   //! hardware thread
+   static ThreadPool& Get();
+
+   size_t GetThreadCount() const noexcept;
+
+   void Enqueue(std::function<void()> task);
+
+   //! Enqueue a task, with a future for its result or exception
+   template<typename Function>
+   auto Async(Function&& function)
+      -> std::future<std::invoke_result_t<std::decay_t<Function>>>
+   {
+      using Result = std::invoke_result_t<std::decay_t<Function>>;
+      // std::function requires copyable callables, hence the shared_ptr
+      auto task = std::make_shared<std::packaged_task<Result()>>(
+         std::forward<Function>(function));
+      auto result = task->get_future();
+      Enqueue([task] { (*task)(); });
+      return result;
+   }
+
+private:
+   void Run();
+
+   std::mutex mMutex;
+   std::condition_variable mCondition;
+   std::deque<std::function<void()>> mTasks;
+   bool mStopping { false };
+
+   std::vector<std::thread> mThreads;
+}; // class ThreadPool
+
+//! Call function(ii) for ii in [0, count) on the pool, and wait for all
+/*!
+ The first exception thrown by any call is rethrown, after all calls end.
+ */
+CONCURRENCY_API void ParallelFor(
+   ThreadPool& pool, size_t count, const std::function<void(size_t)>& function);
+
+//! Call function(ii, cancelled) for ii in [0, count) on the pool, in waves
+//! of at most waveSize calls, polling for progress and cancellation
+/*!
+ Waves bound the memory that the calls' results take before the caller
+ consumes them.  Calls that have not started when the loop is cancelled or
+ fails are skipped; calls already running should return soon after
+ `cancelled` becomes true.  The first exception thrown by any call is
+ rethrown, after all calls of its wave end.
+
+ @param function called on worker threads; returns false to fail the loop
+ @param poll called on this thread about ten times a second while a wave
+ runs, and after each wave; returns false to cancel the loop
+ @param finishWave if not empty, called on this thread with the range of
+ indices [first, last) of each wave that succeeded; returns false to fail the
+ loop
+ @return whether every call, poll and finishWave succeeded
+ */
+CONCURRENCY_API bool ParallelFor(
+   ThreadPool& pool, size_t count, size_t waveSize,
+   const std::function<bool(size_t, const std::atomic<bool>& cancelled)>&
+      function,
+   const std::function<bool()>& poll,
+   const std::function<bool(size_t first, size_t last)>& finishWave = {});
+} // namespace audacity::concurrency
@@ -0,0 +1,161 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ * SPDX-FileName: ThreadPoolTests.cpp
+ */
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "concurrency/ThreadPool.h"
+
+using namespace audacity::concurrency;
+
+TEST_CASE("ThreadPool", "")
+{
+   ThreadPool pool { 3 };
+   REQUIRE(pool.GetThreadCount() == 3);
+
+   SECTION("Async returns results")
+   {
+      auto result = pool.Async([] { return 42; });
+      REQUIRE(result.get() == 42);
+   }
+
+   SECTION("Async propagates exceptions")
+   {
+      auto result = pool.Async([]() -> int { throw std::runtime_error("x"); });
+      REQUIRE_THROWS_AS(result.get(), std::runtime_error);
+   }
+
+   SECTION("ParallelFor visits every index once")
+   {
+      std::vector<std::atomic<int>> visits(1000);
+      ParallelFor(pool, visits.size(), [&](size_t i) { ++visits[i]; });
+      for (auto& count : visits)
+         REQUIRE(count == 1);
+   }
+
+   SECTION("ParallelFor rethrows after all calls end")
+   {
+      std::atomic<int> calls { 0 };
+      REQUIRE_THROWS_AS(
+         ParallelFor(
+            pool, 10,
+            [&](size_t i)
+            {
+               ++calls;
+               if (i == 3)
+                  throw std::runtime_error("x");
+            }),
+         std::runtime_error);
+      REQUIRE(calls == 10);
+   }
+
+   SECTION("ParallelFor in waves finishes each wave in order")
+   {
+      std::vector<std::atomic<int>> visits(100);
+      std::vector<std::pair<size_t, size_t>> waves;
+      const auto result = ParallelFor(
+         pool, visits.size(), 7,
+         [&](size_t i, const std::atomic<bool>&)
+         {
+            ++visits[i];
+            return true;
+         },
+         [] { return true; },
+         [&](size_t first, size_t last)
+         {
+            // All calls of the wave are done, and none of the next
+            for (auto i = first; i < last; ++i)
+               REQUIRE(visits[i] == 1);
+            if (last < visits.size())
+               REQUIRE(visits[last] == 0);
+            waves.emplace_back(first, last);
+            return true;
+         });
+      REQUIRE(result);
+      REQUIRE(waves.size() == 15);
+      for (size_t i = 0; i < waves.size(); ++i)
+      {
+         REQUIRE(waves[i].first == 7 * i);
+         REQUIRE(waves[i].second == std::min<size_t>(100, 7 * i + 7));
+      }
+   }
+
+   SECTION("ParallelFor stops when polling cancels")
+   {
+      std::atomic<int> calls { 0 };
+      std::atomic<int> interrupted { 0 };
+      int polls = 0;
+      const auto result = ParallelFor(
+         pool, 100, 3,
+         [&](size_t, const std::atomic<bool>& cancelled)
+         {
+            ++calls;
+            while (!cancelled)
+               std::this_thread::yield();
+            ++interrupted;
+            return true;
+         },
+         [&] { return ++polls < 3; });
+      REQUIRE(!result);
+      REQUIRE(polls == 3);
+      // Only the first wave started, and all its calls saw the cancellation
+      REQUIRE(calls <= 3);
+      REQUIRE(interrupted == calls);
+   }
+
+   SECTION("ParallelFor fails when a call or a wave fails")
+   {
+      std::atomic<int> calls { 0 };
+      REQUIRE(!ParallelFor(
+         pool, 100, 10,
+         [&](size_t i, const std::atomic<bool>&)
+         {
+            ++calls;
+            return i != 5;
+         },
+         [] { return true; }));
+      REQUIRE(calls <= 10);
+
+      int waves = 0;
+      REQUIRE(!ParallelFor(
+         pool, 100, 10, [](size_t, const std::atomic<bool>&) { return true; },
+         [] { return true; },
+         [&](size_t, size_t) { return ++waves < 2; }));
+      REQUIRE(waves == 2);
+   }
+
+   SECTION("ParallelFor in waves rethrows after the wave ends")
+   {
+      std::atomic<int> calls { 0 };
+      REQUIRE_THROWS_AS(
+         ParallelFor(
+            pool, 100, 10,
+            [&](size_t i, const std::atomic<bool>&) -> bool
+            {
+               ++calls;
+               if (i == 3)
+                  throw std::runtime_error("x");
+               return true;
+            },
+            [] { return true; }),
+         std::runtime_error);
+      REQUIRE(calls <= 10);
+   }
+}
+
+TEST_CASE("ThreadPool destructor finishes queued tasks", "")
+{
+   std::atomic<int> count { 0 };
+   {
+      ThreadPool pool { 2 };
+      for (int i = 0; i < 100; ++i)
+         pool.Enqueue([&] { ++count; });
+   }
+   REQUIRE(count == 100);
+}
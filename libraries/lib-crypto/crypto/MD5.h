@@ -0,0 +1,64 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ * SPDX-FileName: MD5.h
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+#include <string>
+
+namespace crypto
+{
+//! MD5 message digest (RFC 1321), as used for checksums of file formats;
+//! not for security
+class CRYPTO_API MD5 final
+{
+public:
+   static constexpr std::size_t HASH_SIZE = 16;
+   static constexpr std::size_t BLOCK_SIZE = 64;
+
+   using Digest = std::array<uint8_t, HASH_SIZE>;
+
+   MD5();
+
+   MD5(const MD5&) = delete;
+   MD5(MD5&&) = delete;
+   MD5& operator=(const MD5&) = delete;
+   MD5& operator=(MD5&&) = delete;
+
+   void Update(const void* data, std::size_t size);
+   void Update(const char* zString);
+
+   template<typename T>
+   void Update(const T& data)
+   {
+      Update(data.data(), data.size());
+   }
+
+   //! Bytes of the digest, then reset
+   Digest FinalizeDigest();
+
+   //! Digest as an upper case hex string, then reset
+   std::string Finalize();
+
+   void Reset();
+
+private:
+   uint64_t mBitLength;
+   uint32_t mState[4];
+   uint8_t mBuffer[BLOCK_SIZE];
+   uint32_t mBufferLength;
+}; // class MD5
+
+template<typename T>
+std::string md5(const T& data)
+{
+   MD5 hasher;
+   hasher.Update(data);
+   return hasher.Finalize();
+}
+} // namespace crypto
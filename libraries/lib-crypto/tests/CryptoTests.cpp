@@ -6,6 +6,7 @@
 
 #include <catch2/catch.hpp>
 
+#include "crypto/MD5.h"
 #include "crypto/SHA256.h"
 
 TEST_CASE("SHA256", "")
@@ -35,3 +36,30 @@ TEST_CASE("SHA256", "")
          " is a free, open source, cross-platform audio software for multi-track recording and editing.") ==
          "00E7C81A5357B1734035CE4CAE5DC0B3F886D22C8AF2E3952E2F5569A994B8A8");
 }
+
+TEST_CASE("MD5", "")
+{
+   crypto::MD5 md5;
+
+   REQUIRE(md5.Finalize() == "D41D8CD98F00B204E9800998ECF8427E");
+
+   md5.Update("a");
+
+   REQUIRE(md5.Finalize() == "0CC175B9C0F1B6A831C399E269772661");
+
+   md5.Update("bc", 2);
+
+   REQUIRE(md5.Finalize() == "5360AF35BDE9EBD8F01F492DC059593C");
+
+   REQUIRE(
+      crypto::md5(std::string("message digest")) ==
+      "F96B697D7CB7938D525A2F31AAF161D0");
+
+   // Longer than one block, given in pieces
+   md5.Update("1234567890123456789012345678901234567890");
+   md5.Update("1234567890123456789012345678901234567890");
+
+   const auto digest = md5.FinalizeDigest();
+   REQUIRE(digest[0] == 0x57);
+   REQUIRE(digest[15] == 0x7A);
+}
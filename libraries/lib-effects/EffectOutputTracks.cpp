@@ -9,11 +9,16 @@
 **********************************************************************/
 #include "EffectOutputTracks.h"
 #include "BasicUI.h"
+#include "Envelope.h"
+#include "Sequence.h"
 #include "SyncLock.h"
 #include "UserException.h"
+#include "WaveClip.h"
 #include "WaveTrack.h"
 #include "TimeStretching.h"
 
+#include <algorithm>
+
 // Effect application counter
 int EffectOutputTracks::nEffectsDone = 0;
 
@@ -98,6 +103,93 @@ const Track* EffectOutputTracks::GetMatchingInput(const Track& outTrack) const
    return mIMap[index];
 }
 
+namespace {
+//! Whether the sequences see the same sample blocks, from the same samples
+bool SameBlocks(const Sequence &input, const Sequence &output)
+{
+   const auto &inputBlocks = input.GetBlockArray();
+   const auto &outputBlocks = output.GetBlockArray();
+   return input.GetSampleFormats() == output.GetSampleFormats() &&
+      std::equal(inputBlocks.begin(), inputBlocks.end(),
+         outputBlocks.begin(), outputBlocks.end(),
+         [](const SeqBlock &a, const SeqBlock &b){
+            return a.sb == b.sb && a.start == b.start &&
+               a.reversed == b.reversed;
+         });
+}
+
+bool SameEnvelope(const Envelope &input, const Envelope &output)
+{
+   const auto nPoints = input.GetNumberOfPoints();
+   if (output.GetNumberOfPoints() != nPoints)
+      return false;
+   for (size_t ii = 0; ii < nPoints; ++ii) {
+      const auto &a = input[ii], &b = output[ii];
+      if (a.GetT() != b.GetT() || a.GetVal() != b.GetVal())
+         return false;
+   }
+   return true;
+}
+
+bool SameClip(const WaveClip &input, const WaveClip &output)
+{
+   const auto nChannels = input.NChannels();
+   if (!(output.NChannels() == nChannels &&
+      output.GetRate() == input.GetRate() &&
+      output.GetSequenceStartTime() == input.GetSequenceStartTime() &&
+      output.GetTrimLeft() == input.GetTrimLeft() &&
+      output.GetTrimRight() == input.GetTrimRight() &&
+      output.GetStretchRatio() == input.GetStretchRatio() &&
+      output.GetCentShift() == input.GetCentShift() &&
+      output.GetPitchAndSpeedPreset() == input.GetPitchAndSpeedPreset() &&
+      output.GetIsPlaceholder() == input.GetIsPlaceholder() &&
+      output.GetName() == input.GetName() &&
+      SameEnvelope(input.GetEnvelope(), output.GetEnvelope())))
+      return false;
+   for (size_t ii = 0; ii < nChannels; ++ii)
+      if (input.GetAppendBufferLen(ii) > 0 ||
+          output.GetAppendBufferLen(ii) > 0 ||
+          !SameBlocks(*input.GetSequence(ii), *output.GetSequence(ii)))
+         return false;
+   const auto &inputCutLines = input.GetCutLines();
+   const auto &outputCutLines = output.GetCutLines();
+   return std::equal(inputCutLines.begin(), inputCutLines.end(),
+      outputCutLines.begin(), outputCutLines.end(),
+      [](const auto &pInput, const auto &pOutput){
+         return SameClip(*pInput, *pOutput);
+      });
+}
+
+//! Whether the tracks play alike, because the clips of the output see the
+//! same sample blocks as those of the input, with the same attributes
+/*!
+ Copies share sample blocks with the originals, and processing replaces only
+ the blocks it writes, so this detects a copy that the effect did not change
+ at all, without visiting the samples.  Tracks of other types are never the
+ same, but they are cheap to replace.
+ */
+bool SameContents(const Track &input, const Track &output)
+{
+   const auto pInput = dynamic_cast<const WaveTrack*>(&input);
+   const auto pOutput = dynamic_cast<const WaveTrack*>(&output);
+   if (!(pInput && pOutput))
+      return false;
+   const auto nClips = pInput->NIntervals();
+   if (!(pOutput->NIntervals() == nClips &&
+      pOutput->NChannels() == pInput->NChannels() &&
+      pOutput->GetRate() == pInput->GetRate() &&
+      pOutput->GetSampleFormat() == pInput->GetSampleFormat() &&
+      pOutput->GetGain() == pInput->GetGain() &&
+      pOutput->GetPan() == pInput->GetPan() &&
+      pOutput->GetName() == pInput->GetName()))
+      return false;
+   for (size_t ii = 0; ii < nClips; ++ii)
+      if (!SameClip(*pInput->GetClip(ii), *pOutput->GetClip(ii)))
+         return false;
+   return true;
+}
+}
+
 // Replace tracks with successfully processed mOutputTracks copies.
 // Else clear and delete mOutputTracks copies.
 void EffectOutputTracks::Commit()
@@ -134,12 +226,14 @@ void EffectOutputTracks::Commit()
          // This track was an addition to output tracks; add it to mTracks
          mTracks.AppendOne(std::move(*mOutputTracks));
       else if (
-         mEffectType != EffectTypeNone && mEffectType != EffectTypeAnalyze)
+         mEffectType != EffectTypeNone && mEffectType != EffectTypeAnalyze &&
+         !SameContents(*mIMap[i], *pOutputTrack))
          // Replace mTracks entry with the new track
          mTracks.ReplaceOne(*mIMap[i], std::move(*mOutputTracks));
       else
-         // This output track was just a placeholder for pre-processing. Discard
-         // it.
+         // This output track was just a placeholder for pre-processing, or
+         // the effect left it unchanged, as often for sync-locked tracks.
+         // Discard it, so the input keeps its clips and their caches.
          mOutputTracks->Remove(*pOutputTrack);
       ++i;
    }
@@ -69,6 +69,9 @@ public:
 
    //! Replace input tracks with temporaries only on commit
    /*
+    Temporary wave tracks that still see the same sample blocks as their
+    inputs, with the same clips and attributes, are discarded instead, so
+    that the inputs are kept.
     @pre `Commit()` was not previously called
     */
    void Commit();
@@ -30,6 +30,15 @@
 #include "WaveTrack.h"
 #include "WaveTrackSink.h"
 #include "WideSampleSource.h"
+#include "concurrency/ThreadPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <iterator>
+#include <mutex>
 
 PerTrackEffect::Instance::~Instance() = default;
 
@@ -61,6 +70,11 @@ bool PerTrackEffect::DoPass2() const
    return false;
 }
 
+bool PerTrackEffect::ProcessesTracksConcurrently() const
+{
+   return false;
+}
+
 bool PerTrackEffect::Process(
    EffectInstance &instance, EffectSettings &settings) const
 {
@@ -110,6 +124,15 @@ bool PerTrackEffect::ProcessPass(TrackList &outputs,
    if (numAudioOut < 1)
       return false;
 
+   if (isProcessor && ProcessesTracksConcurrently()) {
+      const auto tracks = outputs.Selected<const WaveTrack>();
+      const size_t nJobs = (numAudioIn > 1)
+         ? tracks.size()
+         : tracks.sum(&WaveTrack::NChannels);
+      if (nJobs > 1)
+         return ProcessConcurrently(outputs, instance, settings);
+   }
+
    // Instances that can be reused in each loop pass
    std::vector<std::shared_ptr<EffectInstance>> recycledInstances{
       // First one is the given one; any others pushed onto here are
@@ -355,6 +378,343 @@ bool PerTrackEffect::ProcessPass(TrackList &outputs,
    return bGoodResult;
 }
 
+namespace {
+//! Samples processed on a worker thread, to be written on the main thread
+struct OutputBlock {
+   std::vector<float> samples[2];
+   size_t length{};
+};
+
+//! Synchronization shared by the main thread and the workers of
+//! PerTrackEffect::ProcessConcurrently()
+struct Exchange {
+   void Cancel()
+   {
+      {
+         std::lock_guard<std::mutex> lock{ mutex };
+         cancelled = true;
+      }
+      condition.notify_all();
+   }
+
+   std::mutex mutex;
+   std::condition_variable condition;
+   std::atomic<bool> cancelled{ false };
+};
+
+//! Sink for a worker thread, queueing blocks for the main thread which
+//! writes them to the track, because sample blocks are created there only
+/*! The worker waits while too many blocks are pending */
+class QueueSink final : public AudioGraph::Sink {
+public:
+   //! Limits the memory used when workers outpace the main thread
+   static constexpr size_t MaxPending = 4;
+
+   QueueSink(Exchange &exchange, size_t nChannels)
+      : mExchange{ exchange }, mnChannels{ nChannels }
+   {}
+
+   bool AcceptsBuffers(const Buffers &buffers) const override
+   {
+      return buffers.Channels() >= mnChannels;
+   }
+
+   bool Acquire(Buffers &data) override
+   {
+      if (data.BlockSize() > data.Remaining())
+         DoConsume(data);
+      return !mExchange.cancelled;
+   }
+
+   bool Release(const Buffers &, size_t) override
+   {
+      return true;
+   }
+
+   //! Worker thread: queue the last samples
+   void Flush(Buffers &data)
+   {
+      DoConsume(data);
+   }
+
+   //! Worker thread: no more blocks will come
+   void Finish()
+   {
+      {
+         std::lock_guard<std::mutex> lock{ mExchange.mutex };
+         mFinished = true;
+      }
+      mExchange.condition.notify_all();
+   }
+
+   //! Main thread, with the mutex of the exchange locked
+   bool HasBlocks() const { return !mBlocks.empty(); }
+   //! Main thread, with the mutex of the exchange locked
+   bool IsFinished() const { return mFinished; }
+   //! Main thread, with the mutex of the exchange locked
+   void TakeBlocks(std::deque<OutputBlock> &blocks)
+   {
+      std::move(mBlocks.begin(), mBlocks.end(), std::back_inserter(blocks));
+      mBlocks.clear();
+   }
+
+private:
+   void DoConsume(Buffers &data)
+   {
+      const auto length = data.Position();
+      if (length == 0)
+         return;
+      OutputBlock block;
+      block.length = length;
+      for (size_t iChannel = 0; iChannel < mnChannels; ++iChannel) {
+         const auto begin = data.GetReadPosition(iChannel);
+         block.samples[iChannel].assign(begin, begin + length);
+      }
+      data.Rewind();
+
+      std::unique_lock<std::mutex> lock{ mExchange.mutex };
+      mExchange.condition.wait(lock, [this]{
+         return mExchange.cancelled || mBlocks.size() < MaxPending; });
+      if (mExchange.cancelled)
+         return;
+      mBlocks.push_back(std::move(block));
+      lock.unlock();
+      mExchange.condition.notify_all();
+   }
+
+   Exchange &mExchange;
+   const size_t mnChannels;
+   std::deque<OutputBlock> mBlocks;
+   bool mFinished{ false };
+};
+
+//! One track, or channel, processed on the thread pool
+struct Job {
+   //! Read by the worker, while the main thread writes the original
+   std::shared_ptr<const WaveTrack> pCopy;
+   WaveChannel *pLeft{};
+   WaveChannel *pRight{};
+   int channel{};
+   sampleCount start, len, outPos;
+   double sampleRate{};
+
+   EffectSettings settings;
+   AudioGraph::Buffers inBuffers, outBuffers;
+   std::optional<WideSampleSource> source;
+   std::unique_ptr<EffectStage> pStage;
+   std::optional<QueueSink> sink;
+   std::future<bool> result;
+};
+}
+
+bool PerTrackEffect::ProcessConcurrently(TrackList &outputs,
+   Instance &instance, EffectSettings &settings)
+{
+   using namespace audacity::concurrency;
+   const auto duration = settings.extra.GetDuration();
+   const auto numAudioIn = instance.GetAudioInCount();
+   const auto numAudioOut = instance.GetAudioOutCount();
+   const bool multichannel = numAudioIn > 1;
+   const auto effectiveFormat =
+      instance.NeedsDither() ? widestSampleFormat : narrowestSampleFormat;
+
+   // Describe the jobs, and adjust other tracks, as ProcessPass() would
+   std::vector<std::unique_ptr<Job>> jobs;
+   sampleCount total = 0;
+   for (const auto pTrack : outputs) {
+      const auto pWaveTrack = dynamic_cast<WaveTrack*>(pTrack);
+      if (!(pWaveTrack && pWaveTrack->GetSelected())) {
+         if (SyncLock::IsSyncLockSelected(*pTrack))
+            pTrack->SyncLockAdjust(mT1, mT0 + duration);
+         continue;
+      }
+      auto &wt = *pWaveTrack;
+      sampleCount start, len;
+      GetBounds(wt, &start, &len);
+      if (len > 0 && numAudioIn < 1)
+         return false;
+      const auto pCopy =
+         std::static_pointer_cast<const WaveTrack>(wt.Duplicate());
+      const auto addJob = [&](int channel, WaveChannel &left,
+         WaveChannel *pRight
+      ){
+         auto &job = *jobs.emplace_back(std::make_unique<Job>());
+         job.pCopy = pCopy;
+         job.pLeft = &left;
+         job.pRight = pRight;
+         job.channel = channel;
+         job.start = job.outPos = start;
+         job.len = len;
+         job.sampleRate = wt.GetRate();
+         total += len;
+      };
+      if (multichannel)
+         addJob(-1, **wt.Channels().begin(), wt.NChannels() == 2
+            ? (*wt.Channels().rbegin()).get() : nullptr);
+      else {
+         int iChannel = 0;
+         for (const auto pChannel : wt.Channels())
+            addJob(iChannel++, *pChannel, nullptr);
+      }
+   }
+
+   // Each instance is made and initialized on this thread; the given one
+   // can serve one job of each wave
+   auto pGiven =
+      std::dynamic_pointer_cast<EffectInstanceEx>(instance.shared_from_this());
+   bool givenUsed = false;
+
+   Exchange exchange;
+   sampleCount done = 0;
+   const auto pollUser = [&exchange](sampleCount){
+      return !exchange.cancelled;
+   };
+
+   // Don't leave workers using this stack frame, if anything throws
+   auto cleanup = finally([&]{
+      exchange.Cancel();
+      for (auto &pJob : jobs)
+         if (pJob->result.valid())
+            pJob->result.wait();
+   });
+
+   // Set up one job for the pool
+   const auto startJob = [&](Job &job) {
+      const auto &copy = *job.pCopy;
+      auto max = copy.GetMaxBlockSize() * 2;
+      const auto blockSize = instance.SetBlockSize(max);
+      if (blockSize == 0)
+         return false;
+      const auto bufferSize =
+         ((max + (blockSize - 1)) / blockSize) * blockSize;
+      job.inBuffers.Reinit(std::max(1u, numAudioIn), blockSize,
+         std::max<size_t>(1, bufferSize / blockSize));
+      job.outBuffers.Reinit(numAudioOut, blockSize,
+         (bufferSize / blockSize) + 1);
+
+      const WideSampleSequence *pSeq = &copy;
+      if (!job.pRight)
+         pSeq = copy.GetChannel(std::max(0, job.channel)).get();
+      const size_t nChannels = job.pRight ? 2 : 1;
+      job.source.emplace(*pSeq, nChannels, job.start, job.len, pollUser);
+      job.sink.emplace(exchange, nChannels);
+
+      // Instances of different jobs get different copies of the settings
+      job.settings = settings;
+      const auto factory = [&]() -> std::shared_ptr<EffectInstance> {
+         if (!givenUsed) {
+            givenUsed = true;
+            return pGiven;
+         }
+         auto result = MakeInstance();
+         if (result)
+            result->SetBlockSize(max);
+         return result;
+      };
+      job.pStage = EffectStage::Create(job.channel, *job.source,
+         job.inBuffers, factory, job.settings, job.sampleRate, {}, copy);
+      if (!job.pStage)
+         return false;
+      assert(job.pStage->AcceptsBuffers(job.outBuffers));
+      assert(job.sink->AcceptsBuffers(job.outBuffers));
+
+      job.result = ThreadPool::Get().Async([&job, &exchange]{
+         auto cleanup = finally([&]{ job.sink->Finish(); });
+         AudioGraph::Task task{ *job.pStage, job.outBuffers, *job.sink };
+         if (!task.RunLoop())
+            return false;
+         job.sink->Flush(job.outBuffers);
+         return !exchange.cancelled;
+      });
+      return true;
+   };
+
+   // Write what the workers produced, in order for each job
+   const auto writeBlocks = [&](Job &job, std::deque<OutputBlock> &blocks) {
+      for (auto &block : blocks) {
+         if (!job.pLeft->Set(
+               reinterpret_cast<constSamplePtr>(block.samples[0].data()),
+               floatSample, job.outPos, block.length, effectiveFormat))
+            return false;
+         if (job.pRight && !job.pRight->Set(
+               reinterpret_cast<constSamplePtr>(block.samples[1].data()),
+               floatSample, job.outPos, block.length, effectiveFormat))
+            return false;
+         job.outPos += block.length;
+         done += block.length;
+      }
+      blocks.clear();
+      return true;
+   };
+
+   // Jobs run in waves, to bound the number of instances and buffers
+   bool bGoodResult = true;
+   const auto waveSize = ThreadPool::Get().GetThreadCount();
+   for (size_t first = 0; bGoodResult && first < jobs.size();
+      first += waveSize
+   ) {
+      const auto last = std::min(jobs.size(), first + waveSize);
+      size_t started = first;
+      givenUsed = false;
+      for (; started < last; ++started) {
+         if (!startJob(*jobs[started])) {
+            bGoodResult = false;
+            exchange.Cancel();
+            break;
+         }
+      }
+
+      std::vector<std::deque<OutputBlock>> pending(started - first);
+      size_t finished = 0;
+      const auto countFinished = [&]{
+         size_t result = 0;
+         for (auto ii = first; ii < started; ++ii)
+            result += jobs[ii]->sink->IsFinished();
+         return result;
+      };
+      while (finished < started - first) {
+         {
+            std::unique_lock<std::mutex> lock{ exchange.mutex };
+            exchange.condition.wait_for(lock, std::chrono::milliseconds(100),
+               [&]{
+                  for (auto ii = first; ii < started; ++ii)
+                     if (jobs[ii]->sink->HasBlocks())
+                        return true;
+                  return countFinished() > finished;
+               });
+            // Take the blocks before counting, so none are left behind
+            for (auto ii = first; ii < started; ++ii)
+               jobs[ii]->sink->TakeBlocks(pending[ii - first]);
+            finished = countFinished();
+         }
+         // Make room for the workers
+         exchange.condition.notify_all();
+
+         for (auto ii = first; ii < started; ++ii)
+            if (!exchange.cancelled &&
+                !writeBlocks(*jobs[ii], pending[ii - first])) {
+               bGoodResult = false;
+               exchange.Cancel();
+            }
+         if (!exchange.cancelled && total > 0 &&
+             TotalProgress(done.as_double() / total.as_double())) {
+            bGoodResult = false;
+            exchange.Cancel();
+         }
+      }
+
+      // Every worker of the wave is finished; rethrow any exception now
+      for (auto ii = first; ii < started; ++ii) {
+         auto &job = *jobs[ii];
+         if (!job.result.get())
+            bGoodResult = false;
+         // Finalize the instances on this thread
+         job.pStage.reset();
+      }
+   }
+   return bGoodResult;
+}
+
 bool PerTrackEffect::ProcessTrack(int channel, const Factory &factory,
    EffectSettings &settings,
    AudioGraph::Source &upstream, AudioGraph::Sink &sink,
@@ -66,6 +66,18 @@ protected:
    // non-virtual
    bool Process(EffectInstance &instance, EffectSettings &settings) const;
 
+   //! Whether a processing pass may process several tracks at once
+   /*!
+    If true, each track (or each channel, if the instance takes one input)
+    gets its own instance, made by MakeInstance(), and its own copy of the
+    settings.  Instances are initialized and finalized on the main thread,
+    but ProcessBlock() is called on worker threads, so it must not use the
+    user interface or mutable state shared with other instances.  mSampleCnt
+    is not updated for each track.
+    Default implementation returns false.
+    */
+   virtual bool ProcessesTracksConcurrently() const;
+
    sampleCount    mSampleCnt{};
 
    // Pre-compute the output track list
@@ -79,6 +91,9 @@ private:
 
    bool ProcessPass(TrackList &outputs,
       Instance &instance, EffectSettings &settings);
+   //! ProcessPass() for processors that allow it, using the thread pool
+   bool ProcessConcurrently(TrackList &outputs,
+      Instance &instance, EffectSettings &settings);
    using Factory = std::function<std::shared_ptr<EffectInstance>()>;
    /*!
     Previous contents of inBuffers and outBuffers are ignored
@@ -0,0 +1,136 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  EffectOutputTracksTests.cpp
+
+**********************************************************************/
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <set>
+
+#include "EffectOutputTracks.h"
+#include "Envelope.h"
+#include "MockSampleBlockFactory.h"
+#include "Sequence.h"
+#include "TestTracks.h"
+#include "WaveClip.h"
+
+using namespace TestTracks;
+
+namespace
+{
+//! The sample blocks of all channels of all clips of a track
+std::vector<const SampleBlock*> Blocks(const WaveTrack& track)
+{
+   std::vector<const SampleBlock*> result;
+   for (size_t iClip = 0; iClip < track.NIntervals(); ++iClip)
+   {
+      const auto pClip = track.GetClip(iClip);
+      for (size_t iChannel = 0; iChannel < pClip->NChannels(); ++iChannel)
+         for (const auto& block : pClip->GetSequence(iChannel)->GetBlockArray())
+            result.push_back(block.sb.get());
+   }
+   return result;
+}
+} // namespace
+
+TEST_CASE("EffectOutputTracks keeps what an effect left unchanged")
+{
+   const auto factory = std::make_shared<MockSampleBlockFactory>();
+
+   // A long track of many blocks, and a short one
+   const auto tracks = TrackList::Create(nullptr);
+   const auto pLong =
+      MakeTrack(factory, 2, static_cast<size_t>(60 * SampleRate), 1);
+   const auto pShort =
+      MakeTrack(factory, 1, static_cast<size_t>(SampleRate), 2);
+   tracks->Add(pLong);
+   tracks->Add(pShort);
+   const auto longBlocks = Blocks(*pLong);
+   REQUIRE(longBlocks.size() > 10);
+
+   EffectOutputTracks outputs { *tracks, EffectTypeProcess,
+                                EffectOutputTracks::TimeInterval { 1.0, 1.5 },
+                                true };
+   auto& longOutput = **outputs.Get().Any<WaveTrack>().begin();
+   REQUIRE(&longOutput != pLong.get());
+   // The copy sees the same blocks
+   REQUIRE(Blocks(longOutput) == longBlocks);
+
+   const auto replaced = [&] {
+      outputs.Commit();
+      REQUIRE(tracks->Size() == 2);
+      // The short track is always kept
+      REQUIRE(*tracks->rbegin() == pShort.get());
+      return *tracks->begin() != pLong.get();
+   };
+
+   SECTION("tracks that the effect did not change")
+   {
+      REQUIRE(!replaced());
+   }
+
+   SECTION("a track that the effect processed briefly")
+   {
+      const auto before = GetContents(*pLong);
+      const auto start = longOutput.TimeToLongSamples(1.0);
+      const auto length = static_cast<size_t>(SampleRate / 2);
+      const std::vector<float> zeroes(length);
+      for (const auto pChannel : longOutput.Channels())
+         REQUIRE(pChannel->Set(reinterpret_cast<constSamplePtr>(zeroes.data()),
+            floatSample, start, length));
+
+      REQUIRE(replaced());
+      const auto& committed = **tracks->Any<const WaveTrack>().begin();
+      REQUIRE(&committed == &longOutput);
+
+      // All blocks but those written are kept, at most two of each channel
+      const auto blocks = Blocks(committed);
+      REQUIRE(blocks.size() == longBlocks.size());
+      const std::set<const SampleBlock*> oldBlocks { longBlocks.begin(),
+                                                     longBlocks.end() };
+      const auto newBlocks = std::count_if(
+         blocks.begin(), blocks.end(),
+         [&](const SampleBlock* pBlock) { return !oldBlocks.count(pBlock); });
+      REQUIRE(newBlocks >= 2);
+      REQUIRE(newBlocks <= 4);
+
+      const auto after = GetContents(committed);
+      const auto first = start.as_size_t();
+      for (size_t iChannel = 0; iChannel < 2; ++iChannel)
+      {
+         const auto& input = before[iChannel];
+         const auto& output = after[iChannel];
+         REQUIRE(output.size() == input.size());
+         REQUIRE(
+            std::equal(input.begin(), input.begin() + first, output.begin()));
+         REQUIRE(std::all_of(
+            output.begin() + first, output.begin() + first + length,
+            [](float sample) { return sample == 0; }));
+         REQUIRE(std::equal(input.begin() + first + length, input.end(),
+            output.begin() + first + length));
+      }
+   }
+
+   SECTION("a track of which the effect changed only attributes")
+   {
+      const auto pClip = longOutput.GetClip(0);
+      SECTION("gain")
+      {
+         longOutput.SetGain(0.5f);
+      }
+      SECTION("envelope")
+      {
+         pClip->GetEnvelope().InsertOrReplace(1.2, 0.5);
+      }
+      SECTION("clip position")
+      {
+         pClip->ShiftBy(0.25);
+      }
+      REQUIRE(Blocks(longOutput) == longBlocks);
+      REQUIRE(replaced());
+   }
+}
@@ -0,0 +1,216 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  PerTrackEffectTests.cpp
+
+**********************************************************************/
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+#include "BasicUI.h"
+#include "MockSampleBlockFactory.h"
+#include "PerTrackEffect.h"
+#include "TestTracks.h"
+
+using namespace TestTracks;
+
+namespace
+{
+//! Low-pass filters each channel, so that what it writes depends on the state
+//! of its instance, which tracks processed at once must not share
+class TestEffect final : public PerTrackEffect
+{
+public:
+   TestEffect(bool concurrently, unsigned nChannels)
+       : mConcurrently { concurrently }
+       , mnChannels { nChannels }
+   {
+   }
+
+   struct Instance final
+       : PerTrackEffect::Instance
+       , EffectInstanceWithBlockSize
+   {
+      explicit Instance(const TestEffect& effect)
+          : PerTrackEffect::Instance { effect }
+          , mEffect { effect }
+      {
+      }
+
+      bool ProcessInitialize(
+         EffectSettings&, double, ChannelNames) override
+      {
+         std::fill(std::begin(mState), std::end(mState), 0.0f);
+         return true;
+      }
+
+      size_t ProcessBlock(EffectSettings&, const float* const* inBlock,
+         float* const* outBlock, size_t blockLen) override
+      {
+         if (mEffect.failAtBlock > 0 && --mEffect.failAtBlock == 0)
+            throw std::runtime_error { "effect failure" };
+         for (unsigned iChannel = 0; iChannel < mEffect.mnChannels; ++iChannel)
+            for (size_t ii = 0; ii < blockLen; ++ii)
+               outBlock[iChannel][ii] = mState[iChannel] =
+                  0.5f * (inBlock[iChannel][ii] + mState[iChannel]);
+         return blockLen;
+      }
+
+      unsigned GetAudioInCount() const override
+      {
+         return mEffect.mnChannels;
+      }
+
+      unsigned GetAudioOutCount() const override
+      {
+         return mEffect.mnChannels;
+      }
+
+      const TestEffect& mEffect;
+      float mState[2] {};
+   };
+
+   EffectType GetType() const override
+   {
+      return EffectTypeProcess;
+   }
+
+   std::shared_ptr<EffectInstance> MakeInstance() const override
+   {
+      return std::make_shared<Instance>(*this);
+   }
+
+   bool ProcessesTracksConcurrently() const override
+   {
+      return mConcurrently;
+   }
+
+   using PerTrackEffect::Process;
+
+   //! If positive, counts down the blocks of all instances, and the last one
+   //! throws
+   mutable std::atomic<int> failAtBlock { 0 };
+
+private:
+   const bool mConcurrently;
+   const unsigned mnChannels;
+};
+
+//! Cancels at the first poll
+class CancellingProgress final : public BasicUI::ProgressDialog
+{
+public:
+   BasicUI::ProgressResult Poll(unsigned long long, unsigned long long,
+      const TranslatableString&) override
+   {
+      return BasicUI::ProgressResult::Cancelled;
+   }
+   void SetMessage(const TranslatableString&) override
+   {
+   }
+   void SetDialogTitle(const TranslatableString&) override
+   {
+   }
+   void Reinit() override
+   {
+   }
+};
+
+//! Mono and stereo tracks of different lengths, and one not selected
+TrackListHolder MakeTracks(const SampleBlockFactoryPtr& factory)
+{
+   auto tracks = TrackList::Create(nullptr);
+   unsigned seed = 1;
+   for (const size_t nChannels : { 1, 2, 1, 2, 1 })
+   {
+      const auto length = 40000 + 1111 * seed;
+      tracks->Add(MakeTrack(factory, nChannels, length, seed++));
+   }
+   (*tracks->rbegin())->SetSelected(false);
+   return tracks;
+}
+
+bool Apply(TestEffect& effect, TrackList& tracks)
+{
+   effect.SetTracks(&tracks);
+   effect.mT0 = 0.1;
+   effect.mT1 = 0.9;
+   EffectSettings settings;
+   const auto pInstance = effect.MakeInstance();
+   const auto result = effect.Process(*pInstance, settings);
+   effect.SetTracks(nullptr);
+   return result;
+}
+} // namespace
+
+TEST_CASE("PerTrackEffect writes the same when processing concurrently")
+{
+   const auto factory = std::make_shared<MockSampleBlockFactory>();
+   const unsigned nChannels = GENERATE(1u, 2u);
+
+   const auto inputs = MakeTracks(factory);
+   const auto before = GetContents(*inputs);
+
+   std::vector<Contents> outputs[2];
+   for (const bool concurrently : { false, true })
+   {
+      const auto tracks = MakeTracks(factory);
+      TestEffect effect { concurrently, nChannels };
+      REQUIRE(Apply(effect, *tracks));
+      outputs[concurrently] = GetContents(*tracks);
+   }
+   REQUIRE(outputs[true] == outputs[false]);
+
+   // Only the selection of the selected tracks changed
+   const auto start = static_cast<size_t>(0.1 * SampleRate);
+   const auto end = static_cast<size_t>(0.9 * SampleRate);
+   for (size_t iTrack = 0; iTrack < before.size(); ++iTrack)
+      for (size_t iChannel = 0; iChannel < before[iTrack].size(); ++iChannel)
+      {
+         const auto& input = before[iTrack][iChannel];
+         const auto& output = outputs[true][iTrack][iChannel];
+         REQUIRE(output.size() == input.size());
+         REQUIRE(std::equal(
+            input.begin(), input.begin() + start, output.begin()));
+         REQUIRE(std::equal(input.begin() + end, input.end(),
+            output.begin() + end));
+         const bool selected = iTrack + 1 < before.size();
+         REQUIRE(std::equal(input.begin() + start, input.begin() + end,
+            output.begin() + start) == !selected);
+      }
+}
+
+TEST_CASE("PerTrackEffect leaves the tracks unchanged when it fails")
+{
+   const auto factory = std::make_shared<MockSampleBlockFactory>();
+   const bool concurrently = GENERATE(false, true);
+   const unsigned nChannels = GENERATE(1u, 2u);
+
+   const auto tracks = MakeTracks(factory);
+   const auto before = GetContents(*tracks);
+   const std::vector<const Track*> trackPointers {
+      tracks->begin(), tracks->end()
+   };
+
+   TestEffect effect { concurrently, nChannels };
+   CancellingProgress progress;
+   SECTION("when cancelled")
+   {
+      effect.mProgress = &progress;
+   }
+   SECTION("when an instance fails")
+   {
+      effect.failAtBlock = 3;
+   }
+   REQUIRE(!Apply(effect, *tracks));
+   effect.mProgress = nullptr;
+
+   REQUIRE(std::vector<const Track*> { tracks->begin(), tracks->end() } ==
+           trackPointers);
+   REQUIRE(GetContents(*tracks) == before);
+}
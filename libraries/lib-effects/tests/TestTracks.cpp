@@ -0,0 +1,61 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  TestTracks.cpp
+
+**********************************************************************/
+#include "TestTracks.h"
+#include "MockedPrefs.h"
+
+#include <catch2/catch.hpp>
+
+MockedPrefs prefs;
+
+namespace TestTracks
+{
+WaveTrack::Holder
+MakeTrack(const SampleBlockFactoryPtr& factory, size_t nChannels,
+   size_t length, unsigned seed)
+{
+   auto track = WaveTrack::Create(factory, floatSample, SampleRate);
+   if (nChannels == 2)
+      track = track->MonoToStereo();
+   for (size_t iChannel = 0; iChannel < nChannels; ++iChannel)
+   {
+      std::vector<float> samples(length);
+      for (auto& sample : samples)
+      {
+         seed = seed * 1664525 + 1013904223;
+         sample = (seed >> 8) / float(1 << 24) - 0.5f;
+      }
+      track->Append(iChannel, reinterpret_cast<constSamplePtr>(samples.data()),
+         floatSample, length);
+   }
+   track->Flush();
+   track->SetSelected(true);
+   return track;
+}
+
+Contents GetContents(const WaveTrack& track)
+{
+   const auto length =
+      track.TimeToLongSamples(track.GetEndTime()).as_size_t();
+   Contents result;
+   for (const auto pChannel : track.Channels())
+   {
+      auto& samples = result.emplace_back(length);
+      REQUIRE(pChannel->GetFloats(samples.data(), 0, length));
+   }
+   return result;
+}
+
+std::vector<Contents> GetContents(const TrackList& tracks)
+{
+   std::vector<Contents> result;
+   for (const auto pTrack : tracks.Any<const WaveTrack>())
+      result.push_back(GetContents(*pTrack));
+   return result;
+}
+} // namespace TestTracks
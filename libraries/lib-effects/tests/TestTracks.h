@@ -0,0 +1,32 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  TestTracks.h
+
+**********************************************************************/
+#pragma once
+
+#include "SampleBlock.h"
+#include "WaveTrack.h"
+
+#include <vector>
+
+namespace TestTracks
+{
+constexpr double SampleRate = 44100;
+
+//! Samples of each channel of a track, from time zero to its end
+using Contents = std::vector<std::vector<float>>;
+
+//! A selected track of noise, which differs with the seed
+WaveTrack::Holder
+MakeTrack(const SampleBlockFactoryPtr& factory, size_t nChannels,
+   size_t length, unsigned seed);
+
+Contents GetContents(const WaveTrack& track);
+
+//! Contents of each wave track of the list, in order
+std::vector<Contents> GetContents(const TrackList& tracks);
+} // namespace TestTracks
@@ -0,0 +1,130 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  FIRConvolver.cpp
+
+**********************************************************************/
+#include "FIRConvolver.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace {
+constexpr size_t MinBlockSize = 64;
+constexpr size_t MaxBlockSize = 1 << 16;
+
+//! Transform 2 * blockSize samples in buffer, and split the result
+void Transform(const FFTParam &fft, fft_type *buffer,
+   float *real, float *imag, size_t blockSize)
+{
+   RealFFTf(buffer, &fft);
+   for (size_t ii = 0; ii < blockSize; ++ii) {
+      real[ii] = buffer[2 * ii];
+      imag[ii] = buffer[2 * ii + 1];
+   }
+}
+}
+
+size_t FIRConvolver::DefaultBlockSize(size_t impulseLen)
+{
+   // One partition, so each block costs two transforms of twice its length
+   // and one multiplication of spectra
+   size_t result = MinBlockSize;
+   while (result < impulseLen && result < MaxBlockSize)
+      result *= 2;
+   return result;
+}
+
+FIRConvolver::FIRConvolver(
+   const float *impulse, size_t impulseLen, size_t blockSize)
+   : mImpulseLen{ impulseLen }
+   , mBlockSize{ blockSize ? blockSize : DefaultBlockSize(impulseLen) }
+   , mNPartitions{ (mImpulseLen + mBlockSize - 1) / mBlockSize }
+   , mFFT{ GetFFT(2 * mBlockSize) }
+   , mFilterReal(mNPartitions * mBlockSize)
+   , mFilterImag(mNPartitions * mBlockSize)
+   , mInputReal(mNPartitions * mBlockSize)
+   , mInputImag(mNPartitions * mBlockSize)
+   , mInput(2 * mBlockSize)
+   , mBuffer(2 * mBlockSize)
+   , mAccReal(mBlockSize)
+   , mAccImag(mBlockSize)
+{
+   assert(impulseLen > 0);
+   assert((mBlockSize & (mBlockSize - 1)) == 0);
+
+   // Each partition is zero-padded to twice the block size, so that the
+   // second half of each circular convolution is the linear convolution
+   for (size_t pp = 0; pp < mNPartitions; ++pp) {
+      const auto first = pp * mBlockSize;
+      const auto count = std::min(mBlockSize, mImpulseLen - first);
+      std::fill(mBuffer.begin(), mBuffer.end(), 0);
+      std::copy(impulse + first, impulse + first + count, mBuffer.begin());
+      Transform(*mFFT, mBuffer.data(),
+         &mFilterReal[first], &mFilterImag[first], mBlockSize);
+   }
+}
+
+FIRConvolver::~FIRConvolver() = default;
+
+void FIRConvolver::Reset()
+{
+   std::fill(mInputReal.begin(), mInputReal.end(), 0);
+   std::fill(mInputImag.begin(), mInputImag.end(), 0);
+   std::fill(mInput.begin(), mInput.end(), 0);
+   mNewest = 0;
+}
+
+void FIRConvolver::ProcessBlock(const float *input, float *output)
+{
+   const auto blockSize = mBlockSize;
+
+   // Slide the input and transform the last two blocks
+   std::copy(mInput.begin() + blockSize, mInput.end(), mInput.begin());
+   std::copy(input, input + blockSize, mInput.begin() + blockSize);
+   std::copy(mInput.begin(), mInput.end(), mBuffer.begin());
+   mNewest = (mNewest + mNPartitions - 1) % mNPartitions;
+   Transform(*mFFT, mBuffer.data(),
+      &mInputReal[mNewest * blockSize], &mInputImag[mNewest * blockSize],
+      blockSize);
+
+   // Multiply-accumulate each partition of the response with the spectrum
+   // of the block as many blocks old.  Bin 0 packs the real dc and nyquist
+   // coefficients; others are complex.
+   const auto accReal = mAccReal.data(), accImag = mAccImag.data();
+   std::fill(accReal, accReal + blockSize, 0);
+   std::fill(accImag, accImag + blockSize, 0);
+   for (size_t pp = 0; pp < mNPartitions; ++pp) {
+      const auto slot = ((mNewest + pp) % mNPartitions) * blockSize;
+      const auto xr = &mInputReal[slot], xi = &mInputImag[slot];
+      const auto hr = &mFilterReal[pp * blockSize],
+         hi = &mFilterImag[pp * blockSize];
+      accReal[0] += xr[0] * hr[0];
+      accImag[0] += xi[0] * hi[0];
+      for (size_t ii = 1; ii < blockSize; ++ii) {
+         accReal[ii] += xr[ii] * hr[ii] - xi[ii] * hi[ii];
+         accImag[ii] += xr[ii] * hi[ii] + xi[ii] * hr[ii];
+      }
+   }
+
+   // InverseRealFFTf wants the natural order
+   const auto &fft = *mFFT;
+   const auto buffer = mBuffer.data();
+   buffer[0] = accReal[0];
+   buffer[1] = accImag[0];
+   for (size_t ii = 1; ii < blockSize; ++ii) {
+      const auto jj = fft.BitReversed[ii] / 2;
+      buffer[2 * ii] = accReal[jj];
+      buffer[2 * ii + 1] = accImag[jj];
+   }
+   InverseRealFFTf(buffer, &fft);
+
+   // Keep the second half of the time domain result, as ReorderToTime would
+   for (size_t ii = blockSize / 2; ii < blockSize; ++ii) {
+      const auto index = fft.BitReversed[ii];
+      *output++ = buffer[index];
+      *output++ = buffer[index + 1];
+   }
+}
@@ -0,0 +1,78 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  FIRConvolver.h
+
+**********************************************************************/
+#pragma once
+
+#include "RealFFTf.h"
+
+#include <vector>
+
+//! Convolves a signal with a finite impulse response, by the FFT
+/*!
+ The response is cut into partitions of the block size, and each block of
+ input is transformed once and multiplied with every partition
+ (uniformly partitioned overlap-save).  Output lags input by nothing more than
+ the block, so small blocks suit real time and large blocks suit offline
+ processing of long filters.
+
+ Spectra are kept with real and imaginary parts in separate arrays, so the
+ multiply-accumulate loops vectorize; transforms use the RealFFTf kernels.
+
+ Not thread safe; use one object per thread.  Objects with the same response
+ may process different parts of a signal concurrently, given enough lead-in;
+ see ProcessBlock().
+ */
+class FFT_API FIRConvolver final
+{
+public:
+   //! Block size that minimizes work per sample for a response length
+   static size_t DefaultBlockSize(size_t impulseLen);
+
+   /*!
+    @param impulse impulseLen coefficients, which are copied
+    @param blockSize a power of 2, or 0 for DefaultBlockSize(impulseLen)
+    @pre `impulseLen > 0`
+    */
+   FIRConvolver(const float *impulse, size_t impulseLen, size_t blockSize = 0);
+   ~FIRConvolver();
+
+   size_t BlockSize() const { return mBlockSize; }
+   size_t ImpulseLength() const { return mImpulseLen; }
+
+   //! Forget previous input, as if it were all zero
+   void Reset();
+
+   //! Filter the next BlockSize() samples
+   /*!
+    Output sample n is the sum of `impulse[k] * x[n - k]`, for all input x
+    since construction or Reset(), and zero before that.  So a lead-in of
+    `ImpulseLength() - 1` samples makes output independent of anything earlier.
+
+    @param output may equal input
+    */
+   void ProcessBlock(const float *input, float *output);
+
+private:
+   const size_t mImpulseLen;
+   const size_t mBlockSize;
+   const size_t mNPartitions;
+   const HFFT mFFT;
+
+   //! Spectra of partitions of the response, in the bit-reversed order of
+   //! RealFFTf, with real and imaginary parts each mBlockSize long
+   std::vector<float> mFilterReal, mFilterImag;
+   //! Spectra of recent blocks of input, used circularly, newest at mNewest
+   std::vector<float> mInputReal, mInputImag;
+   size_t mNewest = 0;
+
+   //! The previous block of input and then the current, 2 * mBlockSize
+   std::vector<float> mInput;
+   //! 2 * mBlockSize
+   std::vector<fft_type> mBuffer;
+   std::vector<float> mAccReal, mAccImag;
+};
@@ -37,13 +37,20 @@
 */
 
 #include "RealFFTf.h"
+#include "RealFFTfKernels.h"
 
+#include <atomic>
 #include <vector>
 #include <stdlib.h>
 #include <math.h>
 
 #include <wx/thread.h>
 
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
 #ifndef M_PI
 #define	M_PI		3.14159265358979323846  /* pi */
 #endif
@@ -83,13 +90,6 @@ HFFT InitializeFFT(size_t fftlen)
       h->SinTable[h->BitReversed[i]+1]=(fft_type)-cos(2*M_PI*i/(2*h->Points));
    }
 
-#ifdef EXPERIMENTAL_EQ_SSE_THREADED
-   // NEW SSE FFT routines work on live data
-   for(size_t i = 0; i < 32; i++)
-      if((1 << i) & fftlen)
-         h->pow2Bits = i;
-#endif
-
    return h;
 }
 
@@ -140,34 +140,16 @@ void FFTDeleter::operator() (FFTParam *hFFT) const
       delete hFFT;
 }
 
-/*
-*  Forward FFT routine.  Must call GetFFT(fftlen) first!
-*
-*  Note: Output is BIT-REVERSED! so you must use the BitReversed to
-*        get legible output, (i.e. Real_i = buffer[ h->BitReversed[i] ]
-*                                  Imag_i = buffer[ h->BitReversed[i]+1 ] )
-*        Input is in normal order.
-*
-* Output buffer[0] is the DC bin, and output buffer[1] is the Fs/2 bin
-* - this can be done because both values will always be real only
-* - this allows us to not have to allocate an extra complex value for the Fs/2 bin
-*
-*  Note: The scaling on this is done according to the standard FFT definition,
-*        so a unit amplitude DC signal will output an amplitude of (N)
-*        (Older revisions would progressively scale the input, so the output
-*        values would be similar in amplitude to the input values, which is
-*        good when using fixed point arithmetic)
-*/
-void RealFFTf(fft_type *buffer, const FFTParam *h)
+/* The scalar butterfly stages of the forward FFT */
+static void ScalarForwardButterflies(
+   fft_type *buffer, const fft_type *SinTable, size_t Points)
 {
    fft_type *A,*B;
    const fft_type *sptr;
    const fft_type *endptr1,*endptr2;
-   const int *br1,*br2;
-   fft_type HRplus,HRminus,HIplus,HIminus;
    fft_type v1,v2,sin,cos;
 
-   auto ButterfliesPerGroup = h->Points/2;
+   auto ButterfliesPerGroup = Points/2;
 
    /*
    *  Butterfly:
@@ -177,13 +159,13 @@ void RealFFTf(fft_type *buffer, const FFTParam *h)
    *     Bin-----Bout
    */
 
-   endptr1 = buffer + h->Points * 2;
+   endptr1 = buffer + Points * 2;
 
    while(ButterfliesPerGroup > 0)
    {
       A = buffer;
       B = buffer + ButterfliesPerGroup * 2;
-      sptr = h->SinTable.get();
+      sptr = SinTable;
 
       while(A < endptr1)
       {
@@ -205,6 +187,147 @@ void RealFFTf(fft_type *buffer, const FFTParam *h)
       }
       ButterfliesPerGroup >>= 1;
    }
+}
+
+static void ScalarInverseButterflies(
+   fft_type *buffer, const fft_type *SinTable, size_t Points);
+
+namespace {
+bool CPUHasAVX2()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+   int info[4];
+   __cpuid(info, 0);
+   if (info[0] < 7)
+      return false;
+   __cpuid(info, 1);
+   const bool fma = info[2] & (1 << 12);
+   const bool osxsave = info[2] & (1 << 27);
+   const bool avx = info[2] & (1 << 28);
+   if (!(fma && osxsave && avx))
+      return false;
+   // Does the operating system save the YMM registers?
+   if ((_xgetbv(0) & 0x6) != 0x6)
+      return false;
+   __cpuidex(info, 7, 0);
+   return info[1] & (1 << 5);
+#elif (defined(__GNUC__) || defined(__clang__)) && \
+   (defined(__x86_64__) || defined(__i386__))
+   return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+   return false;
+#endif
+}
+
+const RealFFTfKernels::Butterflies *FindButterflies(RealFFTfKernel kernel)
+{
+   static const RealFFTfKernels::Butterflies scalar{
+      ScalarForwardButterflies, ScalarInverseButterflies, 1, nullptr };
+   switch (kernel) {
+   case RealFFTfKernel::Scalar:
+      return &scalar;
+   case RealFFTfKernel::SSE2:
+      return RealFFTfKernels::SSE2Butterflies();
+   case RealFFTfKernel::AVX2:
+      return CPUHasAVX2() ? RealFFTfKernels::AVX2Butterflies() : nullptr;
+   case RealFFTfKernel::NEON:
+      return RealFFTfKernels::NEONButterflies();
+   default:
+      return nullptr;
+   }
+}
+
+RealFFTfKernel ChooseKernel()
+{
+   for (auto kernel : {
+      RealFFTfKernel::AVX2, RealFFTfKernel::SSE2, RealFFTfKernel::NEON })
+      if (FindButterflies(kernel))
+         return kernel;
+   return RealFFTfKernel::Scalar;
+}
+
+std::atomic<RealFFTfKernel> &CurrentKernel()
+{
+   static std::atomic<RealFFTfKernel> kernel{ ChooseKernel() };
+   return kernel;
+}
+
+std::atomic<const RealFFTfKernels::Butterflies *> &CurrentButterflies()
+{
+   static std::atomic<const RealFFTfKernels::Butterflies *> butterflies{
+      FindButterflies(CurrentKernel()) };
+   return butterflies;
+}
+}
+
+const RealFFTfKernels::Butterflies &RealFFTfKernels::GetButterflies()
+{
+   return *CurrentButterflies().load(std::memory_order_relaxed);
+}
+
+RealFFTfKernel GetRealFFTfKernel()
+{
+   return CurrentKernel();
+}
+
+bool IsRealFFTfKernelSupported(RealFFTfKernel kernel)
+{
+   return FindButterflies(kernel) != nullptr;
+}
+
+bool SetRealFFTfKernel(RealFFTfKernel kernel)
+{
+   const auto butterflies = FindButterflies(kernel);
+   if (!butterflies)
+      return false;
+   CurrentKernel() = kernel;
+   CurrentButterflies() = butterflies;
+   return true;
+}
+
+const char *GetRealFFTfKernelName(RealFFTfKernel kernel)
+{
+   switch (kernel) {
+   case RealFFTfKernel::Scalar:
+      return "Scalar";
+   case RealFFTfKernel::SSE2:
+      return "SSE2";
+   case RealFFTfKernel::AVX2:
+      return "AVX2";
+   case RealFFTfKernel::NEON:
+      return "NEON";
+   default:
+      return "";
+   }
+}
+
+/*
+*  Forward FFT routine.  Must call GetFFT(fftlen) first!
+*
+*  Note: Output is BIT-REVERSED! so you must use the BitReversed to
+*        get legible output, (i.e. Real_i = buffer[ h->BitReversed[i] ]
+*                                  Imag_i = buffer[ h->BitReversed[i]+1 ] )
+*        Input is in normal order.
+*
+* Output buffer[0] is the DC bin, and output buffer[1] is the Fs/2 bin
+* - this can be done because both values will always be real only
+* - this allows us to not have to allocate an extra complex value for the Fs/2 bin
+*
+*  Note: The scaling on this is done according to the standard FFT definition,
+*        so a unit amplitude DC signal will output an amplitude of (N)
+*        (Older revisions would progressively scale the input, so the output
+*        values would be similar in amplitude to the input values, which is
+*        good when using fixed point arithmetic)
+*/
+void RealFFTf(fft_type *buffer, const FFTParam *h)
+{
+   fft_type *A,*B;
+   const int *br1,*br2;
+   fft_type HRplus,HRminus,HIplus,HIminus;
+   fft_type v1,v2,sin,cos;
+
+   RealFFTfKernels::GetButterflies().forward(buffer, h->SinTable.get(), h->Points);
+
    /* Massage output to get the output for a real input sequence. */
    br1 = h->BitReversed.get() + 1;
    br2 = h->BitReversed.get() + h->Points - 1;
@@ -263,14 +386,10 @@ void RealFFTf(fft_type *buffer, const FFTParam *h)
 void InverseRealFFTf(fft_type *buffer, const FFTParam *h)
 {
    fft_type *A,*B;
-   const fft_type *sptr;
-   const fft_type *endptr1,*endptr2;
    const int *br1;
    fft_type HRplus,HRminus,HIplus,HIminus;
    fft_type v1,v2,sin,cos;
 
-   auto ButterfliesPerGroup = h->Points / 2;
-
    /* Massage input to get the input for a real output sequence. */
    A = buffer + 2;
    B = buffer + h->Points * 2 - 2;
@@ -306,6 +425,19 @@ void InverseRealFFTf(fft_type *buffer, const FFTParam *h)
    buffer[0]=v1;
    buffer[1]=v2;
 
+   RealFFTfKernels::GetButterflies().inverse(buffer, h->SinTable.get(), h->Points);
+}
+
+static void ScalarInverseButterflies(
+   fft_type *buffer, const fft_type *SinTable, size_t Points)
+{
+   fft_type *A,*B;
+   const fft_type *sptr;
+   const fft_type *endptr1,*endptr2;
+   fft_type v1,v2,sin,cos;
+
+   auto ButterfliesPerGroup = Points / 2;
+
    /*
    *  Butterfly:
    *     Ain-----Aout
@@ -314,13 +446,13 @@ void InverseRealFFTf(fft_type *buffer, const FFTParam *h)
    *     Bin-----Bout
    */
 
-   endptr1 = buffer + h->Points * 2;
+   endptr1 = buffer + Points * 2;
 
    while(ButterfliesPerGroup > 0)
    {
       A = buffer;
       B = buffer + ButterfliesPerGroup * 2;
-      sptr = h->SinTable.get();
+      sptr = SinTable;
 
       while(A < endptr1)
       {
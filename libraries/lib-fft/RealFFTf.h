@@ -8,9 +8,6 @@ struct FFTParam {
    ArrayOf<int> BitReversed;
    ArrayOf<fft_type> SinTable;
    size_t Points;
-#ifdef EXPERIMENTAL_EQ_SSE_THREADED
-   int pow2Bits;
-#endif
 };
 
 struct FFT_API FFTDeleter{
@@ -28,5 +25,24 @@ FFT_API void ReorderToTime(const FFTParam *hFFT, const fft_type *buffer, fft_typ
 FFT_API void ReorderToFreq(const FFTParam *hFFT, const fft_type *buffer,
 		   fft_type *RealOut, fft_type *ImagOut);
 
+//! Implementations of the butterfly stages of RealFFTf and InverseRealFFTf
+/*!
+ The fastest one that the build and the CPU support is chosen at first use.
+ All give the same results as Scalar, to within rounding.
+ */
+enum class RealFFTfKernel {
+   Scalar,
+   SSE2,
+   AVX2,
+   NEON,
+};
+
+FFT_API RealFFTfKernel GetRealFFTfKernel();
+FFT_API bool IsRealFFTfKernelSupported(RealFFTfKernel kernel);
+//! Override the choice made at first use, for tests and benchmarks
+/*! @return whether the kernel is supported, else the choice is unchanged */
+FFT_API bool SetRealFFTfKernel(RealFFTfKernel kernel);
+FFT_API const char *GetRealFFTfKernelName(RealFFTfKernel kernel);
+
 #endif
 
@@ -0,0 +1,74 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  RealFFTfAVX2.cpp
+
+  This file alone is compiled with AVX2 and FMA code generation enabled.
+  Nothing here may be called unless the CPU is checked first.
+
+**********************************************************************/
+#include "RealFFTfKernels.h"
+
+// The flags that enable AVX2 here enable FMA too; MSVC's /arch:AVX2 does, but
+// it defines only __AVX2__
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace RealFFTfKernels {
+
+namespace {
+struct AVX2Traits {
+   using V = __m256;
+   static constexpr size_t Width = 8;
+
+   static V Load(const fft_type *p) { return _mm256_loadu_ps(p); }
+   static void Store(fft_type *p, V v) { _mm256_storeu_ps(p, v); }
+   static V Set(fft_type x) { return _mm256_set1_ps(x); }
+   static V SetAlternating(fft_type re, fft_type im)
+      { return _mm256_setr_ps(re, im, re, im, re, im, re, im); }
+   static V SwapPairs(V v)
+      { return _mm256_permute_ps(v, _MM_SHUFFLE(2, 3, 0, 1)); }
+   static V Add(V a, V b) { return _mm256_add_ps(a, b); }
+   static V Sub(V a, V b) { return _mm256_sub_ps(a, b); }
+   static V Mul(V a, V b) { return _mm256_mul_ps(a, b); }
+   static V MulAdd(V a, V b, V c) { return _mm256_fmadd_ps(a, b, c); }
+};
+
+//! The narrower stages, with VEX encodings so there are no transition stalls
+struct SSETraits {
+   using V = __m128;
+   static constexpr size_t Width = 4;
+
+   static V Load(const fft_type *p) { return _mm_loadu_ps(p); }
+   static void Store(fft_type *p, V v) { _mm_storeu_ps(p, v); }
+   static V Set(fft_type x) { return _mm_set1_ps(x); }
+   static V SetAlternating(fft_type re, fft_type im)
+      { return _mm_setr_ps(re, im, re, im); }
+   static V SwapPairs(V v) { return _mm_permute_ps(v, _MM_SHUFFLE(2, 3, 0, 1)); }
+   static V Add(V a, V b) { return _mm_add_ps(a, b); }
+   static V Sub(V a, V b) { return _mm_sub_ps(a, b); }
+   static V Mul(V a, V b) { return _mm_mul_ps(a, b); }
+   static V MulAdd(V a, V b, V c) { return _mm_fmadd_ps(a, b, c); }
+};
+}
+
+const Butterflies *AVX2Butterflies()
+{
+   static const auto result = MakeButterflies<AVX2Traits, SSETraits>();
+   return &result;
+}
+
+}
+
+#else
+
+namespace RealFFTfKernels {
+const Butterflies *AVX2Butterflies()
+{
+   return nullptr;
+}
+}
+
+#endif
@@ -0,0 +1,87 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  RealFFTfBatch.cpp
+
+**********************************************************************/
+#include "RealFFTfBatch.h"
+#include "RealFFTfKernels.h"
+
+#include <algorithm>
+
+namespace {
+//! Beyond this many floats the transposed frames no longer fit in the
+//! level 1 cache, and transforming one frame at a time is faster
+constexpr size_t MaxTransposedSize = 8192;
+}
+
+RealFFTfBatch::RealFFTfBatch(size_t fftLen, const float *window)
+   : mFFTLen{ fftLen }
+   , mFFT{ GetFFT(fftLen) }
+{
+   if (window)
+      mWindow.assign(window, window + fftLen);
+}
+
+RealFFTfBatch::~RealFFTfBatch() = default;
+
+void RealFFTfBatch::ForwardOne(const float *input, float *output)
+{
+   if (mWindow.empty())
+      std::copy(input, input + mFFTLen, output);
+   else
+      std::transform(input, input + mFFTLen, mWindow.begin(), output,
+         std::multiplies<>{});
+   RealFFTf(output, mFFT.get());
+}
+
+void RealFFTfBatch::Forward(
+   const float *const inputs[], float *const outputs[], size_t nFrames)
+{
+   const auto &kernel = RealFFTfKernels::GetButterflies();
+   const auto lanes = kernel.lanes;
+   size_t frame = 0;
+   if (kernel.forwardTransposed && nFrames >= lanes &&
+      mFFTLen * lanes <= MaxTransposedSize) {
+      mTransposed.resize(mFFTLen * lanes);
+      const auto data = mTransposed.data();
+      const auto window = mWindow.empty() ? nullptr : mWindow.data();
+      for (; frame + lanes <= nFrames; frame += lanes) {
+         for (size_t lane = 0; lane < lanes; ++lane) {
+            const auto input = inputs[frame + lane];
+            auto pData = data + lane;
+            if (window)
+               for (size_t ii = 0; ii < mFFTLen; ++ii, pData += lanes)
+                  *pData = input[ii] * window[ii];
+            else
+               for (size_t ii = 0; ii < mFFTLen; ++ii, pData += lanes)
+                  *pData = input[ii];
+         }
+         kernel.forwardTransposed(data,
+            mFFT->SinTable.get(), mFFT->BitReversed.get(), mFFT->Points);
+         for (size_t lane = 0; lane < lanes; ++lane) {
+            const auto output = outputs[frame + lane];
+            auto pData = data + lane;
+            for (size_t ii = 0; ii < mFFTLen; ++ii, pData += lanes)
+               output[ii] = *pData;
+         }
+      }
+   }
+   // Leftover frames, or all of them if the transposed kernel is not used
+   for (; frame < nFrames; ++frame)
+      ForwardOne(inputs[frame], outputs[frame]);
+}
+
+void RealFFTfBatch::Forward(const float *input, size_t hop,
+   float *output, size_t outputStride, size_t nFrames)
+{
+   mInputs.resize(nFrames);
+   mOutputs.resize(nFrames);
+   for (size_t ii = 0; ii < nFrames; ++ii) {
+      mInputs[ii] = input + ii * hop;
+      mOutputs[ii] = output + ii * outputStride;
+   }
+   Forward(mInputs.data(), mOutputs.data(), nFrames);
+}
@@ -0,0 +1,67 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  RealFFTfBatch.h
+
+**********************************************************************/
+#pragma once
+
+#include "RealFFTf.h"
+
+#include <vector>
+
+//! Windows and transforms many frames of one size in one call
+/*!
+ Results are as if each frame were multiplied by the window and passed to
+ RealFFTf, so they are in the same bit-reversed layout, to within rounding.
+
+ When the vectorized RealFFTf kernels are available, short frames are
+ transformed several at a time, one in each lane of the vector registers, so
+ that every stage of the transform is fully vectorized.
+
+ Not thread safe; use one object per thread.
+ */
+class FFT_API RealFFTfBatch final
+{
+public:
+   /*!
+    @param fftLen a power of 2
+    @param window null for rectangular, else fftLen coefficients, which are
+    copied
+    */
+   RealFFTfBatch(size_t fftLen, const float *window);
+   ~RealFFTfBatch();
+
+   size_t FFTLen() const { return mFFTLen; }
+   const FFTParam &Param() const { return *mFFT; }
+
+   //! Window and transform nFrames frames
+   /*!
+    @param inputs nFrames pointers to fftLen samples
+    @param outputs nFrames pointers to fftLen results; each may equal the
+    corresponding input
+    */
+   void Forward(const float *const inputs[], float *const outputs[],
+      size_t nFrames);
+
+   //! Window and transform frames that begin at a regular hop
+   /*!
+    @param input frame ii begins at `input + ii * hop`
+    @param output result ii begins at `output + ii * outputStride`
+    */
+   void Forward(const float *input, size_t hop,
+      float *output, size_t outputStride, size_t nFrames);
+
+private:
+   void ForwardOne(const float *input, float *output);
+
+   const size_t mFFTLen;
+   const HFFT mFFT;
+   std::vector<float> mWindow;
+   //! Frames transposed for the vectorized kernel
+   std::vector<fft_type> mTransposed;
+   std::vector<const float *> mInputs;
+   std::vector<float *> mOutputs;
+};
@@ -0,0 +1,284 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  RealFFTfKernels.h
+
+**********************************************************************/
+#pragma once
+
+//! Private to lib-fft: vectorized butterfly stages for RealFFTf
+
+/*!
+ The butterfly stages of RealFFTf and InverseRealFFTf are a radix-2
+ decimation-in-time complex FFT over Points interleaved (re, im) pairs, with
+ a single twiddle factor for each group of butterflies.  That makes every
+ group a straight run of identical complex multiply-adds, which vectorizes
+ across the butterflies of the group.
+
+ Pairs of consecutive stages are fused into radix-4 passes, so that each
+ value is loaded and stored once for two stages.  The remaining stages that
+ are too narrow for the vector fall back to a narrower vector or to scalar
+ code.
+
+ The bit reversal and the real-sequence post- and pre-processing are shared
+ with the scalar implementation in RealFFTf.cpp.
+
+ Instantiate the templates in a translation unit compiled for the
+ instruction set of the vector traits.  They are in an unnamed namespace, and
+ the entry points take plain pointers rather than FFTParam, so that no inline
+ function compiled for one instruction set can be merged by the linker into
+ code meant for another.
+ */
+
+#include "RealFFTf.h"
+
+#include <cstddef>
+
+namespace RealFFTfKernels {
+
+//! Entry points for the butterfly stages only, which differ by instruction set
+/*!
+ @param sinTable FFTParam::SinTable
+ @param points FFTParam::Points
+ */
+struct Butterflies {
+   void (*forward)(fft_type *buffer, const fft_type *sinTable, size_t points);
+   void (*inverse)(fft_type *buffer, const fft_type *sinTable, size_t points);
+
+   //! How many frames forwardTransposed transforms at once; 1 if it is null
+   size_t lanes;
+   //! The complete forward transform, butterflies and post-processing, of
+   //! lanes frames, stored so that value ii of frame jj is at
+   //! `data[ii * lanes + jj]`
+   /*! @param bitReversed FFTParam::BitReversed */
+   void (*forwardTransposed)(fft_type *data,
+      const fft_type *sinTable, const int *bitReversed, size_t points);
+};
+
+//! The kernel in use by RealFFTf, defined in RealFFTf.cpp
+const Butterflies &GetButterflies();
+
+//! Defined in RealFFTfSIMD.cpp; null if not built for this architecture
+const Butterflies *SSE2Butterflies();
+//! Defined in RealFFTfSIMD.cpp; null if not built for this architecture
+const Butterflies *NEONButterflies();
+//! Defined in RealFFTfAVX2.cpp; null if not built with AVX2 enabled
+const Butterflies *AVX2Butterflies();
+
+namespace {
+
+//! Portable traits holding one complex value, for the narrowest stages
+struct ScalarTraits {
+   struct V { fft_type re, im; };
+   static constexpr size_t Width = 2;
+
+   static V Load(const fft_type *p) { return { p[0], p[1] }; }
+   static void Store(fft_type *p, V v) { p[0] = v.re; p[1] = v.im; }
+   static V Set(fft_type x) { return { x, x }; }
+   static V SetAlternating(fft_type re, fft_type im) { return { re, im }; }
+   static V SwapPairs(V v) { return { v.im, v.re }; }
+   static V Add(V a, V b) { return { a.re + b.re, a.im + b.im }; }
+   static V Sub(V a, V b) { return { a.re - b.re, a.im - b.im }; }
+   static V Mul(V a, V b) { return { a.re * b.re, a.im * b.im }; }
+   static V MulAdd(V a, V b, V c) { return Add(Mul(a, b), c); }
+};
+
+//! Twiddle factor of one group, broadcast to vectors
+template<typename T> struct Twiddle {
+   using V = typename T::V;
+   V cos;
+   //! sin with the signs needed by the swapped term of the butterfly
+   V sin;
+
+   //! @param sptr points to the (sin, cos) entries of the group in SinTable
+   template<bool Inverse> static Twiddle Make(const fft_type *sptr)
+   {
+      const auto s = sptr[0], c = sptr[1];
+      return { T::Set(c),
+         Inverse ? T::SetAlternating(-s, s) : T::SetAlternating(s, -s) };
+   }
+};
+
+/*!
+ Forward:
+   w = (Bre * cos + Bim * sin, Bim * cos - Bre * sin)
+   A' = A - w, B' = A + w
+ Inverse:
+   w = (Bre * cos - Bim * sin, Bim * cos + Bre * sin)
+   A' = (A - w) / 2, B' = (A + w) / 2
+ The sign differences are all in Twiddle::sin.
+ */
+template<typename T, bool Inverse>
+inline void Butterfly(
+   typename T::V &a, typename T::V &b, const Twiddle<T> &tw)
+{
+   const auto w = T::MulAdd(b, tw.cos, T::Mul(T::SwapPairs(b), tw.sin));
+   auto a1 = T::Sub(a, w), b1 = T::Add(a, w);
+   if constexpr (Inverse) {
+      const auto half = T::Set(0.5f);
+      a1 = T::Mul(a1, half);
+      b1 = T::Mul(b1, half);
+   }
+   a = a1;
+   b = b1;
+}
+
+//! One radix-2 stage; requires the vector to hold no more than
+//! butterfliesPerGroup complex values
+template<typename T, bool Inverse>
+void Radix2Pass(fft_type *buffer, const fft_type *sinTable, size_t points,
+   size_t butterfliesPerGroup)
+{
+   const auto end = buffer + points * 2;
+   const auto groupStride = butterfliesPerGroup * 4;
+   const auto half = butterfliesPerGroup * 2;
+   auto sptr = sinTable;
+   for (auto A = buffer; A < end; A += groupStride, sptr += 2) {
+      const auto tw = Twiddle<T>::template Make<Inverse>(sptr);
+      const auto B = A + half;
+      for (size_t ii = 0; ii < half; ii += T::Width) {
+         auto a = T::Load(A + ii), b = T::Load(B + ii);
+         Butterfly<T, Inverse>(a, b, tw);
+         T::Store(A + ii, a);
+         T::Store(B + ii, b);
+      }
+   }
+}
+
+//! Two fused radix-2 stages, with butterfliesPerGroup counting for the first
+//! of them; requires the vector to hold no more than butterfliesPerGroup / 2
+//! complex values
+template<typename T, bool Inverse>
+void Radix4Pass(fft_type *buffer, const fft_type *sinTable, size_t points,
+   size_t butterfliesPerGroup)
+{
+   const auto end = buffer + points * 2;
+   const auto groupStride = butterfliesPerGroup * 4;
+   const auto half = butterfliesPerGroup * 2;
+   const auto quarter = butterfliesPerGroup;
+   size_t group = 0;
+   for (auto A = buffer; A < end; A += groupStride, ++group) {
+      // The group of the first stage splits into groups 2 * group and
+      // 2 * group + 1 of the second stage
+      const auto tw1 = Twiddle<T>::template Make<Inverse>(sinTable + 2 * group);
+      const auto tw2a =
+         Twiddle<T>::template Make<Inverse>(sinTable + 4 * group);
+      const auto tw2b =
+         Twiddle<T>::template Make<Inverse>(sinTable + 4 * group + 2);
+      const auto A1 = A + quarter, B0 = A + half, B1 = B0 + quarter;
+      for (size_t ii = 0; ii < quarter; ii += T::Width) {
+         auto a0 = T::Load(A + ii), a1 = T::Load(A1 + ii),
+            b0 = T::Load(B0 + ii), b1 = T::Load(B1 + ii);
+         Butterfly<T, Inverse>(a0, b0, tw1);
+         Butterfly<T, Inverse>(a1, b1, tw1);
+         Butterfly<T, Inverse>(a0, a1, tw2a);
+         Butterfly<T, Inverse>(b0, b1, tw2b);
+         T::Store(A + ii, a0);
+         T::Store(A1 + ii, a1);
+         T::Store(B0 + ii, b0);
+         T::Store(B1 + ii, b1);
+      }
+   }
+}
+
+//! All butterfly stages, widest vectors first
+/*!
+ @tparam Narrower traits of a vector of half the width, or ScalarTraits;
+ stages too narrow for both use ScalarTraits
+ */
+template<typename T, typename Narrower, bool Inverse>
+void AllStages(fft_type *buffer, const fft_type *sinTable, size_t points)
+{
+   constexpr size_t complexPerVector = T::Width / 2;
+   auto butterfliesPerGroup = points / 2;
+   for (; butterfliesPerGroup >= 2 * complexPerVector;
+      butterfliesPerGroup >>= 2)
+      Radix4Pass<T, Inverse>(buffer, sinTable, points, butterfliesPerGroup);
+   for (; butterfliesPerGroup >= complexPerVector; butterfliesPerGroup >>= 1)
+      Radix2Pass<T, Inverse>(buffer, sinTable, points, butterfliesPerGroup);
+   constexpr size_t narrowerPerVector = Narrower::Width / 2;
+   for (; butterfliesPerGroup >= narrowerPerVector && butterfliesPerGroup > 0;
+      butterfliesPerGroup >>= 1)
+      Radix2Pass<Narrower, Inverse>(
+         buffer, sinTable, points, butterfliesPerGroup);
+   for (; butterfliesPerGroup > 0; butterfliesPerGroup >>= 1)
+      Radix2Pass<ScalarTraits, Inverse>(
+         buffer, sinTable, points, butterfliesPerGroup);
+}
+
+//! Forward transform of T::Width frames at once, one in each lane
+/*!
+ This is the same arithmetic as the scalar RealFFTf, but with no shuffles,
+ and the narrow stages and the post-processing are vectorized too.
+ */
+template<typename T>
+void ForwardTransposed(fft_type *data,
+   const fft_type *sinTable, const int *bitReversed, size_t points)
+{
+   using V = typename T::V;
+   constexpr auto lanes = T::Width;
+   const auto at = [data](size_t ii){ return data + ii * lanes; };
+
+   for (auto butterfliesPerGroup = points / 2; butterfliesPerGroup > 0;
+      butterfliesPerGroup >>= 1) {
+      const auto half = butterfliesPerGroup * 2;
+      auto sptr = sinTable;
+      for (size_t A = 0; A < points * 2; A += 2 * half, sptr += 2) {
+         const auto sin = T::Set(sptr[0]), cos = T::Set(sptr[1]);
+         const auto B = A + half;
+         for (size_t ii = 0; ii < half; ii += 2) {
+            const V ar = T::Load(at(A + ii)), ai = T::Load(at(A + ii + 1)),
+               br = T::Load(at(B + ii)), bi = T::Load(at(B + ii + 1));
+            const auto v1 = T::MulAdd(br, cos, T::Mul(bi, sin));
+            const auto v2 = T::Sub(T::Mul(br, sin), T::Mul(bi, cos));
+            T::Store(at(B + ii), T::Add(ar, v1));
+            T::Store(at(A + ii), T::Sub(ar, v1));
+            T::Store(at(B + ii + 1), T::Sub(ai, v2));
+            T::Store(at(A + ii + 1), T::Add(ai, v2));
+         }
+      }
+   }
+
+   // Massage output to get the output for a real input sequence
+   const auto half = T::Set(0.5f);
+   auto br1 = bitReversed + 1;
+   auto br2 = bitReversed + points - 1;
+   for (; br1 < br2; ++br1, --br2) {
+      const auto sin = T::Set(sinTable[*br1]),
+         cos = T::Set(sinTable[*br1 + 1]);
+      const auto A = *br1, B = *br2;
+      const V ar = T::Load(at(A)), ai = T::Load(at(A + 1)),
+         br = T::Load(at(B)), bi = T::Load(at(B + 1));
+      const auto hrPlus = T::Add(ar, br), hrMinus = T::Sub(ar, br),
+         hiPlus = T::Add(ai, bi), hiMinus = T::Sub(ai, bi);
+      const auto v1 = T::Sub(T::Mul(sin, hrMinus), T::Mul(cos, hiPlus));
+      const auto v2 = T::MulAdd(cos, hrMinus, T::Mul(sin, hiPlus));
+      const auto newAr = T::Mul(T::Add(hrPlus, v1), half);
+      const auto newAi = T::Mul(T::Add(hiMinus, v2), half);
+      T::Store(at(A), newAr);
+      T::Store(at(B), T::Sub(newAr, v1));
+      T::Store(at(A + 1), newAi);
+      T::Store(at(B + 1), T::Sub(newAi, hiMinus));
+   }
+   // Handle the center bin (just need a conjugate)
+   if (points > 1) {
+      const auto center = at(*br1 + 1);
+      T::Store(center, T::Sub(T::Set(0), T::Load(center)));
+   }
+   // Put the Fs/2 value into the imaginary part of the DC bin
+   const V dc = T::Load(at(0)), nyquist = T::Load(at(1));
+   T::Store(at(0), T::Add(dc, nyquist));
+   T::Store(at(1), T::Sub(dc, nyquist));
+}
+
+template<typename T, typename Narrower = ScalarTraits>
+Butterflies MakeButterflies()
+{
+   return { AllStages<T, Narrower, false>, AllStages<T, Narrower, true>,
+      T::Width, ForwardTransposed<T> };
+}
+
+}
+}
@@ -0,0 +1,96 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  RealFFTfSIMD.cpp
+
+**********************************************************************/
+#include "RealFFTfKernels.h"
+
+#if defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64) || \
+   (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define REALFFTF_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__aarch64__) || defined(_M_ARM64)
+#define REALFFTF_NEON
+#include <arm_neon.h>
+#endif
+
+namespace RealFFTfKernels {
+
+#if defined(REALFFTF_SSE2)
+
+namespace {
+struct SSE2Traits {
+   using V = __m128;
+   static constexpr size_t Width = 4;
+
+   static V Load(const fft_type *p) { return _mm_loadu_ps(p); }
+   static void Store(fft_type *p, V v) { _mm_storeu_ps(p, v); }
+   static V Set(fft_type x) { return _mm_set1_ps(x); }
+   static V SetAlternating(fft_type re, fft_type im)
+      { return _mm_setr_ps(re, im, re, im); }
+   static V SwapPairs(V v)
+      { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)); }
+   static V Add(V a, V b) { return _mm_add_ps(a, b); }
+   static V Sub(V a, V b) { return _mm_sub_ps(a, b); }
+   static V Mul(V a, V b) { return _mm_mul_ps(a, b); }
+   static V MulAdd(V a, V b, V c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+};
+}
+
+const Butterflies *SSE2Butterflies()
+{
+   static const auto result = MakeButterflies<SSE2Traits>();
+   return &result;
+}
+
+#else
+
+const Butterflies *SSE2Butterflies()
+{
+   return nullptr;
+}
+
+#endif
+
+#if defined(REALFFTF_NEON)
+
+namespace {
+struct NEONTraits {
+   using V = float32x4_t;
+   static constexpr size_t Width = 4;
+
+   static V Load(const fft_type *p) { return vld1q_f32(p); }
+   static void Store(fft_type *p, V v) { vst1q_f32(p, v); }
+   static V Set(fft_type x) { return vdupq_n_f32(x); }
+   static V SetAlternating(fft_type re, fft_type im)
+   {
+      const fft_type values[4]{ re, im, re, im };
+      return vld1q_f32(values);
+   }
+   static V SwapPairs(V v) { return vrev64q_f32(v); }
+   static V Add(V a, V b) { return vaddq_f32(a, b); }
+   static V Sub(V a, V b) { return vsubq_f32(a, b); }
+   static V Mul(V a, V b) { return vmulq_f32(a, b); }
+   static V MulAdd(V a, V b, V c) { return vmlaq_f32(c, a, b); }
+};
+}
+
+const Butterflies *NEONButterflies()
+{
+   static const auto result = MakeButterflies<NEONTraits>();
+   return &result;
+}
+
+#else
+
+const Butterflies *NEONButterflies()
+{
+   return nullptr;
+}
+
+#endif
+
+}
@@ -0,0 +1,141 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  FFTBenchmark.cpp
+
+  Times a forward and inverse real FFT with each RealFFTf kernel that the
+  machine supports, and with pffft for comparison.
+
+  Usage: fft-benchmark [seconds per measurement]
+
+**********************************************************************/
+#include "RealFFTf.h"
+#include "RealFFTfBatch.h"
+
+#include <pffft.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+//! @return nanoseconds per call of the function, after a warm up
+double Measure(double seconds, const std::function<void()> &function)
+{
+   function();
+   size_t iterations = 0;
+   const auto start = Clock::now();
+   const auto budget = std::chrono::duration<double>(seconds);
+   Clock::duration elapsed;
+   do {
+      for (int ii = 0; ii < 16; ++ii)
+         function();
+      iterations += 16;
+      elapsed = Clock::now() - start;
+   } while (elapsed < budget);
+   return std::chrono::duration<double, std::nano>(elapsed).count()
+      / iterations;
+}
+
+std::vector<float> RandomSignal(size_t size)
+{
+   std::mt19937 gen{ 0 };
+   std::uniform_real_distribution<float> dist{ -1, 1 };
+   std::vector<float> result(size);
+   for (auto &x : result)
+      x = dist(gen);
+   return result;
+}
+}
+
+int main(int argc, char *argv[])
+{
+   const double seconds = argc > 1 ? atof(argv[1]) : 0.2;
+   const auto defaultKernel = GetRealFFTfKernel();
+
+   printf("Forward + inverse real FFT, ns per transform pair\n");
+   printf("Default RealFFTf kernel: %s\n\n",
+      GetRealFFTfKernelName(defaultKernel));
+   printf("%8s", "size");
+   for (auto kernel : { RealFFTfKernel::Scalar, RealFFTfKernel::SSE2,
+      RealFFTfKernel::AVX2, RealFFTfKernel::NEON })
+      if (IsRealFFTfKernelSupported(kernel))
+         printf("%12s", GetRealFFTfKernelName(kernel));
+   printf("%12s%12s\n", "pffft", "pffft-ord");
+
+   for (size_t size = 64; size <= 65536; size *= 2) {
+      printf("%8zu", size);
+      const auto signal = RandomSignal(size);
+
+      const auto hFFT = GetFFT(size);
+      std::vector<fft_type> buffer(size);
+      for (auto kernel : { RealFFTfKernel::Scalar, RealFFTfKernel::SSE2,
+         RealFFTfKernel::AVX2, RealFFTfKernel::NEON }) {
+         if (!SetRealFFTfKernel(kernel))
+            continue;
+         printf("%12.0f", Measure(seconds, [&]{
+            buffer = signal;
+            RealFFTf(buffer.data(), hFFT.get());
+            InverseRealFFTf(buffer.data(), hFFT.get());
+         }));
+      }
+      SetRealFFTfKernel(defaultKernel);
+
+      const auto setup = pffft_new_setup(size, PFFFT_REAL);
+      const auto input =
+         static_cast<float*>(pffft_aligned_malloc(size * sizeof(float)));
+      const auto output =
+         static_cast<float*>(pffft_aligned_malloc(size * sizeof(float)));
+      const auto work =
+         static_cast<float*>(pffft_aligned_malloc(size * sizeof(float)));
+      std::copy(signal.begin(), signal.end(), input);
+      // The unordered transforms are comparable to RealFFTf, which also
+      // leaves its output in bit-reversed order
+      printf("%12.0f", Measure(seconds, [&]{
+         pffft_transform(setup, input, output, work, PFFFT_FORWARD);
+         pffft_transform(setup, output, output, work, PFFFT_BACKWARD);
+      }));
+      printf("%12.0f\n", Measure(seconds, [&]{
+         pffft_transform_ordered(setup, input, output, work, PFFFT_FORWARD);
+         pffft_transform_ordered(setup, output, output, work, PFFFT_BACKWARD);
+      }));
+      pffft_aligned_free(work);
+      pffft_aligned_free(output);
+      pffft_aligned_free(input);
+      pffft_destroy_setup(setup);
+   }
+
+   printf("\nWindowed forward FFT of 64 frames at 75%% overlap, "
+      "ns per frame\n");
+   printf("%8s%12s%12s\n", "size", "one-by-one", "batched");
+   for (size_t size = 64; size <= 8192; size *= 2) {
+      constexpr size_t nFrames = 64;
+      const auto hop = size / 4;
+      const auto signal = RandomSignal(size + (nFrames - 1) * hop);
+      std::vector<float> window(size, 0.5f);
+      std::vector<float> output(size * nFrames);
+      const auto hFFT = GetFFT(size);
+      printf("%8zu%12.0f", size, Measure(seconds, [&]{
+         for (size_t frame = 0; frame < nFrames; ++frame) {
+            const auto pOut = output.data() + frame * size;
+            const auto pIn = signal.data() + frame * hop;
+            for (size_t ii = 0; ii < size; ++ii)
+               pOut[ii] = pIn[ii] * window[ii];
+            RealFFTf(pOut, hFFT.get());
+         }
+      }) / nFrames);
+      RealFFTfBatch batch{ size, window.data() };
+      printf("%12.0f\n", Measure(seconds, [&]{
+         batch.Forward(signal.data(), hop, output.data(), size, nFrames);
+      }) / nFrames);
+   }
+   return 0;
+}
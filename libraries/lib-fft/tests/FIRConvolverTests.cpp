@@ -0,0 +1,77 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  FIRConvolverTests.cpp
+
+**********************************************************************/
+#include "FIRConvolver.h"
+
+#include <catch2/catch.hpp>
+
+#include <random>
+#include <vector>
+
+namespace {
+std::vector<float> Random(size_t len, unsigned seed)
+{
+   std::mt19937 gen{ seed };
+   std::uniform_real_distribution<float> dist{ -1, 1 };
+   std::vector<float> result(len);
+   for (auto &x : result)
+      x = dist(gen);
+   return result;
+}
+}
+
+TEST_CASE("FIRConvolver matches direct convolution")
+{
+   for (size_t impulseLen : { 1, 7, 64, 100, 1000 }) {
+      for (size_t blockSize : { 0, 16, 64, 256 }) {
+         const auto impulse = Random(impulseLen, impulseLen);
+         FIRConvolver convolver{ impulse.data(), impulseLen, blockSize };
+         const auto block = convolver.BlockSize();
+         INFO("length " << impulseLen << " block " << block);
+
+         const size_t nBlocks = 2 + 3000 / block;
+         const auto input = Random(nBlocks * block, 17);
+         std::vector<float> output(input.size());
+         for (size_t ii = 0; ii < nBlocks; ++ii)
+            convolver.ProcessBlock(&input[ii * block], &output[ii * block]);
+
+         for (size_t nn = 0; nn < input.size(); ++nn) {
+            double expected = 0;
+            for (size_t kk = 0; kk < impulseLen && kk <= nn; ++kk)
+               expected += impulse[kk] * input[nn - kk];
+            REQUIRE(output[nn] == Approx(expected).margin(1e-4));
+         }
+      }
+   }
+}
+
+TEST_CASE("FIRConvolver is independent of input before the lead-in")
+{
+   constexpr size_t impulseLen = 300, blockSize = 128;
+   const auto impulse = Random(impulseLen, 1);
+   const auto input = Random(8 * blockSize, 2);
+
+   // Begin filtering at the third block, from a reset state, and in place
+   FIRConvolver whole{ impulse.data(), impulseLen, blockSize };
+   FIRConvolver part{ impulse.data(), impulseLen, blockSize };
+   std::vector<float> expected(blockSize), actual(blockSize);
+   part.ProcessBlock(input.data(), actual.data());
+   part.Reset();
+   for (size_t ii = 0; ii < 8; ++ii) {
+      whole.ProcessBlock(&input[ii * blockSize], expected.data());
+      if (ii < 2)
+         continue;
+      std::copy(&input[ii * blockSize], &input[(ii + 1) * blockSize],
+         actual.begin());
+      part.ProcessBlock(actual.data(), actual.data());
+      // 300 samples of lead-in are complete by the fifth block
+      if (ii >= 5)
+         for (size_t jj = 0; jj < blockSize; ++jj)
+            REQUIRE(actual[jj] == Approx(expected[jj]).margin(1e-4));
+   }
+}
@@ -0,0 +1,56 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  RealFFTfBatchTests.cpp
+
+**********************************************************************/
+#include "RealFFTfBatch.h"
+
+#include <catch2/catch.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+TEST_CASE("RealFFTfBatch")
+{
+   const auto previous = GetRealFFTfKernel();
+   for (auto kernel : { RealFFTfKernel::Scalar, RealFFTfKernel::SSE2,
+      RealFFTfKernel::AVX2, RealFFTfKernel::NEON }) {
+      if (!SetRealFFTfKernel(kernel))
+         continue;
+      for (size_t fftLen : { 4, 16, 256, 2048 }) {
+         // Enough frames to leave some over after whole groups of lanes
+         constexpr size_t nFrames = 19;
+         const size_t hop = fftLen / 4;
+         INFO(GetRealFFTfKernelName(kernel) << " size " << fftLen);
+
+         std::mt19937 gen{ static_cast<unsigned>(fftLen) };
+         std::uniform_real_distribution<float> dist{ -1, 1 };
+         std::vector<float> input(fftLen + (nFrames - 1) * hop);
+         for (auto &x : input)
+            x = dist(gen);
+         std::vector<float> window(fftLen);
+         for (size_t ii = 0; ii < fftLen; ++ii)
+            window[ii] = 0.5 - 0.5 * cos(2 * M_PI * ii / fftLen);
+
+         RealFFTfBatch batch{ fftLen, window.data() };
+         std::vector<float> output(nFrames * fftLen);
+         batch.Forward(input.data(), hop, output.data(), fftLen, nFrames);
+
+         const auto hFFT = GetFFT(fftLen);
+         std::vector<float> expected(fftLen);
+         for (size_t frame = 0; frame < nFrames; ++frame) {
+            for (size_t ii = 0; ii < fftLen; ++ii)
+               expected[ii] = input[frame * hop + ii] * window[ii];
+            RealFFTf(expected.data(), hFFT.get());
+            for (size_t ii = 0; ii < fftLen; ++ii)
+               REQUIRE(output[frame * fftLen + ii] ==
+                  Approx(expected[ii]).margin(1e-5 * fftLen));
+         }
+      }
+   }
+   SetRealFFTfKernel(previous);
+}
@@ -0,0 +1,105 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  RealFFTfTests.cpp
+
+**********************************************************************/
+#include "RealFFTf.h"
+
+#include <catch2/catch.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+const auto allKernels = {
+   RealFFTfKernel::Scalar,
+   RealFFTfKernel::SSE2,
+   RealFFTfKernel::AVX2,
+   RealFFTfKernel::NEON,
+};
+
+std::vector<fft_type> RandomSignal(size_t size)
+{
+   std::mt19937 gen{ static_cast<unsigned>(size) };
+   std::uniform_real_distribution<fft_type> dist{ -1, 1 };
+   std::vector<fft_type> result(size);
+   for (auto &x : result)
+      x = dist(gen);
+   return result;
+}
+
+//! The spectrum in RealFFTf's packed, bit-reversed layout, by direct DFT
+std::vector<fft_type> ReferenceSpectrum(
+   const FFTParam &param, const std::vector<fft_type> &signal)
+{
+   const auto size = signal.size();
+   std::vector<fft_type> result(size);
+   for (size_t bin = 0; bin <= size / 2; ++bin) {
+      double re = 0, im = 0;
+      for (size_t ii = 0; ii < size; ++ii) {
+         const auto phase = 2 * M_PI * bin * ii / size;
+         re += signal[ii] * cos(phase);
+         im -= signal[ii] * sin(phase);
+      }
+      if (bin == 0)
+         result[0] = re;
+      else if (bin == size / 2)
+         result[1] = re;
+      else {
+         result[param.BitReversed[bin]] = re;
+         result[param.BitReversed[bin] + 1] = im;
+      }
+   }
+   return result;
+}
+
+struct KernelRestorer {
+   const RealFFTfKernel kernel = GetRealFFTfKernel();
+   ~KernelRestorer() { SetRealFFTfKernel(kernel); }
+};
+}
+
+TEST_CASE("RealFFTf kernels")
+{
+   KernelRestorer restorer;
+   REQUIRE(IsRealFFTfKernelSupported(RealFFTfKernel::Scalar));
+   REQUIRE(IsRealFFTfKernelSupported(GetRealFFTfKernel()));
+
+   for (auto kernel : allKernels) {
+      if (!SetRealFFTfKernel(kernel))
+         continue;
+      for (size_t size = 4; size <= 8192; size *= 2) {
+         INFO(GetRealFFTfKernelName(kernel) << " size " << size);
+         const auto hFFT = GetFFT(size);
+         const auto signal = RandomSignal(size);
+         const auto expected = ReferenceSpectrum(*hFFT, signal);
+         // Error of a float FFT grows like log2(size), and the reference
+         // is a sum of size terms
+         const auto tolerance = 1e-5 * size;
+
+         auto buffer = signal;
+         RealFFTf(buffer.data(), hFFT.get());
+         for (size_t ii = 0; ii < size; ++ii)
+            REQUIRE(buffer[ii] == Approx(expected[ii]).margin(tolerance));
+
+         // Round trip; the inverse takes the spectrum in natural order and
+         // divides by size
+         std::vector<fft_type> spectrum(size);
+         spectrum[0] = buffer[0];
+         spectrum[1] = buffer[1];
+         for (size_t bin = 1; bin < size / 2; ++bin) {
+            spectrum[2 * bin] = buffer[hFFT->BitReversed[bin]];
+            spectrum[2 * bin + 1] = buffer[hFFT->BitReversed[bin] + 1];
+         }
+         InverseRealFFTf(spectrum.data(), hFFT.get());
+         std::vector<fft_type> time(size);
+         ReorderToTime(hFFT.get(), spectrum.data(), time.data());
+         for (size_t ii = 0; ii < size; ++ii)
+            REQUIRE(time[ii] == Approx(signal[ii]).margin(1e-5));
+      }
+   }
+}
@@ -0,0 +1,97 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  RandomAccessFile.cpp
+
+**********************************************************************/
+#include "RandomAccessFile.h"
+
+#include <cstring>
+#include <limits>
+
+#include <wx/file.h>
+
+#include "FileException.h"
+
+#ifdef _WIN32
+#  include <io.h>
+#  include <windows.h>
+#else
+#  include <cerrno>
+#  include <unistd.h>
+#endif
+
+RandomAccessFile::RandomAccessFile(const FilePath &path)
+   : mPath{ path }
+{
+   // wxFile opens names that are not representable in the narrow encoding
+   wxFile file;
+   if (!file.Open(path))
+      throw FileException{ FileException::Cause::Open, path };
+
+   const auto length = file.Length();
+   if (length < 0 ||
+       static_cast<uint64_t>(length) > std::numeric_limits<size_t>::max())
+      throw FileException{ FileException::Cause::Read, path };
+   mSize = length;
+
+#ifdef _WIN32
+   if (mSize == 0)
+      return;
+   // The mapping keeps the file open after wxFile closes its descriptor
+   const auto handle = reinterpret_cast<HANDLE>(_get_osfhandle(file.fd()));
+   mMapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+   if (!mMapping)
+      throw FileException{ FileException::Cause::Read, path };
+   mData = static_cast<const uint8_t*>(
+      MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+   if (!mData) {
+      CloseHandle(mMapping);
+      throw FileException{ FileException::Cause::Read, path };
+   }
+#else
+   // Keep the descriptor that wxFile would close
+   mFd = file.fd();
+   file.Detach();
+#endif
+}
+
+RandomAccessFile::~RandomAccessFile()
+{
+#ifdef _WIN32
+   if (!mData)
+      return;
+   UnmapViewOfFile(mData);
+   CloseHandle(mMapping);
+#else
+   if (mFd >= 0)
+      close(mFd);
+#endif
+}
+
+void RandomAccessFile::Read(uint64_t offset, void *dest, size_t size) const
+{
+   if (size == 0)
+      return;
+#ifdef _WIN32
+   // The mapping keeps the file from being truncated
+   if (offset > mSize || size > mSize - offset)
+      throw FileException{ FileException::Cause::Read, mPath };
+   memcpy(dest, mData + offset, size);
+#else
+   auto buffer = static_cast<char*>(dest);
+   while (size > 0) {
+      const auto result = pread(mFd, buffer, size, offset);
+      if (result < 0 && errno == EINTR)
+         continue;
+      // Fewer bytes than the file had when opened
+      if (result <= 0)
+         throw FileException{ FileException::Cause::Read, mPath };
+      buffer += result;
+      offset += result;
+      size -= result;
+   }
+#endif
+}
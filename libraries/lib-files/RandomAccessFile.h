@@ -0,0 +1,52 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  RandomAccessFile.h
+
+**********************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Identifier.h"
+
+//! A read-only file that several threads may read at any offsets at once
+/*!
+ On Windows the whole file is mapped, which also keeps other processes from
+ truncating it.  Elsewhere reads use pread(), because touching a mapping past
+ the end of a file that another process truncated raises SIGBUS.
+ */
+class FILES_API RandomAccessFile final
+{
+public:
+   //! @throws FileException if the file can't be opened or mapped
+   explicit RandomAccessFile(const FilePath &path);
+   RandomAccessFile(const RandomAccessFile&) = delete;
+   RandomAccessFile &operator=(const RandomAccessFile&) = delete;
+   ~RandomAccessFile();
+
+   const FilePath &GetPath() const noexcept { return mPath; }
+
+   //! @return the size of the file when it was opened
+   uint64_t GetSize() const noexcept { return mSize; }
+
+   //! Copy size bytes at the offset
+   /*!
+    @throws FileException if not all of them can be read, as when the file is
+    now shorter
+    */
+   void Read(uint64_t offset, void *dest, size_t size) const;
+
+private:
+   const FilePath mPath;
+   uint64_t mSize{};
+#ifdef _WIN32
+   const uint8_t *mData{};
+   void *mMapping{};
+#else
+   int mFd{ -1 };
+#endif
+};
@@ -0,0 +1,87 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  BatchFileResult.cpp
+
+**********************************************************************/
+#include "BatchFileResult.h"
+
+namespace LibImportExport
+{
+namespace
+{
+wxString Escape(const wxString &text)
+{
+   wxString result;
+   for (const auto c : text)
+   {
+      if (c == '\\')
+         result += wxT("\\\\");
+      else if (c == '\t')
+         result += wxT("\\t");
+      else if (c == '\n')
+         result += wxT("\\n");
+      else if (c == '\r')
+         result += wxT("\\r");
+      else
+         result += c;
+   }
+   return result;
+}
+
+wxString Unescape(const wxString &text)
+{
+   wxString result;
+   for (size_t ii = 0; ii < text.length(); ++ii)
+   {
+      const auto c = text[ii];
+      if (c != '\\' || ii + 1 == text.length())
+      {
+         result += c;
+         continue;
+      }
+      const auto next = text[++ii];
+      if (next == 't')
+         result += '\t';
+      else if (next == 'n')
+         result += '\n';
+      else if (next == 'r')
+         result += '\r';
+      else
+         result += next;
+   }
+   return result;
+}
+} // namespace
+
+wxString FormatBatchFileResult(const BatchFileResult &result)
+{
+   // Not wxString::Format, which writes decimal separators of the locale
+   return BatchFileResultPrefix + (result.success ? wxT("1") : wxT("0")) +
+          wxT("\t") + wxString::FromCDouble(result.seconds, 6) + wxT("\t") +
+          Escape(result.message);
+}
+
+std::optional<BatchFileResult> ParseBatchFileResult(const wxString &line)
+{
+   // Messages can't hold the prefix, which has a tab
+   const auto position = line.rfind(BatchFileResultPrefix);
+   if (position == wxString::npos)
+      return {};
+   const auto fields = line.substr(position + BatchFileResultPrefix.length());
+
+   BatchFileResult result;
+   const auto success = fields.BeforeFirst('\t');
+   if (success != wxT("1") && success != wxT("0"))
+      return {};
+   result.success = success == wxT("1");
+
+   const auto rest = fields.AfterFirst('\t');
+   if (!rest.BeforeFirst('\t').ToCDouble(&result.seconds))
+      return {};
+   result.message = Unescape(rest.AfterFirst('\t'));
+   return result;
+}
+} // namespace LibImportExport
@@ -0,0 +1,45 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  BatchFileResult.h
+
+**********************************************************************/
+#pragma once
+
+#include <optional>
+#include <wx/string.h>
+
+namespace LibImportExport
+{
+//! What a worker process of "Apply Macro to Files" reports of one file to the
+//! process that started it
+struct BatchFileResult final
+{
+   bool success { false };
+   //! Time to import the file, apply the macro, and reset the project
+   double seconds { 0 };
+   //! Explains a failure
+   wxString message;
+};
+
+//! Begins each line of a result, so that the parent can tell results from
+//! whatever else libraries print to the standard output of the worker
+inline const wxString BatchFileResultPrefix = wxT("@audacity-batch-result@\t");
+
+//! @return the line, without the line break, that reports the result
+/*!
+ Fields are separated by tabs:  1 or 0 for success, seconds, and the message,
+ in which backslashes, tabs and line breaks are escaped
+ */
+IMPORT_EXPORT_API wxString FormatBatchFileResult(const BatchFileResult &result);
+
+//! @return the result that the line reports, or null if it reports none
+/*!
+ Text before BatchFileResultPrefix is ignored, as another library may have
+ printed part of a line just before the worker reported
+ */
+IMPORT_EXPORT_API std::optional<BatchFileResult>
+ParseBatchFileResult(const wxString &line);
+} // namespace LibImportExport
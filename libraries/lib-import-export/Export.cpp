@@ -15,9 +15,15 @@
 
 #include "Export.h"
 
+#include <atomic>
+#include <cmath>
+#include <future>
 #include <numeric>
+#include <optional>
 
 #include "BasicUI.h"
+#include "ExportFanOut.h"
+#include "ExportPluginHelpers.h"
 #include "ExportPluginRegistry.h"
 #include "Mix.h"
 #include "Project.h"
@@ -81,20 +87,78 @@ ExportTaskBuilder& ExportTaskBuilder::SetTags(const Tags *tags) noexcept
    return *this;
 }
 
-ExportTask ExportTaskBuilder::Build(AudacityProject& project)
+ExportTaskBuilder& ExportTaskBuilder::AddTarget(Target target)
+{
+   mTargets.push_back(std::move(target));
+   return *this;
+}
+
+namespace
 {
    //File rename stuff should be moved out to somewhere else...
-   auto filename = mFileName;
-
-   //For safety, if the file already exists we use temporary filename
-   //and replace original one export succeeded
-   int suffix = 0;
-   while (filename.FileExists()) {
-      filename.SetName(mFileName.GetName() +
-                        wxString::Format(wxT("%d"), suffix));
-      suffix++;
+   wxFileName GetActualFileName(const wxFileName& targetFilename)
+   {
+      auto filename = targetFilename;
+
+      //For safety, if the file already exists we use temporary filename
+      //and replace original one export succeeded
+      int suffix = 0;
+      while (filename.FileExists()) {
+         filename.SetName(targetFilename.GetName() +
+                           wxString::Format(wxT("%d"), suffix));
+         suffix++;
+      }
+      return filename;
+   }
+
+   ExportResult Process(ExportProcessor& processor,
+      ExportProcessorDelegate& delegate,
+      const wxFileName& actualFilename,
+      const wxFileName& targetFilename)
+   {
+      auto result = ExportResult::Error;
+      auto cleanup = finally( [&] {
+         if(result == ExportResult::Success || result == ExportResult::Stopped)
+         {
+            if (actualFilename != targetFilename)
+            {
+               //may fail...
+               ::wxRenameFile(actualFilename.GetFullPath(),
+                  targetFilename.GetFullPath(),
+                  true);
+            }
+         }
+         else
+            ::wxRemoveFile(actualFilename.GetFullPath());
+      } );
+      result = processor.Process(delegate);
+      return result;
    }
 
+   //! Gives one of several processors the state of the export, which the task
+   //! copies from its own delegate, and keeps its progress
+   class TargetDelegate final : public ExportProcessorDelegate
+   {
+   public:
+      std::atomic<bool> mCancelled {false};
+      std::atomic<bool> mStopped {false};
+      std::atomic<double> mProgress {};
+
+      bool IsCancelled() const override { return mCancelled; }
+      bool IsStopped() const override { return mStopped; }
+      // The task describes all the files at once
+      void SetStatusString(const TranslatableString&) override {}
+      void OnProgress(double progress) override { mProgress = progress; }
+   };
+
+   constexpr size_t MixBufferSize = 16384;
+}
+
+ExportTask ExportTaskBuilder::Build(AudacityProject& project)
+{
+   if (!mTargets.empty())
+      return BuildMany(project);
+
    auto processor = mPlugin->CreateProcessor(mFormat);
    if(!processor->Initialize(project,
       mParameters,
@@ -107,27 +171,135 @@ ExportTask ExportTaskBuilder::Build(AudacityProject& project)
       return ExportTask([](ExportProcessorDelegate&){ return ExportResult::Cancelled; });
    }
 
-   return ExportTask([actualFilename = filename,
+   return ExportTask([actualFilename = GetActualFileName(mFileName),
       targetFilename = mFileName,
       processor = std::shared_ptr<ExportProcessor>(processor.release())]
       (ExportProcessorDelegate& delegate)
       {
-         auto result = ExportResult::Error;
-         auto cleanup = finally( [&] {
-            if(result == ExportResult::Success || result == ExportResult::Stopped)
+         return Process(*processor, delegate, actualFilename, targetFilename);
+      });
+}
+
+ExportTask ExportTaskBuilder::BuildMany(AudacityProject& project)
+{
+   auto targets = mTargets;
+   targets.insert(targets.begin(), Target{
+      mFileName, mPlugin, mFormat, mParameters, mSampleRate, mNumChannels });
+
+   unsigned numChannels = 0;
+   double rate = 0;
+   for (auto& target : targets)
+   {
+      if (mMixerSpec)
+         target.numChannels = mMixerSpec->GetNumChannels();
+      numChannels = std::max(numChannels, target.numChannels);
+      rate = std::max(rate, target.sampleRate);
+   }
+
+   // Mix once for all when the processors can take the mix in place of the
+   // tracks, which needs the channels of the mix to be left and right
+   std::shared_ptr<ExportFanOut> fanOut;
+   if (numChannels <= 2)
+   {
+      // Begin at a sample of the mix, which the processors read without shift
+      const auto t0 = floor(mT0 * rate + 0.5) / rate;
+      fanOut = std::make_shared<ExportFanOut>(
+         ExportPluginHelpers::CreateMixer(TrackList::Get(project),
+            mSelectedOnly, t0, mT1,
+            numChannels, MixBufferSize, false,
+            rate, floatSample,
+            mMixerSpec),
+         rate, t0, mT1, targets.size());
+   }
+
+   struct Job
+   {
+      std::shared_ptr<ExportProcessor> processor;
+      wxFileName actualFilename;
+      wxFileName targetFilename;
+   };
+   std::vector<Job> jobs;
+   for (size_t i = 0; i < targets.size(); ++i)
+   {
+      const auto& target = targets[i];
+      std::optional<ExportPluginHelpers::SourceOverride> sourceOverride;
+      if (fanOut)
+         sourceOverride.emplace(fanOut->GetTap(i));
+      auto processor = target.plugin->CreateProcessor(target.format);
+      if(!processor->Initialize(project,
+         target.parameters,
+         target.fileName.GetFullPath(),
+         mT0, mT1, mSelectedOnly,
+         target.sampleRate, target.numChannels,
+         mMixerSpec,
+         mTags))
+      {
+         return ExportTask([](ExportProcessorDelegate&){ return ExportResult::Cancelled; });
+      }
+      jobs.push_back({ std::move(processor),
+         GetActualFileName(target.fileName), target.fileName });
+   }
+
+   return ExportTask([jobs = std::move(jobs), fanOut]
+      (ExportProcessorDelegate& delegate)
+      {
+         delegate.SetStatusString(
+            XO("Exporting the audio to %d files").Format(int(jobs.size())));
+
+         const auto delegates = std::make_unique<TargetDelegate[]>(jobs.size());
+         const auto update = [&]{
+            double progress = 0;
+            for (size_t i = 0; i < jobs.size(); ++i)
             {
-               if (actualFilename != targetFilename)
-               {
-                  //may fail...
-                  ::wxRenameFile(actualFilename.GetFullPath(),
-                     targetFilename.GetFullPath(),
-                     true);
-               }
+               delegates[i].mCancelled = delegate.IsCancelled();
+               delegates[i].mStopped = delegate.IsStopped();
+               progress += delegates[i].mProgress;
+            }
+            delegate.OnProgress(progress / jobs.size());
+         };
+
+         if (fanOut)
+            fanOut->Start();
+         std::vector<std::future<ExportResult>> results;
+         results.reserve(jobs.size());
+         try {
+            for (size_t i = 0; i < jobs.size(); ++i)
+               results.push_back(std::async(std::launch::async, [&, i]{
+                  // The mix need not wait any more for this processor
+                  auto detach = finally([&]{
+                     if (fanOut)
+                        fanOut->Detach(i);
+                  });
+                  const auto& job = jobs[i];
+                  return Process(*job.processor, delegates[i],
+                     job.actualFilename, job.targetFilename);
+               }));
+         }
+         catch (...) {
+            // Don't let the started processors wait for the others
+            for (auto i = results.size(); fanOut && i < jobs.size(); ++i)
+               fanOut->Detach(i);
+            throw;
+         }
+
+         auto result = ExportResult::Success;
+         std::exception_ptr exception;
+         for (auto& future : results)
+         {
+            while (future.wait_for(std::chrono::milliseconds(50)) !=
+               std::future_status::ready)
+               update();
+            try {
+               result = ExportUtils::WorstResult(result, future.get());
+            }
+            catch (...) {
+               result = ExportResult::Error;
+               if (!exception)
+                  exception = std::current_exception();
             }
-            else
-               ::wxRemoveFile(actualFilename.GetFullPath());
-         } );
-         result = processor->Process(delegate);
+         }
+         if (exception)
+            std::rethrow_exception(exception);
          return result;
       });
 }
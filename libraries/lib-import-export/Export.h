@@ -33,6 +33,18 @@ class IMPORT_EXPORT_API ExportTaskBuilder final
 {
 public:
 
+   //! Another file to export from the same mix, with its own format and rate
+   struct Target
+   {
+      wxFileName fileName;
+      const ExportPlugin* plugin{};
+      int format{};
+      ExportProcessor::Parameters parameters;
+      double sampleRate{44100};
+      //! Ignored when there is a mixer spec
+      unsigned numChannels{1};
+   };
+
    ExportTaskBuilder();
    ~ExportTaskBuilder();
    
@@ -44,10 +56,19 @@ public:
    ExportTaskBuilder& SetTags(const Tags* tags) noexcept;
    ExportTaskBuilder& SetSampleRate(double sampleRate) noexcept;
    ExportTaskBuilder& SetMixerSpec(MixerOptions::Downmix* mixerSpec) noexcept;
+   //! Export the same range also to the target
+   /*!
+    The tracks are then mixed only once, at the highest of the rates, and all
+    files are encoded at once, each converting that mix to its own rate.
+    (When any file needs more than two channels, each mixes for itself.)
+    */
+   ExportTaskBuilder& AddTarget(Target target);
    
    ExportTask Build(AudacityProject& project);
    
 private:
+   ExportTask BuildMany(AudacityProject& project);
+
    wxFileName mFileName;
    double mT0 {};
    double mT1 {};
@@ -59,6 +80,7 @@ private:
    int mFormat{};
    MixerOptions::Downmix* mMixerSpec{};//Should be const
    const Tags* mTags{};
+   std::vector<Target> mTargets;
 };
 
 void IMPORT_EXPORT_API ShowExportErrorDialog(const TranslatableString& message,
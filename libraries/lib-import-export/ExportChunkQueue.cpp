@@ -0,0 +1,38 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ExportChunkQueue.cpp
+
+**********************************************************************/
+#include "ExportChunkQueue.h"
+
+#include <atomic>
+
+namespace
+{
+std::atomic<size_t> sAcquired{ 0 };
+}
+
+size_t ExportChunkBudget::Capacity()
+{
+   return ExportChunkQueue<int>::DefaultConcurrency();
+}
+
+bool ExportChunkBudget::TryAcquire()
+{
+   const auto capacity = Capacity();
+   auto acquired = sAcquired.load(std::memory_order_relaxed);
+   do {
+      if (acquired >= capacity)
+         return false;
+   } while (!sAcquired.compare_exchange_weak(acquired, acquired + 1,
+      std::memory_order_relaxed));
+   return true;
+}
+
+void ExportChunkBudget::Release(size_t count)
+{
+   sAcquired.fetch_sub(count, std::memory_order_relaxed);
+}
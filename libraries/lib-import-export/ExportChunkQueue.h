@@ -0,0 +1,119 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ExportChunkQueue.h
+
+**********************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <future>
+
+#include "concurrency/ThreadPool.h"
+
+//! Shares among all exports of the process a number of chunks that may be
+//! pending beyond the first of each export
+/*!
+ So several exports at once, as of multiple files, hold not many more chunks
+ than one export alone
+ */
+class IMPORT_EXPORT_API ExportChunkBudget final
+{
+public:
+   //! Exporters make chunks of at most this many samples per channel, of at
+   //! most four bytes each
+   static constexpr size_t MaxChunkSamples = 1 << 20;
+
+   //! How many chunks all exports may have pending beyond their first
+   static size_t Capacity();
+
+   //! @return whether a chunk was granted, which must be released later
+   static bool TryAcquire();
+   static void Release(size_t count = 1);
+};
+
+//! Runs tasks that encode consecutive chunks of one export on several
+//! threads, and passes their results to a consumer in the order of the chunks
+/*!
+ Tasks run on the ThreadPool that the application shares, so Add() and
+ Finish(), which wait for tasks, must not be called from a task of that pool.
+ The consumer is called on the thread that adds the tasks, so it may write
+ to the file without locking.  At most a fixed number of tasks are pending at
+ once, and beyond the first, only while the ExportChunkBudget allows, which
+ bounds the memory held by samples not yet written.  An exception
+ from a task is thrown again to the caller of Add() or Finish().
+
+ @tparam Result what a task gives the consumer, such as encoded bytes
+ */
+template<typename Result>
+class ExportChunkQueue final
+{
+public:
+   using Consumer = std::function<void(Result)>;
+
+   //! The number of tasks worth running at once on this machine
+   static size_t DefaultConcurrency()
+   {
+      return audacity::concurrency::ThreadPool::Get().GetThreadCount();
+   }
+
+   /*!
+    @param maxPending at most this many tasks run or wait to be consumed
+    @param consumer receives results in the order the tasks were added
+    */
+   ExportChunkQueue(size_t maxPending, Consumer consumer)
+      : mMaxPending{ std::max<size_t>(1, maxPending) }
+      , mConsumer{ move(consumer) }
+   {
+   }
+   ExportChunkQueue(const ExportChunkQueue&) = delete;
+   ExportChunkQueue &operator=(const ExportChunkQueue&) = delete;
+
+   //! Waits for pending tasks and discards their results
+   ~ExportChunkQueue()
+   {
+      for (auto &pending : mPending)
+         if (pending.valid())
+            pending.wait();
+      if (!mPending.empty())
+         ExportChunkBudget::Release(mPending.size() - 1);
+   }
+
+   //! Start a task on the shared pool, first consuming the oldest results
+   //! while too many are pending
+   template<typename Task> void Add(Task &&task)
+   {
+      // The first pending task needs nothing from the budget, so that every
+      // export makes progress
+      while (mPending.size() >= mMaxPending ||
+         (!mPending.empty() && !ExportChunkBudget::TryAcquire()))
+         ConsumeOne();
+      mPending.push_back(audacity::concurrency::ThreadPool::Get().Async(
+         std::forward<Task>(task)));
+   }
+
+   //! Consume all pending results
+   void Finish()
+   {
+      while (!mPending.empty())
+         ConsumeOne();
+   }
+
+private:
+   void ConsumeOne()
+   {
+      auto pending = std::move(mPending.front());
+      mPending.pop_front();
+      if (!mPending.empty())
+         ExportChunkBudget::Release();
+      mConsumer(pending.get());
+   }
+
+   const size_t mMaxPending;
+   const Consumer mConsumer;
+   std::deque<std::future<Result>> mPending;
+};
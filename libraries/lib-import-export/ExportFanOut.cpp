@@ -0,0 +1,299 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ExportFanOut.cpp
+
+**********************************************************************/
+#include "ExportFanOut.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <optional>
+
+#include "Mix.h"
+#include "WideSampleSequence.h"
+
+namespace
+{
+//! Samples per channel kept for the taps, about 24 seconds at 44.1 kHz
+constexpr size_t Capacity = 1 << 20;
+//! A tap waits for at most this many samples at once, so that the mixer can
+//! always make them, however far behind the other taps are
+constexpr size_t MaxRead = Capacity / 4;
+}
+
+struct ExportFanOut::State
+{
+   State(std::unique_ptr<Mixer> mixer,
+      double rate, double startTime, double stopTime, size_t nTaps)
+      : mixer{ move(mixer) }
+      , nChannels{ this->mixer->NumChannels() }
+      , rate{ rate }
+      , offset{ sampleCount(floor(startTime * rate + 0.5)) }
+      , stopTime{ stopTime }
+      , effectiveFormat{ this->mixer->EffectiveFormat() }
+      , ring(nChannels, std::vector<float>(Capacity))
+      , starts(nTaps, sampleCount{ 0 })
+   {
+   }
+
+   //! The mixer may not write at or after the result; no result when all taps
+   //! are detached
+   std::optional<sampleCount> Limit() const
+   {
+      std::optional<sampleCount> result;
+      for (const auto &start : starts)
+         if (start && (!result || *start < *result))
+            result = *start;
+      if (result)
+         *result += Capacity;
+      return result;
+   }
+
+   //! Copy mixed samples of one channel, which must still be in the ring
+   void Copy(unsigned channel,
+      sampleCount from, size_t len, samplePtr dst, sampleFormat format) const
+   {
+      const auto position = size_t(from.as_long_long() % Capacity);
+      const auto first = std::min(len, Capacity - position);
+      const auto src = ring[channel].data();
+      CopySamples(reinterpret_cast<constSamplePtr>(src + position),
+         floatSample, dst, format, first, DitherType::none);
+      CopySamples(reinterpret_cast<constSamplePtr>(src),
+         floatSample, dst + first * SAMPLE_SIZE(format), format, len - first,
+         DitherType::none);
+   }
+
+   const std::unique_ptr<Mixer> mixer;
+   const unsigned nChannels;
+   const double rate;
+   //! Index at the rate of the mixer of its first sample
+   const sampleCount offset;
+   const double stopTime;
+   const sampleFormat effectiveFormat;
+   std::vector<std::vector<float>> ring;
+
+   std::mutex mutex;
+   std::condition_variable condition;
+   //! Count of samples mixed
+   sampleCount produced{ 0 };
+   //! For each tap, where its latest read starts, counting from the first
+   //! mixed sample; or nothing after it is detached
+   std::vector<std::optional<sampleCount>> starts;
+   bool finished{ false };
+   bool stopping{ false };
+   std::exception_ptr exception;
+};
+
+class ExportFanOut::Tap final : public WideSampleSequence
+{
+public:
+   Tap(std::shared_ptr<State> pState, size_t index)
+      : mpState{ move(pState) }
+      , mIndex{ index }
+   {
+   }
+
+   AudioGraph::ChannelType GetChannelType() const override
+   {
+      // As for WaveTrack, channels of a stereo sequence are not distinguished
+      return NChannels() == 1
+         ? AudioGraph::MonoChannel : AudioGraph::LeftChannel;
+   }
+
+   size_t NChannels() const override { return mpState->nChannels; }
+
+   // Gains and envelopes were applied when mixing
+   float GetChannelGain(int) const override { return 1.0f; }
+
+   bool DoGet(size_t iChannel, size_t nBuffers, const samplePtr buffers[],
+      sampleFormat format, sampleCount start, size_t len, bool backward,
+      fillFormat fill, bool mayThrow,
+      sampleCount* pNumWithinClips) const override;
+
+   double GetStartTime() const override
+   {
+      return mpState->offset.as_double() / mpState->rate;
+   }
+   double GetEndTime() const override { return mpState->stopTime; }
+   double GetRate() const override { return mpState->rate; }
+
+   sampleFormat WidestEffectiveFormat() const override
+   {
+      return mpState->effectiveFormat;
+   }
+
+   bool HasTrivialEnvelope() const override { return true; }
+
+   void GetEnvelopeValues(double* buffer, size_t bufferLen, double, bool)
+      const override
+   {
+      std::fill(buffer, buffer + bufferLen, 1.0);
+   }
+
+private:
+   const std::shared_ptr<State> mpState;
+   const size_t mIndex;
+};
+
+bool ExportFanOut::Tap::DoGet(size_t iChannel, size_t nBuffers,
+   const samplePtr buffers[], sampleFormat format, sampleCount start,
+   size_t len, bool backward, fillFormat, bool mayThrow,
+   sampleCount* pNumWithinClips) const
+{
+   // Mixer reads this forward
+   assert(!backward);
+   assert(iChannel + nBuffers <= NChannels());
+   auto &state = *mpState;
+   const auto size = SAMPLE_SIZE(format);
+   sampleCount numWithin = 0;
+   for (size_t done = 0; done < len;) {
+      const auto count = std::min(len - done, MaxRead);
+      const auto first = start + done - state.offset;
+      const auto last = first + count;
+      sampleCount produced;
+      std::exception_ptr exception;
+      {
+         std::unique_lock lock{ state.mutex };
+         // Earlier samples may now be overwritten
+         auto &myStart = state.starts[mIndex];
+         if (myStart && *myStart < first) {
+            myStart = first;
+            state.condition.notify_all();
+         }
+         state.condition.wait(lock, [&]{
+            return state.produced >= last || state.finished; });
+         produced = state.produced;
+         exception = state.exception;
+      }
+      if (exception && produced < last) {
+         for (size_t ii = 0; ii < nBuffers; ++ii)
+            ClearSamples(buffers[ii], format, 0, len);
+         if (mayThrow)
+            std::rethrow_exception(exception);
+         return false;
+      }
+      // Before the start of mixing, or after its end, is silence
+      const auto begin = std::min(std::max(first, sampleCount{ 0 }), last);
+      const auto end = std::max(begin, std::min(last, produced));
+      const auto before = (begin - first).as_size_t();
+      const auto within = (end - begin).as_size_t();
+      assert(end == begin || begin + Capacity >= produced);
+      for (size_t ii = 0; ii < nBuffers; ++ii) {
+         const auto buffer = buffers[ii];
+         ClearSamples(buffer, format, done, before);
+         state.Copy(iChannel + ii,
+            begin, within, buffer + (done + before) * size, format);
+         ClearSamples(buffer, format,
+            done + before + within, count - before - within);
+      }
+      numWithin += within;
+      done += count;
+   }
+   if (pNumWithinClips)
+      *pNumWithinClips = numWithin;
+   return true;
+}
+
+ExportFanOut::ExportFanOut(std::unique_ptr<Mixer> mixer, double rate,
+   double startTime, double stopTime, size_t nTaps)
+   : mState{ std::make_shared<State>(
+      move(mixer), rate, startTime, stopTime, nTaps) }
+{
+   assert(!mState->mixer->IsInterleaved());
+   assert(mState->mixer->Format() == floatSample);
+   assert(mState->mixer->BufferSize() <= Capacity - MaxRead);
+   mTaps.reserve(nTaps);
+   for (size_t ii = 0; ii < nTaps; ++ii)
+      mTaps.push_back(std::make_shared<Tap>(mState, ii));
+}
+
+ExportFanOut::~ExportFanOut()
+{
+   {
+      std::lock_guard lock{ mState->mutex };
+      mState->stopping = true;
+      if (!mThread.joinable())
+         mState->finished = true;
+   }
+   mState->condition.notify_all();
+   if (mThread.joinable())
+      mThread.join();
+}
+
+std::shared_ptr<const WideSampleSequence>
+ExportFanOut::GetTap(size_t iTap) const
+{
+   return mTaps[iTap];
+}
+
+void ExportFanOut::Start()
+{
+   assert(!mThread.joinable());
+   mThread = std::thread{ [&state = *mState]{ Run(state); } };
+}
+
+void ExportFanOut::Detach(size_t iTap)
+{
+   {
+      std::lock_guard lock{ mState->mutex };
+      mState->starts[iTap].reset();
+   }
+   mState->condition.notify_all();
+}
+
+void ExportFanOut::Run(State &state)
+{
+   auto &mixer = *state.mixer;
+   const auto bufferSize = mixer.BufferSize();
+   try {
+      while (true) {
+         sampleCount position;
+         {
+            std::unique_lock lock{ state.mutex };
+            state.condition.wait(lock, [&]{
+               const auto limit = state.Limit();
+               return state.stopping || !limit ||
+                  state.produced + bufferSize <= *limit;
+            });
+            if (state.stopping || !state.Limit())
+               break;
+            position = state.produced;
+         }
+         // Taps read nothing at or after position until produced counts it
+         const auto length = mixer.Process();
+         if (length == 0)
+            break;
+         for (unsigned channel = 0; channel < state.nChannels; ++channel) {
+            const auto src =
+               reinterpret_cast<const float*>(mixer.GetBuffer(channel));
+            const auto ringPosition =
+               size_t(position.as_long_long() % Capacity);
+            const auto first = std::min(length, Capacity - ringPosition);
+            auto &ring = state.ring[channel];
+            std::copy(src, src + first, ring.begin() + ringPosition);
+            std::copy(src + first, src + length, ring.begin());
+         }
+         {
+            std::lock_guard lock{ state.mutex };
+            state.produced += length;
+         }
+         state.condition.notify_all();
+      }
+   }
+   catch (...) {
+      std::lock_guard lock{ state.mutex };
+      state.exception = std::current_exception();
+   }
+   {
+      std::lock_guard lock{ state.mutex };
+      state.finished = true;
+   }
+   state.condition.notify_all();
+}
@@ -0,0 +1,73 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ExportFanOut.h
+
+**********************************************************************/
+#pragma once
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+class Mixer;
+class WideSampleSequence;
+
+//! Runs one Mixer on its own thread and shares its output with several
+//! readers, so that exports to several files mix the tracks only once
+/*!
+ Each reader is a "tap": a WideSampleSequence at the rate of the mixer, that
+ may be given to the Mixer of an export processor in place of the tracks.
+ Those mixers then convert rate, channels and format for their own files, on
+ their own threads.
+
+ The output of the mixer is kept in a ring buffer.  The mixer waits when it
+ would overwrite samples that a tap has not yet read, and a tap waits for
+ samples not yet mixed.  An exception from the mixer is thrown again in taps
+ that need samples after it.  Taps must read forward, as Mixer does, and each
+ tap must be detached when its reader is done, lest the others wait for it.
+ */
+class IMPORT_EXPORT_API ExportFanOut final
+{
+public:
+   /*!
+    @param mixer makes non-interleaved floatSample output
+    @param rate the output rate of the mixer
+    @param startTime the start time of the mixer, which should be a whole
+    number of samples at that rate
+    @param stopTime the end time of the taps
+    @param nTaps how many readers will share the output
+    @pre `mixer != nullptr`
+    */
+   ExportFanOut(std::unique_ptr<Mixer> mixer, double rate,
+      double startTime, double stopTime, size_t nTaps);
+   ExportFanOut(const ExportFanOut&) = delete;
+   ExportFanOut &operator=(const ExportFanOut&) = delete;
+   //! Stops the mixer; taps that read later get silence or the exception
+   ~ExportFanOut();
+
+   //! The sequence that the reader with the given index should mix
+   /*! It may outlive this object
+       @pre `iTap < nTaps` */
+   std::shared_ptr<const WideSampleSequence> GetTap(size_t iTap) const;
+
+   //! Start mixing on another thread; call it once
+   void Start();
+
+   //! The reader with the given index will read no more
+   /*! May be called from any thread */
+   void Detach(size_t iTap);
+
+private:
+   struct State;
+   class Tap;
+
+   //! The loop of the mixer thread
+   static void Run(State &state);
+
+   const std::shared_ptr<State> mState;
+   std::vector<std::shared_ptr<Tap>> mTaps;
+   std::thread mThread;
+};
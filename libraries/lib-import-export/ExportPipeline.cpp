@@ -0,0 +1,137 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ExportPipeline.cpp
+
+**********************************************************************/
+#include "ExportPipeline.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+#include "Mix.h"
+
+ExportPipeline::ExportPipeline(std::unique_ptr<Mixer> mixer, size_t depth)
+   : mMixer{ move(mixer) }
+   , mSlots(std::max<size_t>(2, depth))
+   , mTime{ mMixer->MixGetCurrentTime() }
+{
+   assert(depth >= 2);
+   const auto nBuffers = mMixer->IsInterleaved() ? 1 : mMixer->NumChannels();
+   const auto size = mMixer->BufferSize() *
+      (mMixer->IsInterleaved() ? mMixer->NumChannels() : 1);
+   for (auto &slot : mSlots) {
+      slot.buffers.reserve(nBuffers);
+      for (size_t ii = 0; ii < nBuffers; ++ii)
+         slot.buffers.emplace_back(size, mMixer->Format());
+   }
+}
+
+ExportPipeline::~ExportPipeline()
+{
+   {
+      std::lock_guard lock{ mMutex };
+      mStopping = true;
+   }
+   mCondition.notify_all();
+   if (mThread.joinable())
+      mThread.join();
+}
+
+size_t ExportPipeline::BufferSize() const
+{
+   return mMixer->BufferSize();
+}
+
+size_t ExportPipeline::Process()
+{
+   if (!mThread.joinable())
+      mThread = std::thread{ [this]{ Run(); } };
+
+   std::unique_lock lock{ mMutex };
+   // The encoder is done with the previous buffer
+   mReleased = mTaken;
+   mCurrent = nullptr;
+   mCondition.notify_all();
+   mCondition.wait(lock, [this]{ return mFilled > mTaken || mFinished; });
+   if (mFilled > mTaken) {
+      mCurrent = &mSlots[mTaken++ % mSlots.size()];
+      mTime = mCurrent->time;
+      return mCurrent->length;
+   }
+   if (mException)
+      std::rethrow_exception(std::exchange(mException, nullptr));
+   return 0;
+}
+
+constSamplePtr ExportPipeline::GetBuffer() const
+{
+   return mCurrent ? mCurrent->buffers[0].ptr() : nullptr;
+}
+
+constSamplePtr ExportPipeline::GetBuffer(int channel) const
+{
+   return mCurrent ? mCurrent->buffers[channel].ptr() : nullptr;
+}
+
+double ExportPipeline::MixGetCurrentTime() const
+{
+   return mTime;
+}
+
+void ExportPipeline::Run()
+{
+   // The mixer writes each slot in place, with the layout of its own buffers
+   const auto nChannels = mMixer->NumChannels();
+   const auto interleaved = mMixer->IsInterleaved();
+   const auto size = SAMPLE_SIZE(mMixer->Format());
+   std::vector<std::vector<Mixer::ChannelDestination>> destinations;
+   for (auto &slot : mSlots) {
+      auto &slotDestinations = destinations.emplace_back();
+      for (size_t c = 0; c < nChannels; ++c)
+         slotDestinations.push_back(interleaved
+            ? Mixer::ChannelDestination{
+               slot.buffers[0].ptr() + c * size, nChannels }
+            : Mixer::ChannelDestination{ slot.buffers[c].ptr(), 1 });
+   }
+   try {
+      while (true) {
+         size_t iSlot{};
+         Slot *pSlot{};
+         {
+            std::unique_lock lock{ mMutex };
+            mCondition.wait(lock, [this]{
+               return mStopping || mFilled - mReleased < mSlots.size();
+            });
+            if (mStopping)
+               break;
+            iSlot = mFilled % mSlots.size();
+            pSlot = &mSlots[iSlot];
+         }
+         // The slot is not shared until mFilled counts it
+         const auto length = mMixer->Process(
+            mMixer->BufferSize(), destinations[iSlot].data());
+         if (length == 0)
+            break;
+         pSlot->length = length;
+         pSlot->time = mMixer->MixGetCurrentTime();
+         {
+            std::lock_guard lock{ mMutex };
+            ++mFilled;
+         }
+         mCondition.notify_all();
+      }
+   }
+   catch (...) {
+      std::lock_guard lock{ mMutex };
+      mException = std::current_exception();
+   }
+   {
+      std::lock_guard lock{ mMutex };
+      mFinished = true;
+   }
+   mCondition.notify_all();
+}
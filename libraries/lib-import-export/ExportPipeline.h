@@ -0,0 +1,91 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ExportPipeline.h
+
+**********************************************************************/
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "SampleFormat.h"
+
+class Mixer;
+
+//! Runs a Mixer on its own thread, a few buffers ahead of the encoder
+/*!
+ Offers the part of the interface of Mixer that export processors use, so that
+ mixing of the next buffers overlaps encoding of the last one.  The mixer waits
+ when all buffers are full, and stops when the pipeline is destroyed, so an
+ export that is stopped or cancelled through ExportProcessorDelegate ends it
+ just by leaving its loop.
+
+ Process() and the other member functions must be called from one thread.
+ */
+class IMPORT_EXPORT_API ExportPipeline final
+{
+public:
+   /*!
+    @param depth how many buffers the mixer may fill before the encoder takes
+    them, counting the one the encoder holds
+    @pre `mixer != nullptr`
+    @pre `depth >= 2`
+    */
+   explicit ExportPipeline(std::unique_ptr<Mixer> mixer, size_t depth = 3);
+   ExportPipeline(const ExportPipeline&) = delete;
+   ExportPipeline &operator=(const ExportPipeline&) = delete;
+   //! Stops the mixer, discarding what it mixed ahead
+   ~ExportPipeline();
+
+   size_t BufferSize() const;
+
+   //! Waits for the next buffer, which stays valid until the next call
+   /*!
+    The mixer starts at the first call.  An exception thrown by the mixer is
+    thrown again here, after the buffers mixed before it.
+    @return number of output samples, or 0 at the end
+    */
+   size_t Process();
+
+   //! Retrieve the main buffer or the interleaved buffer
+   constSamplePtr GetBuffer() const;
+
+   //! Retrieve one of the non-interleaved buffers
+   constSamplePtr GetBuffer(int channel) const;
+
+   //! Time of the mixer at the end of the buffer last given by Process()
+   double MixGetCurrentTime() const;
+
+private:
+   struct Slot {
+      std::vector<SampleBuffer> buffers;
+      size_t length{ 0 };
+      double time{ 0 };
+   };
+
+   //! The loop of the mixer thread
+   void Run();
+
+   const std::unique_ptr<Mixer> mMixer;
+   std::vector<Slot> mSlots;
+   const Slot *mCurrent{};
+   double mTime;
+
+   std::mutex mMutex;
+   std::condition_variable mCondition;
+   //! Counts of slots filled by the mixer, taken by Process(), and given back
+   //! by the next Process(); slots are reused in a cycle
+   size_t mFilled{ 0 }, mTaken{ 0 }, mReleased{ 0 };
+   bool mFinished{ false };
+   bool mStopping{ false };
+   std::exception_ptr mException;
+
+   std::thread mThread;
+};
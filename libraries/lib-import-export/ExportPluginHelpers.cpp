@@ -16,9 +16,26 @@
 #include "WaveTrack.h"
 #include "MixAndRender.h"
 #include "ExportUtils.h"
+#include "ExportPipeline.h"
 #include "ExportPlugin.h"
 #include "StretchingSequence.h"
 
+namespace
+{
+   thread_local std::shared_ptr<const WideSampleSequence> sOverride;
+}
+
+ExportPluginHelpers::SourceOverride::SourceOverride(
+   std::shared_ptr<const WideSampleSequence> pSequence)
+   : mpPrevious{ std::exchange(sOverride, std::move(pSequence)) }
+{
+}
+
+ExportPluginHelpers::SourceOverride::~SourceOverride()
+{
+   sOverride = std::move(mpPrevious);
+}
+
 //Create a mixer by computing the time warp factor
 std::unique_ptr<Mixer> ExportPluginHelpers::CreateMixer(const TrackList &tracks,
          bool selectionOnly,
@@ -29,6 +46,20 @@ std::unique_ptr<Mixer> ExportPluginHelpers::CreateMixer(const TrackList &tracks,
 {
    Mixer::Inputs inputs;
 
+   if (sOverride)
+   {
+      // Only convert rate, channels and format; a stereo source is averaged
+      // for mono output
+      inputs.emplace_back(sOverride);
+      return std::make_unique<Mixer>(move(inputs),
+                  true,
+                  Mixer::WarpOptions{ 1.0, 1.0 },
+                  startTime, stopTime,
+                  numOutChannels, outBufferSize, outInterleaved,
+                  outRate, outFormat,
+                  true, nullptr, Mixer::ApplyGain::Mixdown);
+   }
+
    for (auto pTrack: ExportUtils::FindExportWaveTracks(tracks, selectionOnly))
       inputs.emplace_back(
          StretchingSequence::Create(*pTrack, pTrack->GetClipInterfaces()),
@@ -45,24 +76,48 @@ std::unique_ptr<Mixer> ExportPluginHelpers::CreateMixer(const TrackList &tracks,
                   mixerSpec ? Mixer::ApplyGain::MapChannels : Mixer::ApplyGain::Mixdown);
 }
 
+std::unique_ptr<ExportPipeline> ExportPluginHelpers::CreatePipeline(const TrackList &tracks,
+         bool selectionOnly,
+         double startTime, double stopTime,
+         unsigned numOutChannels, size_t outBufferSize, bool outInterleaved,
+         double outRate, sampleFormat outFormat,
+         MixerOptions::Downmix *mixerSpec)
+{
+   return std::make_unique<ExportPipeline>(CreateMixer(tracks, selectionOnly,
+      startTime, stopTime,
+      numOutChannels, outBufferSize, outInterleaved,
+      outRate, outFormat,
+      mixerSpec));
+}
+
 namespace
 {
-   double EvalExportProgress(Mixer &mixer, double t0, double t1)
+   double EvalExportProgress(double time, double t0, double t1)
    {
       const auto duration = t1 - t0;
       if(duration > 0)
-         return std::clamp(mixer.MixGetCurrentTime() - t0, .0, duration) / duration;
+         return std::clamp(time - t0, .0, duration) / duration;
       return .0;
    }
+
+   ExportResult UpdateProgress(ExportProcessorDelegate& delegate, double time, double t0, double t1)
+   {
+      delegate.OnProgress(EvalExportProgress(time, t0, t1));
+      if(delegate.IsStopped())
+         return ExportResult::Stopped;
+      if(delegate.IsCancelled())
+         return ExportResult::Cancelled;
+      return ExportResult::Success;
+   }
 }
 
 ExportResult ExportPluginHelpers::UpdateProgress(ExportProcessorDelegate& delegate, Mixer &mixer, double t0, double t1)
 {
-   delegate.OnProgress(EvalExportProgress(mixer, t0, t1));
-   if(delegate.IsStopped())
-      return ExportResult::Stopped;
-   if(delegate.IsCancelled())
-      return ExportResult::Cancelled;
-   return ExportResult::Success;
+   return ::UpdateProgress(delegate, mixer.MixGetCurrentTime(), t0, t1);
+}
+
+ExportResult ExportPluginHelpers::UpdateProgress(ExportProcessorDelegate& delegate, const ExportPipeline& pipeline, double t0, double t1)
+{
+   return ::UpdateProgress(delegate, pipeline.MixGetCurrentTime(), t0, t1);
 }
 
@@ -21,6 +21,8 @@
 class TrackList;
 class WaveTrack;
 class Mixer;
+class ExportPipeline;
+class WideSampleSequence;
 
 namespace MixerOptions
 {
@@ -32,6 +34,22 @@ class IMPORT_EXPORT_API ExportPluginHelpers final
 {
 public:
 
+   ///\brief While an object of this class exists, CreateMixer and
+   ///CreatePipeline on the same thread mix the given sequence in place of
+   ///the tracks.  It is already warped, processed by effects, and mapped to
+   ///channels, as when ExportTaskBuilder exports to several files at once.
+   class IMPORT_EXPORT_API SourceOverride final
+   {
+   public:
+      explicit SourceOverride(std::shared_ptr<const WideSampleSequence> pSequence);
+      SourceOverride(const SourceOverride&) = delete;
+      SourceOverride& operator=(const SourceOverride&) = delete;
+      ~SourceOverride();
+
+   private:
+      std::shared_ptr<const WideSampleSequence> mpPrevious;
+   };
+
    static std::unique_ptr<Mixer> CreateMixer(const TrackList &tracks,
          bool selectionOnly,
          double startTime, double stopTime,
@@ -39,9 +57,19 @@ public:
          double outRate, sampleFormat outFormat,
          MixerOptions::Downmix *mixerSpec);
 
+   ///\brief Like CreateMixer, but the mixer runs ahead on another thread, so
+   ///that mixing overlaps encoding
+   static std::unique_ptr<ExportPipeline> CreatePipeline(const TrackList &tracks,
+         bool selectionOnly,
+         double startTime, double stopTime,
+         unsigned numOutChannels, size_t outBufferSize, bool outInterleaved,
+         double outRate, sampleFormat outFormat,
+         MixerOptions::Downmix *mixerSpec);
+
    ///\brief Sends progress update to delegate and retrieves state update from it.
    ///Typically used inside each export iteration.
    static ExportResult UpdateProgress(ExportProcessorDelegate& delegate, Mixer& mixer, double t0, double t1);
+   static ExportResult UpdateProgress(ExportProcessorDelegate& delegate, const ExportPipeline& pipeline, double t0, double t1);
 
    template<typename T>
    static T GetParameterValue(const ExportProcessor::Parameters& parameters, int id, T defaultValue = T())
@@ -10,8 +10,13 @@
 
 #include "ExportProgressUI.h"
 
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include "Export.h"
 #include "ExportPlugin.h"
+#include "ExportUtils.h"
 #include "Internat.h"
 #include "BasicUI.h"
 #include "FileException.h"
@@ -75,6 +80,85 @@ namespace
       
    };
 
+   //! Runs one of several tasks, which take the state of the export from the
+   //! dialog and report their own progress and status
+   class ConcurrentTaskDelegate : public ExportProcessorDelegate
+   {
+      const ExportProcessorDelegate& mParent;
+      std::atomic<double> mProgress {};
+
+      mutable std::mutex mStatusMutex;
+      TranslatableString mStatus;
+   public:
+
+      explicit ConcurrentTaskDelegate(const ExportProcessorDelegate& parent)
+         : mParent(parent)
+      {
+      }
+
+      bool IsCancelled() const override
+      {
+         return mParent.IsCancelled();
+      }
+
+      bool IsStopped() const override
+      {
+         return mParent.IsStopped();
+      }
+
+      void SetStatusString(const TranslatableString& str) override
+      {
+         std::lock_guard<std::mutex> lock(mStatusMutex);
+         mStatus = str;
+      }
+
+      void OnProgress(double progress) override
+      {
+         mProgress = progress;
+      }
+
+      double GetProgress() const
+      {
+         return mProgress;
+      }
+
+      TranslatableString GetStatus() const
+      {
+         std::lock_guard<std::mutex> lock(mStatusMutex);
+         return mStatus;
+      }
+   };
+
+   struct ConcurrentTask final
+   {
+      ConcurrentTask(size_t index,
+         const ExportProcessorDelegate& parent,
+         ExportTask task)
+         : index(index)
+         , delegate(parent)
+         , result(task.get_future())
+         , thread(std::move(task), std::ref(delegate))
+      {
+      }
+
+      ~ConcurrentTask()
+      {
+         thread.join();
+      }
+
+      const size_t index;
+      ConcurrentTaskDelegate delegate;
+      std::future<ExportResult> result;
+      std::thread thread;
+   };
+
+   void ShowCompletedWithError()
+   {
+      BasicUI::ShowErrorDialog(
+         {}, XO("Export error"),
+         XO("Export completed with error."), {},
+         BasicUI::ErrorDialogOptions { BasicUI::ErrorDialogType::ModalError });
+   }
 }
 
 ExportResult ExportProgressUI::Show(ExportTask exportTask)
@@ -91,12 +175,76 @@ ExportResult ExportProgressUI::Show(ExportTask exportTask)
    ExceptionWrappedCall([&] { result = f.get(); });
 
    if(result == ExportResult::Error)
+      ShowCompletedWithError();
+
+   return result;
+}
+
+ExportResult ExportProgressUI::ShowConcurrent(size_t count,
+   size_t maxConcurrent,
+   const std::function<ExportTask(size_t)>& makeTask,
+   const std::function<void(size_t, ExportResult)>& onFinished)
+{
+   assert(maxConcurrent > 0);
+
+   DialogExportProgressDelegate delegate;
+   std::vector<std::unique_ptr<ConcurrentTask>> running;
+   auto result = ExportResult::Success;
+   size_t next = 0;
+   size_t finished = 0;
+
+   const auto finish = [&](size_t index, ExportResult taskResult)
    {
-      BasicUI::ShowErrorDialog(
-         {}, XO("Export error"),
-         XO("Export completed with error."), {},
-         BasicUI::ErrorDialogOptions { BasicUI::ErrorDialogType::ModalError });
+      result = ExportUtils::WorstResult(result, taskResult);
+      ++finished;
+      onFinished(index, taskResult);
+   };
+
+   while(true)
+   {
+      while(result == ExportResult::Success &&
+         !delegate.IsCancelled() && !delegate.IsStopped() &&
+         next < count && running.size() < maxConcurrent)
+      {
+         const auto index = next++;
+         ExportTask task;
+         ExceptionWrappedCall([&] { task = makeTask(index); });
+         if(task.valid())
+            running.push_back(std::make_unique<ConcurrentTask>(
+               index, delegate, std::move(task)));
+         else
+            finish(index, ExportResult::Error);
+      }
+      if(running.empty())
+         break;
+
+      running.front()->result.wait_for(std::chrono::milliseconds(50));
+      for(auto it = running.begin(); it != running.end();)
+      {
+         if((*it)->result.wait_for(std::chrono::seconds::zero()) !=
+            std::future_status::ready)
+         {
+            ++it;
+            continue;
+         }
+         const auto index = (*it)->index;
+         auto taskResult = ExportResult::Error;
+         ExceptionWrappedCall([&] { taskResult = (*it)->result.get(); });
+         it = running.erase(it);
+         finish(index, taskResult);
+      }
+
+      double progress = finished;
+      for(const auto& task : running)
+         progress += task->delegate.GetProgress();
+      delegate.OnProgress(progress / count);
+      if(!running.empty())
+         delegate.SetStatusString(running.front()->delegate.GetStatus());
+      delegate.UpdateUI();
    }
 
+   if(result == ExportResult::Error)
+      ShowCompletedWithError();
+
    return result;
 }
@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include <functional>
 #include <future>
 
 #include "Export.h"
@@ -25,6 +26,25 @@ namespace ExportProgressUI
 {
 IMPORT_EXPORT_API ExportResult Show(ExportTask exportTask);
 
+//! Runs several tasks, some at once, under one progress dialog
+/*!
+ Each task is made only when it can start, so that no more than
+ `maxConcurrent` exist at once; so are the resources their processors take.
+ Stopping or cancelling applies to all running tasks, and after any task ends
+ with a result other than ExportResult::Success, no more tasks are made.
+
+ @param makeTask called on this thread with indices from 0 in order; an
+ exception from it is reported, and counts as ExportResult::Error
+ @param onFinished called on this thread with the index and the result, when
+ each task that was made is done
+ @return the worst of the results, as in ExportUtils::WorstResult
+ @pre `maxConcurrent > 0`
+ */
+IMPORT_EXPORT_API ExportResult ShowConcurrent(size_t count,
+   size_t maxConcurrent,
+   const std::function<ExportTask(size_t)>& makeTask,
+   const std::function<void(size_t, ExportResult)>& onFinished);
+
 template <typename Callable>
 void ExceptionWrappedCall(Callable callable)
 {
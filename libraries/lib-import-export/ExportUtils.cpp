@@ -42,6 +42,15 @@ ExportProcessor::Parameters ExportUtils::ParametersFromEditor(const ExportOption
    return parameters;
 }
 
+ExportResult ExportUtils::WorstResult(ExportResult a, ExportResult b) noexcept
+{
+   for (auto result :
+      { ExportResult::Error, ExportResult::Cancelled, ExportResult::Stopped })
+      if (a == result || b == result)
+         return result;
+   return ExportResult::Success;
+}
+
 namespace
 {
 struct ExportHookElement final
@@ -31,6 +31,10 @@ public:
 
    static ExportProcessor::Parameters ParametersFromEditor(const ExportOptionsEditor& editor);
 
+   ///\brief The worse of two results of exports that ran together, in the
+   ///order Success, Stopped, Cancelled, Error
+   static ExportResult WorstResult(ExportResult a, ExportResult b) noexcept;
+
    enum class ExportHookResult
    {
       Handled, 
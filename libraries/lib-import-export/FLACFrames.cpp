@@ -0,0 +1,103 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  FLACFrames.cpp
+
+**********************************************************************/
+#include "FLACFrames.h"
+
+namespace LibImportExport
+{
+namespace
+{
+template<unsigned Bits, unsigned Polynomial> struct CrcTable
+{
+   CrcTable()
+   {
+      constexpr unsigned Top = 1u << (Bits - 1);
+      constexpr unsigned Mask = (Top << 1) - 1;
+      for (unsigned byte = 0; byte < 256; ++byte)
+      {
+         unsigned crc = byte << (Bits - 8);
+         for (int bit = 0; bit < 8; ++bit)
+            crc = ((crc & Top) ? (crc << 1) ^ Polynomial : crc << 1) & Mask;
+         values[byte] = crc;
+      }
+   }
+
+   unsigned operator()(const uint8_t* data, size_t size) const
+   {
+      constexpr unsigned Mask = (1u << Bits) - 1;
+      unsigned crc = 0;
+      while (size--)
+         crc = ((crc << 8) ^ values[((crc >> (Bits - 8)) ^ *data++) & 0xff]) &
+               Mask;
+      return crc;
+   }
+
+   unsigned values[256];
+};
+
+const CrcTable<8, 0x07> Crc8;
+const CrcTable<16, 0x8005> Crc16;
+} // namespace
+
+uint8_t FLACCrc8(const uint8_t* data, size_t size)
+{
+   return Crc8(data, size);
+}
+
+uint16_t FLACCrc16(const uint8_t* data, size_t size)
+{
+   return Crc16(data, size);
+}
+
+bool RenumberFLACFrame(std::vector<uint8_t>& frame, uint32_t number)
+{
+   // Sync code and fixed block size
+   if (frame.size() < 7 || frame[0] != 0xFF || frame[1] != 0xF8)
+      return false;
+   const auto blocksizeCode = frame[2] >> 4;
+   const auto sampleRateCode = frame[2] & 0x0F;
+
+   size_t numberLength = 1;
+   for (auto lead = frame[4]; lead & 0x80; lead <<= 1)
+      ++numberLength;
+   if (numberLength > 1)
+      --numberLength;
+   const size_t extraLength =
+      (blocksizeCode == 6 ? 1 : blocksizeCode == 7 ? 2 : 0) +
+      (sampleRateCode == 12                          ? 1 :
+       (sampleRateCode == 13 || sampleRateCode == 14) ? 2 :
+                                                        0);
+   // The header, its checksum, and the checksum of the frame
+   if (numberLength > 6 ||
+       4 + numberLength + extraLength + 1 + 2 > frame.size())
+      return false;
+   const auto extra = frame.begin() + 4 + numberLength;
+   const auto body = extra + extraLength + 1;
+
+   std::vector<uint8_t> result(frame.begin(), frame.begin() + 4);
+   if (number < 0x80)
+      result.push_back(number);
+   else
+   {
+      size_t length = 2;
+      while (length < 6 && number >= (1u << (5 * length + 1)))
+         ++length;
+      result.push_back((0xFF00 >> length) | (number >> (6 * (length - 1))));
+      for (auto shift = 6 * int(length - 2); shift >= 0; shift -= 6)
+         result.push_back(0x80 | ((number >> shift) & 0x3F));
+   }
+   result.insert(result.end(), extra, extra + extraLength);
+   result.push_back(Crc8(result.data(), result.size()));
+   result.insert(result.end(), body, frame.end() - 2);
+   const auto crc = Crc16(result.data(), result.size());
+   result.push_back(crc >> 8);
+   result.push_back(crc & 0xFF);
+   frame.swap(result);
+   return true;
+}
+} // namespace LibImportExport
@@ -0,0 +1,37 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  FLACFrames.h
+
+**********************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace LibImportExport
+{
+//! The checksum of a FLAC frame header, CRC-8 of polynomial 0x07
+IMPORT_EXPORT_API uint8_t FLACCrc8(const uint8_t* data, size_t size);
+
+//! The checksum of a whole FLAC frame, CRC-16 of polynomial 0x8005
+IMPORT_EXPORT_API uint16_t FLACCrc16(const uint8_t* data, size_t size);
+
+//! Give a frame of a stream of fixed block size another frame number
+/*!
+ Frames of such a stream do not depend on each other, so encodings of
+ consecutive chunks, each numbered from zero, join into one stream when their
+ frames are numbered again.  Frame numbers are coded like UTF-8, so the
+ length of the header may change, and both of its checksums are computed
+ again.
+
+ @param number less than 2^31
+ @return false, leaving the frame unchanged, if it does not begin with the
+ header of a frame of fixed block size
+ */
+IMPORT_EXPORT_API bool
+RenumberFLACFrame(std::vector<uint8_t>& frame, uint32_t number);
+} // namespace LibImportExport
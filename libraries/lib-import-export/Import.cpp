@@ -835,3 +835,5 @@ bool Importer::Import(
 }
 
 BoolSetting NewImportingSession{ L"/NewImportingSession", false };
+
+BoolSetting DeferPCMImport{ L"/FileFormats/DeferPCMImport", false };
@@ -204,4 +204,8 @@ public:
 
 extern IMPORT_EXPORT_API BoolSetting NewImportingSession;
 
+//! When true, tracks read samples from an imported uncompressed file until
+//! they are copied into the project during idle time, or when it is saved
+extern IMPORT_EXPORT_API BoolSetting DeferPCMImport;
+
 #endif
@@ -0,0 +1,198 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ImportStreamDecoders.h
+
+**********************************************************************/
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+//! Decodes the packets of each stream of an import on a thread of its own,
+//! and passes what they decode to a consumer on the importing thread
+/*!
+ The importing thread demuxes and pushes packets, and the consumer appends
+ to tracks, so only that thread touches tracks and the sample blocks behind
+ them.  It is called with the decodings of each stream in the order of the
+ packets, while Push() waits for room or in Finish(); decodings of different
+ streams interleave as they become ready.  Decoding thus overlaps appending,
+ even for one stream.
+
+ At most MaxPending packets wait to be decoded, and as many decodings to be
+ consumed, for each stream, which bounds the memory held by a stream that
+ decodes more slowly than the others, or faster than it is appended.  An
+ exception from a decoding is thrown again by Push() or Finish().
+
+ @tparam Packet what the importing thread demuxes
+ @tparam Decoded what a decoding thread makes of a packet
+ */
+template<typename Packet, typename Decoded>
+class ImportStreamDecoders final
+{
+public:
+   //! Called on the thread of the stream, with the index of the stream
+   using Decode = std::function<Decoded(size_t, Packet)>;
+   //! Called on the importing thread, with the index of the stream
+   using Consumer = std::function<void(size_t, Decoded)>;
+
+   static constexpr size_t MaxPending = 64;
+
+   ImportStreamDecoders(size_t nStreams, Decode decode, Consumer consumer)
+      : mDecode{ move(decode) }
+      , mConsumer{ move(consumer) }
+      , mStreams(nStreams)
+      , mRunning{ nStreams }
+   {
+      for (size_t stream = 0; stream < nStreams; ++stream)
+         mThreads.emplace_back([this, stream] { Run(stream); });
+   }
+   ImportStreamDecoders(const ImportStreamDecoders&) = delete;
+   ImportStreamDecoders &operator=(const ImportStreamDecoders&) = delete;
+
+   //! Discards the packets not yet decoded, and the decodings not consumed
+   ~ImportStreamDecoders()
+   {
+      {
+         std::lock_guard<std::mutex> lock{ mMutex };
+         mStopping = true;
+         for (auto& stream : mStreams)
+         {
+            stream.packets.clear();
+            stream.decoded.clear();
+         }
+      }
+      mCondition.notify_all();
+      for (auto& thread : mThreads)
+         thread.join();
+   }
+
+   //! Queue a packet of a stream, first consuming what is decoded while the
+   //! stream has too many packets waiting
+   void Push(size_t stream, Packet packet)
+   {
+      std::unique_lock<std::mutex> lock{ mMutex };
+      while (true)
+      {
+         if (mException)
+            std::rethrow_exception(mException);
+         if (ConsumeOne(lock))
+            continue;
+         if (mStreams[stream].packets.size() < MaxPending)
+            break;
+         mCondition.wait(lock);
+      }
+      mStreams[stream].packets.push_back(std::move(packet));
+      lock.unlock();
+      mCondition.notify_all();
+   }
+
+   //! Decode the packets that wait, and consume all that is decoded
+   void Finish()
+   {
+      std::unique_lock<std::mutex> lock{ mMutex };
+      mFinishing = true;
+      mCondition.notify_all();
+      while (true)
+      {
+         if (mException)
+            std::rethrow_exception(mException);
+         if (ConsumeOne(lock))
+            continue;
+         if (mRunning == 0)
+            break;
+         mCondition.wait(lock);
+      }
+   }
+
+private:
+   struct Stream
+   {
+      std::deque<Packet> packets;
+      std::deque<Decoded> decoded;
+   };
+
+   //! Pass the oldest decoding of a stream that has one to the consumer,
+   //! unlocking while it runs
+   //! @return whether there was one
+   bool ConsumeOne(std::unique_lock<std::mutex>& lock)
+   {
+      for (size_t stream = 0; stream < mStreams.size(); ++stream)
+      {
+         auto& queue = mStreams[stream].decoded;
+         if (queue.empty())
+            continue;
+         auto decoded = std::move(queue.front());
+         queue.pop_front();
+         lock.unlock();
+         mCondition.notify_all();
+         mConsumer(stream, std::move(decoded));
+         lock.lock();
+         return true;
+      }
+      return false;
+   }
+
+   void Run(size_t stream)
+   {
+      auto& queues = mStreams[stream];
+      std::unique_lock<std::mutex> lock{ mMutex };
+      while (true)
+      {
+         mCondition.wait(lock, [&] {
+            return mStopping || mFinishing || !queues.packets.empty();
+         });
+         if (mStopping || queues.packets.empty())
+            break;
+         auto packet = std::move(queues.packets.front());
+         queues.packets.pop_front();
+         lock.unlock();
+         mCondition.notify_all();
+
+         std::optional<Decoded> decoded;
+         try
+         {
+            decoded.emplace(mDecode(stream, std::move(packet)));
+         }
+         catch (...)
+         {
+            lock.lock();
+            if (!mException)
+               mException = std::current_exception();
+            break;
+         }
+
+         lock.lock();
+         mCondition.wait(lock, [&] {
+            return mStopping || queues.decoded.size() < MaxPending;
+         });
+         if (mStopping)
+            break;
+         queues.decoded.push_back(std::move(*decoded));
+         mCondition.notify_all();
+      }
+      --mRunning;
+      lock.unlock();
+      mCondition.notify_all();
+   }
+
+   const Decode mDecode;
+   const Consumer mConsumer;
+
+   std::mutex mMutex;
+   std::condition_variable mCondition;
+   std::vector<Stream> mStreams;
+   size_t mRunning;
+   bool mFinishing { false };
+   bool mStopping { false };
+   std::exception_ptr mException;
+   std::vector<std::thread> mThreads;
+};
@@ -0,0 +1,145 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  InterleavedPCM.cpp
+
+**********************************************************************/
+#include "InterleavedPCM.h"
+
+#include <cstring>
+
+#include <wx/ffile.h>
+
+#include "FileException.h"
+#include "SampleFormat.h"
+
+namespace LibImportExport
+{
+std::optional<SampleFileRange::Layout>
+FindPCMSamples(const FilePath &path, const SF_INFO &info)
+{
+   SampleFileRange::Layout layout;
+   switch (info.format & SF_FORMAT_SUBMASK) {
+   case SF_FORMAT_PCM_16:
+      layout.encoding = SampleFileRange::Encoding::Int16;
+      break;
+   case SF_FORMAT_PCM_24:
+      layout.encoding = SampleFileRange::Encoding::Int24;
+      break;
+   case SF_FORMAT_FLOAT:
+      layout.encoding = SampleFileRange::Encoding::Float32;
+      break;
+   default:
+      return {};
+   }
+   layout.stride =
+      info.channels * SampleFileRange::GetEncodedSize(layout.encoding);
+
+   const auto type = info.format & SF_FORMAT_TYPEMASK;
+   if (type != SF_FORMAT_WAV && type != SF_FORMAT_WAVEX &&
+       type != SF_FORMAT_RF64 && type != SF_FORMAT_W64 &&
+       type != SF_FORMAT_AIFF)
+      return {};
+
+   wxFFile f(path, wxT("rb"));
+   if (!f.IsOpened())
+      return {};
+
+   const auto matches = [](const char *id, const char *expected) {
+      return memcmp(id, expected, 4) == 0;
+   };
+
+   if (type == SF_FORMAT_W64) {
+      // Chunks have GUIDs for ids, beginning with the familiar names, and
+      // 64-bit little-endian sizes that include the 24 byte chunk header
+      char header[40];
+      if (f.Read(header, sizeof(header)) != sizeof(header) ||
+          !matches(header, "riff") || !matches(header + 24, "wave"))
+         return {};
+      char guid[16];
+      wxUint64 len;
+      while (f.Read(guid, 16) == 16 && f.Read(&len, 8) == 8) {
+         len = wxUINT64_SWAP_ON_BE(len);
+         if (matches(guid, "data")) {
+            layout.offset = f.Tell();
+            return layout;
+         }
+         // Chunks are padded to a multiple of 8 bytes
+         if (len < 24 ||
+             !f.Seek(((len + 7) & ~wxUint64{ 7 }) - 24, wxFromCurrent))
+            break;
+      }
+      return {};
+   }
+
+   char header[12];
+   if (f.Read(header, sizeof(header)) != sizeof(header))
+      return {};
+   // Reject AIFC, which may compress, or store little-endian samples
+   const char *dataID;
+   if ((matches(header, "RIFF") || matches(header, "RF64") ||
+        matches(header, "BW64")) && matches(header + 8, "WAVE"))
+      dataID = "data";
+   else if (matches(header, "RIFX") && matches(header + 8, "WAVE"))
+      dataID = "data", layout.bigEndian = true;
+   else if (matches(header, "FORM") && matches(header + 8, "AIFF"))
+      dataID = "SSND", layout.bigEndian = true;
+   else
+      return {};
+   if (layout.encoding == SampleFileRange::Encoding::Float32 &&
+       layout.bigEndian)
+      return {};
+
+   // The data chunk of RF64 has a placeholder size, but the ds64 chunk that
+   // holds its true size comes first and is skipped like any other
+   char id[4];
+   wxUint32 len;
+   while (f.Read(id, 4) == 4 && f.Read(&len, 4) == 4) {
+      len = layout.bigEndian
+         ? wxUINT32_SWAP_ON_LE(len) : wxUINT32_SWAP_ON_BE(len);
+      if (matches(id, dataID)) {
+         wxFileOffset offset = f.Tell();
+         if (matches(dataID, "SSND")) {
+            // Skip the offset and block size fields, and then the offset
+            wxUint32 skip;
+            if (f.Read(&skip, 4) != 4)
+               return {};
+            offset += 8 + wxUINT32_SWAP_ON_LE(skip);
+         }
+         layout.offset = offset;
+         return layout;
+      }
+      // Chunks are padded to even length
+      if (!f.Seek(len + (len & 0x01), wxFromCurrent))
+         break;
+   }
+   return {};
+}
+
+InterleavedPCMReader::InterleavedPCMReader(const FilePath &path,
+   const SampleFileRange::Layout &layout, size_t channels,
+   uint64_t frames, size_t maxBlock)
+   : mFile{ path }
+   , mLayout{ layout }
+   , mChannels{ channels }
+   // Read whole frames at once, rather than each channel's samples apart
+   , mBytes(maxBlock * layout.stride)
+{
+   if (mFile.GetSize() < layout.offset ||
+       (mFile.GetSize() - layout.offset) / layout.stride < frames)
+      throw FileException{ FileException::Cause::Read, path };
+}
+
+void InterleavedPCMReader::Read(std::vector<SampleBuffer> &dest,
+   sampleFormat format, uint64_t start, size_t len)
+{
+   mFile.Read(mLayout.offset + start * mLayout.stride,
+      mBytes.data(), len * mLayout.stride);
+   const auto sampleSize = SampleFileRange::GetEncodedSize(mLayout.encoding);
+   for (size_t c = 0; c < mChannels; ++c)
+      SampleFileRange::Decode(mLayout, mBytes.data() + c * sampleSize,
+         dest[c].ptr(), format, len);
+}
+} // namespace LibImportExport
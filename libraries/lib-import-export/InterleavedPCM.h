@@ -0,0 +1,66 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  InterleavedPCM.h
+
+**********************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// SNDFILE is defined differently between libsndfile versions
+#include <sndfile.h>
+
+#include "RandomAccessFile.h"
+#include "SampleFileRange.h"
+
+class SampleBuffer;
+
+namespace LibImportExport
+{
+//! Find where a WAV, W64, RF64 or AIFF file stores its samples, if they are
+//! in a layout that SampleFileRange can read in place
+/*!
+ The layout describes the first channel; the others follow it in each frame.
+ AIFC, which may compress or store little-endian samples, and big-endian
+ float are not found.
+ */
+IMPORT_EXPORT_API std::optional<SampleFileRange::Layout>
+FindPCMSamples(const FilePath &path, const SF_INFO &info);
+
+//! Reads blocks of whole frames that FindPCMSamples() located, and
+//! deinterleaves their channels, bypassing the staging buffer of libsndfile
+class IMPORT_EXPORT_API InterleavedPCMReader final
+{
+public:
+   /*!
+    @param layout as FindPCMSamples() returned
+    @param frames that the file must hold
+    @param maxBlock the most frames that one Read() copies
+    @throws FileException if the file can't be opened or is too short
+    */
+   InterleavedPCMReader(const FilePath &path,
+      const SampleFileRange::Layout &layout, size_t channels,
+      uint64_t frames, size_t maxBlock);
+
+   //! Copy frames [start, start + len) into a buffer for each channel,
+   //! converting them to format without dither
+   /*!
+    @pre `len <= maxBlock`, and dest has a buffer for each channel, of at
+    least len samples of format
+    @throws FileException if the file is now too short
+    */
+   void Read(std::vector<SampleBuffer> &dest, sampleFormat format,
+      uint64_t start, size_t len);
+
+private:
+   const RandomAccessFile mFile;
+   const SampleFileRange::Layout mLayout;
+   const size_t mChannels;
+   std::vector<uint8_t> mBytes;
+};
+} // namespace LibImportExport
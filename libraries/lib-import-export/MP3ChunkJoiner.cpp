@@ -0,0 +1,250 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  MP3ChunkJoiner.cpp
+
+**********************************************************************/
+#include "MP3ChunkJoiner.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+
+namespace LibImportExport
+{
+namespace
+{
+// Offsets in the Xing or Info tag, which follows the side information
+constexpr size_t XingFlags = 4;
+constexpr size_t XingFrames = 8;
+constexpr size_t XingBytes = 12;
+constexpr size_t XingTOC = 16;
+constexpr size_t XingTOCSize = 100;
+constexpr size_t LameExtension = 120;
+
+// Offsets in the LAME extension of the tag
+constexpr size_t LameDelayAndPadding = 21;
+constexpr size_t LameMusicLength = 28;
+constexpr size_t LameMusicCRC = 32;
+constexpr size_t LameTagCRC = 34;
+
+uint32_t GetBE(const uint8_t* data, size_t size)
+{
+   uint32_t result = 0;
+   for (size_t ii = 0; ii < size; ++ii)
+      result = (result << 8) | data[ii];
+   return result;
+}
+
+void PutBE(uint8_t* data, size_t size, uint32_t value)
+{
+   for (size_t ii = size; ii-- > 0; value >>= 8)
+      data[ii] = value & 0xFF;
+}
+
+//! The CRC-16 that LAME computes for the tag and the music
+uint16_t UpdateCRC(uint16_t crc, const uint8_t* data, size_t size)
+{
+   static const auto table = [] {
+      std::array<uint16_t, 256> table {};
+      for (unsigned ii = 0; ii < table.size(); ++ii)
+      {
+         unsigned value = ii;
+         for (int bit = 0; bit < 8; ++bit)
+            value = (value & 1) ? (value >> 1) ^ 0xA001 : value >> 1;
+         table[ii] = value;
+      }
+      return table;
+   }();
+   for (size_t ii = 0; ii < size; ++ii)
+      crc = (crc >> 8) ^ table[(crc ^ data[ii]) & 0xFF];
+   return crc;
+}
+
+//! Sum with a difference that may be negative, limited to what a tag holds
+uint32_t Adjust(uint32_t value, uint64_t subtract, uint64_t add)
+{
+   const auto result = static_cast<int64_t>(value) -
+      static_cast<int64_t>(subtract) + static_cast<int64_t>(add);
+   return static_cast<uint32_t>(std::clamp<int64_t>(
+      result, 0, std::numeric_limits<uint32_t>::max()));
+}
+} // namespace
+
+std::optional<MP3FrameHeader>
+ParseMP3FrameHeader(const uint8_t* data, size_t size)
+{
+   static const unsigned mpeg1Rates[] = { 0,   32,  40,  48,  56,
+                                          64,  80,  96,  112, 128,
+                                          160, 192, 224, 256, 320 };
+   static const unsigned mpeg2Rates[] = { 0,  8,  16, 24,  32,  40,  48, 56,
+                                          64, 80, 96, 112, 128, 144, 160 };
+   static const unsigned sampleRates[] = { 44100, 48000, 32000 };
+
+   if (size < 4 || data[0] != 0xFF || (data[1] & 0xE0) != 0xE0)
+      return {};
+   const unsigned version = (data[1] >> 3) & 0x03;
+   const unsigned layer = (data[1] >> 1) & 0x03;
+   const unsigned bitrateIndex = data[2] >> 4;
+   const unsigned rateIndex = (data[2] >> 2) & 0x03;
+   const unsigned padding = (data[2] >> 1) & 0x01;
+   const bool mono = (data[3] >> 6) == 0x03;
+   // Reject reserved values, free format, and layers other than III
+   if (version == 1 || layer != 1 || bitrateIndex == 0 ||
+       bitrateIndex == 15 || rateIndex == 3)
+      return {};
+
+   const bool mpeg1 = version == 3;
+   // MPEG 2 halves the rate of MPEG 1, and MPEG 2.5 halves it again
+   const auto sampleRate =
+      sampleRates[rateIndex] >> (mpeg1 ? 0 : version == 2 ? 1 : 2);
+   const auto bitrate =
+      (mpeg1 ? mpeg1Rates : mpeg2Rates)[bitrateIndex] * 1000;
+
+   MP3FrameHeader header;
+   header.samplesPerFrame = mpeg1 ? 1152 : 576;
+   header.frameSize =
+      header.samplesPerFrame / 8 * bitrate / sampleRate + padding;
+   header.sideInfoSize = mpeg1 ? (mono ? 17 : 32) : (mono ? 9 : 17);
+   return header;
+}
+
+size_t MP3ChunkJoiner::SamplesPerFrame(int sampleRate)
+{
+   return sampleRate >= 32000 ? 1152 : 576;
+}
+
+auto MP3ChunkJoiner::PlanChunk(uint64_t firstFrame,
+   std::optional<size_t> frames, size_t samplesPerFrame) -> Chunk
+{
+   const auto before = std::min<uint64_t>(firstFrame, Overlap);
+   Chunk chunk;
+   chunk.inputStart = (firstFrame - before) * samplesPerFrame;
+   chunk.inputEnd = frames
+      ? (firstFrame + *frames + Overlap) * samplesPerFrame
+      : std::numeric_limits<uint64_t>::max();
+   chunk.dropFrames = before;
+   chunk.keepFrames = frames;
+   return chunk;
+}
+
+std::optional<std::vector<uint8_t>>
+MP3ChunkJoiner::Join(const std::vector<uint8_t>& encoding, const Chunk& chunk)
+{
+   const auto data = encoding.data();
+   std::vector<size_t> offsets;
+   for (size_t pos = 0; pos < encoding.size();)
+   {
+      const auto header =
+         ParseMP3FrameHeader(data + pos, encoding.size() - pos);
+      if (!header || header->frameSize > encoding.size() - pos ||
+          (mSamplesPerFrame && header->samplesPerFrame != mSamplesPerFrame))
+         return {};
+      mSamplesPerFrame = header->samplesPerFrame;
+      offsets.push_back(pos);
+      pos += header->frameSize;
+   }
+   offsets.push_back(encoding.size());
+   const size_t frames = offsets.size() - 1;
+
+   std::vector<uint8_t> result;
+   size_t first = 0;
+   if (!mFirst)
+   {
+      if (frames == 0)
+         return {};
+      mInfoFrameSize = offsets[1];
+      mFirst = FirstEncoding {
+         encoding.size(), frames - 1,
+         UpdateCRC(
+            0, data + mInfoFrameSize, encoding.size() - mInfoFrameSize),
+         UpdateCRC(0, data, encoding.size())
+      };
+      result.assign(data, data + mInfoFrameSize);
+      mBytes = mInfoFrameSize;
+      mCRCWithInfoFrame = UpdateCRC(0, data, mInfoFrameSize);
+      first = 1;
+   }
+
+   const auto begin = first + chunk.dropFrames;
+   const auto end = chunk.keepFrames ? begin + *chunk.keepFrames : frames;
+   if (end > frames)
+      return {};
+
+   for (auto ii = begin; ii < end; ++ii)
+      mFrameOffsets.push_back(mBytes + offsets[ii] - offsets[begin]);
+   const auto kept = data + offsets[begin];
+   const auto keptSize = offsets[end] - offsets[begin];
+   result.insert(result.end(), kept, kept + keptSize);
+   mBytes += keptSize;
+   mCRC = UpdateCRC(mCRC, kept, keptSize);
+   mCRCWithInfoFrame = UpdateCRC(mCRCWithInfoFrame, kept, keptSize);
+   return result;
+}
+
+bool MP3ChunkJoiner::FixInfoTag(
+   std::vector<uint8_t>& tag, uint64_t totalSamples) const
+{
+   if (!mFirst)
+      return false;
+   const auto header = ParseMP3FrameHeader(tag.data(), tag.size());
+   if (!header || header->frameSize > tag.size())
+      return false;
+
+   const auto xing = tag.data() + 4 + header->sideInfoSize;
+   const auto lame = xing + LameExtension;
+   if (lame + LameTagCRC + 2 > tag.data() + header->frameSize ||
+       (memcmp(xing, "Info", 4) != 0 && memcmp(xing, "Xing", 4) != 0) ||
+       // Frames, bytes and TOC must all be present, to find the extension
+       (GetBE(xing + XingFlags, 4) & 0x07) != 0x07 ||
+       memcmp(lame, "LAME", 4) != 0)
+      return false;
+
+   // The encoder may have counted the info frame, or other data such as
+   // ID3 tags, in the totals; the differences from its totals for the first
+   // chunk tell
+   const auto frames = GetFrameCount();
+   PutBE(xing + XingFrames, 4,
+      Adjust(GetBE(xing + XingFrames, 4), mFirst->frames, frames));
+   const auto bytes =
+      Adjust(GetBE(xing + XingBytes, 4), mFirst->bytes, mBytes);
+   PutBE(xing + XingBytes, 4, bytes);
+   PutBE(lame + LameMusicLength, 4,
+      Adjust(GetBE(lame + LameMusicLength, 4), mFirst->bytes, mBytes));
+
+   // Fraction of the bytes before the frame at each percent of the time
+   const uint64_t skipped = bytes > mBytes ? bytes - mBytes : 0;
+   for (size_t ii = 0; ii < XingTOCSize; ++ii)
+   {
+      const auto frame = ii * frames / XingTOCSize;
+      const auto offset =
+         skipped + (frame < frames ? mFrameOffsets[frame] : mBytes);
+      xing[XingTOC + ii] = static_cast<uint8_t>(std::min<uint64_t>(
+         255, bytes ? 256 * offset / bytes : 0));
+   }
+
+   // The delay is the same for all encoders; the padding at the end is what
+   // the last frames make beyond the delayed input
+   const auto delayAndPadding = lame + LameDelayAndPadding;
+   const auto delay =
+      (delayAndPadding[0] << 4) | (delayAndPadding[1] >> 4);
+   const auto length = static_cast<uint64_t>(frames) * mSamplesPerFrame;
+   if (length < delay + totalSamples ||
+       length - delay - totalSamples > 0xFFF)
+      return false;
+   const auto padding = length - delay - totalSamples;
+   delayAndPadding[1] = ((delay & 0x0F) << 4) | (padding >> 8);
+   delayAndPadding[2] = padding & 0xFF;
+
+   const auto musicCRC = GetBE(lame + LameMusicCRC, 2);
+   PutBE(lame + LameMusicCRC, 2,
+      musicCRC == mFirst->crcWithInfoFrame && musicCRC != mFirst->crc
+         ? mCRCWithInfoFrame : mCRC);
+   PutBE(lame + LameTagCRC, 2,
+      UpdateCRC(0, tag.data(), lame + LameTagCRC - tag.data()));
+   return true;
+}
+} // namespace LibImportExport
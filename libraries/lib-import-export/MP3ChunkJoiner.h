@@ -0,0 +1,113 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  MP3ChunkJoiner.h
+
+**********************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace LibImportExport
+{
+//! What the four byte header of an MPEG Layer III frame says
+struct MP3FrameHeader final
+{
+   //! Bytes in the frame, including the header
+   size_t frameSize {};
+   size_t samplesPerFrame {};
+   //! Bytes of side information, which follow the header
+   size_t sideInfoSize {};
+};
+
+//! @return null if data does not begin with the header of a Layer III frame
+IMPORT_EXPORT_API std::optional<MP3FrameHeader>
+ParseMP3FrameHeader(const uint8_t* data, size_t size);
+
+//! Joins the encodings of consecutive chunks of one input, which separate
+//! LAME encoders made at once, into the stream that one encoder would make
+/*!
+ Encoders of the same settings have the same delay, so frame j of the
+ encoding of input that starts at frame a of the input is frame a + j of the
+ whole stream.  Each chunk's encoder also sees Overlap frames of input before
+ and after the chunk, so that the frames kept from it are encoded as if the
+ encoder had seen all of the input.  Chunks must be encoded without the bit
+ reservoir, so that no frame kept refers to data in a frame dropped.
+
+ Chunks must be passed to Join() in order.  The encoder of the first chunk
+ alone writes a LAME info tag, and its encoding begins with a frame reserved
+ for the tag, which is kept.
+ */
+class IMPORT_EXPORT_API MP3ChunkJoiner final
+{
+public:
+   //! Frames of input on each side of a chunk, besides its own
+   static constexpr size_t Overlap = 4;
+
+   //! Input that the encoder of a chunk needs, and which frames to keep
+   struct Chunk final
+   {
+      //! Sample of the input, per channel, where the encoder starts
+      uint64_t inputStart {};
+      //! Sample of the input where the encoder stops, or past the end of the
+      //! input for the last chunk
+      uint64_t inputEnd {};
+      //! Frames at the start of the encoding that overlap the chunk before
+      size_t dropFrames {};
+      //! Frames to keep after those, or all of the rest if null
+      std::optional<size_t> keepFrames;
+   };
+
+   //! @return samples per channel in each frame at the rate
+   static size_t SamplesPerFrame(int sampleRate);
+
+   /*!
+    @param firstFrame the first frame of the whole stream in the chunk
+    @param frames how many frames of the whole stream are in the chunk, or
+    null for the last chunk, which makes the rest
+    */
+   static Chunk PlanChunk(uint64_t firstFrame, std::optional<size_t> frames,
+      size_t samplesPerFrame);
+
+   //! @return bytes of the chunk to write after those returned before, or
+   //! null if the encoding is not a sequence of whole Layer III frames
+   std::optional<std::vector<uint8_t>>
+   Join(const std::vector<uint8_t>& encoding, const Chunk& chunk);
+
+   //! Frames written after the info tag frame
+   size_t GetFrameCount() const { return mFrameOffsets.size(); }
+
+   //! Rewrite the info tag frame, that the encoder of the first chunk made,
+   //! to describe all the chunks joined
+   /*!
+    @param totalSamples samples per channel of all the input
+    @return false if the frame is not an info tag of LAME
+    */
+   bool FixInfoTag(std::vector<uint8_t>& tag, uint64_t totalSamples) const;
+
+private:
+   //! Facts about the encoding of the first chunk, to tell how its encoder
+   //! counted, so the counts for the whole stream follow suit
+   struct FirstEncoding final
+   {
+      uint64_t bytes {};
+      size_t frames {};
+      uint16_t crc {};
+      uint16_t crcWithInfoFrame {};
+   };
+
+   std::optional<FirstEncoding> mFirst;
+   size_t mInfoFrameSize {};
+   size_t mSamplesPerFrame {};
+   //! Positions of frames after the info tag frame, from its start
+   std::vector<uint64_t> mFrameOffsets;
+   uint64_t mBytes {};
+   uint16_t mCRC {};
+   uint16_t mCRCWithInfoFrame {};
+};
+} // namespace LibImportExport
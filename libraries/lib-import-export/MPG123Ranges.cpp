@@ -0,0 +1,176 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  MPG123Ranges.cpp
+
+**********************************************************************/
+#include "MPG123Ranges.h"
+
+#include <algorithm>
+#include <deque>
+#include <future>
+
+#include <wx/file.h>
+
+#include <mpg123.h>
+
+#include "MemoryX.h"
+#include "concurrency/ThreadPool.h"
+
+namespace LibImportExport
+{
+namespace
+{
+//! Append decoder output to samples, converting double to float
+void AppendDecoded(std::vector<float>& samples,
+   const unsigned char* data, size_t count, bool float64)
+{
+   if (float64)
+   {
+      const auto doubles = reinterpret_cast<const double*>(data);
+      samples.insert(samples.end(), doubles, doubles + count);
+   }
+   else
+   {
+      const auto floats = reinterpret_cast<const float*>(data);
+      samples.insert(samples.end(), floats, floats + count);
+   }
+}
+
+ptrdiff_t ReadFile(void* handle, void* buffer, size_t size)
+{
+   return static_cast<wxFile*>(handle)->Read(buffer, size);
+}
+
+off_t SeekFile(void* handle, off_t offset, int whence)
+{
+   const auto mode = whence == SEEK_CUR ? wxFromCurrent :
+      whence == SEEK_END ? wxFromEnd : wxFromStart;
+   return static_cast<wxFile*>(handle)->Seek(offset, mode);
+}
+} // namespace
+
+MPG123DecodedRange DecodeMPG123Range(
+   const FilePath& filename, const MPG123FrameIndex& index,
+   off_t start, off_t end, unsigned numChannels)
+{
+   MPG123DecodedRange range;
+   auto& errorCode = range.result;
+
+   wxFile file;
+   if (!file.Open(filename))
+   {
+      errorCode = MPG123_ERR;
+      return range;
+   }
+
+   auto handle = mpg123_new(nullptr, &errorCode);
+   if (handle == nullptr)
+      return range;
+   auto cleanup = finally([handle]() { mpg123_delete(handle); });
+
+   // mpg123_set_index() copies the offsets
+   auto offsets = index.offsets;
+   if ((errorCode = mpg123_replace_reader_handle(
+           handle, ReadFile, SeekFile, nullptr)) != MPG123_OK ||
+       (errorCode = mpg123_param(
+           handle, MPG123_FLAGS, MPG123_GAPLESS | MPG123_FORCE_FLOAT, 0.0)) !=
+          MPG123_OK ||
+       (errorCode = mpg123_param(
+           handle, MPG123_PREFRAMES, MPG123PrimingFrames, 0.0)) != MPG123_OK ||
+       (errorCode = mpg123_open_handle(handle, &file)) != MPG123_OK ||
+       (errorCode = mpg123_set_index(
+           handle, offsets.data(), index.step, offsets.size())) != MPG123_OK)
+      return range;
+
+   if (mpg123_seek(handle, start, SEEK_SET) < 0)
+   {
+      errorCode = mpg123_errcode(handle);
+      return range;
+   }
+
+   const size_t count = (end - start) * numChannels;
+   range.samples.reserve(count);
+   bool float64 = false;
+   while (range.samples.size() < count)
+   {
+      unsigned char* data { nullptr };
+      size_t dataSize { 0 };
+      errorCode = mpg123_decode_frame(handle, nullptr, &data, &dataSize);
+
+      if (errorCode == MPG123_NEW_FORMAT)
+      {
+         long rate;
+         int channels;
+         int encoding = MPG123_ENC_FLOAT_32;
+         mpg123_getformat(handle, &rate, &channels, &encoding);
+         float64 = encoding == MPG123_ENC_FLOAT_64;
+         continue;
+      }
+      if (errorCode == MPG123_DONE)
+         break;
+      if (errorCode != MPG123_OK)
+         return range;
+
+      // The frame decoded last may reach beyond the end of the range
+      const auto decoded =
+         dataSize / (float64 ? sizeof(double) : sizeof(float));
+      AppendDecoded(range.samples, data,
+         std::min(decoded, count - range.samples.size()), float64);
+   }
+
+   errorCode = MPG123_OK;
+   return range;
+}
+
+int DecodeMPG123Ranges(
+   const FilePath& filename, const MPG123FrameIndex& index,
+   off_t length, unsigned numChannels, off_t rangeLength,
+   const MPG123RangeConsumer& consume)
+{
+   auto& pool = audacity::concurrency::ThreadPool::Get();
+   const size_t maxPending = std::max<size_t>(1, pool.GetThreadCount());
+   std::deque<std::future<MPG123DecodedRange>> pending;
+   // Tasks refer to these, so that pending tasks must end before they do
+   auto waitForPending = finally([&pending] {
+      for (auto& range : pending)
+         range.wait();
+   });
+   off_t nextStart = 0;
+   off_t decoded = 0;
+
+   while (decoded < length)
+   {
+      while (nextStart < length && pending.size() < maxPending)
+      {
+         const auto end = std::min(nextStart + rangeLength, length);
+         pending.push_back(pool.Async(
+            [&filename, &index, start = nextStart, end, numChannels] {
+               return DecodeMPG123Range(
+                  filename, index, start, end, numChannels);
+            }));
+         nextStart = end;
+      }
+
+      auto range = pending.front().get();
+      pending.pop_front();
+
+      if (range.result != MPG123_OK)
+         return range.result;
+
+      const auto end = std::min(decoded + rangeLength, length);
+      if (end < length &&
+          range.samples.size() !=
+             static_cast<size_t>(end - decoded) * numChannels)
+         return MPG123_ERR;
+
+      decoded = end;
+      if (!consume(range.samples, decoded))
+         break;
+   }
+
+   return MPG123_OK;
+}
+} // namespace LibImportExport
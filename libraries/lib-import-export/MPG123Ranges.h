@@ -0,0 +1,70 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  MPG123Ranges.h
+
+**********************************************************************/
+#pragma once
+
+#include <functional>
+#include <sys/types.h>
+#include <vector>
+
+#include "Identifier.h"
+
+namespace LibImportExport
+{
+//! Copy of the frame index that mpg123_scan() built, which lets other
+//! handles seek accurately without scanning again
+struct MPG123FrameIndex final
+{
+   std::vector<off_t> offsets;
+   off_t step {};
+};
+
+struct MPG123DecodedRange final
+{
+   std::vector<float> samples; //!< Interleaved
+   int result {}; //!< An mpg123 error code, MPG123_OK if it succeeded
+};
+
+//! Frames decoded in advance of a seek target, which refill the bit
+//! reservoir of layer 3; the reservoir reaches back 511 bytes, which is
+//! several frames at the lowest bit rates
+constexpr long MPG123PrimingFrames = 10;
+
+//! Decode samples [start, end) of an MPEG audio file with a handle of its
+//! own, so that several ranges can be decoded at once
+/*!
+ mpg123 seeks sample-accurately, and decodes MPG123PrimingFrames before the
+ target, so that the ranges join without gaps or glitches.  The range is
+ short only where the file ends before `end`.
+ */
+IMPORT_EXPORT_API MPG123DecodedRange DecodeMPG123Range(
+   const FilePath& filename, const MPG123FrameIndex& index,
+   off_t start, off_t end, unsigned numChannels);
+
+//! Receives decoded samples of a range, interleaved, and the sample per
+//! channel where they end; returns false to stop decoding
+using MPG123RangeConsumer =
+   std::function<bool(const std::vector<float>& samples, off_t end)>;
+
+//! Decode samples [0, length) in ranges of rangeLength on the thread pool
+//! that the application shares, passing them to consume in order on this
+//! thread
+/*!
+ At most as many ranges as the pool has threads are decoded ahead of
+ consume, which bounds memory.  Only the last range may end early, where
+ `length` was estimated; a short one before it fails the decoding, as it
+ would leave a gap.
+
+ @return MPG123_OK if all ranges were consumed or consume stopped the
+ decoding, else an mpg123 error code
+ */
+IMPORT_EXPORT_API int DecodeMPG123Ranges(
+   const FilePath& filename, const MPG123FrameIndex& index,
+   off_t length, unsigned numChannels, off_t rangeLength,
+   const MPG123RangeConsumer& consume);
+} // namespace LibImportExport
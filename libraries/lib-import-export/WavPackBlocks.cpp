@@ -0,0 +1,255 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  WavPackBlocks.cpp
+
+**********************************************************************/
+#include "WavPackBlocks.h"
+
+#include <cstring>
+#include <limits>
+
+namespace LibImportExport
+{
+namespace
+{
+// Fields of the block header, as in wavpack.h
+constexpr size_t SizeOffset = 4;
+constexpr size_t BlockIndexHighOffset = 10;
+constexpr size_t TotalSamplesHighOffset = 11;
+constexpr size_t TotalSamplesOffset = 12;
+constexpr size_t BlockIndexOffset = 16;
+
+// Sub-block ids, as in wavpack.h
+constexpr uint8_t IdUnique = 0x3f;
+constexpr uint8_t IdOddSize = 0x40;
+constexpr uint8_t IdLarge = 0x80;
+constexpr uint8_t IdRiffHeader = 0x21;
+constexpr uint8_t IdBlockChecksum = 0x2f;
+
+uint32_t GetLittleEndian(const uint8_t* src)
+{
+   return src[0] | (src[1] << 8) | (src[2] << 16) | (uint32_t(src[3]) << 24);
+}
+
+void PutLittleEndian(uint8_t* dst, uint32_t value)
+{
+   for (int ii = 0; ii < 4; ++ii, value >>= 8)
+      dst[ii] = value & 0xff;
+}
+
+void SetBlockIndex(uint8_t* block, int64_t index)
+{
+   PutLittleEndian(block + BlockIndexOffset, static_cast<uint32_t>(index));
+   block[BlockIndexHighOffset] = static_cast<uint8_t>(index >> 32);
+}
+
+void SetTotalSamples(uint8_t* block, int64_t total)
+{
+   if (total < 0)
+   {
+      PutLittleEndian(block + TotalSamplesOffset, -1);
+      return;
+   }
+   // The high byte counts wraps of 2^32 - 1, which is reserved for unknown
+   total += total / 0xffffffffLL;
+   PutLittleEndian(block + TotalSamplesOffset, static_cast<uint32_t>(total));
+   block[TotalSamplesHighOffset] = static_cast<uint8_t>(total >> 32);
+}
+
+struct SubBlock
+{
+   uint8_t id;
+   // Offsets in the block of the id, of the data, and after the data
+   size_t begin, data, end;
+};
+
+bool GetSubBlocks(
+   const uint8_t* block, size_t length, std::vector<SubBlock>& result)
+{
+   result.clear();
+   for (size_t offset = WavPackHeaderSize; offset < length;)
+   {
+      if (offset + 2 > length)
+         return false;
+      const auto id = block[offset];
+      size_t data = offset + 2;
+      size_t words = block[offset + 1];
+      if (id & IdLarge)
+      {
+         if (offset + 4 > length)
+            return false;
+         words |= (block[offset + 2] << 8) | (block[offset + 3] << 16);
+         data += 2;
+      }
+      const auto end = data + 2 * words;
+      if (end > length)
+         return false;
+      result.push_back({ id, offset, data, end });
+      offset = end;
+   }
+   return true;
+}
+
+bool IsChecksum(const SubBlock& subBlock)
+{
+   const auto size = subBlock.end - subBlock.data;
+   return (subBlock.id & IdUnique) == IdBlockChecksum &&
+          (size == 4 || size == 2);
+}
+
+uint32_t ComputeChecksum(const uint8_t* block, const SubBlock& checksum)
+{
+   return ComputeWavPackChecksum(
+      block, checksum.begin, checksum.end - checksum.data == 2);
+}
+
+uint32_t GetChecksum(const uint8_t* block, const SubBlock& checksum)
+{
+   const auto data = block + checksum.data;
+   return checksum.end - checksum.data == 4 ? GetLittleEndian(data) :
+                                              data[0] | (data[1] << 8);
+}
+
+void PutChecksum(uint8_t* block, const SubBlock& checksum)
+{
+   const auto value = ComputeChecksum(block, checksum);
+   const auto data = block + checksum.data;
+   if (checksum.end - checksum.data == 4)
+      PutLittleEndian(data, value);
+   else
+   {
+      data[0] = value & 0xff;
+      data[1] = (value >> 8) & 0xff;
+   }
+}
+
+bool AppendBlock(std::vector<uint8_t>& dst, const uint8_t* block,
+   size_t length, int64_t firstSample, bool keepWrapper)
+{
+   std::vector<SubBlock> subBlocks;
+   if (!GetSubBlocks(block, length, subBlocks))
+      return false;
+
+   const auto start = dst.size();
+   dst.insert(dst.end(), block, block + WavPackHeaderSize);
+   SetBlockIndex(&dst[start], GetWavPackBlockIndex(block) + firstSample);
+   for (const auto& subBlock : subBlocks)
+   {
+      const auto id = subBlock.id & IdUnique;
+      if (id == IdRiffHeader && !keepWrapper)
+         continue;
+      if (id == IdBlockChecksum &&
+          (!IsChecksum(subBlock) ||
+           GetChecksum(block, subBlock) != ComputeChecksum(block, subBlock)))
+         continue;
+      dst.insert(dst.end(), block + subBlock.begin, block + subBlock.end);
+   }
+
+   PutLittleEndian(&dst[start + SizeOffset], dst.size() - start - 8);
+   return UpdateWavPackChecksum(&dst[start], dst.size() - start);
+}
+} // namespace
+
+int64_t GetWavPackBlockIndex(const uint8_t* block)
+{
+   return GetLittleEndian(block + BlockIndexOffset) +
+          (int64_t(block[BlockIndexHighOffset]) << 32);
+}
+
+int64_t GetWavPackTotalSamples(const uint8_t* block)
+{
+   const auto low = GetLittleEndian(block + TotalSamplesOffset);
+   if (low == std::numeric_limits<uint32_t>::max())
+      return -1;
+   const auto high = block[TotalSamplesHighOffset];
+   return low + (int64_t(high) << 32) - high;
+}
+
+uint32_t
+ComputeWavPackChecksum(const uint8_t* block, size_t size, bool shortened)
+{
+   uint32_t result = -1;
+   for (size_t ii = 0; ii + 1 < size; ii += 2)
+      result = result * 3 + block[ii] + (block[ii + 1] << 8);
+   if (shortened)
+      result = (result ^ (result >> 16)) & 0xffff;
+   return result;
+}
+
+bool UpdateWavPackChecksum(uint8_t* block, size_t length)
+{
+   std::vector<SubBlock> subBlocks;
+   if (!GetSubBlocks(block, length, subBlocks))
+      return false;
+   for (const auto& subBlock : subBlocks)
+      if (IsChecksum(subBlock))
+         PutChecksum(block, subBlock);
+   return true;
+}
+
+bool RelocateWavPackBlocks(
+   const std::vector<uint8_t>& blocks, int64_t firstSample, bool keepWrapper,
+   const std::function<void(const std::vector<uint8_t>&)>& write)
+{
+   std::vector<uint8_t> result;
+   for (size_t offset = 0; offset < blocks.size();)
+   {
+      const auto block = &blocks[offset];
+      if (offset + WavPackHeaderSize > blocks.size() ||
+          memcmp(block, "wvpk", 4) != 0)
+         return false;
+      const size_t length = GetLittleEndian(block + SizeOffset) + 8;
+      if (offset + length > blocks.size())
+         return false;
+      result.clear();
+      if (!AppendBlock(result, block, length, firstSample, keepWrapper))
+         return false;
+      write(result);
+      keepWrapper = false;
+      offset += length;
+   }
+   return true;
+}
+
+void UpdateWavPackRiffHeader(uint8_t* header, uint32_t size, uint64_t dataBytes)
+{
+   if (size < 12 || memcmp(header, "RIFF", 4) != 0 ||
+       memcmp(header + 8, "WAVE", 4) != 0 ||
+       size + dataBytes + 1 > std::numeric_limits<uint32_t>::max())
+      return;
+   for (uint32_t offset = 12; offset + 8 <= size;)
+   {
+      const auto chunkSize = GetLittleEndian(header + offset + 4);
+      if (memcmp(header + offset, "data", 4) == 0)
+      {
+         PutLittleEndian(header + offset + 4, dataBytes);
+         PutLittleEndian(header + 4, size - 8 + dataBytes + (dataBytes & 1));
+         return;
+      }
+      offset += 8 + chunkSize + (chunkSize & 1);
+   }
+}
+
+bool UpdateWavPackNumSamples(uint8_t* block, size_t length,
+   int64_t totalSamples, size_t bytesPerFrame)
+{
+   std::vector<SubBlock> subBlocks;
+   if (length < WavPackHeaderSize ||
+       !GetSubBlocks(block, length, subBlocks))
+      return false;
+
+   SetTotalSamples(block, totalSamples);
+   for (const auto& subBlock : subBlocks)
+      if ((subBlock.id & IdUnique) == IdRiffHeader)
+      {
+         const auto odd = (subBlock.id & IdOddSize) ? 1 : 0;
+         UpdateWavPackRiffHeader(block + subBlock.data,
+            subBlock.end - subBlock.data - odd, totalSamples * bytesPerFrame);
+         break;
+      }
+   return UpdateWavPackChecksum(block, length);
+}
+} // namespace LibImportExport
@@ -0,0 +1,76 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  WavPackBlocks.h
+
+**********************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace LibImportExport
+{
+//! Bytes of the header of a WavPack block, which begins with "wvpk"
+constexpr size_t WavPackHeaderSize = 32;
+
+//! @return the index in the stream of the first sample of the block
+IMPORT_EXPORT_API int64_t GetWavPackBlockIndex(const uint8_t* block);
+
+//! @return the samples of the stream that the header of the block gives, or
+//! -1 where they are unknown
+IMPORT_EXPORT_API int64_t GetWavPackTotalSamples(const uint8_t* block);
+
+//! The block checksum of WavPack 5, over the given bytes of a block
+/*!
+ It begins at -1, and for each 16 bit little-endian word is multiplied by 3
+ and the word added.  It covers the block, header included, up to its own
+ sub-block.  Blocks of hybrid mode store it shortened to 16 bits.
+ */
+IMPORT_EXPORT_API uint32_t
+ComputeWavPackChecksum(const uint8_t* block, size_t size, bool shortened);
+
+//! Compute again the checksum sub-block of a block, if it has one
+//! @return false if the block is not a sequence of sub-blocks
+IMPORT_EXPORT_API bool UpdateWavPackChecksum(uint8_t* block, size_t length);
+
+//! Rewrite the blocks that one context packed, for where its samples begin
+//! in the stream
+/*!
+ Each context numbers its samples from zero, so encodings of consecutive
+ chunks join into one stream when their blocks are moved.  The first block of
+ each context has a RIFF header, which only the first of the stream keeps.  A
+ checksum is computed again, or dropped if it is not computed as expected,
+ since it is optional.
+
+ @param write receives each rewritten block in turn
+ @return false if blocks is not a sequence of whole blocks; the blocks
+ before the first one found wrong were written
+ */
+IMPORT_EXPORT_API bool RelocateWavPackBlocks(
+   const std::vector<uint8_t>& blocks, int64_t firstSample, bool keepWrapper,
+   const std::function<void(const std::vector<uint8_t>&)>& write);
+
+//! Put the length of the audio into a RIFF header that WavPack made for an
+//! unknown length
+/*!
+ An RF64 header, or one that a RIFF size can't describe, is left as it is
+ */
+IMPORT_EXPORT_API void UpdateWavPackRiffHeader(
+   uint8_t* header, uint32_t size, uint64_t dataBytes);
+
+//! What WavpackUpdateNumSamples() does, for a first block that another
+//! context packed
+/*!
+ @param bytesPerFrame bytes of the samples of all channels at one time, in
+ the RIFF header
+ @return false, leaving the block unchanged, if it is not a sequence of
+ sub-blocks
+ */
+IMPORT_EXPORT_API bool UpdateWavPackNumSamples(uint8_t* block, size_t length,
+   int64_t totalSamples, size_t bytesPerFrame);
+} // namespace LibImportExport
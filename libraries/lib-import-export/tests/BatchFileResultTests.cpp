@@ -0,0 +1,67 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  BatchFileResultTests.cpp
+
+**********************************************************************/
+#include <catch2/catch.hpp>
+
+#include "BatchFileResult.h"
+
+namespace LibImportExport
+{
+TEST_CASE("BatchFileResult", "[BatchFileResult]")
+{
+   SECTION("a result survives formatting and parsing")
+   {
+      BatchFileResult result;
+      result.success = GENERATE(true, false);
+      result.seconds = 12.5;
+      result.message = GENERATE(
+         wxString {}, wxString { wxT("Importing failed") },
+         // What the line format uses must be escaped
+         wxString { wxT("tab\there, line\nbreak\r\n, back\\slash\\t") });
+
+      const auto line = FormatBatchFileResult(result);
+      REQUIRE(line.Find('\n') == wxNOT_FOUND);
+      REQUIRE(line.StartsWith(BatchFileResultPrefix));
+
+      const auto parsed = ParseBatchFileResult(line);
+      REQUIRE(parsed.has_value());
+      REQUIRE(parsed->success == result.success);
+      REQUIRE(parsed->seconds == Approx(result.seconds));
+      REQUIRE(parsed->message == result.message);
+   }
+
+   SECTION("other output of the worker is ignored")
+   {
+      REQUIRE(!ParseBatchFileResult(wxT("")).has_value());
+      REQUIRE(!ParseBatchFileResult(wxT("1\t0.5\tlooks like a result"))
+                  .has_value());
+      REQUIRE(!ParseBatchFileResult(wxT("ALSA lib pcm.c: unknown PCM"))
+                  .has_value());
+      // The prefix, but not a result after it
+      REQUIRE(!ParseBatchFileResult(BatchFileResultPrefix + wxT("yes\t1\t"))
+                  .has_value());
+      REQUIRE(!ParseBatchFileResult(BatchFileResultPrefix + wxT("1\tsoon\t"))
+                  .has_value());
+   }
+
+   SECTION("a result after part of a line of other output is found")
+   {
+      BatchFileResult result;
+      result.success = true;
+      result.seconds = 0.25;
+      result.message = wxT("done");
+      const auto parsed = ParseBatchFileResult(
+         wxT("partial output without a line break") +
+         FormatBatchFileResult(result));
+      REQUIRE(parsed.has_value());
+      REQUIRE(parsed->success);
+      REQUIRE(parsed->seconds == Approx(0.25));
+      REQUIRE(parsed->message == wxT("done"));
+   }
+}
+} // namespace LibImportExport
@@ -0,0 +1,150 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ExportChunkQueueTests.cpp
+
+**********************************************************************/
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "ExportChunkQueue.h"
+
+TEST_CASE("ExportChunkQueue")
+{
+   std::vector<int> results;
+   const auto consumer = [&](int result) { results.push_back(result); };
+
+   SECTION("consumes results in the order of the tasks")
+   {
+      ExportChunkQueue<int> queue { 3, consumer };
+      std::vector<int> expected;
+      for (int ii = 0; ii < 20; ++ii)
+      {
+         // Later tasks finish sooner
+         queue.Add([ii] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20 - ii));
+            return ii;
+         });
+         expected.push_back(ii);
+         // No more than three are pending
+         REQUIRE(results.size() + 3 >= expected.size());
+      }
+      queue.Finish();
+      REQUIRE(results == expected);
+   }
+
+   SECTION("throws the exception of a task to the caller")
+   {
+      ExportChunkQueue<int> queue { 2, consumer };
+      queue.Add([] { return 0; });
+      queue.Add([]() -> int { throw std::runtime_error { "encoder failure" }; });
+      queue.Add([] { return 2; });
+      REQUIRE(results == std::vector<int> { 0 });
+      REQUIRE_THROWS_AS(queue.Finish(), std::runtime_error);
+      REQUIRE(results == std::vector<int> { 0 });
+   }
+}
+
+TEST_CASE("ExportChunkBudget")
+{
+   const auto capacity = ExportChunkBudget::Capacity();
+   size_t added = 0, consumed = 0;
+   const auto consumer = [&](int) { ++consumed; };
+
+   {
+      // Two exports at once, each allowed more chunks than the budget has
+      ExportChunkQueue<int> queue1 { capacity + 10, consumer };
+      ExportChunkQueue<int> queue2 { capacity + 10, consumer };
+      for (int ii = 0; ii < 4 * int(capacity + 10); ++ii)
+      {
+         (ii % 2 ? queue2 : queue1).Add([] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            return 0;
+         });
+         ++added;
+         // Each has one chunk of its own, and they share the rest
+         REQUIRE(added - consumed <= capacity + 2);
+      }
+      // The other discards what it has pending
+      queue1.Finish();
+   }
+
+   // Whatever the queues took, they gave back
+   size_t acquired = 0;
+   while (acquired <= capacity && ExportChunkBudget::TryAcquire())
+      ++acquired;
+   ExportChunkBudget::Release(acquired);
+   REQUIRE(acquired == capacity);
+}
+
+TEST_CASE("ExportChunkBudget is shared by exports on several threads")
+{
+   const auto capacity = ExportChunkBudget::Capacity();
+   const auto threadCount = ExportChunkQueue<int>::DefaultConcurrency();
+   constexpr size_t nExports = 4;
+   constexpr int nChunks = 200;
+
+   // Chunks added and not yet consumed, by all exports
+   std::atomic<size_t> outstanding { 0 }, maxOutstanding { 0 };
+   // Tasks running at once
+   std::atomic<size_t> running { 0 }, maxRunning { 0 };
+   const auto raise = [](std::atomic<size_t>& max, size_t value) {
+      auto old = max.load();
+      while (old < value && !max.compare_exchange_weak(old, value))
+         ;
+   };
+
+   std::vector<std::vector<int>> results(nExports);
+   std::vector<std::thread> exports;
+   for (size_t iExport = 0; iExport < nExports; ++iExport)
+      exports.emplace_back([&, iExport] {
+         auto& myResults = results[iExport];
+         // Each export alone would allow more chunks than the budget has
+         ExportChunkQueue<int> queue { capacity + 10, [&](int result) {
+                                          myResults.push_back(result);
+                                          --outstanding;
+                                       } };
+         for (int ii = 0; ii < nChunks; ++ii)
+         {
+            queue.Add([&, ii] {
+               raise(maxRunning, ++running);
+               std::this_thread::sleep_for(std::chrono::microseconds(200));
+               --running;
+               return ii;
+            });
+            raise(maxOutstanding, ++outstanding);
+         }
+         queue.Finish();
+      });
+   for (auto& thread : exports)
+      thread.join();
+
+   // Each export consumed its own chunks, in order
+   std::vector<int> expected(nChunks);
+   for (int ii = 0; ii < nChunks; ++ii)
+      expected[ii] = ii;
+   for (const auto& myResults : results)
+      REQUIRE(myResults == expected);
+   REQUIRE(outstanding == 0);
+
+   // The tasks of all exports share the pool
+   REQUIRE(maxRunning <= threadCount);
+   // Beyond the first of each export, chunks come from one budget.  The count
+   // may exceed that by one for each export while its consumer runs, after
+   // the release of the chunk it consumes.
+   REQUIRE(maxOutstanding <= capacity + 2 * nExports);
+
+   // Whatever the queues took, they gave back
+   size_t acquired = 0;
+   while (acquired <= capacity && ExportChunkBudget::TryAcquire())
+      ++acquired;
+   ExportChunkBudget::Release(acquired);
+   REQUIRE(acquired == capacity);
+}
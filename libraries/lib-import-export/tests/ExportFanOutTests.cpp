@@ -0,0 +1,159 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ExportFanOutTests.cpp
+
+**********************************************************************/
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+#include "ExportFanOut.h"
+#include "MemoryX.h"
+#include "Mix.h"
+#include "WideSampleSequence.h"
+
+#include "MockedPrefs.h"
+
+namespace
+{
+constexpr double Rate = 44100;
+
+//! A mono sequence whose samples rise steadily, and which may fail to read
+class RampSequence final : public WideSampleSequence
+{
+public:
+   RampSequence(sampleCount length, sampleCount failAt = -1)
+       : mLength { length }
+       , mFailAt { failAt }
+   {
+   }
+
+   size_t NChannels() const override { return 1; }
+   float GetChannelGain(int) const override { return 1.f; }
+
+   bool DoGet(
+      size_t, size_t nBuffers, const samplePtr buffers[], sampleFormat,
+      sampleCount start, size_t len, bool, fillFormat, bool,
+      sampleCount*) const override
+   {
+      if (mFailAt >= 0 && start + len > mFailAt)
+         throw std::runtime_error { "read failure" };
+      for (size_t iBuffer = 0; iBuffer < nBuffers; ++iBuffer)
+         for (size_t ii = 0; ii < len; ++ii)
+         {
+            const auto s = start + ii;
+            reinterpret_cast<float*>(buffers[iBuffer])[ii] =
+               s < mLength ? s.as_float() / mLength.as_float() : 0.f;
+         }
+      return true;
+   }
+
+   double GetStartTime() const override { return 0; }
+   double GetEndTime() const override { return mLength.as_double() / Rate; }
+   double GetRate() const override { return Rate; }
+   sampleFormat WidestEffectiveFormat() const override { return floatSample; }
+   bool HasTrivialEnvelope() const override { return true; }
+   void GetEnvelopeValues(double* buffer, size_t bufferLen, double, bool)
+      const override
+   {
+      std::fill(buffer, buffer + bufferLen, 1.0);
+   }
+
+   AudioGraph::ChannelType GetChannelType() const override
+   {
+      return AudioGraph::MonoChannel;
+   }
+
+private:
+   const sampleCount mLength;
+   const sampleCount mFailAt;
+};
+
+std::unique_ptr<Mixer> MakeMixer(
+   std::shared_ptr<const WideSampleSequence> pSequence, double t1,
+   size_t bufferSize)
+{
+   Mixer::Inputs inputs;
+   inputs.emplace_back(pSequence);
+   return std::make_unique<Mixer>(
+      std::move(inputs), true, Mixer::WarpOptions { 1.0, 1.0 }, 0, t1, 1,
+      bufferSize, false, Rate, floatSample, false);
+}
+
+std::vector<float> Drain(Mixer& mixer)
+{
+   std::vector<float> result;
+   while (const auto length = mixer.Process())
+   {
+      const auto buffer = reinterpret_cast<const float*>(mixer.GetBuffer(0));
+      result.insert(result.end(), buffer, buffer + length);
+   }
+   return result;
+}
+} // namespace
+
+TEST_CASE("ExportFanOut")
+{
+   MockedPrefs prefs;
+   // Longer than the ring buffer of the fan-out
+   const sampleCount length = 3 * (1 << 20) + 123;
+   const double t1 = length.as_double() / Rate;
+
+   SECTION("gives each tap the same samples as the mixer")
+   {
+      const auto pSequence = std::make_shared<RampSequence>(length);
+      auto pMixer = MakeMixer(pSequence, t1, 4096);
+      const auto expected = Drain(*pMixer);
+
+      constexpr size_t nTaps = 3;
+      ExportFanOut fanOut { MakeMixer(pSequence, t1, 4096), Rate, 0, t1,
+                            nTaps };
+      std::vector<std::unique_ptr<Mixer>> mixers;
+      // Taps read at different paces
+      for (size_t ii = 0; ii < nTaps; ++ii)
+         mixers.push_back(MakeMixer(fanOut.GetTap(ii), t1, 1000 << ii));
+      fanOut.Start();
+      std::vector<std::future<std::vector<float>>> results;
+      for (size_t ii = 0; ii < nTaps; ++ii)
+         results.push_back(std::async(std::launch::async, [&, ii] {
+            auto result = Drain(*mixers[ii]);
+            fanOut.Detach(ii);
+            return result;
+         }));
+      for (auto& result : results)
+         REQUIRE(result.get() == expected);
+   }
+
+   SECTION("does not wait for detached taps")
+   {
+      const auto pSequence = std::make_shared<RampSequence>(length);
+      ExportFanOut fanOut { MakeMixer(pSequence, t1, 4096), Rate, 0, t1, 2 };
+      fanOut.Start();
+      fanOut.Detach(0);
+      auto pMixer = MakeMixer(fanOut.GetTap(1), t1, 4096);
+      REQUIRE(Drain(*pMixer).size() == length.as_size_t());
+   }
+
+   SECTION("throws the exception of the mixer in each tap")
+   {
+      const auto pSequence =
+         std::make_shared<RampSequence>(length, length.as_long_long() / 2);
+      ExportFanOut fanOut { MakeMixer(pSequence, t1, 4096), Rate, 0, t1, 2 };
+      auto pMixer0 = MakeMixer(fanOut.GetTap(0), t1, 4096);
+      auto pMixer1 = MakeMixer(fanOut.GetTap(1), t1, 4096);
+      fanOut.Start();
+      auto result = std::async(std::launch::async, [&] {
+         auto detach = finally([&] { fanOut.Detach(1); });
+         Drain(*pMixer1);
+      });
+      REQUIRE_THROWS_AS(Drain(*pMixer0), std::runtime_error);
+      fanOut.Detach(0);
+      REQUIRE_THROWS_AS(result.get(), std::runtime_error);
+   }
+}
@@ -0,0 +1,185 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ExportPipelineTests.cpp
+
+**********************************************************************/
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "ExportPipeline.h"
+#include "Mix.h"
+#include "WideSampleSequence.h"
+
+#include "MockedPrefs.h"
+
+namespace
+{
+constexpr double Rate = 44100;
+constexpr size_t BufferSize = 1000;
+
+//! A mono sequence whose samples rise steadily, and which may fail to read
+class RampSequence final : public WideSampleSequence
+{
+public:
+   RampSequence(sampleCount length, sampleCount failAt = -1)
+       : mLength { length }
+       , mFailAt { failAt }
+   {
+   }
+
+   size_t NChannels() const override { return 1; }
+   float GetChannelGain(int) const override { return 1.f; }
+
+   bool DoGet(
+      size_t, size_t nBuffers, const samplePtr buffers[], sampleFormat,
+      sampleCount start, size_t len, bool, fillFormat, bool,
+      sampleCount*) const override
+   {
+      if (mFailAt >= 0 && start + len > mFailAt)
+         throw std::runtime_error { "read failure" };
+      for (size_t iBuffer = 0; iBuffer < nBuffers; ++iBuffer)
+         for (size_t ii = 0; ii < len; ++ii)
+         {
+            const auto s = start + ii;
+            reinterpret_cast<float*>(buffers[iBuffer])[ii] =
+               s < mLength ? s.as_float() / mLength.as_float() : 0.f;
+         }
+      return true;
+   }
+
+   double GetStartTime() const override { return 0; }
+   double GetEndTime() const override { return mLength.as_double() / Rate; }
+   double GetRate() const override { return Rate; }
+   sampleFormat WidestEffectiveFormat() const override { return floatSample; }
+   bool HasTrivialEnvelope() const override { return true; }
+   void GetEnvelopeValues(double* buffer, size_t bufferLen, double, bool)
+      const override
+   {
+      std::fill(buffer, buffer + bufferLen, 1.0);
+   }
+
+   AudioGraph::ChannelType GetChannelType() const override
+   {
+      return AudioGraph::MonoChannel;
+   }
+
+private:
+   const sampleCount mLength;
+   const sampleCount mFailAt;
+};
+
+std::unique_ptr<Mixer>
+MakeMixer(std::shared_ptr<const WideSampleSequence> pSequence)
+{
+   Mixer::Inputs inputs;
+   inputs.emplace_back(pSequence);
+   return std::make_unique<Mixer>(
+      std::move(inputs), true, Mixer::WarpOptions { 1.0, 1.0 }, 0,
+      pSequence->GetEndTime(), 1, BufferSize, false, Rate, floatSample,
+      false);
+}
+
+template<typename Source> std::vector<float> Drain(Source& source)
+{
+   std::vector<float> result;
+   while (const auto length = source.Process())
+   {
+      const auto buffer = reinterpret_cast<const float*>(source.GetBuffer(0));
+      result.insert(result.end(), buffer, buffer + length);
+   }
+   return result;
+}
+} // namespace
+
+TEST_CASE("ExportPipeline")
+{
+   MockedPrefs prefs;
+   const sampleCount length = 25 * BufferSize + 123;
+
+   SECTION("gives the same samples as the mixer")
+   {
+      const auto pSequence = std::make_shared<RampSequence>(length);
+      auto pMixer = MakeMixer(pSequence);
+      const auto expected = Drain(*pMixer);
+
+      for (const size_t depth : { 2, 3, 8 })
+      {
+         ExportPipeline pipeline { MakeMixer(pSequence), depth };
+         REQUIRE(Drain(pipeline) == expected);
+         REQUIRE(pipeline.MixGetCurrentTime() ==
+                 Approx(pMixer->MixGetCurrentTime()));
+         // Stays at the end
+         REQUIRE(pipeline.Process() == 0);
+      }
+   }
+
+   SECTION("stops the mixer when destroyed early")
+   {
+      const auto pSequence = std::make_shared<RampSequence>(length);
+      ExportPipeline pipeline { MakeMixer(pSequence) };
+      REQUIRE(pipeline.Process() > 0);
+      REQUIRE(pipeline.MixGetCurrentTime() > 0);
+   }
+
+   SECTION("throws the exception of the mixer after the buffers before it")
+   {
+      const auto pSequence =
+         std::make_shared<RampSequence>(length, 10 * BufferSize + 1);
+      ExportPipeline pipeline { MakeMixer(pSequence) };
+      size_t total = 0;
+      REQUIRE_THROWS_AS(
+         [&] {
+            while (const auto n = pipeline.Process())
+               total += n;
+         }(),
+         std::runtime_error);
+      // The mixer may read ahead of what it gives
+      REQUIRE(total > 0);
+      REQUIRE(total <= 10 * BufferSize);
+   }
+}
+
+TEST_CASE("Mixer writes into the destinations it is given")
+{
+   MockedPrefs prefs;
+   const sampleCount length = 5 * BufferSize + 123;
+   const auto pSequence = std::make_shared<RampSequence>(length);
+   const auto makeMixer = [&] {
+      Mixer::Inputs inputs;
+      inputs.emplace_back(pSequence);
+      return std::make_unique<Mixer>(
+         std::move(inputs), true, Mixer::WarpOptions { 1.0, 1.0 }, 0,
+         pSequence->GetEndTime(), 2, BufferSize, true, Rate, floatSample,
+         false);
+   };
+
+   // The samples of its own interleaved buffer, in frames of three with a
+   // gap between the channels
+   auto pMixer = makeMixer();
+   auto pDirect = makeMixer();
+   std::vector<float> frames(3 * BufferSize);
+   const Mixer::ChannelDestination destinations[] = {
+      { reinterpret_cast<samplePtr>(frames.data()), 3 },
+      { reinterpret_cast<samplePtr>(frames.data() + 2), 3 },
+   };
+   while (const auto n = pMixer->Process())
+   {
+      std::fill(frames.begin(), frames.end(), -1.f);
+      REQUIRE(pDirect->Process(BufferSize, destinations) == n);
+      const auto expected =
+         reinterpret_cast<const float*>(pMixer->GetBuffer());
+      for (size_t ii = 0; ii < n; ++ii)
+      {
+         REQUIRE(frames[3 * ii] == expected[2 * ii]);
+         REQUIRE(frames[3 * ii + 1] == -1.f);
+         REQUIRE(frames[3 * ii + 2] == expected[2 * ii + 1]);
+      }
+   }
+   REQUIRE(pDirect->Process(BufferSize, destinations) == 0);
+}
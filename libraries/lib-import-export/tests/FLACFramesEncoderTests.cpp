@@ -0,0 +1,110 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  FLACFramesEncoderTests.cpp
+
+**********************************************************************/
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#include "FLAC++/encoder.h"
+
+#include "FLACFrames.h"
+
+namespace LibImportExport
+{
+namespace
+{
+using Frame = std::vector<uint8_t>;
+
+//! Keeps the frames that libFLAC writes
+class FrameEncoder final : public FLAC::Encoder::Stream
+{
+public:
+   std::vector<Frame> frames;
+
+protected:
+   ::FLAC__StreamEncoderWriteStatus write_callback(
+      const FLAC__byte buffer[], size_t bytes, uint32_t samples,
+      uint32_t) override
+   {
+      // Metadata come with no samples, and each frame in one call
+      if (samples > 0)
+         frames.emplace_back(buffer, buffer + bytes);
+      return FLAC__STREAM_ENCODER_WRITE_STATUS_OK;
+   }
+};
+
+//! The frames of samples [first, last) of a stereo signal, numbered from
+//! zero, as the FLAC exporter encodes a chunk
+std::vector<Frame>
+Encode(unsigned sampleRate, unsigned blocksize, size_t first, size_t last)
+{
+   FrameEncoder encoder;
+   REQUIRE(encoder.set_channels(2));
+   REQUIRE(encoder.set_bits_per_sample(16));
+   REQUIRE(encoder.set_sample_rate(sampleRate));
+   REQUIRE(encoder.set_compression_level(5));
+   REQUIRE(encoder.set_blocksize(blocksize));
+   REQUIRE(encoder.set_do_md5(false));
+   REQUIRE(encoder.init() == FLAC__STREAM_ENCODER_INIT_STATUS_OK);
+
+   std::vector<FLAC__int32> left, right;
+   for (auto ii = first; ii < last; ++ii)
+   {
+      const auto noise = static_cast<FLAC__int32>((ii * 7919) % 613) - 306;
+      left.push_back(std::lround(12000 * std::sin(0.01 * ii)) + noise);
+      right.push_back(std::lround(9000 * std::sin(0.013 * ii)) - noise);
+   }
+   const FLAC__int32* buffers[] = { left.data(), right.data() };
+   REQUIRE(encoder.process(buffers, left.size()));
+   REQUIRE(encoder.finish());
+   return std::move(encoder.frames);
+}
+} // namespace
+
+TEST_CASE("RenumberFLACFrame joins chunks that libFLAC encoded")
+{
+   // Frame numbers of one, two and three bytes, and headers that give the
+   // block size or the sample rate after the frame number, or not
+   const std::pair<unsigned, unsigned> formats[] = {
+      { 44100, 16 }, { 12345, 1000 }, { 50000, 4096 }, { 12340, 576 },
+   };
+   for (const auto& [sampleRate, blocksize] : formats)
+   {
+      const size_t frames = blocksize == 16 ? 2200 : 140;
+      // The last frame is short, with its block size in its header
+      const size_t length = frames * blocksize - blocksize / 2;
+      const auto whole = Encode(sampleRate, blocksize, 0, length);
+      REQUIRE(whole.size() == frames);
+
+      // The checksums are those that libFLAC computes
+      for (size_t ii = 0; ii < whole.size(); ++ii)
+      {
+         auto frame = whole[ii];
+         REQUIRE(RenumberFLACFrame(frame, ii));
+         REQUIRE(frame == whole[ii]);
+      }
+
+      // Chunks numbered again make the frames of one encoder
+      constexpr size_t ChunkFrames = 50;
+      std::vector<Frame> joined;
+      for (size_t start = 0; start < length; start += ChunkFrames * blocksize)
+      {
+         const auto end = std::min(length, start + ChunkFrames * blocksize);
+         for (auto& frame : Encode(sampleRate, blocksize, start, end))
+         {
+            REQUIRE(RenumberFLACFrame(frame, joined.size()));
+            joined.push_back(std::move(frame));
+         }
+      }
+      REQUIRE(joined.size() == whole.size());
+      for (size_t ii = 0; ii < whole.size(); ++ii)
+         REQUIRE(joined[ii] == whole[ii]);
+   }
+}
+} // namespace LibImportExport
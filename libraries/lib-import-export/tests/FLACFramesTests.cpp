@@ -0,0 +1,101 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  FLACFramesTests.cpp
+
+**********************************************************************/
+#include <catch2/catch.hpp>
+
+#include <cstring>
+
+#include "FLACFrames.h"
+
+namespace LibImportExport
+{
+namespace
+{
+//! A frame of fixed block size, with a 16 bit block size and sample rate
+//! at the end of the header, and some bytes for subframes
+std::vector<uint8_t> MakeFrame()
+{
+   std::vector<uint8_t> frame { 0xFF, 0xF8, 0x7D, 0x18, 0x00, 0x03, 0xE7,
+                                0x30, 0x39 };
+   frame.push_back(FLACCrc8(frame.data(), frame.size()));
+   for (uint8_t ii = 0; ii < 20; ++ii)
+      frame.push_back(ii * 13);
+   const auto crc = FLACCrc16(frame.data(), frame.size());
+   frame.push_back(crc >> 8);
+   frame.push_back(crc & 0xFF);
+   return frame;
+}
+} // namespace
+
+TEST_CASE("FLACCrc")
+{
+   // The check values of CRC-8 and CRC-16/UMTS
+   const auto check = reinterpret_cast<const uint8_t*>("123456789");
+   REQUIRE(FLACCrc8(check, 9) == 0xF4);
+   REQUIRE(FLACCrc16(check, 9) == 0xFEE8);
+   REQUIRE(FLACCrc8(check, 0) == 0);
+   REQUIRE(FLACCrc16(check, 0) == 0);
+}
+
+TEST_CASE("RenumberFLACFrame")
+{
+   const auto original = MakeFrame();
+
+   SECTION("codes numbers of every length, and restores the frame")
+   {
+      for (const uint32_t number :
+           { 0x7Fu, 0x80u, 0x7FFu, 0x800u, 0xFFFFu, 0x10000u, 0x1FFFFFu,
+             0x200000u, 0x3FFFFFFu, 0x4000000u, 0x7FFFFFFFu })
+      {
+         auto frame = original;
+         REQUIRE(RenumberFLACFrame(frame, number));
+
+         // The leading byte tells the length of the number, as in UTF-8
+         const size_t length = number < 0x80 ? 1 :
+                               number < 0x800 ? 2 :
+                               number < 0x10000 ? 3 :
+                               number < 0x200000 ? 4 :
+                               number < 0x4000000 ? 5 : 6;
+         REQUIRE(frame.size() == original.size() + length - 1);
+         uint32_t decoded = frame[4] & (0x7F >> (length - 1 + (length > 1)));
+         for (size_t ii = 1; ii < length; ++ii)
+         {
+            REQUIRE((frame[4 + ii] & 0xC0) == 0x80);
+            decoded = (decoded << 6) | (frame[4 + ii] & 0x3F);
+         }
+         REQUIRE(decoded == number);
+
+         // The rest of the header follows, and the checksums are right
+         const auto header = 4 + length + 4;
+         REQUIRE(std::memcmp(&frame[4 + length], &original[5], 4) == 0);
+         REQUIRE(FLACCrc8(frame.data(), header) == frame[header]);
+         REQUIRE(
+            FLACCrc16(frame.data(), frame.size() - 2) ==
+            ((frame[frame.size() - 2] << 8) | frame.back()));
+
+         REQUIRE(RenumberFLACFrame(frame, 0));
+         REQUIRE(frame == original);
+      }
+   }
+
+   SECTION("rejects what is not a frame of fixed block size")
+   {
+      auto frame = original;
+      frame[1] = 0xF9;
+      REQUIRE(!RenumberFLACFrame(frame, 1));
+      frame[1] = 0xF8;
+      frame[0] = 0xFE;
+      REQUIRE(!RenumberFLACFrame(frame, 1));
+
+      frame = original;
+      frame.resize(10);
+      REQUIRE(!RenumberFLACFrame(frame, 1));
+      REQUIRE(frame.size() == 10);
+   }
+}
+} // namespace LibImportExport
@@ -0,0 +1,144 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ImportStreamDecodersTests.cpp
+
+**********************************************************************/
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "ImportStreamDecoders.h"
+
+namespace
+{
+using Packet = std::unique_ptr<int>;
+using Decoded = std::vector<int>;
+
+//! Makes of a packet of a stream some samples that depend on both, taking a
+//! while that differs by stream and packet
+Decoded Decode(size_t stream, Packet packet)
+{
+   const auto value = *packet;
+   std::this_thread::sleep_for(
+      std::chrono::microseconds((value * 7 + stream * 13) % 50));
+   Decoded result;
+   for (int ii = 0; ii < 1 + value % 5; ++ii)
+      result.push_back(value * 100 + ii + 1000000 * int(stream));
+   return result;
+}
+
+//! Packets of the streams, interleaved as a file would hold them, with
+//! some streams for a while more often than others
+std::vector<std::pair<size_t, int>> Demux(size_t nStreams, int nPackets)
+{
+   std::vector<std::pair<size_t, int>> result;
+   std::vector<int> next(nStreams);
+   for (int ii = 0; ii < nPackets; ++ii)
+   {
+      const auto stream = (ii / 3 + ii * ii) % nStreams;
+      result.emplace_back(stream, next[stream]++);
+   }
+   return result;
+}
+} // namespace
+
+TEST_CASE("ImportStreamDecoders")
+{
+   const auto importingThread = std::this_thread::get_id();
+
+   SECTION("appends to each stream what decoding serially does")
+   {
+      const size_t nStreams = GENERATE(1, 2, 5);
+      const auto packets = Demux(nStreams, 1000);
+
+      std::vector<Decoded> serial(nStreams);
+      for (const auto& [stream, value] : packets)
+      {
+         const auto decoded = Decode(stream, std::make_unique<int>(value));
+         serial[stream].insert(
+            serial[stream].end(), decoded.begin(), decoded.end());
+      }
+
+      std::vector<Decoded> appended(nStreams);
+      bool otherThread = false;
+      ImportStreamDecoders<Packet, Decoded> decoders {
+         nStreams, Decode, [&](size_t stream, Decoded decoded) {
+            otherThread =
+               otherThread || std::this_thread::get_id() != importingThread;
+            appended[stream].insert(
+               appended[stream].end(), decoded.begin(), decoded.end());
+         }
+      };
+      for (const auto& [stream, value] : packets)
+         decoders.Push(stream, std::make_unique<int>(value));
+      decoders.Finish();
+
+      REQUIRE(!otherThread);
+      REQUIRE(appended == serial);
+   }
+
+   SECTION("bounds what waits when appending is slow")
+   {
+      size_t pushed = 0, consumed = 0;
+      ImportStreamDecoders<Packet, Decoded> decoders {
+         1, Decode, [&](size_t, Decoded) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            ++consumed;
+         }
+      };
+      for (int ii = 0; ii < 1000; ++ii)
+      {
+         decoders.Push(0, std::make_unique<int>(ii));
+         ++pushed;
+         // Packets waiting, decodings waiting, and one being decoded
+         REQUIRE(pushed - consumed <= 2 * decoders.MaxPending + 1);
+      }
+      decoders.Finish();
+      REQUIRE(consumed == pushed);
+   }
+
+   SECTION("throws the exception of a decoding to the importing thread")
+   {
+      size_t consumed = 0;
+      ImportStreamDecoders<Packet, Decoded> decoders {
+         2,
+         [](size_t stream, Packet packet) {
+            if (stream == 1 && *packet == 10)
+               throw std::runtime_error { "decoder failure" };
+            return Decode(stream, move(packet));
+         },
+         [&](size_t, Decoded) { ++consumed; }
+      };
+      REQUIRE_THROWS_AS(
+         [&] {
+            for (int ii = 0; ii < 1000; ++ii)
+               decoders.Push(ii % 2, std::make_unique<int>(ii / 2));
+            decoders.Finish();
+         }(),
+         std::runtime_error);
+      REQUIRE(consumed < 1000);
+   }
+
+   SECTION("discards what is not yet appended when destroyed")
+   {
+      size_t consumed = 0;
+      {
+         ImportStreamDecoders<Packet, Decoded> decoders {
+            3, Decode, [&](size_t, Decoded) { ++consumed; }
+         };
+         for (int ii = 0; ii < 300; ++ii)
+            decoders.Push(ii % 3, std::make_unique<int>(ii / 3));
+      }
+      const auto afterDestruction = consumed;
+      REQUIRE(afterDestruction < 300);
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      REQUIRE(consumed == afterDestruction);
+   }
+}
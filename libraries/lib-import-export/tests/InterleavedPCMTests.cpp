@@ -0,0 +1,403 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  InterleavedPCMTests.cpp
+
+**********************************************************************/
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <wx/file.h>
+#include <wx/filename.h>
+
+#include "FileException.h"
+#include "InterleavedPCM.h"
+#include "SampleFormat.h"
+
+namespace LibImportExport
+{
+namespace
+{
+using Encoding = SampleFileRange::Encoding;
+
+constexpr size_t NumChannels = 3;
+constexpr size_t NumFrames = 1001;
+constexpr uint32_t SampleRate = 44100;
+
+//! Bytes of a file in the making, of either byte order
+struct Bytes
+{
+   bool bigEndian;
+   std::vector<uint8_t> data;
+
+   void Put(uint64_t word, size_t size)
+   {
+      for (size_t ii = 0; ii < size; ++ii)
+         data.push_back(word >> (8 * (bigEndian ? size - 1 - ii : ii)));
+   }
+   void Id(const char *id)
+   {
+      data.insert(data.end(), id, id + 4);
+   }
+   void Append(const std::vector<uint8_t> &bytes)
+   {
+      data.insert(data.end(), bytes.begin(), bytes.end());
+   }
+   //! A chunk of a RIFF or AIFF file, padded to even length
+   void Chunk(const char *id, const std::vector<uint8_t> &body,
+      uint32_t size)
+   {
+      Id(id);
+      Put(size, 4);
+      Append(body);
+      if (body.size() % 2)
+         data.push_back(0);
+   }
+   void Chunk(const char *id, const std::vector<uint8_t> &body)
+   {
+      Chunk(id, body, body.size());
+   }
+};
+
+uint32_t FloatWord(float value)
+{
+   uint32_t word;
+   memcpy(&word, &value, sizeof(word));
+   return word;
+}
+
+size_t EncodedSize(Encoding encoding)
+{
+   return SampleFileRange::GetEncodedSize(encoding);
+}
+
+//! Interleaved samples that differ in each frame and channel, and reach
+//! both ends of the range of the encoding
+std::vector<uint8_t> Samples(Encoding encoding, bool bigEndian)
+{
+   Bytes bytes{ bigEndian };
+   for (size_t frame = 0; frame < NumFrames; ++frame)
+      for (size_t c = 0; c < NumChannels; ++c) {
+         const double value = std::sin(0.05 * frame + 2.0 * c);
+         switch (encoding) {
+         case Encoding::Int16:
+            bytes.Put(static_cast<int16_t>(
+               std::lround(std::clamp(value * 32768, -32768.0, 32767.0))), 2);
+            break;
+         case Encoding::Int24:
+            bytes.Put(static_cast<int32_t>(std::lround(
+               std::clamp(value * 8388608, -8388608.0, 8388607.0))), 3);
+            break;
+         case Encoding::Float32:
+            bytes.Put(FloatWord(value), 4);
+            break;
+         }
+      }
+   return bytes.data;
+}
+
+//! The body of a WAVE format chunk
+std::vector<uint8_t> WaveFormat(Encoding encoding, bool bigEndian,
+   bool extended = false)
+{
+   const auto sampleSize = EncodedSize(encoding);
+   Bytes fmt{ bigEndian };
+   fmt.Put(encoding == Encoding::Float32 ? 3 : 1, 2);
+   fmt.Put(NumChannels, 2);
+   fmt.Put(SampleRate, 4);
+   fmt.Put(SampleRate * NumChannels * sampleSize, 4);
+   fmt.Put(NumChannels * sampleSize, 2);
+   fmt.Put(8 * sampleSize, 2);
+   if (extended)
+      fmt.Put(0, 2);
+   return fmt.data;
+}
+
+//! RIFF, or RIFX if big-endian, with an odd-sized chunk before the samples
+std::vector<uint8_t> Wave(Encoding encoding, bool bigEndian)
+{
+   const auto samples = Samples(encoding, bigEndian);
+   Bytes chunks{ bigEndian };
+   chunks.Id("WAVE");
+   chunks.Chunk("fmt ", WaveFormat(encoding, bigEndian));
+   chunks.Chunk("junk", { 1, 2, 3, 4, 5 });
+   chunks.Chunk("data", samples);
+
+   Bytes file{ bigEndian };
+   file.Chunk(bigEndian ? "RIFX" : "RIFF", chunks.data);
+   return file.data;
+}
+
+//! RF64, or BW64, whose sizes are in a ds64 chunk
+std::vector<uint8_t> Wave64Sizes(Encoding encoding, const char *id)
+{
+   const auto samples = Samples(encoding, false);
+   Bytes chunks{ false };
+   Bytes ds64{ false };
+   // Sizes of the RIFF chunk, the data chunk and the samples, then no table
+   ds64.Put(4 + 8 + 28 + 8 + 16 + 8 + samples.size(), 8);
+   ds64.Put(samples.size(), 8);
+   ds64.Put(NumFrames, 8);
+   ds64.Put(0, 4);
+   chunks.Chunk("ds64", ds64.data);
+   chunks.Chunk("fmt ", WaveFormat(encoding, false));
+   chunks.Chunk("data", samples, 0xFFFFFFFF);
+
+   Bytes file{ false };
+   file.Id(id);
+   file.Put(0xFFFFFFFF, 4);
+   file.Id("WAVE");
+   file.Append(chunks.data);
+   return file.data;
+}
+
+//! Sony Wave64, whose chunks have GUIDs for ids, 64-bit sizes, and are
+//! padded to multiples of 8 bytes
+std::vector<uint8_t> W64(Encoding encoding)
+{
+   static const uint8_t riff[] = { 'r', 'i', 'f', 'f', 0x2E, 0x91, 0xCF,
+      0x11, 0xA5, 0xD6, 0x28, 0xDB, 0x04, 0xC1, 0x00, 0x00 };
+   const auto guid = [](const char *name) {
+      const uint8_t suffix[] = { 0xF3, 0xAC, 0xD3, 0x11, 0x8C, 0xD1, 0x00,
+         0xC0, 0x4F, 0x8E, 0xDB, 0x8A };
+      std::vector<uint8_t> result(name, name + 4);
+      result.insert(result.end(), std::begin(suffix), std::end(suffix));
+      return result;
+   };
+
+   Bytes chunks{ false };
+   const auto chunk = [&](const char *name, const std::vector<uint8_t> &body) {
+      chunks.Append(guid(name));
+      chunks.Put(24 + body.size(), 8);
+      chunks.Append(body);
+      while (chunks.data.size() % 8)
+         chunks.data.push_back(0);
+   };
+   // The format of 18 bytes makes padding before the samples
+   chunk("fmt ", WaveFormat(encoding, false, true));
+   chunk("data", Samples(encoding, false));
+
+   Bytes file{ false };
+   file.Append({ std::begin(riff), std::end(riff) });
+   file.Put(16 + 8 + 16 + chunks.data.size(), 8);
+   file.Append(guid("wave"));
+   file.Append(chunks.data);
+   return file.data;
+}
+
+//! The body of an AIFF common chunk, with the compression of AIFC if given
+std::vector<uint8_t> AiffCommon(Encoding encoding, const char *compression)
+{
+   Bytes comm{ true };
+   comm.Put(NumChannels, 2);
+   comm.Put(NumFrames, 4);
+   comm.Put(8 * EncodedSize(encoding), 2);
+   // 44100 as an 80-bit extended float
+   comm.Put(0x400E, 2);
+   comm.Put(0xAC440000, 4);
+   comm.Put(0, 4);
+   if (compression) {
+      comm.Id(compression);
+      // An empty Pascal string, padded to even length
+      comm.Put(0, 2);
+   }
+   return comm.data;
+}
+
+//! AIFF, or AIFC if compression is given, whose sound data chunk has an
+//! offset before the samples
+std::vector<uint8_t> Aiff(Encoding encoding, const char *compression)
+{
+   const auto samples = Samples(encoding, true);
+   Bytes chunks{ true };
+   chunks.Id(compression ? "AIFC" : "AIFF");
+   if (compression)
+      chunks.Chunk("FVER", { 0xA2, 0x80, 0x51, 0x40 });
+   chunks.Chunk("COMM", AiffCommon(encoding, compression));
+   chunks.Chunk("NAME", { 'a', 'b', 'c' });
+   Bytes ssnd{ true };
+   ssnd.Put(6, 4);
+   ssnd.Put(0, 4);
+   ssnd.Append({ 9, 9, 9, 9, 9, 9 });
+   ssnd.Append(samples);
+   chunks.Chunk("SSND", ssnd.data);
+
+   Bytes file{ true };
+   file.Chunk("FORM", chunks.data);
+   return file.data;
+}
+
+//! A file of the given bytes, removed at the end of the scope
+struct TempFile
+{
+   explicit TempFile(const std::vector<uint8_t>& bytes)
+       : path { wxFileName::CreateTempFileName("InterleavedPCMTest") }
+   {
+      wxFile file { path, wxFile::write };
+      REQUIRE(file.Write(bytes.data(), bytes.size()) == bytes.size());
+   }
+   ~TempFile()
+   {
+      wxRemoveFile(path);
+   }
+   const FilePath path;
+};
+
+using Channels = std::vector<std::vector<float>>;
+
+//! Read the file with libsndfile, as the import does when it can't bypass it
+Channels ReadWithLibsndfile(const FilePath &path, SF_INFO &info)
+{
+   wxFile file{ path };
+   REQUIRE(file.IsOpened());
+   memset(&info, 0, sizeof(info));
+   const auto sndFile = sf_open_fd(file.fd(), SFM_READ, &info, FALSE);
+   REQUIRE(sndFile != nullptr);
+   REQUIRE(info.channels == NumChannels);
+   REQUIRE(info.frames == NumFrames);
+
+   std::vector<float> interleaved(NumFrames * NumChannels);
+   const auto read = sf_readf_float(sndFile, interleaved.data(), NumFrames);
+   sf_close(sndFile);
+   REQUIRE(read == NumFrames);
+
+   Channels channels(NumChannels);
+   for (size_t frame = 0; frame < NumFrames; ++frame)
+      for (size_t c = 0; c < NumChannels; ++c)
+         channels[c].push_back(interleaved[frame * NumChannels + c]);
+   return channels;
+}
+
+//! Read the file as the import does when it bypasses libsndfile, in blocks
+//! that don't divide the file evenly
+Channels ReadInterleaved(const FilePath &path,
+   const SampleFileRange::Layout &layout)
+{
+   constexpr size_t MaxBlock = 300;
+   InterleavedPCMReader reader{ path, layout, NumChannels, NumFrames, MaxBlock };
+   std::vector<SampleBuffer> buffers;
+   for (size_t c = 0; c < NumChannels; ++c)
+      buffers.emplace_back(MaxBlock, floatSample);
+
+   Channels channels(NumChannels);
+   for (size_t start = 0; start < NumFrames; start += MaxBlock) {
+      const auto len = std::min(MaxBlock, NumFrames - start);
+      reader.Read(buffers, floatSample, start, len);
+      for (size_t c = 0; c < NumChannels; ++c) {
+         const auto samples = reinterpret_cast<const float *>(buffers[c].ptr());
+         channels[c].insert(channels[c].end(), samples, samples + len);
+      }
+   }
+   return channels;
+}
+
+//! Check that the file's samples are found, and read as libsndfile reads
+//! the expected file, which is the same file unless libsndfile can't open it
+void CheckSameAsLibsndfile(const std::vector<uint8_t> &bytes,
+   Encoding encoding, bool bigEndian,
+   const std::vector<uint8_t> &expected)
+{
+   const TempFile file{ bytes };
+   const TempFile expectedFile{ expected };
+   SF_INFO info;
+   const auto channels = ReadWithLibsndfile(expectedFile.path, info);
+
+   const auto layout = FindPCMSamples(file.path, info);
+   REQUIRE(layout);
+   CHECK(layout->encoding == encoding);
+   CHECK(layout->bigEndian == bigEndian);
+   CHECK(layout->stride == NumChannels * EncodedSize(encoding));
+   REQUIRE(ReadInterleaved(file.path, *layout) == channels);
+}
+
+void CheckSameAsLibsndfile(const std::vector<uint8_t> &bytes,
+   Encoding encoding, bool bigEndian)
+{
+   CheckSameAsLibsndfile(bytes, encoding, bigEndian, bytes);
+}
+} // namespace
+
+TEST_CASE("FindPCMSamples and InterleavedPCMReader", "[InterleavedPCM]")
+{
+   SECTION("WAV")
+   {
+      const auto encoding =
+         GENERATE(Encoding::Int16, Encoding::Int24, Encoding::Float32);
+      CheckSameAsLibsndfile(Wave(encoding, false), encoding, false);
+   }
+
+   SECTION("RIFX")
+   {
+      const auto encoding = GENERATE(Encoding::Int16, Encoding::Int24);
+      CheckSameAsLibsndfile(Wave(encoding, true), encoding, true);
+   }
+
+   SECTION("RF64")
+   {
+      const auto encoding =
+         GENERATE(Encoding::Int16, Encoding::Int24, Encoding::Float32);
+      CheckSameAsLibsndfile(Wave64Sizes(encoding, "RF64"), encoding, false);
+   }
+
+   SECTION("BW64")
+   {
+      // Not every version of libsndfile reads BW64, which is RF64 by
+      // another name
+      const auto encoding =
+         GENERATE(Encoding::Int16, Encoding::Int24, Encoding::Float32);
+      CheckSameAsLibsndfile(Wave64Sizes(encoding, "BW64"), encoding, false,
+         Wave64Sizes(encoding, "RF64"));
+   }
+
+   SECTION("W64")
+   {
+      const auto encoding =
+         GENERATE(Encoding::Int16, Encoding::Int24, Encoding::Float32);
+      CheckSameAsLibsndfile(W64(encoding), encoding, false);
+   }
+
+   SECTION("AIFF")
+   {
+      const auto encoding = GENERATE(Encoding::Int16, Encoding::Int24);
+      CheckSameAsLibsndfile(Aiff(encoding, nullptr), encoding, true);
+   }
+
+   SECTION("AIFC is left to libsndfile")
+   {
+      // Even uncompressed, as it may be little-endian
+      const char *const compression = GENERATE("NONE", "sowt");
+      const TempFile file{ Aiff(Encoding::Int16, compression) };
+      SF_INFO info;
+      ReadWithLibsndfile(file.path, info);
+      REQUIRE(!FindPCMSamples(file.path, info));
+   }
+
+   SECTION("Big-endian float is left to libsndfile")
+   {
+      const TempFile file{ Wave(Encoding::Float32, true) };
+      SF_INFO info;
+      ReadWithLibsndfile(file.path, info);
+      REQUIRE(!FindPCMSamples(file.path, info));
+   }
+
+   SECTION("A file too short for its frames is not read")
+   {
+      auto bytes = Wave(Encoding::Int16, false);
+      const TempFile file{ bytes };
+      SF_INFO info;
+      ReadWithLibsndfile(file.path, info);
+      const auto layout = FindPCMSamples(file.path, info);
+      REQUIRE(layout);
+      REQUIRE_THROWS_AS(
+         InterleavedPCMReader(file.path, *layout, NumChannels, NumFrames + 1, 1),
+         FileException);
+   }
+}
+} // namespace LibImportExport
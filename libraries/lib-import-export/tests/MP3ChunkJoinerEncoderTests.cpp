@@ -0,0 +1,219 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  MP3ChunkJoinerEncoderTests.cpp
+
+**********************************************************************/
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <vector>
+
+#include <wx/file.h>
+#include <wx/filename.h>
+
+#include <lame/lame.h>
+#include <mpg123.h>
+
+#include "MP3ChunkJoiner.h"
+
+namespace LibImportExport
+{
+namespace
+{
+using Bytes = std::vector<uint8_t>;
+
+constexpr int SampleRate = 44100;
+constexpr size_t NumChannels = 2;
+
+//! Encode the samples of each channel with one LAME encoder, as the export
+//! does
+/*!
+ @param tag if not null, receives the info tag, and the encoding begins with
+ a frame reserved for it
+ */
+Bytes Encode(const float* left, const float* right, size_t length,
+   bool reservoir, Bytes* tag)
+{
+   auto flags = lame_init();
+   REQUIRE(flags != nullptr);
+   lame_set_error_protection(flags, false);
+   lame_set_in_samplerate(flags, SampleRate);
+   lame_set_out_samplerate(flags, SampleRate);
+   lame_set_num_channels(flags, NumChannels);
+   lame_set_disable_reservoir(flags, !reservoir);
+   lame_set_bWriteVbrTag(flags, tag != nullptr);
+   lame_set_VBR(flags, vbr_off);
+   lame_set_brate(flags, 128);
+   lame_set_mode(flags, JOINT_STEREO);
+   REQUIRE(lame_init_params(flags) >= 0);
+
+   const auto size = static_cast<int>(length);
+   Bytes bytes(size * 5 / 4 + 7200);
+   const auto written = lame_encode_buffer_ieee_float(
+      flags, left, right, size, bytes.data(), bytes.size());
+   REQUIRE(written >= 0);
+   const auto flushed = lame_encode_flush(
+      flags, bytes.data() + written, bytes.size() - written);
+   REQUIRE(flushed >= 0);
+   bytes.resize(written + flushed);
+
+   if (tag)
+   {
+      // See MAXFRAMESIZE in libmp3lame/VbrTag.c for explanation of 2880.
+      tag->resize(2880);
+      tag->resize(lame_get_lametag_frame(flags, tag->data(), tag->size()));
+      REQUIRE(!tag->empty());
+   }
+   lame_close(flags);
+   return bytes;
+}
+
+//! Decode an MP3 file, trimming the delay and padding that its info tag
+//! gives
+std::vector<float> Decode(const Bytes& bytes)
+{
+   const auto path = wxFileName::CreateTempFileName("MP3ChunkJoinerTest");
+   {
+      wxFile file { path, wxFile::write };
+      REQUIRE(file.Write(bytes.data(), bytes.size()) == bytes.size());
+   }
+
+   int errorCode = MPG123_OK;
+   auto handle = mpg123_new(nullptr, &errorCode);
+   REQUIRE(handle != nullptr);
+   REQUIRE(mpg123_param(handle, MPG123_FLAGS,
+      MPG123_GAPLESS | MPG123_FORCE_FLOAT, 0.0) == MPG123_OK);
+   REQUIRE(mpg123_open(handle, path.utf8_str()) == MPG123_OK);
+
+   std::vector<float> samples;
+   unsigned char* data { nullptr };
+   size_t dataSize { 0 };
+   int result = MPG123_OK;
+   while ((result = mpg123_decode_frame(handle, nullptr, &data, &dataSize)) ==
+             MPG123_OK ||
+          result == MPG123_NEW_FORMAT)
+   {
+      const auto floats = reinterpret_cast<const float*>(data);
+      samples.insert(samples.end(), floats, floats + dataSize / sizeof(float));
+   }
+   mpg123_close(handle);
+   mpg123_delete(handle);
+   wxRemoveFile(path);
+
+   REQUIRE(result == MPG123_DONE);
+   return samples;
+}
+
+//! Root mean square difference of decoded and input samples of all channels
+//! from start to end
+double RMSError(const std::vector<float>& decoded,
+   const std::vector<float>& left, const std::vector<float>& right,
+   size_t start, size_t end)
+{
+   double sum = 0;
+   for (auto ii = start; ii < end; ++ii)
+   {
+      const auto dl = decoded[ii * NumChannels] - left[ii];
+      const auto dr = decoded[ii * NumChannels + 1] - right[ii];
+      sum += dl * dl + dr * dr;
+   }
+   return std::sqrt(sum / ((end - start) * NumChannels));
+}
+} // namespace
+
+TEST_CASE("Chunks that LAME encodes apart join into one stream",
+   "[MP3ChunkJoiner]")
+{
+#if MPG123_API_VERSION < 46
+   mpg123_init();
+#endif
+
+   // Five seconds of different tones in each channel, which change at
+   // random, so that each chunk is unlike the others
+   const size_t length = 5 * SampleRate + 777;
+   std::vector<float> left(length), right(length);
+   uint32_t seed = 1;
+   double phase = 0;
+   for (size_t ii = 0; ii < length; ++ii)
+   {
+      if (ii % 1000 == 0)
+         seed = seed * 1664525 + 1013904223;
+      phase += 0.01 + (seed >> 24) * 0.0002;
+      left[ii] = 0.5 * std::sin(phase);
+      right[ii] = 0.25 * std::cos(3 * phase);
+   }
+
+   // What the export writes when it encodes serially
+   Bytes sequentialTag;
+   auto sequential =
+      Encode(left.data(), right.data(), length, true, &sequentialTag);
+   std::copy(sequentialTag.begin(), sequentialTag.end(), sequential.begin());
+
+   // What it writes when it encodes chunks apart, as ProcessChunks does
+   const auto samplesPerFrame = MP3ChunkJoiner::SamplesPerFrame(SampleRate);
+   REQUIRE(samplesPerFrame == 1152);
+   const size_t chunkFrames = GENERATE(40, 57);
+   MP3ChunkJoiner joiner;
+   Bytes chunked, tag;
+   std::vector<size_t> seams;
+   for (uint64_t nextFrame = 0;;)
+   {
+      // A chunk starts once all of its input is mixed
+      const auto last = MP3ChunkJoiner::PlanChunk(
+                           nextFrame, chunkFrames, samplesPerFrame)
+                           .inputEnd > length;
+      const auto frames =
+         last ? std::optional<size_t> {} : std::optional { chunkFrames };
+      const auto chunk =
+         MP3ChunkJoiner::PlanChunk(nextFrame, frames, samplesPerFrame);
+      const auto start = chunk.inputStart;
+      const auto end = std::min<uint64_t>(chunk.inputEnd, length);
+      const auto encoding = Encode(left.data() + start, right.data() + start,
+         end - start, false, nextFrame == 0 ? &tag : nullptr);
+
+      const auto bytes = joiner.Join(encoding, chunk);
+      REQUIRE(bytes.has_value());
+      chunked.insert(chunked.end(), bytes->begin(), bytes->end());
+      if (last)
+         break;
+      nextFrame += chunkFrames;
+      seams.push_back(nextFrame * samplesPerFrame);
+   }
+   REQUIRE(seams.size() >= 3);
+   REQUIRE(joiner.FixInfoTag(tag, length));
+   REQUIRE(tag.size() <= chunked.size());
+   std::copy(tag.begin(), tag.end(), chunked.begin());
+
+   const auto sequentialDecoded = Decode(sequential);
+   const auto chunkedDecoded = Decode(chunked);
+
+   // The info tag trims the same delay and padding, so that both decode as
+   // long as the input, without gaps
+   REQUIRE(sequentialDecoded.size() == length * NumChannels);
+   REQUIRE(chunkedDecoded.size() == length * NumChannels);
+
+   const auto error = RMSError(chunkedDecoded, left, right, 0, length);
+   INFO("Error of the chunked encoding " << error);
+   CHECK(error < 0.02);
+
+   // About the seams, where a frame dropped or misplaced would show, the
+   // chunked encoding errs not much more than the sequential one
+   for (const auto seam : seams)
+   {
+      const auto start = seam - 2 * samplesPerFrame;
+      const auto end = std::min(seam + 2 * samplesPerFrame, length);
+      const auto chunkedError =
+         RMSError(chunkedDecoded, left, right, start, end);
+      const auto sequentialError =
+         RMSError(sequentialDecoded, left, right, start, end);
+      INFO("Seam at " << seam << ", chunked error " << chunkedError
+                      << ", sequential error " << sequentialError);
+      CHECK(chunkedError < 2 * sequentialError + 0.01);
+   }
+}
+} // namespace LibImportExport
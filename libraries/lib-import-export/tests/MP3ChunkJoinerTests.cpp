@@ -0,0 +1,184 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  MP3ChunkJoinerTests.cpp
+
+**********************************************************************/
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#include "MP3ChunkJoiner.h"
+
+namespace LibImportExport
+{
+namespace
+{
+constexpr size_t FrameSamples = 1152;
+// 128 kbps at 48 kHz, so that frames never need padding
+constexpr uint8_t FrameHeader[] = { 0xFF, 0xFB, 0x94, 0x44 };
+constexpr size_t FrameSize = 384;
+constexpr size_t SideInfoSize = 32;
+// What LAME reports for its delay
+constexpr uint64_t Delay = 576 + 529;
+
+void PutBE(uint8_t* data, size_t size, uint64_t value)
+{
+   for (size_t ii = size; ii-- > 0; value >>= 8)
+      data[ii] = value & 0xFF;
+}
+
+uint16_t CRC(const uint8_t* data, size_t size, uint16_t crc = 0)
+{
+   for (size_t ii = 0; ii < size; ++ii)
+   {
+      crc ^= data[ii];
+      for (int bit = 0; bit < 8; ++bit)
+         crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+   }
+   return crc;
+}
+
+//! Imitates what matters of LAME without the bit reservoir:  each frame holds
+//! the number of the frame of the output that the whole input makes, and the
+//! frames hold the input delayed, padded to whole frames, and one more.
+//! The first encoder writes an info tag frame first.
+std::vector<uint8_t> Encode(uint64_t start, uint64_t end, bool infoTag)
+{
+   const auto frames = (end - start + Delay) / FrameSamples + 2;
+   std::vector<uint8_t> encoding((frames + infoTag) * FrameSize);
+   for (size_t ii = 0; ii < frames + infoTag; ++ii)
+   {
+      const auto frame = encoding.data() + ii * FrameSize;
+      std::copy(std::begin(FrameHeader), std::end(FrameHeader), frame);
+      if (!infoTag || ii > 0)
+         PutBE(frame + 4 + SideInfoSize, 8,
+            start / FrameSamples + ii - infoTag);
+   }
+   if (!infoTag)
+      return encoding;
+
+   const auto xing = encoding.data() + 4 + SideInfoSize;
+   memcpy(xing, "Info", 4);
+   PutBE(xing + 4, 4, 0x0F);
+   PutBE(xing + 8, 4, frames);
+   PutBE(xing + 12, 4, encoding.size());
+   for (size_t ii = 0; ii < 100; ++ii)
+      xing[16 + ii] = std::min<uint64_t>(
+         255, 256 * (FrameSize + ii * frames / 100 * FrameSize) /
+                 encoding.size());
+   const auto lame = xing + 120;
+   memcpy(lame, "LAME3.100", 9);
+   PutBE(lame + 21, 3,
+      (Delay << 12) | (frames * FrameSamples - Delay - (end - start)));
+   PutBE(lame + 28, 4, encoding.size());
+   PutBE(lame + 32, 2,
+      CRC(encoding.data() + FrameSize, encoding.size() - FrameSize));
+   PutBE(lame + 34, 2, CRC(encoding.data(), lame + 34 - encoding.data()));
+   return encoding;
+}
+} // namespace
+
+TEST_CASE("ParseMP3FrameHeader")
+{
+   SECTION("reads MPEG 1 headers")
+   {
+      const uint8_t header[] = { 0xFF, 0xFB, 0x90, 0x64 };
+      const auto result = ParseMP3FrameHeader(header, sizeof(header));
+      REQUIRE(result);
+      REQUIRE(result->frameSize == 417);
+      REQUIRE(result->samplesPerFrame == 1152);
+      REQUIRE(result->sideInfoSize == 32);
+
+      const uint8_t padded[] = { 0xFF, 0xFB, 0x92, 0x64 };
+      REQUIRE(ParseMP3FrameHeader(padded, sizeof(padded))->frameSize == 418);
+   }
+
+   SECTION("reads MPEG 2 headers")
+   {
+      const uint8_t header[] = { 0xFF, 0xF3, 0x80, 0xC0 };
+      const auto result = ParseMP3FrameHeader(header, sizeof(header));
+      REQUIRE(result);
+      REQUIRE(result->frameSize == 208);
+      REQUIRE(result->samplesPerFrame == 576);
+      REQUIRE(result->sideInfoSize == 9);
+   }
+
+   SECTION("rejects other layers and bad headers")
+   {
+      const uint8_t layer2[] = { 0xFF, 0xFD, 0x90, 0x64 };
+      REQUIRE(!ParseMP3FrameHeader(layer2, sizeof(layer2)));
+      const uint8_t freeFormat[] = { 0xFF, 0xFB, 0x00, 0x64 };
+      REQUIRE(!ParseMP3FrameHeader(freeFormat, sizeof(freeFormat)));
+      REQUIRE(!ParseMP3FrameHeader(FrameHeader, 3));
+   }
+}
+
+TEST_CASE("MP3ChunkJoiner")
+{
+   SECTION("joins chunks into the stream of one encoder, without gaps")
+   {
+      for (const uint64_t totalSamples :
+           { uint64_t { 1000000 }, 1000000 + FrameSamples, 1000000 + Delay })
+      {
+         MP3ChunkJoiner joiner;
+         std::vector<uint8_t> joined, tag;
+         constexpr size_t chunkFrames = 100;
+         uint64_t frame = 0;
+         const auto join = [&](std::optional<size_t> frames) {
+            const auto chunk =
+               MP3ChunkJoiner::PlanChunk(frame, frames, FrameSamples);
+            const auto encoding = Encode(chunk.inputStart,
+               std::min(chunk.inputEnd, totalSamples), frame == 0);
+            if (frame == 0)
+               tag.assign(encoding.begin(), encoding.begin() + FrameSize);
+            const auto bytes = joiner.Join(encoding, chunk);
+            REQUIRE(bytes);
+            joined.insert(joined.end(), bytes->begin(), bytes->end());
+         };
+         // As the exporter does, start a chunk once its input is all there
+         for (; (frame + chunkFrames + MP3ChunkJoiner::Overlap) *
+                   FrameSamples <= totalSamples;
+              frame += chunkFrames)
+            join(chunkFrames);
+         join({});
+
+         const auto expected = Encode(0, totalSamples, true);
+         REQUIRE(joiner.GetFrameCount() == expected.size() / FrameSize - 1);
+         // Frames after the info tag frame are those of one encoder
+         REQUIRE(joined.size() == expected.size());
+         REQUIRE(std::equal(joined.begin() + FrameSize, joined.end(),
+            expected.begin() + FrameSize));
+
+         // The tag has the counts, padding and checksums of one encoder
+         REQUIRE(joiner.FixInfoTag(tag, totalSamples));
+         REQUIRE(std::equal(tag.begin(), tag.end(), expected.begin()));
+      }
+   }
+
+   SECTION("rejects what is not whole frames")
+   {
+      MP3ChunkJoiner joiner;
+      const auto chunk = MP3ChunkJoiner::PlanChunk(0, {}, FrameSamples);
+      auto encoding = Encode(0, 10000, true);
+      encoding.pop_back();
+      REQUIRE(!joiner.Join(encoding, chunk));
+      REQUIRE(!joiner.Join({ 1, 2, 3, 4 }, chunk));
+   }
+
+   SECTION("rejects tags that are not LAME info tags")
+   {
+      MP3ChunkJoiner joiner;
+      const auto chunk = MP3ChunkJoiner::PlanChunk(0, {}, FrameSamples);
+      const auto encoding = Encode(0, 10000, true);
+      REQUIRE(joiner.Join(encoding, chunk));
+      std::vector<uint8_t> tag(
+         encoding.begin(), encoding.begin() + FrameSize);
+      tag[4 + SideInfoSize] = 'X';
+      REQUIRE(!joiner.FixInfoTag(tag, 10000));
+   }
+}
+} // namespace LibImportExport
@@ -0,0 +1,198 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  MPG123RangesTests.cpp
+
+**********************************************************************/
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <wx/file.h>
+#include <wx/filename.h>
+
+#include <lame/lame.h>
+#include <mpg123.h>
+
+#include "MPG123Ranges.h"
+
+namespace LibImportExport
+{
+namespace
+{
+constexpr int SampleRate = 44100;
+constexpr size_t NumChannels = 2;
+
+//! An MP3 file that LAME encodes, removed at the end of the scope
+struct TempMP3File
+{
+   explicit TempMP3File(const std::vector<float>& left,
+      const std::vector<float>& right)
+       : path { wxFileName::CreateTempFileName("MPG123RangesTest") }
+   {
+      auto flags = lame_init();
+      REQUIRE(flags != nullptr);
+      lame_set_in_samplerate(flags, SampleRate);
+      lame_set_out_samplerate(flags, SampleRate);
+      lame_set_num_channels(flags, NumChannels);
+      lame_set_brate(flags, 128);
+      REQUIRE(lame_init_params(flags) >= 0);
+
+      const auto size = static_cast<int>(left.size());
+      std::vector<unsigned char> bytes(size * 5 / 4 + 7200);
+      auto written = lame_encode_buffer_ieee_float(flags,
+         left.data(), right.data(), size, bytes.data(), bytes.size());
+      REQUIRE(written >= 0);
+      const auto flushed = lame_encode_flush(flags,
+         bytes.data() + written, bytes.size() - written);
+      REQUIRE(flushed >= 0);
+      bytes.resize(written + flushed);
+
+      // The info tag, which tells the decoder the delay and padding to
+      // trim, goes in place of the frame reserved for it
+      std::vector<unsigned char> tag(2880);
+      const auto tagSize =
+         lame_get_lametag_frame(flags, tag.data(), tag.size());
+      REQUIRE(tagSize > 0);
+      REQUIRE(tagSize <= bytes.size());
+      std::copy(tag.begin(), tag.begin() + tagSize, bytes.begin());
+      lame_close(flags);
+
+      wxFile file { path, wxFile::write };
+      REQUIRE(file.Write(bytes.data(), bytes.size()) == bytes.size());
+   }
+   ~TempMP3File()
+   {
+      wxRemoveFile(path);
+   }
+   const FilePath path;
+};
+
+//! Decode the file with one handle, as the import does serially
+std::vector<float> DecodeSerially(mpg123_handle* handle)
+{
+   std::vector<float> samples;
+   unsigned char* data { nullptr };
+   size_t dataSize { 0 };
+   int result = MPG123_OK;
+   while ((result = mpg123_decode_frame(handle, nullptr, &data, &dataSize)) ==
+             MPG123_OK ||
+          result == MPG123_NEW_FORMAT)
+   {
+      const auto floats = reinterpret_cast<const float*>(data);
+      samples.insert(samples.end(), floats, floats + dataSize / sizeof(float));
+   }
+   REQUIRE(result == MPG123_DONE);
+   return samples;
+}
+} // namespace
+
+TEST_CASE("DecodeMPG123Ranges", "[MPG123Ranges]")
+{
+#if MPG123_API_VERSION < 46
+   mpg123_init();
+#endif
+
+   // Five seconds of different tones in each channel, which change at
+   // random, so that each range is unlike the others
+   const size_t length = 5 * SampleRate;
+   std::vector<float> left(length), right(length);
+   uint32_t seed = 1;
+   double phase = 0;
+   for (size_t ii = 0; ii < length; ++ii)
+   {
+      if (ii % 1000 == 0)
+         seed = seed * 1664525 + 1013904223;
+      phase += 0.01 + (seed >> 24) * 0.0005;
+      left[ii] = 0.5 * std::sin(phase);
+      right[ii] = 0.25 * std::cos(3 * phase);
+   }
+   const TempMP3File file { left, right };
+
+   int errorCode = MPG123_OK;
+   auto handle = mpg123_new(nullptr, &errorCode);
+   REQUIRE(handle != nullptr);
+   REQUIRE(mpg123_param(handle, MPG123_FLAGS,
+      MPG123_GAPLESS | MPG123_FORCE_FLOAT, 0.0) == MPG123_OK);
+   REQUIRE(mpg123_open(handle, file.path.utf8_str()) == MPG123_OK);
+   REQUIRE(mpg123_scan(handle) == MPG123_OK);
+
+   off_t* offsets { nullptr };
+   off_t step { 0 };
+   size_t fill { 0 };
+   REQUIRE(mpg123_index(handle, &offsets, &step, &fill) == MPG123_OK);
+   REQUIRE(fill > 0);
+   const MPG123FrameIndex index { { offsets, offsets + fill }, step };
+
+   const off_t decodedLength = mpg123_length(handle);
+   const auto serial = DecodeSerially(handle);
+   mpg123_close(handle);
+   mpg123_delete(handle);
+
+   // The encoder's delay and padding are trimmed
+   REQUIRE(decodedLength == length);
+   REQUIRE(serial.size() == length * NumChannels);
+
+   SECTION("Ranges join into what one handle decodes")
+   {
+      // Ranges that end within frames, so that each begins with part of a
+      // frame decoded after the priming frames
+      const off_t rangeLength = GENERATE(1152 * 7 + 100, 30000);
+      std::vector<float> ranged;
+      std::vector<off_t> ends;
+      const auto result = DecodeMPG123Ranges(file.path, index,
+         decodedLength, NumChannels, rangeLength,
+         [&](const std::vector<float>& samples, off_t end) {
+            ranged.insert(ranged.end(), samples.begin(), samples.end());
+            ends.push_back(end);
+            return true;
+         });
+
+      REQUIRE(result == MPG123_OK);
+      REQUIRE(ends.size() == (length + rangeLength - 1) / rangeLength);
+      REQUIRE(ends.back() == decodedLength);
+      REQUIRE(ranged.size() == serial.size());
+      for (size_t ii = 0; ii < serial.size(); ++ii)
+      {
+         INFO("sample " << ii / NumChannels << ", channel " << ii % NumChannels);
+         REQUIRE(ranged[ii] == serial[ii]);
+      }
+   }
+
+   SECTION("A range decodes as the same samples of the whole")
+   {
+      const off_t start = 40000;
+      const off_t end = 50000;
+      const auto range =
+         DecodeMPG123Range(file.path, index, start, end, NumChannels);
+      REQUIRE(range.result == MPG123_OK);
+      REQUIRE(std::equal(range.samples.begin(), range.samples.end(),
+         serial.begin() + start * NumChannels,
+         serial.begin() + end * NumChannels));
+   }
+
+   SECTION("The consumer stops the decoding")
+   {
+      size_t calls = 0;
+      const auto result = DecodeMPG123Ranges(file.path, index,
+         decodedLength, NumChannels, 10000,
+         [&](const std::vector<float>&, off_t) { return ++calls < 3; });
+      REQUIRE(result == MPG123_OK);
+      REQUIRE(calls == 3);
+   }
+
+   SECTION("A range that decodes short before the last fails")
+   {
+      // Claim that the file is longer than it is, so that the range where
+      // it ends is not the last
+      const auto result = DecodeMPG123Ranges(file.path, index,
+         decodedLength + 20000, NumChannels, 10000,
+         [](const std::vector<float>&, off_t) { return true; });
+      REQUIRE(result != MPG123_OK);
+   }
+}
+} // namespace LibImportExport
@@ -0,0 +1,182 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  WavPackBlocksEncoderTests.cpp
+
+**********************************************************************/
+#include <catch2/catch.hpp>
+
+#include <cmath>
+#include <cstring>
+
+#include <wx/file.h>
+#include <wx/filename.h>
+
+#include <wavpack/wavpack.h>
+
+#include "WavPackBlocks.h"
+
+namespace LibImportExport
+{
+namespace
+{
+using Bytes = std::vector<uint8_t>;
+
+constexpr int NumChannels = 2;
+
+int WriteToMemory(void* id, void* data, int32_t length)
+{
+   auto& bytes = *static_cast<Bytes*>(id);
+   const auto begin = static_cast<const uint8_t*>(data);
+   bytes.insert(bytes.end(), begin, begin + length);
+   return true;
+}
+
+WavpackConfig MakeConfig(bool hybrid)
+{
+   WavpackConfig config {};
+   config.bytes_per_sample = 2;
+   config.bits_per_sample = 16;
+   config.channel_mask = 3;
+   config.num_channels = NumChannels;
+   config.sample_rate = 44100;
+   if (hybrid)
+   {
+      config.flags |= CONFIG_HYBRID_FLAG | CONFIG_CREATE_WVC;
+      config.bitrate = 3.0;
+   }
+   return config;
+}
+
+//! Pack samples with a context of their own, of unknown length, as the
+//! export packs each chunk
+void Pack(WavpackConfig config, std::vector<int32_t> samples, Bytes& wv,
+   Bytes& wvc)
+{
+   const bool correction = config.flags & CONFIG_CREATE_WVC;
+   const auto wpc =
+      WavpackOpenFileOutput(WriteToMemory, &wv, correction ? &wvc : nullptr);
+   REQUIRE(wpc != nullptr);
+   const auto frames = samples.size() / NumChannels;
+   CHECK(WavpackSetConfiguration64(wpc, &config, -1, nullptr));
+   CHECK(WavpackPackInit(wpc));
+   CHECK(WavpackPackSamples(wpc, samples.data(), frames));
+   CHECK(WavpackFlushSamples(wpc));
+   WavpackCloseFile(wpc);
+}
+
+//! A file of the given bytes, removed at the end of the scope
+struct TempFile
+{
+   TempFile(const wxString& path, const Bytes& bytes)
+       : path { path }
+   {
+      wxFile file { path, wxFile::write };
+      REQUIRE(file.Write(bytes.data(), bytes.size()) == bytes.size());
+   }
+   ~TempFile()
+   {
+      wxRemoveFile(path);
+   }
+   const wxString path;
+};
+
+//! Check each block alone, as WavPack does, checksum included
+void VerifyBlocks(Bytes bytes)
+{
+   size_t blocks = 0;
+   for (size_t offset = 0; offset < bytes.size(); ++blocks)
+   {
+      REQUIRE(offset + WavPackHeaderSize <= bytes.size());
+      const size_t length = (bytes[offset + 4] | (bytes[offset + 5] << 8) |
+         (bytes[offset + 6] << 16) | (uint32_t(bytes[offset + 7]) << 24)) + 8;
+      REQUIRE(offset + length <= bytes.size());
+      CHECK(WavpackVerifySingleBlock(&bytes[offset], 1));
+      offset += length;
+   }
+   CHECK(blocks > 1);
+}
+} // namespace
+
+TEST_CASE("Chunks that WavPack packs apart join into one file",
+   "[WavPackBlocks]")
+{
+   const bool hybrid = GENERATE(false, true);
+   const auto config = MakeConfig(hybrid);
+
+   // Chunks of different lengths, which aren't whole blocks
+   const std::vector<size_t> chunkFrames { 100000, 77777, 12345 };
+   std::vector<int32_t> samples;
+   for (const auto frames : chunkFrames)
+      for (size_t ii = 0; ii < frames; ++ii)
+      {
+         const auto time = samples.size() / NumChannels;
+         samples.push_back(std::lround(20000 * std::sin(0.01 * time)));
+         samples.push_back(std::lround(9000 * std::cos(0.037 * time)) ^ 5);
+      }
+   const auto totalFrames = samples.size() / NumChannels;
+
+   Bytes wv, wvc;
+   int64_t firstSample = 0;
+   auto begin = samples.begin();
+   for (const auto frames : chunkFrames)
+   {
+      Bytes chunkWv, chunkWvc;
+      const auto end = begin + frames * NumChannels;
+      Pack(config, { begin, end }, chunkWv, chunkWvc);
+      begin = end;
+
+      const auto append = [&](Bytes& dst, const Bytes& blocks) {
+         REQUIRE(RelocateWavPackBlocks(blocks, firstSample, firstSample == 0,
+            [&](const Bytes& block) {
+               dst.insert(dst.end(), block.begin(), block.end());
+            }));
+      };
+      append(wv, chunkWv);
+      append(wvc, chunkWvc);
+      firstSample += frames;
+   }
+
+   // As the export does when all samples are written
+   const size_t firstLength = (wv[4] | (wv[5] << 8) | (wv[6] << 16) |
+      (uint32_t(wv[7]) << 24)) + 8;
+   REQUIRE(UpdateWavPackNumSamples(wv.data(), firstLength, totalFrames,
+      NumChannels * config.bytes_per_sample));
+
+   VerifyBlocks(wv);
+   if (hybrid)
+      VerifyBlocks(wvc);
+
+   const auto path = wxFileName::CreateTempFileName("WavPackBlocksTest");
+   wxRemoveFile(path);
+   const TempFile wvFile { path + ".wv", wv };
+   const TempFile wvcFile { path + ".wvc", wvc };
+
+   char error[100] {};
+   const auto wpc = WavpackOpenFileInput(wvFile.path.utf8_str(), error,
+      OPEN_FILE_UTF8 | OPEN_WRAPPER | (hybrid ? OPEN_WVC : 0), 0);
+   REQUIRE(wpc != nullptr);
+   CHECK(WavpackGetNumSamples64(wpc) == totalFrames);
+
+   // The RIFF header that only the first chunk kept has the length
+   const auto wrapperSize = WavpackGetWrapperBytes(wpc);
+   const auto wrapper = WavpackGetWrapperData(wpc);
+   REQUIRE(wrapperSize >= 44);
+   REQUIRE(memcmp(wrapper, "RIFF", 4) == 0);
+   uint32_t dataSize = 0;
+   memcpy(&dataSize, wrapper + wrapperSize - 4, 4);
+   CHECK(wxUINT32_SWAP_ON_BE(dataSize) ==
+      totalFrames * NumChannels * config.bytes_per_sample);
+
+   std::vector<int32_t> decoded(samples.size());
+   const auto unpacked =
+      WavpackUnpackSamples(wpc, decoded.data(), totalFrames);
+   CHECK(WavpackGetNumErrors(wpc) == 0);
+   WavpackCloseFile(wpc);
+   REQUIRE(unpacked == totalFrames);
+   // Lossless, also where the chunks join
+   REQUIRE(decoded == samples);
+}
+} // namespace LibImportExport
@@ -0,0 +1,320 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  WavPackBlocksTests.cpp
+
+**********************************************************************/
+#include <catch2/catch.hpp>
+
+#include <cstring>
+
+#include "WavPackBlocks.h"
+
+namespace LibImportExport
+{
+namespace
+{
+using Bytes = std::vector<uint8_t>;
+
+constexpr uint8_t RiffHeaderId = 0x21;
+constexpr uint8_t BitstreamId = 0x0a;
+constexpr uint8_t ChecksumId = 0x2f;
+constexpr uint8_t OddSize = 0x40;
+
+void PutLittleEndian(Bytes& bytes, uint64_t word, size_t size)
+{
+   for (size_t ii = 0; ii < size; ++ii)
+      bytes.push_back(word >> (8 * ii));
+}
+
+uint32_t GetLittleEndian(const uint8_t* src)
+{
+   return src[0] | (src[1] << 8) | (src[2] << 16) | (uint32_t(src[3]) << 24);
+}
+
+//! A sub-block of the id and data, padded to whole words
+Bytes SubBlock(uint8_t id, Bytes data)
+{
+   if (data.size() % 2)
+   {
+      id |= OddSize;
+      data.push_back(0);
+   }
+   Bytes result { id, static_cast<uint8_t>(data.size() / 2) };
+   result.insert(result.end(), data.begin(), data.end());
+   return result;
+}
+
+//! A header of a RIFF file of unknown length, as WavPack makes, with an odd
+//! chunk before the data chunk
+Bytes RiffHeader(const char* id = "RIFF")
+{
+   Bytes header;
+   header.insert(header.end(), id, id + 4);
+   PutLittleEndian(header, 0, 4);
+   header.insert(header.end(), { 'W', 'A', 'V', 'E', 'f', 'm', 't', ' ' });
+   PutLittleEndian(header, 16, 4);
+   header.insert(header.end(), 16, 1);
+   header.insert(header.end(), { 'j', 'u', 'n', 'k' });
+   PutLittleEndian(header, 3, 4);
+   header.insert(header.end(), { 7, 7, 7, 0 });
+   header.insert(header.end(), { 'd', 'a', 't', 'a' });
+   PutLittleEndian(header, 0, 4);
+   return header;
+}
+
+//! The checksum as a loop over 16 bit words, apart from the function tested
+uint32_t ReferenceChecksum(const Bytes& bytes, size_t size)
+{
+   uint32_t sum = 0xffffffff;
+   for (size_t ii = 0; ii < size / 2; ++ii)
+      sum = sum * 3 + uint16_t(bytes[2 * ii] | (bytes[2 * ii + 1] << 8));
+   return sum;
+}
+
+//! A block with the given sub-blocks, then a checksum of checksumSize bytes
+//! if it is not zero
+Bytes Block(int64_t index, uint32_t samples, const std::vector<Bytes>& subBlocks,
+   size_t checksumSize)
+{
+   Bytes block { 'w', 'v', 'p', 'k' };
+   PutLittleEndian(block, 0, 4);
+   PutLittleEndian(block, 0x410, 2);
+   block.push_back(index >> 32);
+   block.push_back(0);
+   PutLittleEndian(block, 0xffffffff, 4);
+   PutLittleEndian(block, index, 4);
+   PutLittleEndian(block, samples, 4);
+   PutLittleEndian(block, 0, 4);
+   PutLittleEndian(block, 0x12345678, 4);
+   REQUIRE(block.size() == WavPackHeaderSize);
+   for (const auto& subBlock : subBlocks)
+      block.insert(block.end(), subBlock.begin(), subBlock.end());
+   // The checksum covers the size of the block in its header
+   const auto size = block.size();
+   const uint32_t ckSize = size + (checksumSize > 0 ? 2 + checksumSize : 0) - 8;
+   for (int ii = 0; ii < 4; ++ii)
+      block[4 + ii] = ckSize >> (8 * ii);
+   if (checksumSize > 0)
+   {
+      const auto sum = ReferenceChecksum(block, size);
+      block.push_back(ChecksumId);
+      block.push_back(checksumSize / 2);
+      if (checksumSize == 4)
+         PutLittleEndian(block, sum, 4);
+      else
+         PutLittleEndian(block, (sum ^ (sum >> 16)) & 0xffff, 2);
+   }
+   return block;
+}
+
+struct Parsed
+{
+   std::vector<uint8_t> ids;
+   //! Whether the checksum, if any, is what WavPack would compute
+   bool checksumValid { true };
+};
+
+Parsed Parse(const Bytes& block)
+{
+   REQUIRE(block.size() >= WavPackHeaderSize);
+   REQUIRE(memcmp(block.data(), "wvpk", 4) == 0);
+   REQUIRE(GetLittleEndian(&block[4]) + 8 == block.size());
+   Parsed result;
+   for (size_t offset = WavPackHeaderSize; offset < block.size();)
+   {
+      const auto id = block[offset] & 0x3f;
+      const size_t size = 2 * block[offset + 1];
+      result.ids.push_back(id);
+      if (id == ChecksumId)
+      {
+         const auto sum = ReferenceChecksum(block, offset);
+         if (size == 4)
+            result.checksumValid = GetLittleEndian(&block[offset + 2]) == sum;
+         else
+            result.checksumValid =
+               (block[offset + 2] | (block[offset + 3] << 8)) ==
+               ((sum ^ (sum >> 16)) & 0xffff);
+      }
+      offset += 2 + size;
+   }
+   return result;
+}
+
+std::vector<Bytes> Relocate(const Bytes& blocks, int64_t firstSample,
+   bool keepWrapper)
+{
+   std::vector<Bytes> result;
+   REQUIRE(RelocateWavPackBlocks(blocks, firstSample, keepWrapper,
+      [&](const Bytes& block) { result.push_back(block); }));
+   return result;
+}
+} // namespace
+
+TEST_CASE("ComputeWavPackChecksum", "[WavPackBlocks]")
+{
+   const Bytes bytes { 0x01, 0x00, 0x02, 0x00, 0x7f };
+   // ((-1 * 3 + 1) * 3 + 2), modulo 2^32
+   REQUIRE(ComputeWavPackChecksum(bytes.data(), 4, false) == 0xfffffffc);
+   // An odd byte at the end is not summed
+   REQUIRE(ComputeWavPackChecksum(bytes.data(), 5, false) == 0xfffffffc);
+   // Shortened, the halves are combined
+   REQUIRE(ComputeWavPackChecksum(bytes.data(), 4, true) == 0x0003);
+   REQUIRE(ComputeWavPackChecksum(bytes.data(), 0, false) == 0xffffffff);
+}
+
+TEST_CASE("RelocateWavPackBlocks", "[WavPackBlocks]")
+{
+   const Bytes bitstream { 1, 2, 3, 4, 5, 6, 7 };
+   const auto first = Block(0, 100,
+      { SubBlock(RiffHeaderId, RiffHeader()), SubBlock(BitstreamId, bitstream) },
+      4);
+   // A second block in hybrid mode, with a short checksum
+   const auto second = Block(100, 50, { SubBlock(BitstreamId, bitstream) }, 2);
+   Bytes blocks = first;
+   blocks.insert(blocks.end(), second.begin(), second.end());
+
+   SECTION("Block indices move, and checksums are computed again")
+   {
+      // Beyond 32 bits, so that the high byte of the index changes
+      const int64_t firstSample = (int64_t(1) << 32) + 16;
+      const auto relocated = Relocate(blocks, firstSample, false);
+      REQUIRE(relocated.size() == 2);
+      CHECK(GetWavPackBlockIndex(relocated[0].data()) == firstSample);
+      CHECK(GetWavPackBlockIndex(relocated[1].data()) == firstSample + 100);
+
+      // Only the first chunk of a file keeps its RIFF header
+      const auto parsed = Parse(relocated[0]);
+      CHECK(parsed.ids == std::vector<uint8_t> { BitstreamId, ChecksumId });
+      CHECK(parsed.checksumValid);
+      const auto parsedSecond = Parse(relocated[1]);
+      CHECK(parsedSecond.ids == std::vector<uint8_t> { BitstreamId, ChecksumId });
+      CHECK(parsedSecond.checksumValid);
+
+      // Other fields of the header are unchanged
+      CHECK(memcmp(&relocated[0][20], &first[20], 12) == 0);
+   }
+
+   SECTION("The first block of the file keeps the RIFF header")
+   {
+      const auto relocated = Relocate(blocks, 0, true);
+      REQUIRE(relocated.size() == 2);
+      CHECK(relocated[0] == first);
+      CHECK(relocated[1] == second);
+   }
+
+   SECTION("Only the first block keeps a RIFF header")
+   {
+      const auto withHeader = Block(100, 50,
+         { SubBlock(RiffHeaderId, RiffHeader()),
+           SubBlock(BitstreamId, bitstream) },
+         4);
+      Bytes both = first;
+      both.insert(both.end(), withHeader.begin(), withHeader.end());
+      const auto relocated = Relocate(both, 0, true);
+      REQUIRE(relocated.size() == 2);
+      CHECK(Parse(relocated[0]).ids ==
+         std::vector<uint8_t> { RiffHeaderId, BitstreamId, ChecksumId });
+      CHECK(Parse(relocated[1]).ids ==
+         std::vector<uint8_t> { BitstreamId, ChecksumId });
+   }
+
+   SECTION("A checksum that doesn't match is dropped")
+   {
+      auto corrupt = blocks;
+      // A byte of the bitstream of the first block
+      corrupt[first.size() - 8] ^= 0xff;
+      const auto relocated = Relocate(corrupt, 1000, false);
+      REQUIRE(relocated.size() == 2);
+      CHECK(Parse(relocated[0]).ids == std::vector<uint8_t> { BitstreamId });
+      CHECK(Parse(relocated[1]).checksumValid);
+   }
+
+   SECTION("Bytes that aren't whole blocks fail")
+   {
+      const auto fails = [](const Bytes& bytes) {
+         size_t written = 0;
+         const auto result = RelocateWavPackBlocks(bytes, 0, false,
+            [&](const Bytes&) { ++written; });
+         return std::make_pair(result, written);
+      };
+
+      auto truncated = blocks;
+      truncated.pop_back();
+      CHECK(fails(truncated) == std::make_pair(false, size_t(1)));
+
+      auto badId = blocks;
+      badId[first.size()] = 'x';
+      CHECK(fails(badId) == std::make_pair(false, size_t(1)));
+
+      // A sub-block that overruns its block
+      auto overrun = blocks;
+      overrun[WavPackHeaderSize + 1] = 0xff;
+      CHECK(fails(overrun) == std::make_pair(false, size_t(0)));
+   }
+}
+
+TEST_CASE("UpdateWavPackRiffHeader", "[WavPackBlocks]")
+{
+   SECTION("The RIFF and data chunks get sizes, past other chunks")
+   {
+      auto header = RiffHeader();
+      UpdateWavPackRiffHeader(header.data(), header.size(), 1001);
+      CHECK(GetLittleEndian(&header[header.size() - 4]) == 1001);
+      // The data chunk is padded to even length
+      CHECK(GetLittleEndian(&header[4]) == header.size() - 8 + 1002);
+   }
+
+   SECTION("RF64 is left as it is")
+   {
+      auto header = RiffHeader("RF64");
+      const auto original = header;
+      UpdateWavPackRiffHeader(header.data(), header.size(), 1000);
+      CHECK(header == original);
+   }
+
+   SECTION("Sizes that RIFF can't hold are left as they are")
+   {
+      auto header = RiffHeader();
+      const auto original = header;
+      UpdateWavPackRiffHeader(header.data(), header.size(), uint64_t(1) << 32);
+      CHECK(header == original);
+   }
+}
+
+TEST_CASE("UpdateWavPackNumSamples", "[WavPackBlocks]")
+{
+   auto block = Block(0, 100,
+      { SubBlock(RiffHeaderId, RiffHeader()), SubBlock(BitstreamId, { 9 }) },
+      4);
+   REQUIRE(GetWavPackTotalSamples(block.data()) == -1);
+
+   SECTION("The header and the RIFF header get the length")
+   {
+      REQUIRE(UpdateWavPackNumSamples(block.data(), block.size(), 1000, 4));
+      CHECK(GetWavPackTotalSamples(block.data()) == 1000);
+      // The data chunk size is the last field of the wrapped RIFF header
+      const auto dataSize = WavPackHeaderSize + 2 + RiffHeader().size() - 4;
+      CHECK(GetLittleEndian(&block[dataSize]) == 4000);
+      CHECK(Parse(block).checksumValid);
+   }
+
+   SECTION("Lengths of 2^32 - 1 samples and more use the high byte")
+   {
+      const int64_t total = GENERATE(
+         int64_t(0xfffffffe), int64_t(0xffffffff), (int64_t(1) << 32) + 5);
+      REQUIRE(UpdateWavPackNumSamples(block.data(), block.size(), total, 4));
+      CHECK(GetWavPackTotalSamples(block.data()) == total);
+      CHECK(Parse(block).checksumValid);
+   }
+
+   SECTION("A malformed block is left as it is")
+   {
+      const auto original = block;
+      REQUIRE(!UpdateWavPackNumSamples(block.data(), block.size() - 1, 10, 4));
+      CHECK(block == original);
+   }
+}
+} // namespace LibImportExport
@@ -10,8 +10,11 @@ Max Maisel
 ***********************************************************************/
 
 #include "Biquad.h"
+#include "BiquadStage.h"
 
+#include <algorithm>
 #include <cmath>
+#include <utility>
 #include <wx/utils.h>
 
 #define square(a) ((a)*(a))
@@ -37,8 +40,141 @@ void Biquad::Reset()
 
 void Biquad::Process(const float* pfIn, float* pfOut, int iNumSamples)
 {
-   for (int i = 0; i < iNumSamples; i++)
-      *pfOut++ = ProcessOne(*pfIn++);
+   ProcessCascade(this, 1, pfIn, pfOut, std::max(0, iNumSamples));
+}
+
+namespace {
+//! Length of the pieces in which ProcessCascade() passes through sections
+constexpr size_t CascadeChunk = 256;
+//! Most sections that ProcessCascade() passes through at once
+constexpr size_t MaxGroup = 4;
+
+//! One step of PassStages(); stages in [first, last) take the previous
+//! step's outputs of the stages before them, or the input, for the first stage
+template<typename Stage, typename Value, size_t... K>
+inline void Step(Stage (&stages)[sizeof...(K)], Value (&pipe)[sizeof...(K)],
+   Value in, size_t first, size_t last, std::index_sequence<K...>)
+{
+   // Expanded, not looped, so that the compiler can keep all in registers
+   const Value next[]{ (K >= first && K < last
+      ? stages[K].ProcessOne(K == 0 ? in : pipe[K > 0 ? K - 1 : 0])
+      : pipe[K])... };
+   ((pipe[K] = next[K]), ...);
+}
+
+//! Pass values through N consecutive stages
+/*! In the i-th step, stage k works on sample i - k, so that the stages are
+ independent within a step and their recursions can overlap
+ @param out may equal in */
+template<size_t N, typename Stage, typename Value>
+void PassStages(Stage (&stages)[N], const Value *in, Value *out, size_t count)
+{
+   constexpr auto indices = std::make_index_sequence<N>{};
+   // Latest output of each stage
+   Value pipe[N]{};
+   size_t i = 0;
+   // Fill the pipe
+   for (; i < count && i + 1 < N; ++i)
+      Step(stages, pipe, in[i], 0, i + 1, indices);
+   for (; i < count; ++i) {
+      Step(stages, pipe, in[i], 0, N, indices);
+      out[i + 1 - N] = pipe[N - 1];
+   }
+   // Drain the pipe
+   for (; i + 1 < count + N; ++i) {
+      Step(stages, pipe, Value{}, i + 1 - count, std::min(N, i + 1), indices);
+      if (i + 1 >= N)
+         out[i + 1 - N] = pipe[N - 1];
+   }
+}
+
+//! Pass samples through N consecutive sections
+template<size_t N> void PassSections(
+   Biquad *pSections, const float *in, float *out, size_t count)
+{
+   BiquadStage stages[N];
+   for (size_t k = 0; k < N; ++k)
+      stages[k].Load(pSections[k]);
+   PassStages(stages, in, out, count);
+   for (size_t k = 0; k < N; ++k)
+      stages[k].Store(pSections[k]);
+}
+
+#ifdef BIQUAD_STAGE_PAIR
+//! Pass interleaved samples of two channels through N consecutive sections
+template<size_t N> void PassSectionPairs(
+   Biquad *pLeft, Biquad *pRight, __m128d *values, size_t count)
+{
+   BiquadStagePair stages[N];
+   for (size_t k = 0; k < N; ++k)
+      stages[k].Load(pLeft[k], pRight[k]);
+   PassStages(stages, values, values, count);
+   for (size_t k = 0; k < N; ++k)
+      stages[k].Store(pLeft[k], pRight[k]);
+}
+#endif
+}
+
+void Biquad::ProcessCascade(Biquad* pSections, size_t nSections,
+   const float* pfIn, float* pfOut, size_t len)
+{
+   if (nSections == 0) {
+      std::copy(pfIn, pfIn + len, pfOut);
+      return;
+   }
+   for (size_t done = 0; done < len; done += CascadeChunk) {
+      const auto count = std::min(CascadeChunk, len - done);
+      auto in = pfIn + done;
+      const auto out = pfOut + done;
+      // Passing through several sections at once lets their recursions overlap
+      for (size_t iSection = 0; iSection < nSections; iSection += MaxGroup) {
+         const auto pSection = pSections + iSection;
+         switch (std::min(MaxGroup, nSections - iSection)) {
+         case 1: PassSections<1>(pSection, in, out, count); break;
+         case 2: PassSections<2>(pSection, in, out, count); break;
+         case 3: PassSections<3>(pSection, in, out, count); break;
+         default: PassSections<MaxGroup>(pSection, in, out, count); break;
+         }
+         in = out;
+      }
+   }
+}
+
+void Biquad::ProcessCascade(Biquad* pLeft, Biquad* pRight, size_t nSections,
+   const float* const pfIn[2], float* const pfOut[2], size_t len)
+{
+#ifdef BIQUAD_STAGE_PAIR
+   if (nSections == 0) {
+      std::copy(pfIn[0], pfIn[0] + len, pfOut[0]);
+      std::copy(pfIn[1], pfIn[1] + len, pfOut[1]);
+      return;
+   }
+   // Interleaved values of both channels, between groups of sections
+   __m128d values[CascadeChunk];
+   for (size_t done = 0; done < len; done += CascadeChunk) {
+      const auto count = std::min(CascadeChunk, len - done);
+      const auto left = pfIn[0] + done, right = pfIn[1] + done;
+      for (size_t i = 0; i < count; ++i)
+         values[i] = _mm_set_pd(right[i], left[i]);
+      for (size_t iSection = 0; iSection < nSections; iSection += MaxGroup) {
+         const auto pl = pLeft + iSection, pr = pRight + iSection;
+         switch (std::min(MaxGroup, nSections - iSection)) {
+         case 1: PassSectionPairs<1>(pl, pr, values, count); break;
+         case 2: PassSectionPairs<2>(pl, pr, values, count); break;
+         case 3: PassSectionPairs<3>(pl, pr, values, count); break;
+         default: PassSectionPairs<MaxGroup>(pl, pr, values, count); break;
+         }
+      }
+      const auto outLeft = pfOut[0] + done, outRight = pfOut[1] + done;
+      for (size_t i = 0; i < count; ++i) {
+         outLeft[i] = _mm_cvtsd_f64(values[i]);
+         outRight[i] = _mm_cvtsd_f64(_mm_unpackhi_pd(values[i], values[i]));
+      }
+   }
+#else
+   ProcessCascade(pLeft, nSections, pfIn[0], pfOut[0], len);
+   ProcessCascade(pRight, nSections, pfIn[1], pfOut[1], len);
+#endif
 }
 
 const double Biquad::s_fChebyCoeffs[MAX_Order][MAX_Order + 1] =
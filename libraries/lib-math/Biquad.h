@@ -15,12 +15,31 @@ Max Maisel
 #include "MemoryX.h"
 
 /// \brief Represents a biquad digital filter.
-struct Biquad
+struct MATH_API Biquad
 {
    Biquad();
    void Reset();
    void Process(const float* pfIn, float* pfOut, int iNumSamples);
 
+   //! Filter through a cascade of sections, each one's output the next one's input
+   /*!
+    Gives the same results as calling Process() on each section in turn, but
+    passes through the sections in pieces of the block small enough to stay in
+    cache.  Allocates nothing, so it may be used in realtime processing.
+    @param pfOut may equal pfIn
+    */
+   static void ProcessCascade(Biquad* pSections, size_t nSections,
+      const float* pfIn, float* pfOut, size_t len);
+
+   //! ProcessCascade() for two channels at once, each with its own sections
+   /*!
+    Where the processor has vector registers for doubles, the channels share
+    them, with the same results as processing each channel alone.
+    @param pfOut may equal pfIn
+    */
+   static void ProcessCascade(Biquad* pLeft, Biquad* pRight, size_t nSections,
+      const float* const pfIn[2], float* const pfOut[2], size_t len);
+
    enum
    {
       /// Numerator coefficient indices
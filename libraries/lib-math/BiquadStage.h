@@ -0,0 +1,113 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  BiquadStage.h
+
+  @brief Biquad state in registers, for loops over blocks of samples
+
+**********************************************************************/
+#ifndef __AUDACITY_BIQUAD_STAGE__
+#define __AUDACITY_BIQUAD_STAGE__
+
+#include "Biquad.h"
+
+#if defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64) || \
+   (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BIQUAD_STAGE_PAIR
+#include <emmintrin.h>
+#endif
+
+//! Biquad::ProcessOne() with the state in locals, which lets the compiler
+//! keep it in registers and overlap the recursions of several sections
+struct BiquadStage {
+   void Load(const Biquad &biquad)
+   {
+      b0 = biquad.fNumerCoeffs[Biquad::B0];
+      b1 = biquad.fNumerCoeffs[Biquad::B1];
+      b2 = biquad.fNumerCoeffs[Biquad::B2];
+      a1 = biquad.fDenomCoeffs[Biquad::A1];
+      a2 = biquad.fDenomCoeffs[Biquad::A2];
+      prevIn = biquad.fPrevIn;
+      prevPrevIn = biquad.fPrevPrevIn;
+      prevOut = biquad.fPrevOut;
+      prevPrevOut = biquad.fPrevPrevOut;
+   }
+
+   void Store(Biquad &biquad) const
+   {
+      biquad.fPrevIn = prevIn;
+      biquad.fPrevPrevIn = prevPrevIn;
+      biquad.fPrevOut = prevOut;
+      biquad.fPrevPrevOut = prevPrevOut;
+   }
+
+   float ProcessOne(float in)
+   {
+      // Same operations in the same order as Biquad::ProcessOne()
+      double out = double(in) * b0 + prevIn * b1 + prevPrevIn * b2
+         - prevOut * a1 - prevPrevOut * a2;
+      prevPrevIn = prevIn;
+      prevIn = in;
+      prevPrevOut = prevOut;
+      prevOut = out;
+      return out;
+   }
+
+   double b0, b1, b2, a1, a2;
+   double prevIn, prevPrevIn, prevOut, prevPrevOut;
+};
+
+#ifdef BIQUAD_STAGE_PAIR
+//! BiquadStage for two channels, one in each lane, computing exactly as
+//! BiquadStage
+struct BiquadStagePair {
+   void Load(const Biquad &left, const Biquad &right)
+   {
+      const auto load = [](double l, double r){ return _mm_set_pd(r, l); };
+      b0 = load(left.fNumerCoeffs[Biquad::B0], right.fNumerCoeffs[Biquad::B0]);
+      b1 = load(left.fNumerCoeffs[Biquad::B1], right.fNumerCoeffs[Biquad::B1]);
+      b2 = load(left.fNumerCoeffs[Biquad::B2], right.fNumerCoeffs[Biquad::B2]);
+      a1 = load(left.fDenomCoeffs[Biquad::A1], right.fDenomCoeffs[Biquad::A1]);
+      a2 = load(left.fDenomCoeffs[Biquad::A2], right.fDenomCoeffs[Biquad::A2]);
+      prevIn = load(left.fPrevIn, right.fPrevIn);
+      prevPrevIn = load(left.fPrevPrevIn, right.fPrevPrevIn);
+      prevOut = load(left.fPrevOut, right.fPrevOut);
+      prevPrevOut = load(left.fPrevPrevOut, right.fPrevPrevOut);
+   }
+
+   void Store(Biquad &left, Biquad &right) const
+   {
+      const auto store = [](__m128d v, double &l, double &r){
+         l = _mm_cvtsd_f64(v);
+         r = _mm_cvtsd_f64(_mm_unpackhi_pd(v, v));
+      };
+      store(prevIn, left.fPrevIn, right.fPrevIn);
+      store(prevPrevIn, left.fPrevPrevIn, right.fPrevPrevIn);
+      store(prevOut, left.fPrevOut, right.fPrevOut);
+      store(prevPrevOut, left.fPrevPrevOut, right.fPrevPrevOut);
+   }
+
+   //! @param in values of floats
+   //! @return values of floats
+   __m128d ProcessOne(__m128d in)
+   {
+      __m128d out = _mm_add_pd(_mm_mul_pd(in, b0), _mm_mul_pd(prevIn, b1));
+      out = _mm_add_pd(out, _mm_mul_pd(prevPrevIn, b2));
+      out = _mm_sub_pd(out, _mm_mul_pd(prevOut, a1));
+      out = _mm_sub_pd(out, _mm_mul_pd(prevPrevOut, a2));
+      prevPrevIn = prevIn;
+      prevIn = in;
+      prevPrevOut = prevOut;
+      prevOut = out;
+      // Round to float, as Biquad::ProcessOne() returns
+      return _mm_cvtps_pd(_mm_cvtpd_ps(out));
+   }
+
+   __m128d b0, b1, b2, a1, a2;
+   __m128d prevIn, prevPrevIn, prevOut, prevPrevOut;
+};
+#endif
+
+#endif
@@ -9,7 +9,10 @@ Max Maisel
 ***********************************************************************/
 
 #include "EBUR128.h"
+#include "BiquadStage.h"
+#include <algorithm>
 #include <cstring>
+#include <numeric>
 
 EBUR128::EBUR128(double rate, size_t channels)
    : mChannelCount{ channels }
@@ -19,6 +22,8 @@ EBUR128::EBUR128(double rate, size_t channels)
 {
    mLoudnessHist.reinit(HIST_BIN_COUNT, false);
    mBlockRingBuffer.reinit(mBlockSize);
+   mSegmentSums.reinit((mBlockSize + mBlockOverlap - 1) / mBlockOverlap, true);
+   mPowers.reinit(CHUNK_SIZE);
    mWeightingFilter.reinit(mChannelCount, false);
    for(size_t channel = 0; channel < mChannelCount; ++channel)
       mWeightingFilter[channel] = CalcWeightingFilter(mRate);
@@ -97,19 +102,126 @@ void EBUR128::ProcessSampleFromChannel(float x_in, size_t channel) const
 
 void EBUR128::NextSample()
 {
-   ++mBlockRingPos;
-   ++mBlockRingSize;
+   Advance(mBlockRingBuffer[mBlockRingPos], 1);
+}
+
+namespace {
+//! Weight N channels at once through their filter cascades, and store or
+//! add the sum of their powers
+template<size_t N> void Weight(ArrayOf<Biquad> *filters,
+   const float *const *channels, size_t offset, size_t len,
+   double *powers, bool add)
+{
+   BiquadStage hsf[N], hpf[N];
+   const float *inputs[N];
+   for (size_t ii = 0; ii < N; ++ii) {
+      hsf[ii].Load(filters[ii][0]);
+      hpf[ii].Load(filters[ii][1]);
+      inputs[ii] = channels[ii] + offset;
+   }
+   for (size_t i = 0; i < len; ++i) {
+      double power = add ? powers[i] : 0.0;
+      for (size_t ii = 0; ii < N; ++ii) {
+         const double value =
+            hpf[ii].ProcessOne(hsf[ii].ProcessOne(inputs[ii][i]));
+         power += value * value;
+      }
+      powers[i] = power;
+   }
+   for (size_t ii = 0; ii < N; ++ii) {
+      hsf[ii].Store(filters[ii][0]);
+      hpf[ii].Store(filters[ii][1]);
+   }
+}
+
+#ifdef BIQUAD_STAGE_PAIR
+template<> void Weight<2>(ArrayOf<Biquad> *filters,
+   const float *const *channels, size_t offset, size_t len,
+   double *powers, bool add)
+{
+   BiquadStagePair hsf, hpf;
+   hsf.Load(filters[0][0], filters[1][0]);
+   hpf.Load(filters[0][1], filters[1][1]);
+   const auto left = channels[0] + offset, right = channels[1] + offset;
+   for (size_t i = 0; i < len; ++i) {
+      const auto value = hpf.ProcessOne(
+         hsf.ProcessOne(_mm_set_pd(right[i], left[i])));
+      const auto squares = _mm_mul_pd(value, value);
+      // Add in the same order as the general template
+      double power = add ? powers[i] : 0.0;
+      power += _mm_cvtsd_f64(squares);
+      power += _mm_cvtsd_f64(_mm_unpackhi_pd(squares, squares));
+      powers[i] = power;
+   }
+   hsf.Store(filters[0][0], filters[1][0]);
+   hpf.Store(filters[0][1], filters[1][1]);
+}
+#endif
+}
+
+void EBUR128::ProcessSamples(const float *const *channels, size_t len)
+{
+   const auto powers = mPowers.get();
+   for (size_t done = 0; done < len;) {
+      const auto count = std::min(CHUNK_SIZE, len - done);
+
+      // Channels in pairs, which may share vector registers
+      size_t channel = 0;
+      for (; channel + 1 < mChannelCount; channel += 2)
+         Weight<2>(&mWeightingFilter[channel], channels + channel,
+            done, count, powers, channel > 0);
+      if (channel < mChannelCount)
+         Weight<1>(&mWeightingFilter[channel], channels + channel,
+            done, count, powers, channel > 0);
+
+      // Copy into the ring, in stretches that end at block boundaries
+      for (size_t i = 0; i < count;) {
+         const auto pos = mBlockRingPos;
+         const auto stretch = std::min({ count - i,
+            mBlockOverlap - pos % mBlockOverlap, mBlockSize - pos });
+         std::copy(powers + i, powers + i + stretch,
+            mBlockRingBuffer.get() + pos);
+         Advance(std::accumulate(powers + i, powers + i + stretch, 0.0),
+            stretch);
+         i += stretch;
+      }
+      done += count;
+   }
+}
+
+void EBUR128::Advance(double sum, size_t len)
+{
+   // Stretches of input never cross a segment boundary
+   auto &segmentSum = mSegmentSums[mBlockRingPos / mBlockOverlap];
+   if (mBlockRingPos % mBlockOverlap == 0)
+      segmentSum = sum;
+   else
+      segmentSum += sum;
+
+   mBlockRingPos += len;
+   mBlockRingSize += len;
 
    if(mBlockRingPos % mBlockOverlap == 0)
    {
       // A new full block of samples was submitted.
-      if(mBlockRingSize >= mBlockSize)
-         AddBlockToHistogram(mBlockSize);
+      if(mBlockRingSize >= mBlockSize) {
+         const auto nSegments =
+            (mBlockSize + mBlockOverlap - 1) / mBlockOverlap;
+         const auto blockSum = std::accumulate(
+            mSegmentSums.get(), mSegmentSums.get() + nSegments, 0.0);
+         mLastBlockPower = blockSum / double(mBlockSize);
+         AddSumToHistogram(blockSum, mBlockSize);
+      }
    }
    // Close the ring.
    if(mBlockRingPos == mBlockSize)
       mBlockRingPos = 0;
-   ++mSampleCount;
+   mSampleCount += len;
+}
+
+double EBUR128::MomentaryLoudness() const
+{
+   return 0.8529037031 * mLastBlockPower;
 }
 
 double EBUR128::IntegrativeLoudness()
@@ -165,6 +277,14 @@ EBUR128::HistogramSums(size_t start_idx, double& sum_v, long int& sum_c) const
 /// However, allow to override the block size if the audio to be
 /// processed is shorter than one block.
 void EBUR128::AddBlockToHistogram(size_t validLen)
+{
+   double blockVal = 0;
+   for(size_t i = 0; i < validLen; ++i)
+      blockVal += mBlockRingBuffer[i];
+   AddSumToHistogram(blockVal, validLen);
+}
+
+void EBUR128::AddSumToHistogram(double blockVal, size_t validLen)
 {
    // Reset mBlockRingSize to full state to avoid overflow.
    // The actual value of mBlockRingSize does not matter
@@ -172,9 +292,6 @@ void EBUR128::AddBlockToHistogram(size_t validLen)
    mBlockRingSize = mBlockSize;
 
    size_t idx;
-   double blockVal = 0;
-   for(size_t i = 0; i < validLen; ++i)
-      blockVal += mBlockRingBuffer[i];
 
    // Histogram values are simplified log10() immediate values
    // without -0.691 + 10*(...) to safe computing power. This is
@@ -18,7 +18,14 @@ Max Maisel
 #include <cmath>
 
 /// \brief Implements EBU-R128 loudness measurement.
-class EBUR128
+/*!
+ Feed it whole buffers with ProcessSamples(), or one sample at a time with
+ ProcessSampleFromChannel() and NextSample(); the two may be mixed.  Suitable
+ for analysis before processing, as during export, or for metering, though
+ so far only the Loudness effect uses it; export and the meters do not yet
+ measure loudness.
+ */
+class MATH_API EBUR128
 {
 public:
    EBUR128(double rate, size_t channels);
@@ -27,24 +34,47 @@ public:
    ~EBUR128() = default;
 
    static ArrayOf<Biquad> CalcWeightingFilter(double fs);
+
+   size_t GetChannelCount() const { return mChannelCount; }
+
+   //! Weight and gate `len` samples of each channel
+   /*!
+    @pre `channels` points to `GetChannelCount()` buffers
+    */
+   void ProcessSamples(const float *const *channels, size_t len);
+
    void ProcessSampleFromChannel(float x_in, size_t channel) const;
    void NextSample();
    double IntegrativeLoudness();
+   //! Loudness of the last complete 400 ms block, on the scale of
+   //! IntegrativeLoudness(), or 0 if there is none yet
+   double MomentaryLoudness() const;
    inline double IntegrativeLoudnessToLUFS(double loudness)
       { return 10 * log10(loudness); }
 
 private:
    void HistogramSums(size_t start_idx, double& sum_v, long int& sum_c) const;
    void AddBlockToHistogram(size_t validLen);
+   void AddSumToHistogram(double blockSum, size_t validLen);
+   //! Add to the sum of the current 100 ms segment of the ring, and
+   //! update the histogram after completing each 400 ms block
+   void Advance(double sum, size_t len);
 
    static constexpr size_t HIST_BIN_COUNT = 65536;
+   //! Number of samples ProcessSamples() weights at once
+   static constexpr size_t CHUNK_SIZE = 4096;
    /// EBU R128 absolute threshold
    static constexpr double GAMMA_A = (-70.0 + 0.691) / 10.0;
    ArrayOf<long int> mLoudnessHist;
    Doubles mBlockRingBuffer;
+   //! Sums of the ring buffer, for each stretch of mBlockOverlap samples
+   Doubles mSegmentSums;
+   //! Weighted powers, summed over channels, for ProcessSamples()
+   Doubles mPowers;
    size_t mSampleCount{ 0 };
    size_t mBlockRingPos{ 0 };
    size_t mBlockRingSize{ 0 };
+   double mLastBlockPower{ 0 };
    const size_t mChannelCount;
    const double mRate;
    const size_t mBlockSize;
@@ -0,0 +1,87 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  BiquadTests.cpp
+
+**********************************************************************/
+#include "Biquad.h"
+
+#include <catch2/catch.hpp>
+
+#include <cmath>
+#include <vector>
+
+namespace {
+std::vector<float> Noise(size_t length, unsigned seed)
+{
+   std::vector<float> result(length);
+   for (auto &value : result) {
+      seed = seed * 1664525u + 1013904223u;
+      value = (seed >> 8) / float(1 << 23) - 1.0f;
+   }
+   return result;
+}
+
+//! The reference: each sample through each section in turn
+std::vector<float> Filter(ArrayOf<Biquad> &sections, size_t nSections,
+   const std::vector<float> &input)
+{
+   auto result = input;
+   for (auto &value : result)
+      for (size_t ii = 0; ii < nSections; ++ii)
+         value = sections[ii].ProcessOne(value);
+   return result;
+}
+}
+
+TEST_CASE("Biquad::ProcessCascade")
+{
+   const int order = 7;
+   const size_t nSections = (order + 1) / 2;
+   const auto make = [&]{
+      return Biquad::CalcChebyshevType1Filter(
+         order, 22050, 1000, 0.5, Biquad::kLowPass);
+   };
+   // Not a multiple of the internal chunk size
+   const size_t length = 10000;
+   const auto left = Noise(length, 1), right = Noise(length, 2);
+   auto expectedLeftFilter = make(), expectedRightFilter = make();
+   const auto expectedLeft = Filter(expectedLeftFilter, nSections, left);
+   const auto expectedRight = Filter(expectedRightFilter, nSections, right);
+
+   // Cut the input into blocks, as realtime processing would
+   const size_t blockSize = 333;
+
+   SECTION("One channel, in place")
+   {
+      auto filter = make();
+      auto output = left;
+      for (size_t done = 0; done < length; done += blockSize)
+         Biquad::ProcessCascade(filter.get(), nSections,
+            output.data() + done, output.data() + done,
+            std::min(blockSize, length - done));
+      REQUIRE(output == expectedLeft);
+   }
+
+   SECTION("Two channels")
+   {
+      auto leftFilter = make(), rightFilter = make();
+      std::vector<float> outLeft(length), outRight(length);
+      for (size_t done = 0; done < length; done += blockSize) {
+         const float *const inputs[2]{ left.data() + done, right.data() + done };
+         float *const outputs[2]{ outLeft.data() + done, outRight.data() + done };
+         Biquad::ProcessCascade(leftFilter.get(), rightFilter.get(), nSections,
+            inputs, outputs, std::min(blockSize, length - done));
+      }
+      REQUIRE(outLeft == expectedLeft);
+      REQUIRE(outRight == expectedRight);
+      // Filter states were kept too
+      for (size_t ii = 0; ii < nSections; ++ii) {
+         REQUIRE(leftFilter[ii].fPrevOut == expectedLeftFilter[ii].fPrevOut);
+         REQUIRE(rightFilter[ii].fPrevPrevIn
+            == expectedRightFilter[ii].fPrevPrevIn);
+      }
+   }
+}
@@ -0,0 +1,82 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  EBUR128Tests.cpp
+
+**********************************************************************/
+#include "EBUR128.h"
+
+#include <catch2/catch.hpp>
+
+#include <vector>
+
+namespace {
+std::vector<float> Sine(double rate, double frequency, float amplitude,
+   size_t length)
+{
+   std::vector<float> result(length);
+   for (size_t i = 0; i < length; ++i)
+      result[i] = amplitude * std::sin(2 * M_PI * frequency * i / rate);
+   return result;
+}
+}
+
+TEST_CASE("EBUR128")
+{
+   SECTION("997 Hz sine at -20 dBFS measures -23 LUFS")
+   {
+      const double rate = 48000;
+      const auto signal = Sine(rate, 997, 0.1f, 10 * rate);
+      EBUR128 meter{ rate, 1 };
+      const float *const channels[]{ signal.data() };
+      meter.ProcessSamples(channels, signal.size());
+      const auto lufs =
+         meter.IntegrativeLoudnessToLUFS(meter.IntegrativeLoudness());
+      REQUIRE(lufs == Approx(-23.01).margin(0.05));
+      REQUIRE(meter.IntegrativeLoudnessToLUFS(meter.MomentaryLoudness())
+         == Approx(-23.01).margin(0.05));
+   }
+
+   SECTION("Buffers give the same result as single samples")
+   {
+      // A rate where blocks are not a whole number of segments
+      const double rate = 11025;
+      const size_t length = 7 * rate + 123;
+      const auto left = Sine(rate, 440, 0.5f, length);
+      auto right = Sine(rate, 3000, 0.05f, length);
+      // Quiet passage, below the relative gate
+      for (size_t i = 2 * rate; i < 4 * rate; ++i)
+         right[i] *= 0.01f;
+
+      EBUR128 bySample{ rate, 2 };
+      for (size_t i = 0; i < length; ++i) {
+         bySample.ProcessSampleFromChannel(left[i], 0);
+         bySample.ProcessSampleFromChannel(right[i], 1);
+         bySample.NextSample();
+      }
+
+      EBUR128 byBuffer{ rate, 2 };
+      // Uneven buffer lengths
+      for (size_t pos = 0, len = 1000; pos < length; pos += len, len += 777) {
+         len = std::min(len, length - pos);
+         const float *const channels[]{ left.data() + pos, right.data() + pos };
+         byBuffer.ProcessSamples(channels, len);
+      }
+
+      REQUIRE(byBuffer.IntegrativeLoudness() ==
+         Approx(bySample.IntegrativeLoudness()).epsilon(1e-6));
+   }
+
+   SECTION("Input shorter than one block")
+   {
+      const double rate = 44100;
+      const auto signal = Sine(rate, 1000, 0.1f, rate / 10);
+      EBUR128 meter{ rate, 1 };
+      const float *const channels[]{ signal.data() };
+      meter.ProcessSamples(channels, signal.size());
+      REQUIRE(meter.IntegrativeLoudness() > 0);
+      REQUIRE(meter.MomentaryLoudness() == 0);
+   }
+}
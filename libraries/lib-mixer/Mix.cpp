@@ -269,6 +269,18 @@ static void MixBuffers(unsigned numChannels,
 #define stackAllocate(T, count) static_cast<T*>(alloca(count * sizeof(T)))
 
 size_t Mixer::Process(const size_t maxToProcess)
+{
+   const auto destinations = stackAllocate(ChannelDestination, mNumChannels);
+   const auto size = SAMPLE_SIZE(mFormat);
+   for (size_t c = 0; c < mNumChannels; ++c)
+      destinations[c] = mInterleaved
+         ? ChannelDestination{ mBuffer[0].ptr() + c * size, mNumChannels }
+         : ChannelDestination{ mBuffer[c].ptr(), 1 };
+   return Process(maxToProcess, destinations);
+}
+
+size_t Mixer::Process(const size_t maxToProcess,
+   const ChannelDestination destinations[])
 {
    assert(maxToProcess <= BufferSize());
 
@@ -355,18 +367,13 @@ size_t Mixer::Process(const size_t maxToProcess)
    else
       mTime = std::clamp(mTime, oldTime, mT1);
 
-   const auto dstStride = (mInterleaved ? mNumChannels : 1);
    auto ditherType = mNeedsDither
       ? (mHighQuality ? gHighQualityDither : gLowQualityDither)
       : DitherType::none;
    for (size_t c = 0; c < mNumChannels; ++c)
       CopySamples((constSamplePtr)mTemp[c].data(), floatSample,
-         (mInterleaved
-            ? mBuffer[0].ptr() + (c * SAMPLE_SIZE(mFormat))
-            : mBuffer[c].ptr()
-         ),
-         mFormat, maxOut, ditherType,
-         1, dstStride);
+         destinations[c].buffer, mFormat, maxOut, ditherType,
+         1, destinations[c].stride);
 
    // MB: this doesn't take warping into account, replaced with code based on mSamplePos
    //mT += (maxOut / mRate);
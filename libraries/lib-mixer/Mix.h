@@ -44,6 +44,13 @@ class MIXER_API Mixer {
    };
    using Inputs = std::vector<Input>;
 
+   //! Where Process() may write one channel of output, in Format()
+   struct ChannelDestination {
+      samplePtr buffer;
+      //! Samples from one sample of the channel to the next
+      size_t stride{ 1 };
+   };
+
    enum class ApplyGain
    {
       Discard,//< No source gain is applied
@@ -77,6 +84,10 @@ class MIXER_API Mixer {
    virtual ~ Mixer();
 
    size_t BufferSize() const { return mBufferSize; }
+   unsigned NumChannels() const { return mNumChannels; }
+   bool IsInterleaved() const { return mInterleaved; }
+   //! Format of the output buffers
+   sampleFormat Format() const { return mFormat; }
 
    //
    // Processing
@@ -97,6 +108,19 @@ class MIXER_API Mixer {
     */
    size_t Process() { return Process(BufferSize()); }
 
+   //! Like Process(maxSamples), but write into the given buffers, leaving
+   //! those at GetBuffer() unchanged
+   /*!
+    The conversion to Format(), with dither, is the only pass that writes
+    the destinations, so they may be buffers of an encoder, or interleave
+    channels in any way.
+    @pre `maxSamples <= BufferSize()`
+    @pre `destinations` has NumChannels() elements, each with room for
+    `maxSamples` samples at its stride
+    @post result: `result <= maxSamples`
+    */
+   size_t Process(size_t maxSamples, const ChannelDestination destinations[]);
+
    //! Reposition processing to absolute time next time Process() is called.
    void Reposition(double t, bool bSkipping = false);
 
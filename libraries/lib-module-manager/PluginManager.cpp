@@ -867,6 +867,9 @@ void PluginManager::LoadGroup(audacity::BasicSettings *pRegistry, PluginType typ
 
 void PluginManager::Save()
 {
+   if (mReadOnly)
+      return;
+
    // Create/Open the registry
    auto pRegistry = sFactory(FileNames::PluginRegistry());
    auto &registry = *pRegistry;
@@ -103,6 +103,10 @@ public:
    void Initialize(ConfigFactory factory);
    void Terminate();
 
+   //! When true, Save() does nothing; for processes that share the registry
+   //! with another that maintains it
+   void SetReadOnly(bool readOnly) { mReadOnly = readOnly; }
+
    bool DropFile(const wxString &fileName);
 
    static PluginManager & Get();
@@ -232,6 +236,7 @@ private:
    std::unique_ptr<audacity::BasicSettings> mSettings;
 
    bool mDirty;
+   bool mReadOnly{ false };
    int mCurrentIndex;
 
    PluginMap mRegisteredPlugins;
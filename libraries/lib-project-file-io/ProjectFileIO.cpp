@@ -2150,9 +2150,22 @@ bool ProjectFileIO::UpdateSaved(const TrackList *tracks)
 // REVIEW: This function is believed to report an error to the user in all cases 
 // of failure.  Callers are believed not to need to do so if they receive 'false'.
 // LLL: All failures checks should now be displaying an error.
+namespace {
+//! The saved project must not refer to files outside of it
+/*! Failures were already reported to the user */
+bool MaterializeDeferredBlocks(AudacityProject &project)
+{
+   return WaveTrackFactory::Get(project)
+      .GetSampleBlockFactory()->MaterializeDeferred();
+}
+}
+
 bool ProjectFileIO::SaveProject(
    const FilePath &fileName, const TrackList *lastSaved)
 {
+   if (!MaterializeDeferredBlocks(mProject))
+      return false;
+
    // In the case where we're saving a temporary project to a permanent project,
    // we'll try to simply rename the project to save a bit of time. We then fall
    // through to the normal Save (not SaveAs) processing.
@@ -2359,6 +2372,8 @@ bool ProjectFileIO::SaveProject(
 
 bool ProjectFileIO::SaveCopy(const FilePath& fileName)
 {
+   if (!MaterializeDeferredBlocks(mProject))
+      return false;
    return CopyTo(fileName, XO("Backing up project"), false, true,
       {&TrackList::Get(mProject)});
 }
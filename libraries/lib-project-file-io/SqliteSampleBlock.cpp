@@ -13,12 +13,14 @@ Paul Licameli -- split from SampleBlock.cpp and SampleBlock.h
 
 #include "BasicUI.h"
 #include "DBConnection.h"
+#include "FileException.h"
 #include "ProjectFileIO.h"
 #include "SampleFormat.h"
 #include "AudioSegmentSampleView.h"
 #include "XMLTagHandler.h"
 
 #include "SampleBlock.h" // to inherit
+#include "SampleFileRange.h"
 #include "UndoManager.h"
 #include "UndoTracks.h"
 #include "WaveTrack.h"
@@ -27,7 +29,12 @@ Paul Licameli -- split from SampleBlock.cpp and SampleBlock.h
 #include "SentryHelper.h"
 #include <wx/log.h>
 
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <limits>
 #include <mutex>
+#include <set>
 
 class SqliteSampleBlockFactory;
 
@@ -57,6 +64,13 @@ public:
 
    void Delete();
 
+   //! Read samples from the file until Materialize()
+   void SetDeferred(
+      std::shared_ptr<const SampleFileRange> pRange, sampleFormat format);
+
+   //! Copy the samples of a deferred block into the database
+   void Materialize();
+
    SampleBlockID GetBlockID() const override;
 
    size_t DoGetSamples(samplePtr dest,
@@ -82,7 +96,33 @@ public:
    void SaveXML(XMLWriter &xmlFile) override;
 
 private:
+   //! State of a block whose samples are not yet in the database
+   struct Deferred
+   {
+      std::shared_ptr<const SampleFileRange> pRange;
+
+      //! Computed on first use
+      std::once_flag summaryFlag;
+      std::vector<float> summary64k;
+      MinMaxRMS minMaxRMS;
+   };
+
+   //! Deferred blocks, like silent blocks, have nonpositive ids and no rows
    bool IsSilent() const { return mBlockID <= 0; }
+   std::shared_ptr<Deferred> GetDeferred() const
+   {
+      // Another thread may read while Materialize() resets the pointer
+      return std::atomic_load(&mpDeferred);
+   }
+   //! Min, max and rms of each frame of samples, the last frame maybe short
+   /*! @return the number of frames */
+   static size_t SummarizeFrames(
+      const float *samples, size_t len, size_t frameLength, float *dest);
+   //! Summarize the whole of a deferred block, once
+   static void CalcDeferredSummary(Deferred &deferred);
+   //! Non-throwing, fills with zeroes on failure
+   static bool GetDeferredSummary(Deferred &deferred,
+      float *dest, size_t frameoffset, size_t numframes, size_t frameLength);
    void Load(SampleBlockID sbid);
    bool GetSummary(float *dest,
                    size_t frameoffset,
@@ -118,7 +158,9 @@ private:
    bool mValid{ false };
    bool mLocked = false;
 
-   SampleBlockID mBlockID{ 0 };
+   //! Atomic, because Materialize() sets it on the main thread while other
+   //! threads may read the block
+   std::atomic<SampleBlockID> mBlockID{ 0 };
 
    ArrayOf<char> mSamples;
    size_t mSampleBytes;
@@ -131,6 +173,9 @@ private:
    double mSumMax;
    double mSumRms;
 
+   //! Null after Materialize(), or for blocks not created deferred
+   std::shared_ptr<Deferred> mpDeferred;
+
 #if defined(WORDS_BIGENDIAN)
 #error All sample block data is little endian...big endian not yet supported
 #endif
@@ -142,6 +187,11 @@ private:
 static std::map< SampleBlockID, std::shared_ptr<SqliteSampleBlock> >
    sSilentBlocks;
 
+// Deferred blocks are given ids below any that encode silence, until they
+// are materialized
+static SampleBlockID sNextDeferredID =
+   std::numeric_limits<SampleBlockID>::min();
+
 ///\brief Implementation of @ref SampleBlockFactory using Sqlite database
 class SqliteSampleBlockFactory final
    : public SampleBlockFactory
@@ -169,6 +219,12 @@ public:
    SampleBlockPtr DoCreateFromId(
       sampleFormat srcformat, SampleBlockID id) override;
 
+   SampleBlockPtr DoCreateDeferred(
+      const std::shared_ptr<const SampleFileRange> &pRange,
+      sampleFormat format) override;
+
+   bool MaterializeDeferred() override;
+
    SampleBlock::DeletionCallback GetSampleBlockDeletionCallback() const
    {
       return mSampleBlockDeletionCallback;
@@ -178,6 +234,13 @@ private:
    void OnBeginPurge(size_t begin, size_t end);
    void OnEndPurge();
 
+   //! Materialize deferred blocks in later idle time
+   void ScheduleMaterialize();
+   void MaterializeSome();
+   //! Materialize the first of mDeferredBlocks, if it still exists
+   /*! @return false, leaving it first, if that failed */
+   bool MaterializeFirst();
+
    friend SqliteSampleBlock;
 
    AudacityProject &mProject;
@@ -192,6 +255,14 @@ private:
    using AllBlocksMap =
       std::map< SampleBlockID, std::weak_ptr< SqliteSampleBlock > >;
    AllBlocksMap mAllBlocks;
+
+   //! Deferred blocks in the order of creation, which get ids when
+   //! materialized
+   std::deque< std::weak_ptr< SqliteSampleBlock > > mDeferredBlocks;
+   bool mMaterializeScheduled{ false };
+
+   //! Files that blocks of the project referred to, but could not be read
+   std::set<FilePath> mMissingFiles;
 };
 
 SqliteSampleBlockFactory::SqliteSampleBlockFactory( AudacityProject &project )
@@ -256,9 +327,96 @@ SampleBlockPtr SqliteSampleBlockFactory::DoCreateSilent(
 }
 
 
+SampleBlockPtr SqliteSampleBlockFactory::DoCreateDeferred(
+   const std::shared_ptr<const SampleFileRange> &pRange, sampleFormat format)
+{
+   auto sb = std::make_shared<SqliteSampleBlock>(shared_from_this());
+   sb->SetDeferred(pRange, format);
+   mDeferredBlocks.push_back(sb);
+   ScheduleMaterialize();
+   return sb;
+}
+
+void SqliteSampleBlockFactory::ScheduleMaterialize()
+{
+   if (mMaterializeScheduled)
+      return;
+   mMaterializeScheduled = true;
+   BasicUI::CallAfter([wFactory = weak_from_this()]{
+      if (auto pFactory = wFactory.lock())
+         pFactory->MaterializeSome();
+   });
+}
+
+void SqliteSampleBlockFactory::MaterializeSome()
+{
+   mMaterializeScheduled = false;
+
+   // Yield to other events after a short while
+   using namespace std::chrono;
+   const auto deadline = steady_clock::now() + milliseconds{ 50 };
+   while (!mDeferredBlocks.empty() && steady_clock::now() < deadline)
+      // After a failure, such as a full disk, leave the blocks deferred
+      if (!MaterializeFirst())
+         return;
+
+   if (!mDeferredBlocks.empty())
+      ScheduleMaterialize();
+}
+
+bool SqliteSampleBlockFactory::MaterializeFirst()
+{
+   // The block may be gone already, if it was discarded by undo
+   if (const auto sb = mDeferredBlocks.front().lock()) {
+      if (!GuardedCall<bool>(
+         [&]{ sb->Materialize(); return true; }, MakeSimpleGuard(false)))
+         return false;
+      mAllBlocks[ sb->GetBlockID() ] = sb;
+   }
+   mDeferredBlocks.pop_front();
+   return true;
+}
+
+bool SqliteSampleBlockFactory::MaterializeDeferred()
+{
+   const auto total = mDeferredBlocks.size();
+   if (total == 0)
+      return true;
+
+   using namespace BasicUI;
+   const auto progress = MakeProgress(XO("Progress"),
+      XO("Copying imported audio into the project"), 0);
+   for (size_t done = 0; !mDeferredBlocks.empty(); ++done) {
+      if (!MaterializeFirst())
+         return false;
+      if (progress)
+         progress->Poll(done + 1, total);
+   }
+   return true;
+}
+
 SampleBlockPtr SqliteSampleBlockFactory::DoCreateFromXML(
    sampleFormat srcformat, const AttributesList &attrs )
 {
+   // A block saved before it was materialized refers to a file
+   try {
+      if (auto pRange = SampleFileRange::FromXML(attrs))
+         return DoCreateDeferred(pRange, srcformat);
+   }
+   catch (const FileException &e) {
+      // Don't throw out of XML handling; let the project open, with silence
+      // for the samples that are missing, and say so once for each file
+      const auto path = e.fileName.GetFullPath();
+      if (mMissingFiles.insert(path).second)
+         BasicUI::CallAfter([path]{
+            BasicUI::ShowMessageBox(XO(
+"The project refers to audio in the file \"%s\", which is missing or shorter than when it was imported.\n\nThat audio is replaced with silence.")
+               .Format(path));
+         });
+      return DoCreateSilent(
+         SampleFileRange::GetLengthFromXML(attrs), floatSample);
+   }
+
    // loop through attrs, which is a null-terminated list of attribute-value pairs
    for (auto pair : attrs)
    {
@@ -399,6 +557,121 @@ void SqliteSampleBlock::CloseLock() noexcept
    mLocked = true;
 }
 
+void SqliteSampleBlock::SetDeferred(
+   std::shared_ptr<const SampleFileRange> pRange, sampleFormat format)
+{
+   SetSizes(pRange->GetSampleCount(), format);
+   mBlockID = sNextDeferredID++;
+
+   auto pDeferred = std::make_shared<Deferred>();
+   pDeferred->pRange = move(pRange);
+   mpDeferred = move(pDeferred);
+   mValid = true;
+}
+
+void SqliteSampleBlock::Materialize()
+{
+   const auto pDeferred = GetDeferred();
+   if (!pDeferred)
+      return;
+
+   mSamples.reinit(mSampleBytes);
+   pDeferred->pRange->Read(mSamples.get(), mSampleFormat, 0, mSampleCount);
+
+   auto sizes = SetSizes(mSampleCount, mSampleFormat);
+   CalcSummary(sizes);
+   Commit(sizes);
+
+   // Readers that already hold the deferred state may finish with it
+   std::atomic_store(&mpDeferred, std::shared_ptr<Deferred>{});
+}
+
+size_t SqliteSampleBlock::SummarizeFrames(
+   const float *samples, size_t len, size_t frameLength, float *dest)
+{
+   const auto frames = (len + frameLength - 1) / frameLength;
+   for (size_t ii = 0; ii < frames; ++ii, samples += frameLength) {
+      const auto jcount = std::min(frameLength, len - ii * frameLength);
+      float min = samples[0];
+      float max = samples[0];
+      float sumsq = 0;
+      for (size_t jj = 0; jj < jcount; ++jj) {
+         const auto sample = samples[jj];
+         min = std::min(min, sample);
+         max = std::max(max, sample);
+         sumsq += sample * sample;
+      }
+      dest[ii * fields] = min;
+      dest[ii * fields + 1] = max;
+      dest[ii * fields + 2] = (float) sqrt(sumsq / jcount);
+   }
+   return frames;
+}
+
+void SqliteSampleBlock::CalcDeferredSummary(Deferred &deferred)
+{
+   const auto &range = *deferred.pRange;
+   const auto count = range.GetSampleCount();
+   const auto frames = (count + 65535) / 65536;
+
+   Floats samples{ std::min<size_t>(count, 65536) };
+   deferred.summary64k.resize(frames * fields);
+   float min = FLT_MAX;
+   float max = -FLT_MAX;
+   double totalSquares = 0.0;
+   for (size_t ii = 0; ii < frames; ++ii) {
+      const auto start = ii * 65536;
+      const auto len = std::min<size_t>(65536, count - start);
+      range.Read(reinterpret_cast<samplePtr>(samples.get()), floatSample,
+         start, len);
+      const auto summary = &deferred.summary64k[ii * fields];
+      SummarizeFrames(samples.get(), len, 65536, summary);
+      min = std::min(min, summary[0]);
+      max = std::max(max, summary[1]);
+      totalSquares += double{ summary[2] } * summary[2] * len;
+   }
+   deferred.minMaxRMS = { min, max, (float) sqrt(totalSquares / count) };
+}
+
+bool SqliteSampleBlock::GetDeferredSummary(Deferred &deferred,
+   float *dest, size_t frameoffset, size_t numframes, size_t frameLength)
+{
+   // Non-throwing, it returns true for success
+   try {
+      size_t frames = 0;
+      if (frameLength == 65536) {
+         std::call_once(deferred.summaryFlag,
+            CalcDeferredSummary, std::ref(deferred));
+         const auto &summary = deferred.summary64k;
+         const auto first = std::min(summary.size(), frameoffset * fields);
+         frames = std::min(numframes, (summary.size() - first) / fields);
+         std::copy_n(summary.begin() + first, frames * fields, dest);
+      }
+      else {
+         const auto &range = *deferred.pRange;
+         const auto count = range.GetSampleCount();
+         const auto start = std::min(count, frameoffset * frameLength);
+         const auto len = std::min(count - start, numframes * frameLength);
+         Floats samples{ len };
+         range.Read(reinterpret_cast<samplePtr>(samples.get()), floatSample,
+            start, len);
+         frames = SummarizeFrames(samples.get(), len, frameLength, dest);
+      }
+
+      // Frames past the end contribute nothing, as in CalcSummary()
+      for (auto ii = frames; ii < numframes; ++ii) {
+         dest[ii * fields] = FLT_MAX;
+         dest[ii * fields + 1] = -FLT_MAX;
+         dest[ii * fields + 2] = 0.0f;
+      }
+      return true;
+   }
+   catch ( const AudacityException & ) {
+   }
+   memset(dest, 0, numframes * bytesPerFrame);
+   return false;
+}
+
 SampleBlockID SqliteSampleBlock::GetBlockID() const
 {
    return mBlockID;
@@ -419,6 +692,17 @@ size_t SqliteSampleBlock::DoGetSamples(samplePtr dest,
                                      size_t sampleoffset,
                                      size_t numsamples)
 {
+   if (const auto pDeferred = GetDeferred()) {
+      // Like GetBlob(), fill with zeroes past the end
+      const auto &range = *pDeferred->pRange;
+      const auto count = range.GetSampleCount();
+      const auto start = std::min(sampleoffset, count);
+      const auto len = std::min(numsamples, count - start);
+      range.Read(dest, destformat, start, len);
+      ClearSamples(dest, destformat, len, numsamples - len);
+      return numsamples;
+   }
+
    if (IsSilent()) {
       auto size = SAMPLE_SIZE(destformat);
       memset(dest, 0, numsamples * size);
@@ -454,6 +738,8 @@ bool SqliteSampleBlock::GetSummary256(float *dest,
                                       size_t frameoffset,
                                       size_t numframes)
 {
+   if (const auto pDeferred = GetDeferred())
+      return GetDeferredSummary(*pDeferred, dest, frameoffset, numframes, 256);
    return GetSummary(dest, frameoffset, numframes, DBConnection::GetSummary256,
       "SELECT summary256 FROM sampleblocks WHERE blockid = ?1;");
 }
@@ -462,6 +748,9 @@ bool SqliteSampleBlock::GetSummary64k(float *dest,
                                       size_t frameoffset,
                                       size_t numframes)
 {
+   if (const auto pDeferred = GetDeferred())
+      return GetDeferredSummary(
+         *pDeferred, dest, frameoffset, numframes, 65536);
    return GetSummary(dest, frameoffset, numframes, DBConnection::GetSummary64k,
       "SELECT summary64k FROM sampleblocks WHERE blockid = ?1;");
 }
@@ -519,7 +808,9 @@ double SqliteSampleBlock::GetSumRms() const
 /// @param len   The number of samples to include in the region
 MinMaxRMS SqliteSampleBlock::DoGetMinMaxRMS(size_t start, size_t len)
 {
-   if (IsSilent())
+   // Deferred blocks read their samples below.  Materialize() sets the id
+   // before it resets the deferred state, so test that state first
+   if (!GetDeferred() && IsSilent())
       return {};
 
    float min = FLT_MAX;
@@ -566,6 +857,11 @@ MinMaxRMS SqliteSampleBlock::DoGetMinMaxRMS(size_t start, size_t len)
 /// these values are already computed.
 MinMaxRMS SqliteSampleBlock::DoGetMinMaxRMS() const
 {
+   if (const auto pDeferred = GetDeferred()) {
+      std::call_once(pDeferred->summaryFlag,
+         CalcDeferredSummary, std::ref(*pDeferred));
+      return pDeferred->minMaxRMS;
+   }
    return { (float) mSumMin, (float) mSumMax, (float) mSumRms };
 }
 
@@ -888,7 +1184,11 @@ void SqliteSampleBlock::Delete()
 
 void SqliteSampleBlock::SaveXML(XMLWriter &xmlFile)
 {
-   xmlFile.WriteAttr(wxT("blockid"), mBlockID);
+   if (const auto pDeferred = GetDeferred())
+      // Until materialized, the project refers to the file
+      pDeferred->pRange->WriteXMLAttributes(xmlFile);
+   else
+      xmlFile.WriteAttr(wxT("blockid"), mBlockID.load());
 }
 
 auto SqliteSampleBlock::SetSizes(
@@ -906,7 +1206,7 @@ auto SqliteSampleBlock::SetSizes(
 /// Calculates summary block data describing this sample data.
 ///
 /// This method also has the side effect of setting the mSumMin,
-/// mSumMax, and mSumRms members of this class.
+/// mSumMax, and mSumRms members of this class, and the sum of the samples.
 ///
 void SqliteSampleBlock::CalcSummary(Sizes sizes)
 {
@@ -938,6 +1238,7 @@ void SqliteSampleBlock::CalcSummary(Sizes sizes)
    float max;
    float sumsq;
    double totalSquares = 0.0;
+   double total = 0.0;
    double fraction = 0.0;
 
    // Recalc 256 summaries
@@ -949,6 +1250,7 @@ void SqliteSampleBlock::CalcSummary(Sizes sizes)
       min = samples[i * 256];
       max = samples[i * 256];
       sumsq = min * min;
+      total += min;
 
       int jcount = 256;
       if (jcount > mSampleCount - i * 256)
@@ -961,6 +1263,7 @@ void SqliteSampleBlock::CalcSummary(Sizes sizes)
       {
          float f1 = samples[i * 256 + j];
          sumsq += f1 * f1;
+         total += f1;
 
          if (f1 < min)
          {
@@ -993,6 +1296,7 @@ void SqliteSampleBlock::CalcSummary(Sizes sizes)
 
    // Calculate now while we can do it accurately
    mSumRms = sqrt(totalSquares / mSampleCount);
+   SetSum(total);
 
    // Recalc 64K summaries
    sumLen = (mSampleCount + 65535) / 65536;
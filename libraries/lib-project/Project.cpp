@@ -75,14 +75,15 @@ int AudacityProject::mProjectCounter=0;// global counter.
 //This array holds onto all of the projects currently open
 AllProjects::Container AllProjects::gAudacityProjects;
 
-std::shared_ptr<AudacityProject> AudacityProject::Create()
+std::shared_ptr<AudacityProject> AudacityProject::Create(bool buildAll)
 {
    // Must complete make_shared before using shared_from_this() or
    // weak_from_this()
    auto result = std::make_shared<AudacityProject>(CreateToken{});
    // Only now build the attached objects, which also causes the project window
    // to be built on demand
-   result->AttachedObjects::BuildAll();
+   if (buildAll)
+      result->AttachedObjects::BuildAll();
    // But not for all the attached windows.  They get built on demand only
    // later.
    return result;
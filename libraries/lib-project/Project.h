@@ -93,7 +93,12 @@ class PROJECT_API AudacityProject final
    using AttachedObjects = ::AttachedProjectObjects;
 
    //! Use this factory function
-   static std::shared_ptr<AudacityProject> Create();
+   /*!
+    @param buildAll whether to build all attached objects now; else each is
+    built when first used, as a program without windows needs, because some
+    of them make windows
+    */
+   static std::shared_ptr<AudacityProject> Create(bool buildAll = true);
    //! Don't use this constructor directly
    AudacityProject(CreateToken);
    virtual ~AudacityProject();
@@ -9,6 +9,10 @@
 
 **********************************************************************/
 #include "MockSampleBlock.h"
+#include "XMLWriter.h"
+
+#include <algorithm>
+#include <cmath>
 
 namespace
 {
@@ -20,6 +24,22 @@ copyToVector(constSamplePtr src, size_t numsamples, sampleFormat srcformat)
    std::copy(src, src + numChars, data.begin());
    return data;
 }
+
+MinMaxRMS
+minMaxRMS(const std::vector<char>& data, sampleFormat format, size_t start,
+   size_t len)
+{
+   if (len == 0)
+      return { 0, 0, 0 };
+   std::vector<float> floats(len);
+   SamplesToFloats(
+      data.data() + start * SAMPLE_SIZE(format), format, floats.data(), len);
+   const auto [min, max] = std::minmax_element(floats.begin(), floats.end());
+   double sumsq = 0;
+   for (const auto sample : floats)
+      sumsq += sample * sample;
+   return { *min, *max, static_cast<float>(std::sqrt(sumsq / len)) };
+}
 } // namespace
 
 MockSampleBlock::MockSampleBlock(
@@ -66,8 +86,9 @@ size_t MockSampleBlock::GetSpaceUsage() const
    return data.size();
 }
 
-void MockSampleBlock::SaveXML(XMLWriter&)
+void MockSampleBlock::SaveXML(XMLWriter& xmlFile)
 {
+   xmlFile.WriteAttr(wxT("blockid"), id);
 }
 
 size_t MockSampleBlock::DoGetSamples(
@@ -83,12 +104,12 @@ size_t MockSampleBlock::DoGetSamples(
 
 MinMaxRMS MockSampleBlock::DoGetMinMaxRMS(size_t start, size_t len)
 {
-   return { 0, 0, 0 };
+   return minMaxRMS(data, srcFormat, start, len);
 }
 
 MinMaxRMS MockSampleBlock::DoGetMinMaxRMS() const
 {
-   return { 0, 0, 0 };
+   return minMaxRMS(data, srcFormat, 0, GetSampleCount());
 }
 
 BlockSampleView MockSampleBlock::GetFloatSampleView(bool mayThrow)
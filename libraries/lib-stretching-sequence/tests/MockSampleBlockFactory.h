@@ -11,6 +11,8 @@
 #pragma once
 
 #include "MockSampleBlock.h"
+#include "XMLTagHandler.h"
+#include <map>
 #include <numeric> // std::iota
 
 class MockSampleBlockFactory final : public SampleBlockFactory
@@ -25,21 +27,33 @@ class MockSampleBlockFactory final : public SampleBlockFactory
    SampleBlockPtr DoCreate(
       constSamplePtr src, size_t numsamples, sampleFormat srcformat) override
    {
-      return std::make_shared<MockSampleBlock>(
-         blockIdCount++, src, numsamples, srcformat);
+      const auto id = blockIdCount++;
+      const auto block =
+         std::make_shared<MockSampleBlock>(id, src, numsamples, srcformat);
+      blocks[id] = block;
+      return block;
    }
 
    SampleBlockPtr
    DoCreateSilent(size_t numsamples, sampleFormat srcformat) override
    {
       std::vector<char> silence(numsamples * SAMPLE_SIZE(srcformat));
-      return std::make_shared<MockSampleBlock>(
-         blockIdCount++, silence.data(), numsamples, srcformat);
+      return DoCreate(silence.data(), numsamples, srcformat);
    }
 
+   //! Finds the block that was saved, if it is still in use
    SampleBlockPtr
    DoCreateFromXML(sampleFormat srcformat, const AttributesList& attrs) override
    {
+      for (auto [attr, value] : attrs)
+      {
+         long long id;
+         if (attr == "blockid" && value.TryGet(id))
+         {
+            const auto iter = blocks.find(id);
+            return iter == blocks.end() ? nullptr : iter->second.lock();
+         }
+      }
       return nullptr;
    }
 
@@ -50,4 +64,6 @@ class MockSampleBlockFactory final : public SampleBlockFactory
    }
 
    long long blockIdCount = 0;
+   //! Blocks still in use, to be found again when loading
+   std::map<long long, std::weak_ptr<SampleBlock>> blocks;
 };
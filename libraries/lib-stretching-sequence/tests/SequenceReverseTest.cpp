@@ -0,0 +1,240 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  SequenceReverseTest.cpp
+
+**********************************************************************/
+#include "MockSampleBlockFactory.h"
+#include "Sequence.h"
+#include "XMLFileReader.h"
+#include "XMLWriter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <set>
+#include <string>
+
+#include <catch2/catch.hpp>
+
+namespace
+{
+constexpr size_t BlockSize = 1024;
+
+//! Makes sequences made while it lasts use blocks of BlockSize samples
+struct BlockSizeScope
+{
+   BlockSizeScope()
+   {
+      Sequence::SetMaxDiskBlockSize(BlockSize * sizeof(float));
+   }
+   ~BlockSizeScope()
+   {
+      Sequence::SetMaxDiskBlockSize(oldSize);
+   }
+   const size_t oldSize = Sequence::GetMaxDiskBlockSize();
+};
+
+std::vector<float> Ramp(size_t len, float offset)
+{
+   std::vector<float> result(len);
+   for (size_t ii = 0; ii < len; ++ii)
+      result[ii] = offset + static_cast<float>(ii) / len;
+   return result;
+}
+
+std::unique_ptr<Sequence> MakeSequence(
+   const SampleBlockFactoryPtr& factory, const std::vector<float>& samples)
+{
+   auto result = std::make_unique<Sequence>(
+      factory, SampleFormats { floatSample, floatSample });
+   result->Append(
+      reinterpret_cast<constSamplePtr>(samples.data()), floatSample,
+      samples.size(), 1, floatSample);
+   result->Flush();
+   return result;
+}
+
+std::vector<float> Contents(const Sequence& sequence)
+{
+   std::vector<float> result(sequence.GetNumSamples().as_size_t());
+   REQUIRE(sequence.Get(
+      reinterpret_cast<samplePtr>(result.data()), floatSample, 0,
+      result.size(), true));
+   return result;
+}
+
+std::set<const SampleBlock*> Blocks(const Sequence& sequence)
+{
+   std::set<const SampleBlock*> result;
+   for (const auto& block : sequence.GetBlockArray())
+      result.insert(block.sb.get());
+   return result;
+}
+
+size_t CountReversed(const Sequence& sequence)
+{
+   const auto& blocks = sequence.GetBlockArray();
+   return std::count_if(
+      blocks.begin(), blocks.end(),
+      [](const SeqBlock& block) { return block.reversed; });
+}
+
+//! Statistics of the sequence over ranges match those of the expected samples
+void RequireStatistics(
+   const Sequence& sequence, const std::vector<float>& expected)
+{
+   const size_t size = expected.size();
+   const std::vector<std::pair<size_t, size_t>> ranges {
+      { 0, size },
+      { 1, size - 2 },
+      { BlockSize + 100, 500 },
+      { BlockSize - 1, 2 },
+      { BlockSize / 2, 3 * BlockSize },
+      { size - 700, 700 },
+   };
+   for (const auto [start, len] : ranges)
+   {
+      const auto first = expected.begin() + start, last = first + len;
+      const auto [min, max] = std::minmax_element(first, last);
+      const auto result = sequence.GetMinMax(start, len, true);
+      REQUIRE(result.first == *min);
+      REQUIRE(result.second == *max);
+
+      const auto sumsq = std::inner_product(first, last, first, 0.0);
+      REQUIRE(
+         sequence.GetRMS(start, len, true) ==
+         Approx(std::sqrt(sumsq / len)).epsilon(1e-5));
+
+      REQUIRE(
+         sequence.GetSum(start, len, true) ==
+         Approx(std::accumulate(first, last, 0.0)).epsilon(1e-6));
+   }
+}
+} // namespace
+
+TEST_CASE("Sequence::Reverse")
+{
+   const BlockSizeScope scope;
+   const auto factory = std::make_shared<MockSampleBlockFactory>();
+
+   const auto original = Ramp(6 * BlockSize, -0.5f);
+   const auto sequence = MakeSequence(factory, original);
+   REQUIRE(sequence->GetBlockArray().size() == 6);
+   const auto originalBlocks = Blocks(*sequence);
+
+   // Cut into the first and the last block, and cover the four between
+   const size_t start = 300, len = 5 * BlockSize - 200;
+   auto expected = original;
+   std::reverse(expected.begin() + start, expected.begin() + start + len);
+   REQUIRE(sequence->Reverse(start, len));
+
+   SECTION("shares the blocks wholly within the range, flipped")
+   {
+      REQUIRE(Contents(*sequence) == expected);
+      REQUIRE(CountReversed(*sequence) == 4);
+      for (const auto& block : sequence->GetBlockArray())
+         if (block.reversed)
+            REQUIRE(originalBlocks.count(block.sb.get()) == 1);
+   }
+
+   SECTION("answers min, max, RMS and sum through reversed blocks")
+   {
+      RequireStatistics(*sequence, expected);
+   }
+
+   SECTION("reverses back to the original")
+   {
+      REQUIRE(sequence->Reverse(start, len));
+      REQUIRE(Contents(*sequence) == original);
+      REQUIRE(CountReversed(*sequence) == 0);
+   }
+
+   SECTION("saves and loads the reversed attribute")
+   {
+      XMLStringWriter writer;
+      sequence->WriteXML(writer);
+
+      // The attribute is written only for reversed blocks
+      const auto xml = writer.ToStdString();
+      size_t count = 0;
+      for (auto pos = xml.find("reversed=\"1\""); pos != std::string::npos;
+           pos = xml.find("reversed=\"1\"", pos + 1))
+         ++count;
+      REQUIRE(count == 4);
+      REQUIRE(xml.find("reversed=\"0\"") == std::string::npos);
+
+      Sequence loaded { factory, SampleFormats { floatSample, floatSample } };
+      XMLFileReader reader;
+      REQUIRE(reader.ParseString(&loaded, writer));
+      REQUIRE(!loaded.GetErrorOpening());
+      REQUIRE(Contents(loaded) == expected);
+
+      const auto& blocks = sequence->GetBlockArray();
+      const auto& loadedBlocks = loaded.GetBlockArray();
+      REQUIRE(loadedBlocks.size() == blocks.size());
+      for (size_t ii = 0; ii < blocks.size(); ++ii)
+      {
+         REQUIRE(loadedBlocks[ii].sb == blocks[ii].sb);
+         REQUIRE(loadedBlocks[ii].start == blocks[ii].start);
+         REQUIRE(loadedBlocks[ii].reversed == blocks[ii].reversed);
+      }
+   }
+}
+
+TEST_CASE("Sequence::Paste shares reversed blocks")
+{
+   const BlockSizeScope scope;
+   const auto factory = std::make_shared<MockSampleBlockFactory>();
+
+   // Six blocks, the last one short, all reversed, so that the short one
+   // comes first
+   const auto source = Ramp(6 * BlockSize - 144, 0.25f);
+   const auto pSource = MakeSequence(factory, source);
+   REQUIRE(pSource->Reverse(0, source.size()));
+   REQUIRE(CountReversed(*pSource) == 6);
+   const auto reversedSource =
+      std::vector<float>(source.rbegin(), source.rend());
+   REQUIRE(Contents(*pSource) == reversedSource);
+
+   const auto destination = Ramp(4 * BlockSize, -0.75f);
+   const auto pDestination = MakeSequence(factory, destination);
+
+   auto expected = destination;
+   const size_t s = BlockSize + 476;
+   expected.insert(
+      expected.begin() + s, reversedSource.begin(), reversedSource.end());
+   pDestination->Paste(s, pSource.get());
+
+   REQUIRE(Contents(*pDestination) == expected);
+   RequireStatistics(*pDestination, expected);
+
+   // The short piece of the split block is merged with the short first
+   // source block; the other five are shared, still reversed
+   const auto sourceBlocks = Blocks(*pSource);
+   size_t shared = 0;
+   for (const auto& block : pDestination->GetBlockArray())
+      if (sourceBlocks.count(block.sb.get()))
+      {
+         ++shared;
+         REQUIRE(block.reversed);
+      }
+   REQUIRE(shared == 5);
+
+   SECTION("and pasting again after the copy shares five more")
+   {
+      expected.insert(
+         expected.begin() + s + source.size(), reversedSource.begin(),
+         reversedSource.end());
+      pDestination->Paste(s + source.size(), pSource.get());
+      REQUIRE(Contents(*pDestination) == expected);
+      RequireStatistics(*pDestination, expected);
+
+      shared = 0;
+      for (const auto& block : pDestination->GetBlockArray())
+         shared += sourceBlocks.count(block.sb.get());
+      REQUIRE(shared == 10);
+   }
+}
@@ -15,6 +15,8 @@
 #include <cassert>
 #include <cmath>
 #include <cstring>
+#include <limits>
+#include <vector>
 
 #include "SampleBlock.h"
 #include "SampleFormat.h"
@@ -177,6 +179,126 @@ private:
    size_t mLastProcessedSample { 0 };
 };
 
+//! Minimum, maximum and RMS of some samples, accumulated from samples and
+//! from summaries of samples
+class SummaryAccumulator final
+{
+public:
+   void AddSamples(const float* begin, const float* end) noexcept
+   {
+      for (auto it = begin; it != end; ++it)
+      {
+         mMin = std::min(mMin, *it);
+         mMax = std::max(mMax, *it);
+         mSqSum += double(*it) * *it;
+      }
+      mCount += end - begin;
+   }
+
+   //! @param summary minimum, maximum and RMS of count samples
+   void AddSummary(const float* summary, size_t count) noexcept
+   {
+      mMin = std::min(mMin, summary[0]);
+      mMax = std::max(mMax, summary[1]);
+      mSqSum += double(summary[2]) * summary[2] * count;
+      mCount += count;
+   }
+
+   //! Write minimum, maximum and RMS, and advance ptr past them
+   void Write(float*& ptr) const noexcept
+   {
+      *ptr++ = mMin;
+      *ptr++ = mMax;
+      *ptr++ = mCount > 0 ?
+                  static_cast<float>(std::sqrt(mSqSum / mCount)) :
+                  0.0f;
+   }
+
+private:
+   float mMin { std::numeric_limits<float>::infinity() };
+   float mMax { -std::numeric_limits<float>::infinity() };
+   double mSqSum { 0.0 };
+   size_t mCount { 0 };
+};
+
+//! Summarize frames of a block seen in reverse, from the summaries of 256
+//! samples that the block stores
+/*!
+ A frame of the reversed view ends where the block ends, so the frames align
+ with the stored summaries only if the length of the block is a multiple of
+ 256.  Otherwise each frame boundary cuts through a stored summary, and the
+ samples of the cut summaries are read: only those at the two ends of each
+ frame of 64k, but all of them for frames of 256.
+ */
+template<size_t frameSize>
+void SummarizeReversedBlock(
+   const SeqBlock& block, float* ptr, size_t framesCount)
+{
+   constexpr size_t summarySize = 256;
+   static_assert(frameSize % summarySize == 0);
+
+   auto& sampleBlock = *block.sb;
+   const auto samplesCount = sampleBlock.GetSampleCount();
+   const auto summariesCount = RoundUpUnsafe(samplesCount, summarySize);
+   std::vector<float> summaries(summariesCount * 3);
+   sampleBlock.GetSummary256(summaries.data(), 0, summariesCount);
+
+   // Frames of 256 that cut through summaries cut through all of them, so
+   // then read all samples at once
+   std::vector<float> samples;
+   const auto addSamples = [&](SummaryAccumulator& accumulator, size_t start,
+                              size_t end) {
+      if (frameSize == summarySize)
+      {
+         if (samples.empty())
+         {
+            samples.resize(samplesCount);
+            sampleBlock.GetSamples(
+               reinterpret_cast<samplePtr>(samples.data()), floatSample, 0,
+               samplesCount, false);
+         }
+         accumulator.AddSamples(samples.data() + start, samples.data() + end);
+         return;
+      }
+      std::vector<float> partSamples(end - start);
+      sampleBlock.GetSamples(
+         reinterpret_cast<samplePtr>(partSamples.data()), floatSample, start,
+         end - start, false);
+      accumulator.AddSamples(
+         partSamples.data(), partSamples.data() + partSamples.size());
+   };
+
+   // Frame m of the view is the range from end - frameSize to end of the
+   // stored samples, where end is samplesCount - m * frameSize
+   for (size_t frame = 0; frame < framesCount; ++frame)
+   {
+      const auto end = samplesCount - frame * frameSize;
+      const auto start = end > frameSize ? end - frameSize : 0;
+
+      SummaryAccumulator accumulator;
+      for (auto position = start; position < end;)
+      {
+         const auto summary = position / summarySize;
+         const auto summaryStart = summary * summarySize;
+         const auto summaryEnd =
+            std::min(summaryStart + summarySize, samplesCount);
+         if (position == summaryStart && summaryEnd <= end)
+         {
+            accumulator.AddSummary(
+               summaries.data() + summary * 3, summaryEnd - summaryStart);
+            position = summaryEnd;
+         }
+         else
+         {
+            const auto partEnd = std::min(summaryEnd, end);
+            addSamples(accumulator, position, partEnd);
+            position = partEnd;
+         }
+      }
+      accumulator.Write(ptr);
+   }
+}
+
 WaveDataCache::DataProvider
 MakeDefaultDataProvider(const WaveClip& clip, int channelIndex)
 {
@@ -215,8 +337,8 @@ MakeDefaultDataProvider(const WaveClip& clip, int channelIndex)
          samplePtr ptr = static_cast<samplePtr>(
             static_cast<void*>(outBlock.GetWritePointer(outBlock.NumSamples)));
 
-         inputBlock.sb->GetSamples(
-            ptr, floatSample, 0, outBlock.NumSamples, false);
+         Sequence::Read(
+            ptr, floatSample, inputBlock, 0, outBlock.NumSamples, false);
       }
       break;
       case WaveCacheSampleBlock::Type::MinMaxRMS256:
@@ -226,7 +348,10 @@ MakeDefaultDataProvider(const WaveClip& clip, int channelIndex)
          float* ptr =
             static_cast<float*>(outBlock.GetWritePointer(framesCount * 3));
 
-         inputBlock.sb->GetSummary256(ptr, 0, framesCount);
+         if (inputBlock.reversed)
+            SummarizeReversedBlock<256>(inputBlock, ptr, framesCount);
+         else
+            inputBlock.sb->GetSummary256(ptr, 0, framesCount);
       }
       break;
       case WaveCacheSampleBlock::Type::MinMaxRMS64k:
@@ -236,7 +361,10 @@ MakeDefaultDataProvider(const WaveClip& clip, int channelIndex)
          float* ptr =
             static_cast<float*>(outBlock.GetWritePointer(framesCount * 3));
 
-         inputBlock.sb->GetSummary64k(ptr, 0, framesCount);
+         if (inputBlock.reversed)
+            SummarizeReversedBlock<64 * 1024>(inputBlock, ptr, framesCount);
+         else
+            inputBlock.sb->GetSummary64k(ptr, 0, framesCount);
       }
       break;
       default:
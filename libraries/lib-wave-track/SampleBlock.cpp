@@ -9,9 +9,12 @@ SampleBlock.cpp
 
 #include "InconsistencyException.h"
 #include "SampleBlock.h"
+#include "SampleFileRange.h"
 #include "SampleFormat.h"
 
 #include <wx/defs.h>
+#include <numeric>
+#include <vector>
 
 SampleBlockFactoryPtr SampleBlockFactory::New( AudacityProject &project )
 {
@@ -66,6 +69,30 @@ SampleBlockPtr SampleBlockFactory::CreateFromId(
    return result;
 }
 
+SampleBlockPtr SampleBlockFactory::CreateDeferred(
+   const std::shared_ptr<const SampleFileRange> &pRange, sampleFormat format)
+{
+   auto result = DoCreateDeferred(pRange, format);
+   if (!result)
+      THROW_INCONSISTENCY_EXCEPTION;
+   Publisher<SampleBlockCreateMessage>::Publish({});
+   return result;
+}
+
+SampleBlockPtr SampleBlockFactory::DoCreateDeferred(
+   const std::shared_ptr<const SampleFileRange> &pRange, sampleFormat format)
+{
+   const auto len = pRange->GetSampleCount();
+   SampleBuffer buffer{ len, format };
+   pRange->Read(buffer.ptr(), format, 0, len);
+   return DoCreate(buffer.ptr(), len, format);
+}
+
+bool SampleBlockFactory::MaterializeDeferred()
+{
+   return true;
+}
+
 SampleBlock::~SampleBlock() = default;
 
 size_t SampleBlock::GetSamples(samplePtr dest,
@@ -103,3 +130,39 @@ size_t SampleBlock::GetSamples(samplePtr dest,
    }
 }
 
+double SampleBlock::GetSum(size_t start, size_t len, bool mayThrow)
+{
+   std::vector<float> buffer(len);
+   // Failures leave zeroes in the buffer, if not throwing
+   const auto copied = GetSamples(reinterpret_cast<samplePtr>(buffer.data()),
+      floatSample, start, len, mayThrow);
+   return std::accumulate(buffer.begin(), buffer.begin() + copied, 0.0);
+}
+
+double SampleBlock::GetSum(bool mayThrow)
+{
+   std::lock_guard<std::mutex> lock{ mSumMutex };
+   if (!mSum) {
+      try {
+         const auto len = GetSampleCount();
+         std::vector<float> buffer(len);
+         const auto copied = DoGetSamples(
+            reinterpret_cast<samplePtr>(buffer.data()), floatSample, 0, len);
+         mSum = std::accumulate(buffer.begin(), buffer.begin() + copied, 0.0);
+      }
+      catch( ... ) {
+         if( mayThrow )
+            throw;
+         // Don't remember the failure
+         return 0;
+      }
+   }
+   return *mSum;
+}
+
+void SampleBlock::SetSum(double sum)
+{
+   std::lock_guard<std::mutex> lock{ mSumMutex };
+   mSum = sum;
+}
+
@@ -15,6 +15,8 @@ SampleBlock.h
 
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <unordered_set>
 
 #include "Observer.h"
@@ -28,6 +30,7 @@ class SampleBlock;
 using SampleBlockPtr = std::shared_ptr<SampleBlock>;
 using SampleBlockConstPtr = std::shared_ptr<const SampleBlock>;
 class SampleBlockFactory;
+class SampleFileRange;
 using SampleBlockFactoryPtr = std::shared_ptr<SampleBlockFactory>;
 
 using SampleBlockID = long long;
@@ -85,6 +88,17 @@ public:
    // That may be appropriate when only attempting to display samples, not edit.
    MinMaxRMS GetMinMaxRMS(bool mayThrow = true) const;
 
+   /// Gets the sum of the samples in the specified region
+   // If !mayThrow and there is an error, ignores it and returns zero.
+   double GetSum(size_t start, size_t len, bool mayThrow = true);
+
+   /// Gets the sum of all samples of the block
+   /*! Remembered, because the contents of a block never change.  Blocks that
+    compute their summaries can supply it with SetSum(); else it is computed
+    from the samples on first use */
+   // If !mayThrow and there is an error, ignores it and returns zero.
+   double GetSum(bool mayThrow = true);
+
    virtual size_t GetSpaceUsage() const = 0;
 
    virtual void SaveXML(XMLWriter &xmlFile) = 0;
@@ -98,6 +112,13 @@ protected:
    virtual MinMaxRMS DoGetMinMaxRMS(size_t start, size_t len) = 0;
 
    virtual MinMaxRMS DoGetMinMaxRMS() const = 0;
+
+   //! Remember the sum of all samples, found while computing other statistics
+   void SetSum(double sum);
+
+private:
+   std::mutex mSumMutex;
+   std::optional<double> mSum;
 };
 
 // Makes a useful function object
@@ -144,10 +165,26 @@ public:
    // Potentially returns a null pointer
    SampleBlockPtr CreateFromId(sampleFormat srcformat, SampleBlockID id);
 
+   // Returns a non-null pointer or else throws an exception
+   /*!
+    The block may read its samples from the file until the factory stores a
+    copy of them, which it may do later
+    @param format the format of the block, to which samples are converted
+    */
+   SampleBlockPtr CreateDeferred(
+      const std::shared_ptr<const SampleFileRange> &pRange,
+      sampleFormat format);
+
    using SampleBlockIDs = std::unordered_set<SampleBlockID>;
    /*! @return ids of all sample blocks created by this factory and still extant */
    virtual SampleBlockIDs GetActiveBlockIDs() = 0;
 
+   //! Store copies of the samples of all extant blocks made by
+   //! CreateDeferred(), so that none of them reads its file any more
+   /*! @return false if some block could not be stored; the default does
+       nothing, as the default DoCreateDeferred() copies at once */
+   virtual bool MaterializeDeferred();
+
 protected:
    // The override should throw more informative exceptions on error than the
    // default InconsistencyException thrown by Create
@@ -169,6 +206,11 @@ protected:
 
    virtual SampleBlockPtr
    DoCreateFromId(sampleFormat srcformat, SampleBlockID id) = 0;
+
+   //! Default implementation reads all the samples now and calls DoCreate()
+   virtual SampleBlockPtr DoCreateDeferred(
+      const std::shared_ptr<const SampleFileRange> &pRange,
+      sampleFormat format);
 };
 
 #endif
@@ -0,0 +1,283 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  SampleFileRange.cpp
+
+**********************************************************************/
+#include "SampleFileRange.h"
+
+#include <cassert>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "Dither.h"
+#include "FileException.h"
+#include "RandomAccessFile.h"
+#include "XMLWriter.h"
+
+#if defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64) || \
+   (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SAMPLE_FILE_RANGE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+static constexpr auto File_attr = "aliasfile";
+static constexpr auto Offset_attr = "aliasoffset";
+static constexpr auto Stride_attr = "aliasstride";
+static constexpr auto Encoding_attr = "aliasencoding";
+static constexpr auto BigEndian_attr = "aliasbigendian";
+static constexpr auto Length_attr = "aliaslen";
+
+//! Ranges of one file share the open file while any of them exists
+std::shared_ptr<const RandomAccessFile> OpenFile(const FilePath &path)
+{
+   static std::mutex mutex;
+   static std::map<FilePath, std::weak_ptr<const RandomAccessFile>> files;
+
+   std::lock_guard<std::mutex> lock{ mutex };
+   auto &wFile = files[path];
+   auto pFile = wFile.lock();
+   if (!pFile)
+      wFile = pFile = std::make_shared<const RandomAccessFile>(path);
+   return pFile;
+}
+
+uint32_t GetWord(const uint8_t *src, size_t size, bool bigEndian)
+{
+   uint32_t result = 0;
+   for (size_t ii = 0; ii < size; ++ii)
+      result |= uint32_t{ src[bigEndian ? size - 1 - ii : ii] } << (8 * ii);
+   return result;
+}
+
+//! Copy every stride-th sample, stored in the byte order of the machine
+template<typename Sample>
+void Gather(const uint8_t *src, size_t stride, Sample *out, size_t len)
+{
+   // memcpy, because the file need not align the samples
+   for (size_t ii = 0; ii < len; ++ii, src += stride)
+      memcpy(out + ii, src, sizeof(Sample));
+}
+
+#ifdef SAMPLE_FILE_RANGE_SSE2
+//! Gather() for a channel of a stereo file, several samples at a time
+/*!
+ Loads of whole frames starting at the channel's sample hold it in the even
+ lanes, whichever channel it is.  A load may reach one sample into the frame
+ after the last it uses, so stop vectors short of the last frame.
+ @return how many samples were copied; the caller copies the rest
+ */
+size_t GatherStereo(const uint8_t *src, int16_t *out, size_t len)
+{
+   size_t ii = 0;
+   for (; ii + 8 < len; ii += 8, src += 32) {
+      const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+      const auto b =
+         _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+      // Sign-extend the even lanes to 32 bits, then narrow without saturating
+      const auto even = _mm_packs_epi32(
+         _mm_srai_epi32(_mm_slli_epi32(a, 16), 16),
+         _mm_srai_epi32(_mm_slli_epi32(b, 16), 16));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + ii), even);
+   }
+   return ii;
+}
+
+size_t GatherStereo(const uint8_t *src, float *out, size_t len)
+{
+   size_t ii = 0;
+   for (; ii + 4 < len; ii += 4, src += 32) {
+      const auto a = _mm_loadu_ps(reinterpret_cast<const float*>(src));
+      const auto b = _mm_loadu_ps(reinterpret_cast<const float*>(src + 16));
+      _mm_storeu_ps(out + ii, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+   }
+   return ii;
+}
+#endif
+
+//! Copy one channel of little-endian samples out of interleaved frames
+template<typename Sample>
+void Deinterleave(const uint8_t *src, size_t stride, Sample *out, size_t len)
+{
+   size_t done = 0;
+#ifdef SAMPLE_FILE_RANGE_SSE2
+   if (stride == 2 * sizeof(Sample))
+      done = GatherStereo(src, out, len);
+#endif
+   Gather(src + done * stride, stride, out + done, len - done);
+}
+}
+
+size_t SampleFileRange::GetEncodedSize(Encoding encoding)
+{
+   switch (encoding) {
+   case Encoding::Int16:
+      return 2;
+   case Encoding::Int24:
+      return 3;
+   case Encoding::Float32:
+   default:
+      return 4;
+   }
+}
+
+sampleFormat SampleFileRange::GetNativeFormat(Encoding encoding)
+{
+   switch (encoding) {
+   case Encoding::Int16:
+      return int16Sample;
+   case Encoding::Int24:
+      return int24Sample;
+   case Encoding::Float32:
+   default:
+      return floatSample;
+   }
+}
+
+SampleFileRange::SampleFileRange(
+   const FilePath &path, const Layout &layout, size_t count)
+   : mpFile{ OpenFile(path) }
+   , mLayout{ layout }
+   , mCount{ count }
+{
+   const auto size = GetEncodedSize(mLayout.encoding);
+   const auto fileSize = mpFile->GetSize();
+   if (mCount == 0 || mLayout.stride < size || mLayout.offset > fileSize ||
+       fileSize - mLayout.offset < size ||
+       (fileSize - mLayout.offset - size) / mLayout.stride < mCount - 1)
+      throw FileException{ FileException::Cause::Read, path };
+}
+
+std::shared_ptr<const SampleFileRange>
+SampleFileRange::FromXML(const AttributesList &attrs)
+{
+   FilePath path;
+   Layout layout;
+   long long offset = -1, stride = 0, length = 0;
+   int encoding = -1;
+   for (auto &[attr, value] : attrs) {
+      if (attr == File_attr)
+         path = value.ToWString();
+      else if (attr == Offset_attr)
+         value.TryGet(offset);
+      else if (attr == Stride_attr)
+         value.TryGet(stride);
+      else if (attr == Encoding_attr)
+         value.TryGet(encoding);
+      else if (attr == BigEndian_attr)
+         value.TryGet(layout.bigEndian);
+      else if (attr == Length_attr)
+         value.TryGet(length);
+   }
+
+   if (path.empty() || offset < 0 || stride <= 0 || length <= 0 ||
+       encoding < static_cast<int>(Encoding::Int16) ||
+       encoding > static_cast<int>(Encoding::Float32))
+      return nullptr;
+
+   layout.encoding = static_cast<Encoding>(encoding);
+   layout.offset = offset;
+   layout.stride = stride;
+   return std::make_shared<const SampleFileRange>(path, layout, length);
+}
+
+size_t SampleFileRange::GetLengthFromXML(const AttributesList &attrs)
+{
+   for (auto &[attr, value] : attrs) {
+      long long length;
+      if (attr == Length_attr && value.TryGet(length) && length > 0)
+         return length;
+   }
+   return 0;
+}
+
+void SampleFileRange::WriteXMLAttributes(XMLWriter &xmlFile) const
+{
+   xmlFile.WriteAttr(File_attr, GetPath());
+   xmlFile.WriteAttr(Offset_attr, static_cast<long long>(mLayout.offset));
+   xmlFile.WriteAttr(Stride_attr, mLayout.stride);
+   xmlFile.WriteAttr(Encoding_attr, static_cast<int>(mLayout.encoding));
+   if (mLayout.bigEndian)
+      xmlFile.WriteAttr(BigEndian_attr, mLayout.bigEndian);
+   xmlFile.WriteAttr(Length_attr, mCount);
+}
+
+const FilePath &SampleFileRange::GetPath() const
+{
+   return mpFile->GetPath();
+}
+
+void SampleFileRange::Read(samplePtr dest, sampleFormat destFormat,
+   size_t start, size_t len) const
+{
+   assert(start + len <= mCount);
+   if (len == 0)
+      return;
+
+   const auto native = GetNativeFormat();
+   const auto size = GetEncodedSize(mLayout.encoding);
+   const auto stride = mLayout.stride;
+   const auto offset = mLayout.offset + start * stride;
+
+   if (native != int24Sample && !mLayout.bigEndian && stride == size) {
+      // Samples in the file are just like those in memory; read them into
+      // dest itself when no conversion follows
+      SampleBuffer buffer;
+      const auto decoded =
+         destFormat == native ? dest : buffer.Allocate(len, native).ptr();
+      mpFile->Read(offset, decoded, len * size);
+      if (decoded != dest)
+         CopySamples(decoded, native, dest, destFormat, len, DitherType::none);
+   }
+   else {
+      std::vector<uint8_t> bytes((len - 1) * stride + size);
+      mpFile->Read(offset, bytes.data(), bytes.size());
+      Decode(mLayout, bytes.data(), dest, destFormat, len);
+   }
+}
+
+void SampleFileRange::Decode(const Layout &layout, const uint8_t *src,
+   samplePtr dest, sampleFormat destFormat, size_t len)
+{
+   const auto native = GetNativeFormat(layout.encoding);
+   const auto size = GetEncodedSize(layout.encoding);
+   const auto stride = layout.stride;
+   const auto bigEndian = layout.bigEndian;
+
+   // Decode into dest itself when no conversion follows
+   SampleBuffer buffer;
+   const auto decoded =
+      destFormat == native ? dest : buffer.Allocate(len, native).ptr();
+
+   if (native == int16Sample && !bigEndian)
+      Deinterleave(src, stride, reinterpret_cast<int16_t*>(decoded), len);
+   else if (native == floatSample && !bigEndian)
+      Deinterleave(src, stride, reinterpret_cast<float*>(decoded), len);
+   else if (native == int16Sample) {
+      const auto out = reinterpret_cast<int16_t*>(decoded);
+      for (size_t ii = 0; ii < len; ++ii, src += stride)
+         out[ii] = static_cast<int16_t>(GetWord(src, size, bigEndian));
+   }
+   else if (native == int24Sample) {
+      const auto out = reinterpret_cast<int32_t*>(decoded);
+      for (size_t ii = 0; ii < len; ++ii, src += stride)
+         // Extend the sign
+         out[ii] =
+            static_cast<int32_t>(GetWord(src, size, bigEndian) << 8) >> 8;
+   }
+   else {
+      const auto out = reinterpret_cast<float*>(decoded);
+      for (size_t ii = 0; ii < len; ++ii, src += stride) {
+         const auto word = GetWord(src, size, bigEndian);
+         memcpy(out + ii, &word, sizeof(float));
+      }
+   }
+
+   if (decoded != dest)
+      CopySamples(decoded, native, dest, destFormat, len, DitherType::none);
+}
@@ -0,0 +1,101 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  SampleFileRange.h
+
+**********************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "Identifier.h"
+#include "SampleFormat.h"
+#include "XMLTagHandler.h"
+
+class RandomAccessFile;
+class XMLWriter;
+
+//! Locates the samples of one channel in an uncompressed audio file
+/*!
+ A SampleBlock may read its samples from the file through this until they are
+ copied into the project.  All ranges in one file share one RandomAccessFile.
+ */
+class WAVE_TRACK_API SampleFileRange final
+{
+public:
+   enum class Encoding : int {
+      Int16,
+      Int24,
+      Float32,
+   };
+
+   struct Layout final
+   {
+      Encoding encoding{ Encoding::Int16 };
+      bool bigEndian{ false };
+      //! Byte position in the file of the first sample
+      uint64_t offset{ 0 };
+      //! Bytes from one sample of the channel to the next
+      size_t stride{ 0 };
+   };
+
+   //! @return bytes that one sample of the encoding occupies in a file
+   static size_t GetEncodedSize(Encoding encoding);
+
+   //! @return the format that holds samples of the encoding without loss
+   static sampleFormat GetNativeFormat(Encoding encoding);
+
+   /*!
+    @throws FileException if the file can't be opened or is too short for
+    count samples
+    */
+   SampleFileRange(const FilePath &path, const Layout &layout, size_t count);
+
+   //! Reconstruct a range from attributes written by WriteXMLAttributes()
+   /*!
+    @return null if the attributes do not describe a range
+    @throws FileException as for the constructor
+    */
+   static std::shared_ptr<const SampleFileRange>
+   FromXML(const AttributesList &attrs);
+
+   //! @return the number of samples that attributes written by
+   //! WriteXMLAttributes() give, without opening the file, or zero
+   static size_t GetLengthFromXML(const AttributesList &attrs);
+
+   void WriteXMLAttributes(XMLWriter &xmlFile) const;
+
+   const FilePath &GetPath() const;
+   const Layout &GetLayout() const { return mLayout; }
+   size_t GetSampleCount() const { return mCount; }
+   sampleFormat GetNativeFormat() const
+   {
+      return GetNativeFormat(mLayout.encoding);
+   }
+
+   //! Copy samples, converting them to destFormat without dither
+   /*!
+    @pre `start + len <= GetSampleCount()`
+    @throws FileException if the file is now too short
+    */
+   void Read(samplePtr dest, sampleFormat destFormat,
+      size_t start, size_t len) const;
+
+   //! Copy len samples of one channel out of bytes read from a file,
+   //! converting them to destFormat without dither
+   /*!
+    The offset of the layout is ignored; src points at the first sample.
+    @pre src holds `(len - 1) * layout.stride + GetEncodedSize(layout.encoding)`
+    bytes
+    */
+   static void Decode(const Layout &layout, const uint8_t *src,
+      samplePtr dest, sampleFormat destFormat, size_t len);
+
+private:
+   const std::shared_ptr<const RandomAccessFile> mpFile;
+   const Layout mLayout;
+   const size_t mCount;
+};
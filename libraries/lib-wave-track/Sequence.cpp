@@ -50,6 +50,40 @@ size_t Sequence::sMaxDiskBlockSize = 1048576;
 const char *Sequence::Sequence_tag = "sequence";
 const char *Sequence::WaveBlock_tag = "waveblock";
 
+namespace {
+void ReverseSamples(samplePtr buffer, sampleFormat format, size_t len)
+{
+   switch (format) {
+   case int16Sample: {
+      const auto p = reinterpret_cast<short *>(buffer);
+      std::reverse(p, p + len);
+      break;
+   }
+   case int24Sample: {
+      const auto p = reinterpret_cast<int *>(buffer);
+      std::reverse(p, p + len);
+      break;
+   }
+   case floatSample: {
+      const auto p = reinterpret_cast<float *>(buffer);
+      std::reverse(p, p + len);
+      break;
+   }
+   default:
+      THROW_INCONSISTENCY_EXCEPTION;
+   }
+}
+
+//! Where a range of samples of a block, in the order they are seen, lies in
+//! its sample block
+size_t StoredStart(const SeqBlock &block, size_t start, size_t len)
+{
+   return block.reversed
+      ? block.sb->GetSampleCount() - start - len
+      : start;
+}
+}
+
 // Sequence methods
 Sequence::Sequence(
    const SampleBlockFactoryPtr &pFactory, SampleFormats formats)
@@ -289,7 +323,10 @@ std::pair<float, float> Sequence::GetMinMax(
          wxASSERT(maxl0 <= mMaxSamples); // Vaughan, 2011-10-19
          const auto l0 = limitSampleBufferSize ( maxl0, len );
 
-         results = theFile->GetMinMaxRMS(s0, l0, mayThrow);
+         // The summary of the whole block is exact if the region covers it
+         if (s0 > 0 || l0 < theFile->GetSampleCount())
+            results = theFile->GetMinMaxRMS(
+               StoredStart(theBlock, s0, l0), l0, mayThrow);
          if (results.min < min)
             min = results.min;
          if (results.max > max)
@@ -309,7 +346,9 @@ std::pair<float, float> Sequence::GetMinMax(
          const auto l0 = ( start + len - theBlock.start ).as_size_t();
          wxASSERT(l0 <= mMaxSamples); // Vaughan, 2011-10-19
 
-         results = theFile->GetMinMaxRMS(0, l0, mayThrow);
+         if (l0 < theFile->GetSampleCount())
+            results = theFile->GetMinMaxRMS(
+               StoredStart(theBlock, 0, l0), l0, mayThrow);
          if (results.min < min)
             min = results.min;
          if (results.max > max)
@@ -361,7 +400,8 @@ float Sequence::GetRMS(sampleCount start, sampleCount len, bool mayThrow) const
       wxASSERT(maxl0 <= mMaxSamples); // Vaughan, 2011-10-19
       const auto l0 = limitSampleBufferSize( maxl0, len );
 
-      auto results = sb->GetMinMaxRMS(s0, l0, mayThrow);
+      auto results =
+         sb->GetMinMaxRMS(StoredStart(theBlock, s0, l0), l0, mayThrow);
       const auto partialRMS = results.RMS;
       sumsq += partialRMS * partialRMS * l0;
       length += l0;
@@ -375,7 +415,8 @@ float Sequence::GetRMS(sampleCount start, sampleCount len, bool mayThrow) const
       const auto l0 = ( start + len - theBlock.start ).as_size_t();
       wxASSERT(l0 <= mMaxSamples); // PRL: I think Vaughan missed this
 
-      auto results = sb->GetMinMaxRMS(0, l0, mayThrow);
+      auto results =
+         sb->GetMinMaxRMS(StoredStart(theBlock, 0, l0), l0, mayThrow);
       const auto partialRMS = results.RMS;
       sumsq += partialRMS * partialRMS * l0;
       length += l0;
@@ -387,6 +428,34 @@ float Sequence::GetRMS(sampleCount start, sampleCount len, bool mayThrow) const
    return sqrt(sumsq / length.as_double() );
 }
 
+double Sequence::GetSum(sampleCount start, sampleCount len, bool mayThrow) const
+{
+   if (len == 0 || mBlock.size() == 0)
+      return 0.0;
+
+   double sum = 0.0;
+
+   const auto block0 = FindBlock(start);
+   const auto block1 = FindBlock(start + len - 1);
+   for (auto b = block0; b <= block1; ++b) {
+      const SeqBlock &theBlock = mBlock[b];
+      const auto &sb = theBlock.sb;
+      const auto blockLen = sb->GetSampleCount();
+      const auto s0 = std::max(start, theBlock.start);
+      const auto s1 = std::min(start + len, theBlock.start + blockLen);
+      if (s0 == theBlock.start && s1 == theBlock.start + blockLen)
+         // Whole blocks are summed only once, ever
+         sum += sb->GetSum(mayThrow);
+      else
+         // The selection only partly overlaps this block; read some samples
+         sum += sb->GetSum(StoredStart(theBlock,
+               (s0 - theBlock.start).as_size_t(), (s1 - s0).as_size_t()),
+            (s1 - s0).as_size_t(), mayThrow);
+   }
+
+   return sum;
+}
+
 // Must pass in the correct factory for the result.  If it's not the same
 // as in this, then block contents must be copied.
 std::unique_ptr<Sequence> Sequence::Copy( const SampleBlockFactoryPtr &pFactory,
@@ -597,6 +666,7 @@ void Sequence::Paste(sampleCount s, const Sequence *src)
          buffer.ptr(),
          largerBlockLen.as_size_t(),
          format);
+      block.reversed = false;
 
       // Don't make a duplicate array.  We can still give Strong-guarantee
       // if we modify only one block in place.
@@ -648,46 +718,64 @@ void Sequence::Paste(sampleCount s, const Sequence *src)
    } else {
 
       // The final case is that we're inserting at least five blocks.
-      // We divide these into three groups: the first two get merged
-      // with the first half of the split block, the middle ones get
-      // used whole, and the last two get merged with the last
-      // half of the split block.
-
-      const auto srcFirstTwoLen =
-          srcBlock[0].sb->GetSampleCount() + srcBlock[1].sb->GetSampleCount();
-      const auto leftLen = splitPoint + srcFirstTwoLen;
-
-      const SeqBlock &penultimate = srcBlock[srcNumBlocks - 2];
-      const auto srcLastTwoLen =
-         penultimate.sb->GetSampleCount() +
-         srcBlock[srcNumBlocks - 1].sb->GetSampleCount();
-      const auto rightSplit = splitBlock.sb->GetSampleCount() - splitPoint;
-      const auto rightLen = rightSplit + srcLastTwoLen;
+      // These are shared whole, except that the first half of the split
+      // block gets merged with up to two of the first ones, and the last
+      // half with up to two of the last ones, while the half or the source
+      // block is shorter than the minimum.  So repeated pasting at the end
+      // of what was pasted before rewrites few blocks or none.
+
+      const auto isShort = [&](size_t len){
+         return len > 0 && len < mMinSamples; };
+
+      size_t leftLen = splitPoint;
+      unsigned iFirst = 0;
+      while (iFirst < 2 && (isShort(leftLen) ||
+         isShort(srcBlock[iFirst].sb->GetSampleCount())))
+         leftLen += srcBlock[iFirst++].sb->GetSampleCount();
+
+      const auto rightSplit = splitLen - splitPoint;
+      size_t rightLen = rightSplit;
+      unsigned iLast = srcNumBlocks;
+      while (srcNumBlocks - iLast < 2 && (isShort(rightLen) ||
+         isShort(srcBlock[iLast - 1].sb->GetSampleCount())))
+         rightLen += srcBlock[--iLast].sb->GetSampleCount();
 
       SampleBuffer sampleBuffer(std::max(leftLen, rightLen), format);
 
-      Read(sampleBuffer.ptr(), format, splitBlock, 0, splitPoint, true);
-      src->Get(0, sampleBuffer.ptr() + splitPoint*sampleSize,
-               format, 0, srcFirstTwoLen, true);
+      if (leftLen > 0) {
+         if (splitPoint > 0)
+            Read(sampleBuffer.ptr(), format, splitBlock, 0, splitPoint, true);
+         src->Get(0, sampleBuffer.ptr() + splitPoint*sampleSize,
+                  format, 0, leftLen - splitPoint, true);
 
-      Blockify(*mpFactory, mMaxSamples, format,
-               newBlock, splitBlock.start, sampleBuffer.ptr(), leftLen);
+         Blockify(*mpFactory, mMaxSamples, format,
+                  newBlock, splitBlock.start, sampleBuffer.ptr(), leftLen);
+      }
 
-      for (i = 2; i < srcNumBlocks - 2; i++) {
+      for (i = iFirst; i < iLast; i++) {
          const SeqBlock &block = srcBlock[i];
          auto sb = ShareOrCopySampleBlock(
             pUseFactory, format, block.sb );
-         newBlock.push_back(SeqBlock(sb, block.start + s));
+         newBlock.push_back(SeqBlock(sb, block.start + s, block.reversed));
       }
 
-      auto lastStart = penultimate.start;
-      src->Get(srcNumBlocks - 2, sampleBuffer.ptr(), format,
-               lastStart, srcLastTwoLen, true);
-      Read(sampleBuffer.ptr() + srcLastTwoLen * sampleSize, format,
-           splitBlock, splitPoint, rightSplit, true);
+      if (splitPoint == 0 && iLast == srcNumBlocks)
+         // The split block is not really split, and can be shared
+         newBlock.push_back(splitBlock.Plus(addedLen));
+      else if (rightLen > 0) {
+         const auto lastStart =
+            iLast < srcNumBlocks ? srcBlock[iLast].start : addedLen;
+         const auto srcRightLen = rightLen - rightSplit;
+         if (srcRightLen > 0)
+            src->Get(iLast, sampleBuffer.ptr(), format,
+                     lastStart, srcRightLen, true);
+         if (rightSplit > 0)
+            Read(sampleBuffer.ptr() + srcRightLen * sampleSize, format,
+                 splitBlock, splitPoint, rightSplit, true);
 
-      Blockify(*mpFactory, mMaxSamples, format,
-               newBlock, s + lastStart, sampleBuffer.ptr(), rightLen);
+         Blockify(*mpFactory, mMaxSamples, format,
+                  newBlock, s + lastStart, sampleBuffer.ptr(), rightLen);
+      }
    }
 
    // Copy remaining blocks to NEW block array and
@@ -767,7 +855,7 @@ void Sequence::AppendBlock( SampleBlockFactory *pFactory, sampleFormat format,
       THROW_INCONSISTENCY_EXCEPTION;
 
    auto sb = ShareOrCopySampleBlock( pFactory, format, b.sb );
-   SeqBlock newBlock(sb, mNumSamples);
+   SeqBlock newBlock(sb, mNumSamples, b.reversed);
 
    // We can assume newBlock.sb is not null
 
@@ -818,6 +906,7 @@ static constexpr auto MaxSamples_attr = "maxsamples";
 static constexpr auto SampleFormat_attr = "sampleformat";
 static constexpr auto EffectiveSampleFormat_attr = "effectivesampleformat";
 static constexpr auto NumSamples_attr = "numsamples";
+static constexpr auto Reversed_attr = "reversed";
 
 bool Sequence::HandleXMLTag(const std::string_view& tag, const AttributesList &attrs)
 {
@@ -855,6 +944,17 @@ bool Sequence::HandleXMLTag(const std::string_view& tag, const AttributesList &a
 
             wb.start = start;
          }
+         else if (attr == Reversed_attr)
+         {
+            bool reversed;
+            if (!value.TryGet(reversed))
+            {
+               mErrorOpening = true;
+               return false;
+            }
+
+            wb.reversed = reversed;
+         }
       }
 
       mBlock.push_back(wb);
@@ -1043,6 +1143,9 @@ void Sequence::WriteXML(XMLWriter &xmlFile) const
 
       xmlFile.StartTag(WaveBlock_tag);
       xmlFile.WriteAttr(Start_attr, bb.start.as_long_long());
+      // This attribute was added in 3.6.0, and written only when true:
+      if (bb.reversed)
+         xmlFile.WriteAttr(Reversed_attr, bb.reversed);
 
       bb.sb->SaveXML(xmlFile);
 
@@ -1111,7 +1214,10 @@ bool Sequence::Read(samplePtr buffer, sampleFormat format,
    wxASSERT(blockRelativeStart + len <= sb->GetSampleCount());
 
    // Either throws, or of !mayThrow, tells how many were really read
-   auto result = sb->GetSamples(buffer, format, blockRelativeStart, len, mayThrow);
+   auto result = sb->GetSamples(buffer, format,
+      StoredStart(b, blockRelativeStart, len), len, mayThrow);
+   if (b.reversed)
+      ReverseSamples(buffer, format, result);
 
    if (result != len)
    {
@@ -1137,7 +1243,11 @@ AudioSegmentSampleView Sequence::GetFloatSampleView(
    {
       const auto b = FindBlock(cursor);
       const SeqBlock& block = mBlock[b];
-      blockViews.push_back(block.sb->GetFloatSampleView(mayThrow));
+      auto view = block.sb->GetFloatSampleView(mayThrow);
+      if (block.reversed)
+         view = std::make_shared<std::vector<float>>(
+            view->rbegin(), view->rend());
+      blockViews.push_back(std::move(view));
       cursor = block.start + block.sb->GetSampleCount();
    }
    return { std::move(blockViews), sequenceOffset, length };
@@ -1295,6 +1405,7 @@ void Sequence::SetSamples(constSamplePtr buffer, sampleFormat format,
             scratch.ptr(),
             fileLength,
             dstFormat);
+         block.reversed = false;
       }
       else {
          // Avoid reading the disk when the replacement is total
@@ -1302,6 +1413,7 @@ void Sequence::SetSamples(constSamplePtr buffer, sampleFormat format,
             block.sb = factory.Create(useBuffer, fileLength, dstFormat);
          else
             block.sb = factory.CreateSilent(fileLength, dstFormat);
+         block.reversed = false;
       }
 
       // blen might be zero for inconsistent Sequence...
@@ -1322,6 +1434,89 @@ void Sequence::SetSamples(constSamplePtr buffer, sampleFormat format,
    mSampleFormats.UpdateEffective(effectiveFormat);
 }
 
+/*! @excsafety{Strong} */
+bool Sequence::Reverse(sampleCount start, sampleCount len,
+   const std::function<bool(size_t)> &progressReport)
+{
+   if (len <= 1)
+      return true;
+
+   const auto end = start + len;
+   if (start < 0 || end > mNumSamples)
+      THROW_INCONSISTENCY_EXCEPTION;
+
+   const auto format = mSampleFormats.Stored();
+   const auto sampleSize = SAMPLE_SIZE(format);
+   const int b0 = FindBlock(start);
+   const int b1 = FindBlock(end - 1);
+   const SeqBlock &firstBlock = mBlock[b0];
+   const SeqBlock &lastBlock = mBlock[b1];
+
+   BlockArray newBlock;
+   newBlock.reserve(mBlock.size() + 4);
+   std::copy(mBlock.begin(), mBlock.begin() + b0,
+      std::back_inserter(newBlock));
+
+   // Samples not in whole blocks are gathered here to make new blocks: the
+   // untouched head of the first block, the reversed part of a block only
+   // partly in the range, and the untouched tail of the last block.  At most
+   // two of these are gathered at once, each at most one block.
+   SampleBuffer buffer(2 * mMaxSamples, format);
+   size_t filled = 0;
+   auto pos = firstBlock.start;
+   const auto flush = [&]{
+      Blockify(*mpFactory, mMaxSamples, format,
+         newBlock, pos, buffer.ptr(), filled);
+      pos += filled;
+      filled = 0;
+   };
+
+   filled = (start - firstBlock.start).as_size_t();
+   if (filled > 0)
+      Read(buffer.ptr(), format, firstBlock, 0, filled, true);
+
+   // Visit old blocks from last to first, so new blocks come out in order
+   for (auto b = b1; b >= b0; --b) {
+      const SeqBlock &block = mBlock[b];
+      const auto blockLen = block.sb->GetSampleCount();
+      const auto pieceStart = std::max(start, block.start);
+      const auto pieceLen =
+         (std::min(end, block.start + blockLen) - pieceStart).as_size_t();
+      if (pieceLen == blockLen) {
+         // Share the whole block, seen in the other direction
+         flush();
+         newBlock.push_back(SeqBlock(block.sb, pos, !block.reversed));
+         pos += blockLen;
+      }
+      else {
+         const auto dst = buffer.ptr() + filled * sampleSize;
+         Read(dst, format, block,
+            (pieceStart - block.start).as_size_t(), pieceLen, true);
+         ReverseSamples(dst, format, pieceLen);
+         filled += pieceLen;
+      }
+
+      if (b == b0) {
+         const auto tailStart = (end - lastBlock.start).as_size_t();
+         const auto tailLen = lastBlock.sb->GetSampleCount() - tailStart;
+         if (tailLen > 0)
+            Read(buffer.ptr() + filled * sampleSize, format, lastBlock,
+               tailStart, tailLen, true);
+         filled += tailLen;
+      }
+      flush();
+
+      if (progressReport && !progressReport(pieceLen))
+         return false;
+   }
+
+   std::copy(mBlock.begin() + b1 + 1, mBlock.end(),
+      std::back_inserter(newBlock));
+
+   CommitChangesIfConsistent(newBlock, mNumSamples, wxT("Reverse"));
+   return true;
+}
+
 size_t Sequence::GetIdealAppendLen() const
 {
    int numBlocks = mBlock.size();
@@ -1349,7 +1544,8 @@ SeqBlock::SampleBlockPtr Sequence::AppendNewBlock(
 }
 
 /*! @excsafety{Strong} */
-void Sequence::AppendSharedBlock(const SeqBlock::SampleBlockPtr &pBlock)
+void Sequence::AppendSharedBlock(
+   const SeqBlock::SampleBlockPtr &pBlock, sampleFormat effectiveFormat)
 {
    auto len = pBlock->GetSampleCount();
 
@@ -1363,6 +1559,7 @@ void Sequence::AppendSharedBlock(const SeqBlock::SampleBlockPtr &pBlock)
 
    AppendBlocksIfConsistent(newBlock, false,
                             newNumSamples, wxT("Append"));
+   mSampleFormats.UpdateEffective(effectiveFormat);
 
 // JKC: During generate we use Append again and again.
 // If generating a long sequence this test would give O(n^2)
@@ -1629,6 +1826,7 @@ void Sequence::Delete(sampleCount start, sampleCount len)
            ( pos + len ).as_size_t(), newLen - pos, true);
 
       b.sb = factory.Create(scratch.ptr(), newLen, format);
+      b.reversed = false;
 
       // Don't make a duplicate array.  We can still give Strong-guarantee
       // if we modify only one block in place.
@@ -32,19 +32,22 @@ class SeqBlock {
    SampleBlockPtr sb;
    ///the sample in the global wavetrack that this block starts at.
    sampleCount start;
+   ///whether the samples of sb are seen in reverse order
+   bool reversed;
 
    SeqBlock()
-      : sb{}, start(0)
+      : sb{}, start(0), reversed(false)
    {}
 
-   SeqBlock(const SampleBlockPtr &sb_, sampleCount start_)
-      : sb(sb_), start(start_)
+   SeqBlock(const SampleBlockPtr &sb_, sampleCount start_,
+      bool reversed_ = false)
+      : sb(sb_), start(start_), reversed(reversed_)
    {}
 
-   // Construct a SeqBlock with changed start, same file
+   // Construct a SeqBlock with changed start, same file and direction
    SeqBlock Plus(sampleCount delta) const
    {
-      return SeqBlock(sb, start + delta);
+      return SeqBlock(sb, start + delta, reversed);
    }
 };
 class BlockArray : public std::vector<SeqBlock> {};
@@ -121,6 +124,19 @@ class WAVE_TRACK_API Sequence final : public XMLTagHandler{
       */
    );
 
+   //! Reverse the order of samples in [start, start + len)
+   /*!
+    Blocks wholly within the range are shared, only flipping their direction
+    and their order.  At most the two blocks that the range partly covers
+    are rewritten, in stored format, so the effective format is unchanged.
+    @param progressReport called with the number of samples done since the
+    last call; returns false to cancel
+    @return false if cancelled, leaving the sequence unchanged
+    @excsafety{Strong}
+    */
+   bool Reverse(sampleCount start, sampleCount len,
+      const std::function<bool(size_t)> &progressReport = {});
+
    // Return non-null, or else throw!
    // Must pass in the correct factory for the result.  If it's not the same
    // as in this, then block contents must be copied.
@@ -163,7 +179,10 @@ class WAVE_TRACK_API Sequence final : public XMLTagHandler{
       constSamplePtr buffer, sampleFormat format, size_t len);
    //! Append a complete block, not coalescing
    /*! @excsafety{Strong} */
-   void AppendSharedBlock(const SeqBlock::SampleBlockPtr &pBlock);
+   void AppendSharedBlock(const SeqBlock::SampleBlockPtr &pBlock,
+      sampleFormat effectiveFormat = narrowestSampleFormat /*!<
+         Widest format the block's samples were converted from */
+   );
    /*! @excsafety{Strong} */
    void Delete(sampleCount start, sampleCount len);
 
@@ -214,6 +233,8 @@ class WAVE_TRACK_API Sequence final : public XMLTagHandler{
    std::pair<float, float> GetMinMax(
       sampleCount start, sampleCount len, bool mayThrow) const;
    float GetRMS(sampleCount start, sampleCount len, bool mayThrow) const;
+   //! Sum of the samples; sums of whole blocks are computed once and cached
+   double GetSum(sampleCount start, sampleCount len, bool mayThrow) const;
 
    //
    // Getting block size and alignment information
@@ -14,6 +14,7 @@
 #include "WaveClipUtilities.h"
 #include "WaveTrack.h"
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
 
@@ -92,6 +93,30 @@ float WaveChannelUtilities::GetRMS(const WaveChannel &channel,
    return duration > 0 ? sqrt(sumsq / duration) : 0.0;
 }
 
+bool WaveChannelUtilities::GetSum(const WaveChannel &channel,
+   sampleCount start, size_t len, double &sum,
+   sampleCount *pNumWithinClips, bool mayThrow)
+{
+   sum = 0;
+   sampleCount numWithinClips = 0;
+   // Iterate the clips.  They are not necessarily sorted by time.
+   for (const auto &clip: channel.Intervals()) {
+      const auto clipStart = clip->GetPlayStartSample();
+      const auto clipEnd = clip->GetPlayEndSample();
+      if (clipEnd > start && clipStart < start + len) {
+         if (clip->HasPitchOrSpeed())
+            return false;
+         const auto s0 = std::max(start, clipStart);
+         const auto s1 = std::min(start + len, clipEnd);
+         sum += clip->GetSum(s0 - clipStart, (s1 - s0).as_size_t(), mayThrow);
+         numWithinClips += s1 - s0;
+      }
+   }
+   if (pNumWithinClips)
+      *pNumWithinClips = numWithinClips;
+   return true;
+}
+
 namespace {
 using namespace WaveChannelUtilities;
 
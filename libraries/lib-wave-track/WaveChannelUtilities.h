@@ -87,6 +87,20 @@ WAVE_TRACK_API std::pair<float, float> GetMinMax(const WaveChannel &channel,
 WAVE_TRACK_API float GetRMS(const WaveChannel &channel,
    double t0, double t1, bool mayThrow = true);
 
+/*!
+ @brief Sum of the samples within clips, in a range of absolute sample
+ positions.  Uses sums cached in sample blocks, so that repeated analysis of
+ unchanged audio does not read it again.
+
+ @param[out] pNumWithinClips if not null, receives how many of the samples
+ were within clips
+ @return false, as for `WaveChannel::GetFloats()`, if a clip in the range has
+ pitch or speed changes
+ */
+WAVE_TRACK_API bool GetSum(const WaveChannel &channel,
+   sampleCount start, size_t len, double &sum,
+   sampleCount *pNumWithinClips = nullptr, bool mayThrow = true);
+
 /*!
  @brief Gets as many samples as it can, but no more than `2 *
  numSideSamples + 1`, centered around `t`. Reads nothing if
@@ -158,6 +158,12 @@ float WaveClipChannel::GetRMS(double t0, double t1, bool mayThrow) const
    return GetClip().GetRMS(miChannel, t0, t1, mayThrow);
 }
 
+double WaveClipChannel::GetSum(
+   sampleCount start, size_t len, bool mayThrow) const
+{
+   return GetClip().GetSum(miChannel, start, len, mayThrow);
+}
+
 sampleCount WaveClipChannel::GetPlayStartSample() const
 {
    return GetClip().GetPlayStartSample();
@@ -408,6 +414,23 @@ void WaveClip::SetSamples(size_t ii,
    MarkChanged();
 }
 
+/*! @excsafety{Strong} */
+bool WaveClip::Reverse(sampleCount start, sampleCount len,
+   const std::function<bool(size_t)> &progressReport)
+{
+   StrongInvariantScope scope{ *this };
+   Transaction transaction{ *this };
+   const auto offset = TimeToSamples(mTrimLeft);
+   for (auto &pSequence : mSequences)
+      if (!pSequence->Reverse(start + offset, len, progressReport))
+         return false;
+   transaction.Commit();
+
+   // use No-fail-guarantee
+   MarkChanged();
+   return true;
+}
+
 void WaveClip::SetEnvelope(std::unique_ptr<Envelope> p)
 {
    assert(p);
@@ -779,6 +802,14 @@ float WaveClip::GetRMS(size_t ii, double t0, double t1, bool mayThrow) const
    return mSequences[ii]->GetRMS(s0, s1-s0, mayThrow);
 }
 
+double WaveClip::GetSum(size_t ii,
+   sampleCount start, size_t len, bool mayThrow) const
+{
+   assert(ii < NChannels());
+   return mSequences[ii]
+      ->GetSum(start + TimeToSamples(mTrimLeft), len, mayThrow);
+}
+
 void WaveClip::ConvertToSampleFormat(sampleFormat format,
    const std::function<void(size_t)> & progressReport)
 {
@@ -841,6 +872,28 @@ void WaveClip::AppendLegacySharedBlock(
    mSequences[0]->AppendSharedBlock( pBlock );
 }
 
+/*! @excsafety{Strong} */
+void WaveClip::AppendSharedBlocks(
+   const std::vector<std::shared_ptr<SampleBlock>> &blocks,
+   sampleFormat effectiveFormat)
+{
+   assert(blocks.size() == NChannels());
+   assert(GreatestAppendBufferLen() == 0);
+
+   StrongInvariantScope scope{ *this };
+
+   Transaction transaction{ *this };
+
+   size_t ii = 0;
+   for (auto &pSequence : mSequences)
+      pSequence->AppendSharedBlock(blocks[ii++], effectiveFormat);
+
+   transaction.Commit();
+   // use No-fail-guarantee
+   UpdateEnvelopeTrackLen();
+   MarkChanged();
+}
+
 bool WaveClip::Append(size_t iChannel, const size_t nChannels,
    constSamplePtr buffers[], sampleFormat format,
    size_t len, unsigned int stride, sampleFormat effectiveFormat)
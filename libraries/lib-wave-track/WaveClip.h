@@ -152,6 +152,9 @@ public:
     */
    float GetRMS(double t0, double t1, bool mayThrow) const;
 
+   //! @param start relative to clip play start sample
+   double GetSum(sampleCount start, size_t len, bool mayThrow = true) const;
+
    //! Real start time of the clip, quantized to raw sample rate (track's rate)
    sampleCount GetPlayStartSample() const;
 
@@ -548,6 +551,19 @@ public:
       */
    );
 
+   //! Reverse the order of samples in all channels, within a range
+   /*!
+    @pre `StrongInvariant()`
+    @post `StrongInvariant()`
+    @param start relative to clip play start sample
+    @param progressReport called with the number of samples done in one
+    channel since the last call; returns false to cancel
+    @return false if cancelled, leaving the clip unchanged
+    @excsafety{Strong}
+    */
+   bool Reverse(sampleCount start, sampleCount len,
+      const std::function<bool(size_t)> &progressReport = {});
+
    //! @}
 
    Envelope &GetEnvelope() noexcept { return *mEnvelope; }
@@ -589,6 +605,14 @@ public:
     @copydoc GetMinMax
     */
    float GetRMS(size_t ii, double t0, double t1, bool mayThrow) const;
+   //! Sum of samples of one channel
+   /*!
+    @param ii identifies the channel
+    @param start relative to clip play start sample
+    @pre `ii < NChannels()`
+    */
+   double GetSum(size_t ii,
+      sampleCount start, size_t len, bool mayThrow = true) const;
 
    /** Whenever you do an operation to the sequence that will change the number
     * of samples (that is, the length of the clip), you will want to call this
@@ -615,6 +639,18 @@ public:
     */
    void AppendLegacySharedBlock(const std::shared_ptr<SampleBlock> &pBlock);
 
+   //! Append one block to each channel, sharing the blocks
+   /*!
+    @pre `blocks.size() == NChannels()`
+    @pre the blocks have equal sample counts
+    @pre no appended samples wait for Flush()
+    */
+   void AppendSharedBlocks(
+      const std::vector<std::shared_ptr<SampleBlock>> &blocks,
+      sampleFormat effectiveFormat /*!<
+         Widest format the blocks' samples were converted from */
+   );
+
    //! Append (non-interleaved) samples to some or all channels
    //! You must call Flush after the last Append
    /*!
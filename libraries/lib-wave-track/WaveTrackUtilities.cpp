@@ -62,67 +62,6 @@ void WaveTrackUtilities::AllClipsIterator::Push(IntervalHolders clips)
    }
 }
 
-namespace {
-bool ReverseOneClip(WaveTrack &track,
-   sampleCount start, sampleCount len,
-   sampleCount originalStart, sampleCount originalEnd,
-      const WaveTrackUtilities::ProgressReport &report)
-{
-   bool rc = true;
-   // keep track of two blocks whose data we will swap
-   auto first = start;
-
-   auto blockSize = track.GetMaxBlockSize();
-   const auto width = track.NChannels();
-   Floats buffers0[2]{
-      Floats(blockSize), width > 1 ? Floats(blockSize) : Floats{} };
-   float *pointers0[2]{ buffers0[0].get(),
-      width > 1 ? buffers0[1].get() : nullptr };
-   Floats buffers1[2]{
-      Floats(blockSize), width > 1 ? Floats(blockSize) : Floats{} };
-   float *pointers1[2]{ buffers1[0].get(),
-      width > 1 ? buffers1[1].get() : nullptr };
-   constexpr auto reverseBuffers =
-   [](float *const (&pointers)[2], size_t size){
-      for (const auto pointer : pointers)
-         if (pointer)
-            std::reverse(pointer, pointer + size);
-   };
-
-   auto originalLen = originalEnd - originalStart;
-
-   while (len > 1) {
-      auto block =
-         limitSampleBufferSize(track.GetBestBlockSize(first), len / 2);
-      auto second = first + (len - block);
-
-      track.GetFloats(0, width, pointers0, first, block);
-      reverseBuffers(pointers0, block);
-      track.GetFloats(0, width, pointers1, second, block);
-      reverseBuffers(pointers1, block);
-      // Don't dither on later rendering if only reversing samples
-      const bool success =
-         track.SetFloats(pointers1, first, block, narrowestSampleFormat)
-         &&
-         track.SetFloats(pointers0, second, block, narrowestSampleFormat);
-      if (!success)
-         return false;
-
-      len -= 2 * block;
-      first += block;
-
-      if (!report(
-         2 * (first - originalStart).as_double() / originalLen.as_double()
-      )) {
-         rc = false;
-         break;
-      }
-   }
-
-   return rc;
-}
-}
-
 bool WaveTrackUtilities::Reverse(WaveTrack &track,
    sampleCount start, sampleCount len, const ProgressReport &progress)
 {
@@ -179,6 +118,9 @@ bool WaveTrackUtilities::Reverse(WaveTrack &track,
 
    bool checkedFirstClip = false;
 
+   // samples reversed so far, over all channels, for progress
+   sampleCount reversed = 0;
+
    // used in calculating the offset of clips to rearrange
    // holds the new end position of the current clip
    auto currentEnd = end;
@@ -216,8 +158,14 @@ bool WaveTrackUtilities::Reverse(WaveTrack &track,
          auto revEnd = std::min(end, clipEnd);
          auto revLen = revEnd - revStart;
          if (revEnd >= revStart) {
-            // reverse the clip
-            if (!ReverseOneClip(track, revStart, revLen, start, end, progress))
+            // reverse the clip, block by block
+            const auto report = [&, total = (end - start).as_double() *
+               clip->NChannels()](size_t done) {
+               reversed += done;
+               return !progress || progress(reversed.as_double() / total);
+            };
+            if (clip->HasPitchOrSpeed() ||
+               !clip->Reverse(revStart - clipStart, revLen, report))
             {
                rValue = false;
                break;
@@ -442,6 +390,23 @@ ProjectFormatExtensionsRegistry::Extension stretchedClipsExtension(
       return BaseProjectFormatVersion;
    }
 );
+
+// If any sample blocks are seen in reverse, don't allow older versions to
+// open the project.  Otherwise they would play those blocks forward.
+ProjectFormatExtensionsRegistry::Extension reversedBlocksExtension(
+   [](const AudacityProject& project) -> ProjectFormatVersion {
+      const TrackList& trackList = TrackList::Get(project);
+      for (auto wt : trackList.Any<const WaveTrack>())
+         for (const auto& clip : GetAllClips(*wt))
+            for (size_t ii = 0, nn = clip->NChannels(); ii < nn; ++ii) {
+               const auto &blocks = *clip->GetSequenceBlockArray(ii);
+               if (std::any_of(blocks.begin(), blocks.end(),
+                  [](const SeqBlock &block){ return block.reversed; }))
+                  return { 3, 6, 0, 0 };
+            }
+      return BaseProjectFormatVersion;
+   }
+);
 }
 
 void WaveTrackUtilities::ExpandClipTillNextOne(
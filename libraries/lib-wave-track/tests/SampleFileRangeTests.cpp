@@ -0,0 +1,361 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  SampleFileRangeTests.cpp
+
+**********************************************************************/
+#include <catch2/catch.hpp>
+
+#include <cstring>
+#include <vector>
+
+#include <wx/file.h>
+#include <wx/filename.h>
+
+#include "FileException.h"
+#include "SampleFileRange.h"
+#include "XMLFileReader.h"
+#include "XMLWriter.h"
+
+namespace
+{
+using Encoding = SampleFileRange::Encoding;
+using Layout = SampleFileRange::Layout;
+
+//! A file of the given bytes, removed at the end of the scope
+struct TempFile
+{
+   explicit TempFile(const std::vector<uint8_t>& bytes)
+       : path { wxFileName::CreateTempFileName("SampleFileRangeTest") }
+   {
+      wxFile file { path, wxFile::write };
+      REQUIRE(file.Write(bytes.data(), bytes.size()) == bytes.size());
+   }
+   ~TempFile()
+   {
+      wxRemoveFile(path);
+   }
+   const FilePath path;
+};
+
+void Put(std::vector<uint8_t>& bytes, uint32_t word, size_t size, bool bigEndian)
+{
+   for (size_t ii = 0; ii < size; ++ii)
+      bytes.push_back(word >> (8 * (bigEndian ? size - 1 - ii : ii)));
+}
+
+uint32_t FloatWord(float value)
+{
+   uint32_t word;
+   memcpy(&word, &value, sizeof(word));
+   return word;
+}
+
+//! Interleaves the channels after a header of headerSize bytes, so that
+//! samples need not be aligned
+std::vector<uint8_t> Interleave(
+   const std::vector<std::vector<uint32_t>>& channels, size_t size,
+   bool bigEndian, size_t headerSize)
+{
+   std::vector<uint8_t> bytes(headerSize, 0xAA);
+   for (size_t ii = 0; ii < channels[0].size(); ++ii)
+      for (const auto& channel : channels)
+         Put(bytes, channel[ii], size, bigEndian);
+   return bytes;
+}
+
+template<typename Sample>
+std::vector<Sample> Read(
+   const SampleFileRange& range, sampleFormat format, size_t start, size_t len)
+{
+   std::vector<Sample> result(len);
+   range.Read(reinterpret_cast<samplePtr>(result.data()), format, start, len);
+   return result;
+}
+
+template<typename Sample>
+std::vector<Sample> ReadAll(const SampleFileRange& range, sampleFormat format)
+{
+   return Read<Sample>(range, format, 0, range.GetSampleCount());
+}
+
+std::vector<float> ToFloats(const std::vector<int16_t>& samples)
+{
+   std::vector<float> result;
+   for (const auto sample : samples)
+      result.push_back(sample / 32768.0f);
+   return result;
+}
+
+//! Reconstructs a range from the attributes of one tag
+struct RangeHandler final : XMLTagHandler
+{
+   bool HandleXMLTag(const std::string_view&, const AttributesList& attrs) override
+   {
+      pRange = SampleFileRange::FromXML(attrs);
+      length = SampleFileRange::GetLengthFromXML(attrs);
+      return true;
+   }
+   XMLTagHandler* HandleXMLChild(const std::string_view&) override
+   {
+      return nullptr;
+   }
+   std::shared_ptr<const SampleFileRange> pRange;
+   size_t length {};
+};
+} // namespace
+
+TEST_CASE("SampleFileRange reads 16-bit samples")
+{
+   constexpr size_t len = 37, headerSize = 45;
+   std::vector<int16_t> left, right;
+   for (size_t ii = 0; ii < len; ++ii)
+   {
+      left.push_back(static_cast<int16_t>(ii * 1789 - 32768));
+      right.push_back(static_cast<int16_t>(-static_cast<int>(ii) * 311 + 7));
+   }
+   const auto words = [](const std::vector<int16_t>& samples) {
+      std::vector<uint32_t> result;
+      for (const auto sample : samples)
+         result.push_back(static_cast<uint16_t>(sample));
+      return result;
+   };
+
+   for (const bool bigEndian : { false, true })
+   {
+      const TempFile file { Interleave(
+         { words(left), words(right) }, 2, bigEndian, headerSize) };
+      for (const size_t channel : { 0, 1 })
+      {
+         const auto& expected = channel == 0 ? left : right;
+         const SampleFileRange range { file.path,
+                                       { Encoding::Int16, bigEndian,
+                                         headerSize + 2 * channel, 4 },
+                                       len };
+         REQUIRE(range.GetNativeFormat() == int16Sample);
+         REQUIRE(ReadAll<int16_t>(range, int16Sample) == expected);
+         REQUIRE(ReadAll<float>(range, floatSample) == ToFloats(expected));
+
+         // Start anywhere
+         REQUIRE(
+            Read<int16_t>(range, int16Sample, 5, 11) ==
+            std::vector<int16_t>(expected.begin() + 5, expected.begin() + 16));
+      }
+   }
+
+   SECTION("of mono files")
+   {
+      for (const bool bigEndian : { false, true })
+      {
+         const TempFile file { Interleave({ words(left) }, 2, bigEndian, 1) };
+         const SampleFileRange range { file.path,
+                                       { Encoding::Int16, bigEndian, 1, 2 },
+                                       len };
+         REQUIRE(ReadAll<int16_t>(range, int16Sample) == left);
+         REQUIRE(ReadAll<float>(range, floatSample) == ToFloats(left));
+      }
+   }
+}
+
+TEST_CASE("SampleFileRange reads 24-bit samples with their signs")
+{
+   const std::vector<int32_t> samples { 0,       1,         -1,       0x7FFFFF,
+                                        -0x800000, 0x123456, -0x123456 };
+   std::vector<uint32_t> words;
+   for (const auto sample : samples)
+      words.push_back(static_cast<uint32_t>(sample) & 0xFFFFFF);
+   const std::vector<uint32_t> zeros(words.size(), 0);
+
+   for (const bool bigEndian : { false, true })
+   {
+      for (const size_t channels : { 1, 2 })
+      {
+         std::vector<std::vector<uint32_t>> interleaved { words };
+         if (channels == 2)
+            interleaved.insert(interleaved.begin(), zeros);
+         const TempFile file { Interleave(interleaved, 3, bigEndian, 2) };
+         const SampleFileRange range {
+            file.path,
+            { Encoding::Int24, bigEndian, 2 + 3 * (channels - 1),
+              3 * channels },
+            samples.size()
+         };
+         REQUIRE(range.GetNativeFormat() == int24Sample);
+         REQUIRE(ReadAll<int32_t>(range, int24Sample) == samples);
+
+         std::vector<float> expected;
+         for (const auto sample : samples)
+            expected.push_back(sample / 8388608.0f);
+         REQUIRE(ReadAll<float>(range, floatSample) == expected);
+      }
+   }
+}
+
+TEST_CASE("SampleFileRange reads float samples")
+{
+   constexpr size_t len = 29;
+   std::vector<float> samples;
+   std::vector<uint32_t> words, others;
+   for (size_t ii = 0; ii < len; ++ii)
+   {
+      samples.push_back(ii / 16.0f - 0.75f);
+      words.push_back(FloatWord(samples.back()));
+      others.push_back(FloatWord(-2.0f));
+   }
+
+   SECTION("of the middle of three channels")
+   {
+      const TempFile file { Interleave({ others, words, others }, 4, false, 3) };
+      const SampleFileRange range { file.path,
+                                    { Encoding::Float32, false, 7, 12 },
+                                    len };
+      REQUIRE(range.GetNativeFormat() == floatSample);
+      REQUIRE(ReadAll<float>(range, floatSample) == samples);
+   }
+
+   for (const bool bigEndian : { false, true })
+   {
+      for (const size_t channel : { 0, 1 })
+      {
+         std::vector<std::vector<uint32_t>> interleaved { words, others };
+         if (channel == 1)
+            std::swap(interleaved[0], interleaved[1]);
+         const TempFile file { Interleave(interleaved, 4, bigEndian, 5) };
+         const SampleFileRange range { file.path,
+                                       { Encoding::Float32, bigEndian,
+                                         5 + 4 * channel, 8 },
+                                       len };
+         REQUIRE(ReadAll<float>(range, floatSample) == samples);
+      }
+   }
+}
+
+TEST_CASE("SampleFileRange XML round trip")
+{
+   const TempFile file { std::vector<uint8_t>(1000, 0x10) };
+   const SampleFileRange range { file.path,
+                                 { Encoding::Int24, true, 17, 6 }, 150 };
+
+   XMLStringWriter writer;
+   writer.StartTag(wxT("range"));
+   range.WriteXMLAttributes(writer);
+   writer.EndTag(wxT("range"));
+
+   RangeHandler handler;
+   XMLFileReader reader;
+   REQUIRE(reader.ParseString(&handler, writer));
+   REQUIRE(handler.pRange);
+   REQUIRE(handler.length == 150);
+
+   const auto& loaded = *handler.pRange;
+   REQUIRE(loaded.GetPath() == range.GetPath());
+   REQUIRE(loaded.GetSampleCount() == 150);
+   REQUIRE(loaded.GetLayout().encoding == Encoding::Int24);
+   REQUIRE(loaded.GetLayout().bigEndian);
+   REQUIRE(loaded.GetLayout().offset == 17);
+   REQUIRE(loaded.GetLayout().stride == 6);
+   REQUIRE(
+      ReadAll<int32_t>(loaded, int24Sample) ==
+      ReadAll<int32_t>(range, int24Sample));
+
+   SECTION("but not of other tags")
+   {
+      RangeHandler other;
+      REQUIRE(reader.ParseString(&other, wxT("<range len=\"150\"/>")));
+      REQUIRE(!other.pRange);
+      REQUIRE(other.length == 0);
+   }
+}
+
+TEST_CASE("SampleFileRange checks the length of the file")
+{
+   // Room for 10 samples at stride 4, the last one not followed by another
+   // channel's
+   const TempFile file { std::vector<uint8_t>(8 + 9 * 4 + 2, 0) };
+   const auto make = [&](uint64_t offset, size_t count) {
+      return SampleFileRange {
+         file.path, { Encoding::Int16, false, offset, 4 }, count
+      };
+   };
+   REQUIRE_NOTHROW(make(8, 10));
+   REQUIRE_THROWS_AS(make(8, 11), FileException);
+   REQUIRE_THROWS_AS(make(9, 10), FileException);
+   REQUIRE_THROWS_AS(make(8 + 9 * 4 + 1, 1), FileException);
+   REQUIRE_THROWS_AS(make(1000, 1), FileException);
+   REQUIRE_THROWS_AS(make(8, 0), FileException);
+   REQUIRE_THROWS_AS(
+      (SampleFileRange { file.path + "-missing",
+                         { Encoding::Int16, false, 0, 2 }, 1 }),
+      FileException);
+
+#ifndef _WIN32
+   SECTION("and reads throw if the file is truncated later")
+   {
+      // Another file, because ranges share the file that one opened
+      const TempFile other { std::vector<uint8_t>(400, 0x7F) };
+      const SampleFileRange range { other.path,
+                                    { Encoding::Int16, false, 0, 2 }, 200 };
+      REQUIRE(ReadAll<int16_t>(range, int16Sample)[199] == 0x7F7F);
+      wxFile { other.path, wxFile::write };
+      REQUIRE_NOTHROW(Read<int16_t>(range, int16Sample, 0, 0));
+      REQUIRE_THROWS_AS(ReadAll<int16_t>(range, int16Sample), FileException);
+   }
+#endif
+}
+
+TEST_CASE("SampleFileRange::Decode deinterleaves stereo of any length")
+{
+   // Lengths about the vectors of eight 16-bit or four float samples, with
+   // the bytes at every alignment
+   for (size_t len = 0; len <= 9; ++len)
+   {
+      std::vector<int16_t> left, right;
+      std::vector<float> leftFloats, rightFloats;
+      for (size_t ii = 0; ii < len; ++ii)
+      {
+         left.push_back(static_cast<int16_t>(-32768 + 4099 * ii));
+         right.push_back(static_cast<int16_t>(32767 - 5003 * ii));
+         leftFloats.push_back(ii / 8.0f - 1.0f);
+         rightFloats.push_back(0.5f - ii / 4.0f);
+      }
+      const auto words16 = [](const std::vector<int16_t>& samples) {
+         std::vector<uint32_t> result;
+         for (const auto sample : samples)
+            result.push_back(static_cast<uint16_t>(sample));
+         return result;
+      };
+      const auto words32 = [](const std::vector<float>& samples) {
+         std::vector<uint32_t> result;
+         for (const auto sample : samples)
+            result.push_back(FloatWord(sample));
+         return result;
+      };
+
+      for (size_t misalignment = 0; misalignment < 4; ++misalignment)
+      {
+         const auto bytes16 = Interleave(
+            { words16(left), words16(right) }, 2, false, misalignment);
+         const auto bytes32 = Interleave(
+            { words32(leftFloats), words32(rightFloats) }, 4, false,
+            misalignment);
+         for (const size_t channel : { 0, 1 })
+         {
+            std::vector<int16_t> samples(len);
+            SampleFileRange::Decode(
+               { Encoding::Int16, false, 0, 4 },
+               bytes16.data() + misalignment + 2 * channel,
+               reinterpret_cast<samplePtr>(samples.data()), int16Sample, len);
+            REQUIRE(samples == (channel == 0 ? left : right));
+
+            std::vector<float> floats(len);
+            SampleFileRange::Decode(
+               { Encoding::Float32, false, 0, 8 },
+               bytes32.data() + misalignment + 4 * channel,
+               reinterpret_cast<samplePtr>(floats.data()), floatSample, len);
+            REQUIRE(floats == (channel == 0 ? leftFloats : rightFloats));
+         }
+      }
+   }
+}
@@ -45,6 +45,7 @@
 
 #include "ExportOptionsEditor.h"
 #include "ExportOptionsUIServices.h"
+#include "ExportPipeline.h"
 #include "ExportPluginHelpers.h"
 #include "ExportPluginRegistry.h"
 
@@ -425,7 +426,7 @@ class CLExportProcessor : public ExportProcessor
       unsigned channels;
       wxString cmd;
       bool showOutput;
-      std::unique_ptr<Mixer> mixer;
+      std::unique_ptr<ExportPipeline> mixer;
       wxString output;
       std::unique_ptr<ExportCLProcess> process;
    } context;
@@ -629,7 +630,7 @@ bool CLExportProcessor::Initialize(AudacityProject& project,
 
    // Mix 'em up
    const auto &tracks = TrackList::Get( project );
-   context.mixer = ExportPluginHelpers::CreateMixer(
+   context.mixer = ExportPluginHelpers::CreatePipeline(
                             tracks,
                             selectionOnly,
                             t0,
@@ -40,6 +40,7 @@ function.
 #include "SelectFile.h"
 #include "ShuttleGui.h"
 
+#include "ExportPipeline.h"
 #include "ExportPluginHelpers.h"
 #include "PlainExportOptionsEditor.h"
 #include "FFmpegDefines.h"
@@ -669,7 +670,7 @@ class FFmpegExportProcessor final : public ExportProcessor
       TranslatableString status;
       double t0;
       double t1;
-      std::unique_ptr<Mixer> mixer;
+      std::unique_ptr<ExportPipeline> mixer;
       std::unique_ptr<FFmpegExporter> exporter;
    } context;
 
@@ -1639,9 +1640,8 @@ bool FFmpegExportProcessor::Initialize(AudacityProject& project,
       throw ExportErrorException("FFmpeg:1008");
    }
 
-   context.mixer = context.exporter->CreateMixer(tracks, selectionOnly,
-      t0, t1,
-      mixerSpec);
+   context.mixer = std::make_unique<ExportPipeline>(
+      context.exporter->CreateMixer(tracks, selectionOnly, t0, t1, mixerSpec));
 
    context.status = selectionOnly
          ? XO("Exporting selected audio as %s")
@@ -23,6 +23,8 @@ Licensed under the GNU General Public License v2 or later
 #include "FFmpeg.h"
 #include "FFmpegFunctions.h"
 
+#include <thread>
+
 #include <wx/log.h>
 #include <wx/window.h>
 
@@ -146,6 +148,7 @@ static const auto exts = {
 #include "ImportPlugin.h"
 #include "ImportUtils.h"
 #include "ImportProgressListener.h"
+#include "ImportStreamDecoders.h"
 
 class FFmpegImportFileHandle;
 
@@ -187,6 +190,16 @@ struct StreamContext final
    bool Use { true };
 };
 
+//! Samples that a packet of a stream decodes to, interleaved
+struct DecodedPacket final
+{
+   //! Filled when the stream imports as int16Sample
+   std::vector<int16_t> Int16Samples;
+   //! Filled otherwise
+   std::vector<float> FloatSamples;
+   int Channels { 0 };
+};
+
 ///! Does actual import, returned by FFmpegImportPlugin::Open
 class FFmpegImportFileHandle final : public ImportFileHandle
 {
@@ -221,6 +234,28 @@ public:
    ///\param sc - stream context
    void WriteData(StreamContext* sc, const AVPacketWrapper* packet);
 
+   ///! Decodes a packet of a stream, which may be done on a thread of the
+   /// stream's own
+   ///\param sc - stream context
+   DecodedPacket DecodePacket(StreamContext& sc, const AVPacketWrapper* packet);
+
+   ///! Appends decoded samples to the track of the stream
+   ///\param sc - stream context
+   ///\param stream - the track made for sc
+   void AppendData(
+      const StreamContext& sc, WaveTrack& stream, const DecodedPacket& decoded);
+
+   ///! Updates mProgressPos and mProgressLen from a packet of a stream
+   ///\param useFrameNumber - whether the codec context may be read, which is
+   /// not so while another thread decodes
+   void UpdateProgress(
+      const StreamContext& sc, const AVPacketWrapper& packet,
+      bool useFrameNumber);
+
+   ///! Demuxes and appends on this thread while each stream decodes on its
+   /// own
+   void DecodeStreams(ImportProgressListener& progressListener);
+
    ///! Writes extracted metadata to tags object
    ///\param avf - file context
    ///\ tags - Audacity tags object
@@ -383,6 +418,11 @@ bool FFmpegImportFileHandle::InitCodecs()
 
          auto codecContextPtr = stream->GetAVCodecContext();
 
+         // Let the decoder use its own threads, if it has any
+         codecContextPtr->SetThreadCount(0);
+         codecContextPtr->SetThreadType(
+            AUDACITY_FF_THREAD_FRAME | AUDACITY_FF_THREAD_SLICE);
+
          if ( codecContextPtr->Open( codecContextPtr->GetCodec() ) < 0 )
          {
             wxLogError(wxT("FFmpeg : Open() failed. Index[%02d], Codec[%02x - %s]"),i,id,name);
@@ -500,34 +540,39 @@ void FFmpegImportFileHandle::Import(
 
    // This is the heart of the importing process
 
-   // Read frames.
-   for (std::unique_ptr<AVPacketWrapper> packet;
-        (packet = mAVFormatContext->ReadNextPacket()) != nullptr &&
-        !mCancelled && !mStopped;)
+   if (!mStreamContexts.empty() && std::thread::hardware_concurrency() > 1)
+      DecodeStreams(progressListener);
+   else
    {
-      // Find a matching StreamContext
-      auto streamContextIt = std::find_if(
-         mStreamContexts.begin(), mStreamContexts.end(),
-         [index = packet->GetStreamIndex()](const StreamContext& ctx)
-         { return ctx.StreamIndex == index;
-      });
-
-      if (streamContextIt == mStreamContexts.end())
-         continue;
+      // Read frames.
+      for (std::unique_ptr<AVPacketWrapper> packet;
+           (packet = mAVFormatContext->ReadNextPacket()) != nullptr &&
+           !mCancelled && !mStopped;)
+      {
+         // Find a matching StreamContext
+         auto streamContextIt = std::find_if(
+            mStreamContexts.begin(), mStreamContexts.end(),
+            [index = packet->GetStreamIndex()](const StreamContext& ctx)
+            { return ctx.StreamIndex == index;
+         });
+
+         if (streamContextIt == mStreamContexts.end())
+            continue;
 
-      WriteData(&(*streamContextIt), packet.get());
-      if(mProgressLen > 0)
-         progressListener.OnImportProgress(static_cast<double>(mProgressPos) /
-                                           static_cast<double>(mProgressLen));
-   }
+         WriteData(&(*streamContextIt), packet.get());
+         if(mProgressLen > 0)
+            progressListener.OnImportProgress(static_cast<double>(mProgressPos) /
+                                              static_cast<double>(mProgressLen));
+      }
 
-   // Flush the decoders.
-   if (!mStreamContexts.empty() && !mCancelled)
-   {
-      auto emptyPacket = mFFmpeg->CreateAVPacketWrapper();
+      // Flush the decoders.
+      if (!mStreamContexts.empty() && !mCancelled)
+      {
+         auto emptyPacket = mFFmpeg->CreateAVPacketWrapper();
 
-      for (StreamContext& sc : mStreamContexts)
-         WriteData(&sc, emptyPacket.get());
+         for (StreamContext& sc : mStreamContexts)
+            WriteData(&sc, emptyPacket.get());
+      }
    }
 
    if(mCancelled)
@@ -563,6 +608,60 @@ void FFmpegImportFileHandle::Stop()
       mStopped = true;
 }
 
+void FFmpegImportFileHandle::DecodeStreams(
+   ImportProgressListener& progressListener)
+{
+   using Packet = std::unique_ptr<AVPacketWrapper>;
+   ImportStreamDecoders<Packet, DecodedPacket> decoders {
+      mStreamContexts.size(),
+      [this](size_t s, Packet packet) {
+         return DecodePacket(mStreamContexts[s], packet.get());
+      },
+      [this](size_t s, DecodedPacket decoded) {
+         AppendData(mStreamContexts[s], *mStreams[s], decoded);
+      }
+   };
+
+   // Read frames, and pass each to the thread of its stream
+   for (std::unique_ptr<AVPacketWrapper> packet;
+        (packet = mAVFormatContext->ReadNextPacket()) != nullptr &&
+        !mCancelled && !mStopped;)
+   {
+      auto streamContextIt = std::find_if(
+         mStreamContexts.begin(), mStreamContexts.end(),
+         [index = packet->GetStreamIndex()](const StreamContext& ctx)
+         { return ctx.StreamIndex == index;
+      });
+
+      if (streamContextIt == mStreamContexts.end())
+         continue;
+
+      UpdateProgress(*streamContextIt, *packet, false);
+
+      // Older libraries may reuse the data of a packet that does not count
+      // references at the next read, so hold a reference of our own
+      if (packet->GetBuf() == nullptr)
+         packet = packet->Clone();
+
+      decoders.Push(
+         std::distance(mStreamContexts.begin(), streamContextIt),
+         std::move(packet));
+
+      if(mProgressLen > 0)
+         progressListener.OnImportProgress(static_cast<double>(mProgressPos) /
+                                           static_cast<double>(mProgressLen));
+   }
+
+   if (mCancelled)
+      // The destructor of the decoders discards what was not yet appended
+      return;
+
+   // Flush the decoders, and append all they decoded
+   for (size_t s = 0; s < mStreamContexts.size(); ++s)
+      decoders.Push(s, mFFmpeg->CreateAVPacketWrapper());
+   decoders.Finish();
+}
+
 void FFmpegImportFileHandle::WriteData(StreamContext *sc, const AVPacketWrapper* packet)
 {
    // Find the stream in mStreamContexts array
@@ -580,65 +679,73 @@ void FFmpegImportFileHandle::WriteData(StreamContext *sc, const AVPacketWrapper*
    }
    auto stream = mStreams[std::distance(mStreamContexts.begin(), streamIt)];
 
-   const auto nChannels = std::min(sc->CodecContext->GetChannels(), sc->InitialChannels);
+   AppendData(*sc, *stream, DecodePacket(*sc, packet));
+   UpdateProgress(*sc, *packet, true);
+}
+
+DecodedPacket FFmpegImportFileHandle::DecodePacket(
+   StreamContext& sc, const AVPacketWrapper* packet)
+{
+   DecodedPacket result;
+   if (sc.SampleFormat == int16Sample)
+      result.Int16Samples = sc.CodecContext->DecodeAudioPacketInt16(packet);
+   else if (sc.SampleFormat == floatSample)
+      result.FloatSamples = sc.CodecContext->DecodeAudioPacketFloat(packet);
+   // The decoder may change its count of channels with any packet
+   result.Channels = sc.CodecContext->GetChannels();
+   return result;
+}
+
+void FFmpegImportFileHandle::AppendData(
+   const StreamContext& sc, WaveTrack& stream, const DecodedPacket& decoded)
+{
+   const auto channelsCount = decoded.Channels;
+   if (channelsCount <= 0)
+      return;
+   const auto nChannels = std::min(channelsCount, sc.InitialChannels);
 
    // Write audio into WaveTracks
-   if (sc->SampleFormat == int16Sample)
-   {
-      auto data = sc->CodecContext->DecodeAudioPacketInt16(packet);
-      const auto channelsCount = sc->CodecContext->GetChannels();
+   const auto append = [&](const auto& data) {
       const auto samplesPerChannel = data.size() / channelsCount;
 
-      unsigned chn = 0;
-      ImportUtils::ForEachChannel(*stream, [&](auto& channel)
+      auto chn = 0;
+      ImportUtils::ForEachChannel(stream, [&](auto& channel)
       {
          if(chn >= nChannels)
             return;
 
          channel.AppendBuffer(
-            reinterpret_cast<samplePtr>(data.data() + chn),
-            sc->SampleFormat,
+            reinterpret_cast<constSamplePtr>(data.data() + chn),
+            sc.SampleFormat,
             samplesPerChannel,
-            sc->CodecContext->GetChannels(),
-            sc->SampleFormat
+            channelsCount,
+            sc.SampleFormat
          );
          ++chn;
       });
-   }
-   else if (sc->SampleFormat == floatSample)
-   {
-      auto data = sc->CodecContext->DecodeAudioPacketFloat(packet);
-      const auto channelsCount = sc->CodecContext->GetChannels();
-      const auto samplesPerChannel = data.size() / channelsCount;
+   };
 
-      auto channelIndex = 0;
-      ImportUtils::ForEachChannel(*stream, [&](auto& channel)
-      {
-         if(channelIndex >= nChannels)
-            return;
+   if (sc.SampleFormat == int16Sample)
+      append(decoded.Int16Samples);
+   else if (sc.SampleFormat == floatSample)
+      append(decoded.FloatSamples);
+}
 
-         channel.AppendBuffer(
-            reinterpret_cast<samplePtr>(data.data() + channelIndex),
-            sc->SampleFormat,
-            samplesPerChannel,
-            sc->CodecContext->GetChannels(),
-            sc->SampleFormat
-         );
-         ++channelIndex;
-      });
-   }
-   const AVStreamWrapper* avStream = mAVFormatContext->GetStream(sc->StreamIndex);
+void FFmpegImportFileHandle::UpdateProgress(
+   const StreamContext& sc, const AVPacketWrapper& packet, bool useFrameNumber)
+{
+   const AVStreamWrapper* avStream = mAVFormatContext->GetStream(sc.StreamIndex);
 
    int64_t filesize = mFFmpeg->avio_size(mAVFormatContext->GetAVIOContext()->GetWrappedValue());
    // PTS (presentation time) is the proper way of getting current position
    if (
-      packet->GetPresentationTimestamp() != AUDACITY_AV_NOPTS_VALUE &&
+      packet.GetPresentationTimestamp() != AUDACITY_AV_NOPTS_VALUE &&
       mAVFormatContext->GetDuration() != AUDACITY_AV_NOPTS_VALUE)
    {
       auto timeBase = avStream->GetTimeBase();
 
       mProgressPos =
-         packet->GetPresentationTimestamp() * timeBase.num / timeBase.den;
+         packet.GetPresentationTimestamp() * timeBase.num / timeBase.den;
 
       mProgressLen =
          (mAVFormatContext->GetDuration() > 0 ?
@@ -647,17 +754,18 @@ void FFmpegImportFileHandle::WriteData(StreamContext *sc, const AVPacketWrapper*
    }
    // When PTS is not set, use number of frames and number of current frame
    else if (
-      avStream->GetFramesCount() > 0 && sc->CodecContext->GetFrameNumber() > 0 &&
-      sc->CodecContext->GetFrameNumber() <= avStream->GetFramesCount())
+      useFrameNumber &&
+      avStream->GetFramesCount() > 0 && sc.CodecContext->GetFrameNumber() > 0 &&
+      sc.CodecContext->GetFrameNumber() <= avStream->GetFramesCount())
    {
-      mProgressPos = sc->CodecContext->GetFrameNumber();
+      mProgressPos = sc.CodecContext->GetFrameNumber();
       mProgressLen = avStream->GetFramesCount();
    }
    // When number of frames is unknown, use position in file
    else if (
-      filesize > 0 && packet->GetPos() > 0 && packet->GetPos() <= filesize)
+      filesize > 0 && packet.GetPos() > 0 && packet.GetPos() <= filesize)
    {
-      mProgressPos = packet->GetPos();
+      mProgressPos = packet.GetPos();
       mProgressLen = filesize;
    }
 }
@@ -83,6 +83,9 @@
 
 #define AUDACITY_AV_CODEC_CAP_SMALL_LAST_FRAME    (1 <<  6)
 
+#define AUDACITY_FF_THREAD_FRAME 1
+#define AUDACITY_FF_THREAD_SLICE 2
+
 
 //#define FF_LAMBDA_SHIFT 7
 //#define FF_LAMBDA_SCALE (1 << FF_LAMBDA_SHIFT)
@@ -21,8 +21,12 @@ Joshua Haberman
 #include <wx/ffile.h>
 #include <wx/log.h>
 
+#include <cstring>
+#include <limits>
+
 #include "FLAC++/encoder.h"
 
+#include "crypto/MD5.h"
 #include "float_cast.h"
 #include "Mix.h"
 #include "Prefs.h"
@@ -32,8 +36,11 @@ Joshua Haberman
 
 #include "wxFileNameWrapper.h"
 
+#include "ExportChunkQueue.h"
+#include "ExportPipeline.h"
 #include "ExportPluginHelpers.h"
 #include "ExportPluginRegistry.h"
+#include "FLACFrames.h"
 #include "PlainExportOptionsEditor.h"
 
 //----------------------------------------------------------------------------
@@ -172,6 +179,175 @@ using FLAC__StreamMetadataHandle = std::unique_ptr<
    FLAC__StreamMetadata, FLAC__StreamMetadataDeleter
 >;
 
+namespace
+{
+// Seconds between seek points, as for the flac command line
+constexpr unsigned SeekPointSpacing = 10;
+
+struct EncoderSettings
+{
+   unsigned numChannels;
+   unsigned sampleRate;
+   unsigned bitsPerSample;
+   long level;
+};
+
+// Everything but the metadata and output, so that encoders of chunks make
+// the same stream as the one that writes the file
+bool ConfigureEncoder(FLAC::Encoder::Stream &encoder,
+   const EncoderSettings &settings)
+{
+   const auto &level = flacLevels[settings.level];
+   bool success =
+      encoder.set_channels(settings.numChannels) &&
+      encoder.set_sample_rate(settings.sampleRate) &&
+      encoder.set_bits_per_sample(settings.bitsPerSample) &&
+      encoder.set_do_exhaustive_model_search(level.do_exhaustive_model_search) &&
+      encoder.set_do_escape_coding(level.do_escape_coding);
+
+   if (settings.numChannels != 2) {
+      success = success &&
+      encoder.set_do_mid_side_stereo(false) &&
+      encoder.set_loose_mid_side_stereo(false);
+   }
+   else {
+      success = success &&
+      encoder.set_do_mid_side_stereo(level.do_mid_side_stereo) &&
+      encoder.set_loose_mid_side_stereo(level.loose_mid_side_stereo);
+   }
+
+   return success &&
+   encoder.set_qlp_coeff_precision(level.qlp_coeff_precision) &&
+   encoder.set_min_residual_partition_order(level.min_residual_partition_order) &&
+   encoder.set_max_residual_partition_order(level.max_residual_partition_order) &&
+   encoder.set_rice_parameter_search_dist(level.rice_parameter_search_dist) &&
+   encoder.set_max_lpc_order(level.max_lpc_order);
+}
+
+#ifndef LEGACY_FLAC
+
+// Long exports are cut into chunks of about this many samples per channel,
+// each a whole number of frames, and the chunks are encoded on several
+// threads.  FLAC frames do not depend on each other, so the chunks are joined
+// by numbering their frames again.
+constexpr size_t ChunkSamples = 1 << 18;
+static_assert(ChunkSamples <= ExportChunkBudget::MaxChunkSamples);
+// Exports shorter than this many chunks are encoded on one thread
+constexpr size_t MinChunks = 4;
+
+struct EncodedChunk
+{
+   size_t samples;
+   std::vector<std::vector<FLAC__byte>> frames;
+};
+
+// Keeps the frames of one chunk in memory, numbered from zero
+class ChunkEncoder final : public FLAC::Encoder::Stream
+{
+public:
+   std::vector<std::vector<FLAC__byte>> frames;
+
+protected:
+   ::FLAC__StreamEncoderWriteStatus write_callback(const FLAC__byte buffer[],
+      size_t bytes, uint32_t samples, uint32_t) override
+   {
+      // Metadata come with no samples, and each frame in one call
+      if (samples > 0)
+         frames.emplace_back(buffer, buffer + bytes);
+      return FLAC__STREAM_ENCODER_WRITE_STATUS_OK;
+   }
+};
+
+EncodedChunk EncodeChunk(const EncoderSettings &settings, unsigned blocksize,
+   const std::vector<std::vector<FLAC__int32>> &samples)
+{
+   ChunkEncoder encoder;
+   if (!ConfigureEncoder(encoder, settings) ||
+       !encoder.set_blocksize(blocksize) ||
+       !encoder.set_do_md5(false) ||
+       encoder.init() != FLAC__STREAM_ENCODER_INIT_STATUS_OK)
+      throw ExportErrorException("FLAC:chunk");
+
+   const auto length = samples[0].size();
+   std::vector<const FLAC__int32*> buffers;
+   for (const auto &channel : samples)
+      buffers.push_back(channel.data());
+   if (!encoder.process(buffers.data(), length) || !encoder.finish())
+      throw ExportErrorException("FLAC:chunk");
+
+   return { length, move(encoder.frames) };
+}
+
+void PutBigEndian(FLAC__byte *dst, FLAC__uint64 value, unsigned bytes)
+{
+   while (bytes--) {
+      dst[bytes] = value & 0xFF;
+      value >>= 8;
+   }
+}
+
+// Write into the STREAMINFO and SEEKTABLE that libFLAC left for a stream of
+// no samples what the chunks made of the stream
+bool PatchMetadata(const wxString &path,
+   uint32_t minFrameSize, uint32_t maxFrameSize, FLAC__uint64 totalSamples,
+   const crypto::MD5::Digest &md5,
+   const std::vector<FLAC__StreamMetadata_SeekPoint> &points)
+{
+   wxFFile f;
+   FLAC__byte marker[4];
+   if (!f.Open(path, wxT("r+b")) ||
+       f.Read(marker, 4) != 4 || memcmp(marker, "fLaC", 4) != 0)
+      return false;
+
+   bool last = false;
+   while (!last) {
+      FLAC__byte header[4];
+      if (f.Read(header, 4) != 4)
+         return false;
+      last = header[0] & 0x80;
+      const auto type = header[0] & 0x7F;
+      const size_t length = (header[1] << 16) | (header[2] << 8) | header[3];
+      const auto start = f.Tell();
+      std::vector<FLAC__byte> data(length);
+
+      if (type == FLAC__METADATA_TYPE_STREAMINFO) {
+         if (length != FLAC__STREAM_METADATA_STREAMINFO_LENGTH ||
+             f.Read(data.data(), length) != length)
+            return false;
+         PutBigEndian(&data[4], minFrameSize, 3);
+         PutBigEndian(&data[7], maxFrameSize, 3);
+         // 36 bits, or zero if the count does not fit
+         if (totalSamples >> 36)
+            totalSamples = 0;
+         data[13] = (data[13] & 0xF0) | (totalSamples >> 32);
+         PutBigEndian(&data[14], totalSamples, 4);
+         std::copy(md5.begin(), md5.end(), &data[18]);
+      }
+      else if (type == FLAC__METADATA_TYPE_SEEKTABLE) {
+         if (length != points.size() * FLAC__STREAM_METADATA_SEEKPOINT_LENGTH)
+            return false;
+         auto dst = data.data();
+         for (const auto &point : points) {
+            PutBigEndian(dst, point.sample_number, 8);
+            PutBigEndian(dst + 8, point.stream_offset, 8);
+            PutBigEndian(dst + 16, point.frame_samples, 2);
+            dst += FLAC__STREAM_METADATA_SEEKPOINT_LENGTH;
+         }
+      }
+      else if (!f.Seek(start + length))
+         return false;
+      else
+         continue;
+
+      if (!f.Seek(start) || f.Write(data.data(), length) != length)
+         return false;
+   }
+   return f.Close();
+}
+
+#endif
+}
+
 class FLACExportProcessor final : public ExportProcessor
 {
    struct
@@ -182,9 +358,15 @@ class FLACExportProcessor final : public ExportProcessor
       unsigned numChannels;
       wxFileNameWrapper fName;
       sampleFormat format;
+      EncoderSettings settings;
+      FLAC__StreamMetadataHandle seekTable;
       FLAC::Encoder::File encoder;
       wxFFile f;
-      std::unique_ptr<Mixer> mixer;
+      std::unique_ptr<ExportPipeline> mixer;
+#ifndef LEGACY_FLAC
+      bool chunked{ false };
+      std::vector<FLAC__uint64> seekTargets;
+#endif
    } context;
 
 public:
@@ -201,6 +383,10 @@ public:
 
 private:
 
+#ifndef LEGACY_FLAC
+   ExportResult ProcessChunks(ExportProcessorDelegate& delegate);
+#endif
+
    FLAC__StreamMetadataHandle MakeMetadata(AudacityProject *project, const Tags *tags) const;
 };
 
@@ -310,16 +496,31 @@ bool FLACExportProcessor::Initialize(AudacityProject& project,
    long levelPref = std::stol(ExportPluginHelpers::GetParameterValue<std::string>(parameters, FlacOptionIDLevel));
    auto bitDepthPref = ExportPluginHelpers::GetParameterValue<std::string>(parameters, FlacOptionIDBitDepth);
 
-   
+
    auto& encoder = context.encoder;
 
+   // Duplicate the flac command line compression levels
+   if (levelPref < 0 || levelPref > 8) {
+      levelPref = 5;
+   }
+
+   context.format = bitDepthPref == "24"
+      ? int24Sample
+      : int16Sample; //convert float to 16 bits
+   context.settings = {
+      numChannels, static_cast<unsigned>(lrint(sampleRate)),
+      context.format == int24Sample ? 24u : 16u, levelPref
+   };
+   const auto totalSamples = static_cast<FLAC__uint64>(
+      std::max(0LL, llrint((t1 - t0) * sampleRate)));
+
    bool success = true;
    success = success &&
 #ifdef LEGACY_FLAC
    encoder.set_filename(OSOUTPUT(fName)) &&
 #endif
-   encoder.set_channels(numChannels) &&
-   encoder.set_sample_rate(lrint(sampleRate));
+   ConfigureEncoder(encoder, context.settings) &&
+   encoder.set_total_samples_estimate(totalSamples);
 
    // See note in MakeMetadata() about a bug in libflac++ 1.1.2
    FLAC__StreamMetadataHandle metadata;
@@ -331,49 +532,25 @@ bool FLACExportProcessor::Initialize(AudacityProject& project,
       throw ExportErrorException("FLAC:283");
    }
 
-   if (success && metadata) {
-      // set_metadata expects an array of pointers to metadata and a size.
-      // The size is 1.
-      FLAC__StreamMetadata *p = metadata.get();
-      success = encoder.set_metadata(&p, 1);
+   // libFLAC fills in the seek points as it writes frames, and writes the
+   // table when it finishes, so the table must outlive the encoder
+   auto& seekTable = context.seekTable;
+   if (success && totalSamples > 0) {
+      seekTable.reset(
+         ::FLAC__metadata_object_new(FLAC__METADATA_TYPE_SEEKTABLE));
+      success = seekTable &&
+         ::FLAC__metadata_object_seektable_template_append_spaced_points_by_samples(
+            seekTable.get(), SeekPointSpacing * context.settings.sampleRate,
+            totalSamples) &&
+         ::FLAC__metadata_object_seektable_template_sort(seekTable.get(), true);
    }
 
-   
-   if (bitDepthPref == "24") {
-      context.format = int24Sample;
-      success = success && encoder.set_bits_per_sample(24);
-   } else { //convert float to 16 bits
-      context.format = int16Sample;
-      success = success && encoder.set_bits_per_sample(16);
-   }
-
-
-   // Duplicate the flac command line compression levels
-   if (levelPref < 0 || levelPref > 8) {
-      levelPref = 5;
-   }
-   success = success &&
-   encoder.set_do_exhaustive_model_search(flacLevels[levelPref].do_exhaustive_model_search) &&
-   encoder.set_do_escape_coding(flacLevels[levelPref].do_escape_coding);
-
-   if (numChannels != 2) {
-      success = success &&
-      encoder.set_do_mid_side_stereo(false) &&
-      encoder.set_loose_mid_side_stereo(false);
-   }
-   else {
-      success = success &&
-      encoder.set_do_mid_side_stereo(flacLevels[levelPref].do_mid_side_stereo) &&
-      encoder.set_loose_mid_side_stereo(flacLevels[levelPref].loose_mid_side_stereo);
+   if (success && metadata) {
+      // set_metadata expects an array of pointers to metadata and a size.
+      FLAC__StreamMetadata *p[] = { metadata.get(), seekTable.get() };
+      success = encoder.set_metadata(p, seekTable ? 2 : 1);
    }
 
-   success = success &&
-   encoder.set_qlp_coeff_precision(flacLevels[levelPref].qlp_coeff_precision) &&
-   encoder.set_min_residual_partition_order(flacLevels[levelPref].min_residual_partition_order) &&
-   encoder.set_max_residual_partition_order(flacLevels[levelPref].max_residual_partition_order) &&
-   encoder.set_rice_parameter_search_dist(flacLevels[levelPref].rice_parameter_search_dist) &&
-   encoder.set_max_lpc_order(flacLevels[levelPref].max_lpc_order);
-
    if (!success) {
       // TODO: more precise message
       throw ExportErrorException("FLAC:336");
@@ -402,7 +579,20 @@ bool FLACExportProcessor::Initialize(AudacityProject& project,
 
    metadata.reset();
 
-   context.mixer = ExportPluginHelpers::CreateMixer(tracks, selectionOnly,
+#ifndef LEGACY_FLAC
+   if (seekTable) {
+      const auto &table = seekTable->data.seek_table;
+      for (unsigned ii = 0; ii < table.num_points; ++ii)
+         if (table.points[ii].sample_number !=
+             FLAC__STREAM_METADATA_SEEKPOINT_PLACEHOLDER)
+            context.seekTargets.push_back(table.points[ii].sample_number);
+   }
+   context.chunked =
+      ExportChunkQueue<EncodedChunk>::DefaultConcurrency() > 1 &&
+      totalSamples >= MinChunks * ChunkSamples;
+#endif
+
+   context.mixer = ExportPluginHelpers::CreatePipeline(tracks, selectionOnly,
                             t0, t1,
                             numChannels, SAMPLES_PER_RUN, false,
                             sampleRate, context.format, mixerSpec);
@@ -418,6 +608,11 @@ ExportResult FLACExportProcessor::Process(ExportProcessorDelegate& delegate)
 {
    delegate.SetStatusString(context.status);
 
+#ifndef LEGACY_FLAC
+   if (context.chunked)
+      return ProcessChunks(delegate);
+#endif
+
    auto exportResult = ExportResult::Success;
 
    auto cleanup2 = finally( [&] {
@@ -430,6 +625,7 @@ ExportResult FLACExportProcessor::Process(ExportProcessorDelegate& delegate)
    } );
 
    ArraysOf<FLAC__int32> tmpsmplbuf{ context.numChannels, SAMPLES_PER_RUN, true };
+   std::vector<const FLAC__int32*> buffers(context.numChannels);
 
    while (exportResult == ExportResult::Success) {
       auto samplesThisRun = context.mixer->Process();
@@ -439,19 +635,17 @@ ExportResult FLACExportProcessor::Process(ExportProcessorDelegate& delegate)
       for (size_t i = 0; i < context.numChannels; i++) {
          auto mixed = context.mixer->GetBuffer(i);
          if (context.format == int24Sample) {
-            for (decltype(samplesThisRun) j = 0; j < samplesThisRun; j++) {
-               tmpsmplbuf[i][j] = ((const int *)mixed)[j];
-            }
+            // Already 32 bit samples, which libFLAC reads where they are
+            buffers[i] = reinterpret_cast<const FLAC__int32*>(mixed);
          }
          else {
             for (decltype(samplesThisRun) j = 0; j < samplesThisRun; j++) {
                tmpsmplbuf[i][j] = ((const short *)mixed)[j];
             }
+            buffers[i] = tmpsmplbuf[i].get();
          }
       }
-      if (! context.encoder.process(
-            reinterpret_cast<FLAC__int32**>( tmpsmplbuf.get() ),
-            samplesThisRun) ) {
+      if (! context.encoder.process(buffers.data(), samplesThisRun) ) {
          // TODO: more precise message
          throw ExportDiskFullError(context.fName);
       }
@@ -477,6 +671,141 @@ ExportResult FLACExportProcessor::Process(ExportProcessorDelegate& delegate)
    return exportResult;
 }
 
+#ifndef LEGACY_FLAC
+ExportResult FLACExportProcessor::ProcessChunks(
+   ExportProcessorDelegate& delegate)
+{
+   auto exportResult = ExportResult::Success;
+
+   auto cleanup = finally( [&] {
+      if (exportResult == ExportResult::Cancelled || exportResult == ExportResult::Error) {
+         context.f.Detach(); // libflac closes the file
+         context.encoder.finish();
+      }
+   } );
+
+   const auto &settings = context.settings;
+   const auto numChannels = context.numChannels;
+   const auto blocksize = context.encoder.get_blocksize();
+   const auto chunkSamples =
+      std::max<size_t>(1, ChunkSamples / blocksize) * blocksize;
+   const auto bytesPerSample = settings.bitsPerSample / 8;
+
+   // What the frames written so far make of the metadata
+   const auto &targets = context.seekTargets;
+   size_t nextTarget = 0;
+   std::vector<FLAC__StreamMetadata_SeekPoint> points;
+   uint32_t frameNumber = 0;
+   FLAC__uint64 sampleNumber = 0;
+   FLAC__uint64 offset = 0;
+   auto minFrameSize = std::numeric_limits<uint32_t>::max();
+   uint32_t maxFrameSize = 0;
+
+   // Every frame of a chunk but the last has the full block size
+   const auto write = [&](EncodedChunk chunk) {
+      if (chunk.frames.size() != (chunk.samples + blocksize - 1) / blocksize)
+         throw ExportErrorException("FLAC:chunk");
+      auto remaining = chunk.samples;
+      for (auto &frame : chunk.frames) {
+         const auto frameSamples = std::min<size_t>(remaining, blocksize);
+         remaining -= frameSamples;
+         if (!LibImportExport::RenumberFLACFrame(frame, frameNumber++))
+            throw ExportErrorException("FLAC:chunk");
+         if (context.f.Write(frame.data(), frame.size()) != frame.size())
+            throw ExportDiskFullError(context.fName);
+
+         // As libFLAC does, the frame containing a target sample becomes
+         // its seek point
+         for (; nextTarget < targets.size() &&
+              targets[nextTarget] < sampleNumber + frameSamples; ++nextTarget)
+            if (points.empty() || points.back().sample_number != sampleNumber)
+               points.push_back({ sampleNumber, offset,
+                  static_cast<unsigned>(frameSamples) });
+
+         const auto frameSize = static_cast<uint32_t>(frame.size());
+         minFrameSize = std::min(minFrameSize, frameSize);
+         maxFrameSize = std::max(maxFrameSize, frameSize);
+         offset += frameSize;
+         sampleNumber += frameSamples;
+      }
+   };
+   ExportChunkQueue<EncodedChunk> queue{
+      ExportChunkQueue<EncodedChunk>::DefaultConcurrency(), write };
+
+   std::vector<std::vector<FLAC__int32>> pending(numChannels);
+   const auto submit = [&](size_t length) {
+      std::vector<std::vector<FLAC__int32>> samples;
+      for (auto &channel : pending) {
+         samples.emplace_back(channel.begin(), channel.begin() + length);
+         channel.erase(channel.begin(), channel.begin() + length);
+      }
+      queue.Add([&settings, blocksize, samples = move(samples)]{
+         return EncodeChunk(settings, blocksize, samples);
+      });
+   };
+
+   // The MD5 of the STREAMINFO is of the interleaved little endian samples,
+   // so it is computed here, in order
+   crypto::MD5 md5;
+   std::vector<FLAC__byte> md5Bytes;
+
+   while (exportResult == ExportResult::Success) {
+      auto samplesThisRun = context.mixer->Process();
+      if (samplesThisRun == 0) //stop encoding
+         break;
+
+      for (size_t i = 0; i < numChannels; i++) {
+         auto mixed = context.mixer->GetBuffer(i);
+         auto &channel = pending[i];
+         if (context.format == int24Sample) {
+            const auto samples = reinterpret_cast<const int *>(mixed);
+            channel.insert(channel.end(), samples, samples + samplesThisRun);
+         }
+         else {
+            const auto samples = reinterpret_cast<const short *>(mixed);
+            channel.insert(channel.end(), samples, samples + samplesThisRun);
+         }
+      }
+
+      md5Bytes.resize(samplesThisRun * numChannels * bytesPerSample);
+      auto byte = md5Bytes.data();
+      for (auto j = pending[0].size() - samplesThisRun; j < pending[0].size(); j++)
+         for (const auto &channel : pending)
+            for (unsigned b = 0; b < bytesPerSample; b++)
+               *byte++ = (channel[j] >> (8 * b)) & 0xFF;
+      md5.Update(md5Bytes.data(), md5Bytes.size());
+
+      if (pending[0].size() >= chunkSamples)
+         submit(chunkSamples);
+
+      exportResult = ExportPluginHelpers::UpdateProgress(
+         delegate, *context.mixer, context.t0, context.t1);
+   }
+
+   if (exportResult == ExportResult::Cancelled || exportResult == ExportResult::Error)
+      return exportResult;
+
+   if (!pending[0].empty())
+      submit(pending[0].size());
+   queue.Finish();
+
+   context.f.Detach(); // libflac closes the file
+   // It writes the metadata of a stream with no samples, which are then
+   // corrected
+   if (!context.encoder.finish())
+      return ExportResult::Error;
+
+   points.resize(targets.size(),
+      { FLAC__STREAM_METADATA_SEEKPOINT_PLACEHOLDER, 0, 0 });
+   if (!PatchMetadata(context.fName.GetFullPath(),
+         frameNumber > 0 ? minFrameSize : 0, maxFrameSize, sampleNumber,
+         md5.FinalizeDigest(), points))
+      return ExportResult::Error;
+
+   return exportResult;
+}
+#endif
+
 // LL:  There's a bug in libflac++ 1.1.2 that prevents us from using
 //      FLAC::Metadata::VorbisComment directly.  The set_metadata()
 //      function allocates an array on the stack, but the base library
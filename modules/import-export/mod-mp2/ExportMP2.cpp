@@ -44,6 +44,7 @@
 #include "Tags.h"
 #include "Track.h"
 
+#include "ExportPipeline.h"
 #include "ExportPluginHelpers.h"
 #include "PlainExportOptionsEditor.h"
 
@@ -252,7 +253,7 @@ class MP2ExportProcessor final : public ExportProcessor
       double t0;
       double t1;
       wxFileNameWrapper fName;
-      std::unique_ptr<Mixer> mixer;
+      std::unique_ptr<ExportPipeline> mixer;
       ArrayOf<char> id3buffer;
       int id3len;
       twolame_options* encodeOptions{};
@@ -398,7 +399,7 @@ bool MP2ExportProcessor::Initialize(AudacityProject& project,
       : XO("Exporting the audio at %ld kbps")
            .Format( bitrate );
 
-   context.mixer = ExportPluginHelpers::CreateMixer(tracks, selectionOnly,
+   context.mixer = ExportPluginHelpers::CreatePipeline(tracks, selectionOnly,
          t0, t1,
          stereo ? 2 : 1, pcmBufferSize, true,
          sampleRate, int16Sample, mixerSpec);
@@ -73,6 +73,10 @@
 #include <wx/textctrl.h>
 #include <wx/choice.h>
 
+#include <functional>
+#include <memory>
+#include <vector>
+
 #include <rapidjson/document.h>
 
 #include "FileNames.h"
@@ -94,9 +98,12 @@
 #include <id3tag.h>
 #endif
 
+#include "ExportChunkQueue.h"
 #include "ExportOptionsEditor.h"
+#include "ExportPipeline.h"
 #include "ExportPluginHelpers.h"
 #include "ExportPluginRegistry.h"
+#include "MP3ChunkJoiner.h"
 #include "SelectFile.h"
 #include "ShuttleGui.h"
 #include "ProjectWindows.h"
@@ -749,7 +756,23 @@ public:
 
    bool PutInfoTag(wxFFile & f, wxFileOffset off);
 
+   /* Encoding of chunks of the stream by separate encoders at once, which
+      MP3ChunkJoiner joins.  Must be called AFTER InitializeStream */
+   using ChunkEncoder =
+      std::unique_ptr<lame_global_flags, std::function<void(lame_global_flags *)>>;
+   bool CanEncodeChunks() const;
+   /* Call on the thread that calls InitializeStream.  Only the encoder of
+      the first chunk writes the info tag */
+   ChunkEncoder InitializeChunk(bool first);
+   /* May be called on any thread.  samples are interleaved if stereo.
+      infoTag, if not null, receives the tag for the first chunk */
+   std::vector<unsigned char> EncodeChunk(ChunkEncoder encoder,
+      const std::vector<float> &samples,
+      std::vector<unsigned char> *infoTag) const;
+
 private:
+   int ConfigureEncoder(lame_global_flags *gf, bool reservoir, bool infoTag);
+
    bool mLibIsExternal;
 
 #ifndef DISABLE_DYNAMIC_LOADING_LAME
@@ -767,6 +790,8 @@ private:
    int mBitrate;
    int mQuality;
    //int mRoutine;
+   unsigned mChannels;
+   int mSampleRate;
    
 #ifndef DISABLE_DYNAMIC_LOADING_LAME
    /* function pointers to the symbols we get from the library */
@@ -840,6 +865,8 @@ MP3Exporter::MP3Exporter()
    mBitrate = 128;
    mQuality = QUALITY_2;
    mMode = MODE_CBR;
+   mChannels = 0;
+   mSampleRate = 0;
    //mRoutine = ROUTINE_FAST;
 }
 
@@ -1181,14 +1208,35 @@ int MP3Exporter::InitializeStream(unsigned channels, int sampleRate)
       return -1;
    }
 
-   lame_set_error_protection(mGF, false);
-   lame_set_num_channels(mGF, channels);
-   lame_set_in_samplerate(mGF, sampleRate);
-   lame_set_out_samplerate(mGF, sampleRate);
-   lame_set_disable_reservoir(mGF, false);
+   mChannels = channels;
+   mSampleRate = sampleRate;
+
    // Add the VbrTag for all types.  For ABR/VBR, a Xing tag will be created.
    // For CBR, it will be a Lame Info tag.
-   lame_set_bWriteVbrTag(mGF, true);
+   int rc = ConfigureEncoder(mGF, true, true);
+   if (rc < 0) {
+      return rc;
+   }
+
+#if 0
+   dump_config(mGF);
+#endif
+
+   mInfoTagLen = 0;
+   mEncoding = true;
+
+   return mSamplesPerChunk;
+}
+
+int MP3Exporter::ConfigureEncoder(lame_global_flags *gf,
+   bool reservoir, bool infoTag)
+{
+   lame_set_error_protection(gf, false);
+   lame_set_num_channels(gf, mChannels);
+   lame_set_in_samplerate(gf, mSampleRate);
+   lame_set_out_samplerate(gf, mSampleRate);
+   lame_set_disable_reservoir(gf, !reservoir);
+   lame_set_bWriteVbrTag(gf, infoTag);
 
    // Set the VBR quality or ABR/CBR bitrate
    switch (mMode) {
@@ -1223,48 +1271,36 @@ int MP3Exporter::InitializeStream(unsigned channels, int sampleRate)
             }
          }
          */
-         lame_set_preset(mGF, preset);
+         lame_set_preset(gf, preset);
       }
       break;
 
       case MODE_VBR:
-         lame_set_VBR(mGF, vbr_mtrh );
-         lame_set_VBR_q(mGF, mQuality);
+         lame_set_VBR(gf, vbr_mtrh );
+         lame_set_VBR_q(gf, mQuality);
       break;
 
       case MODE_ABR:
-         lame_set_preset(mGF, mBitrate );
+         lame_set_preset(gf, mBitrate );
       break;
 
       default:
-         lame_set_VBR(mGF, vbr_off);
-         lame_set_brate(mGF, mBitrate);
+         lame_set_VBR(gf, vbr_off);
+         lame_set_brate(gf, mBitrate);
       break;
    }
 
    // Set the channel mode
    MPEG_mode mode;
 
-   if (channels == 1)
+   if (mChannels == 1)
       mode = MONO;
    else
       mode = JOINT_STEREO;
    
-   lame_set_mode(mGF, mode);
-
-   int rc = lame_init_params(mGF);
-   if (rc < 0) {
-      return rc;
-   }
-
-#if 0
-   dump_config(mGF);
-#endif
+   lame_set_mode(gf, mode);
 
-   mInfoTagLen = 0;
-   mEncoding = true;
-
-   return mSamplesPerChunk;
+   return lame_init_params(gf);
 }
 
 int MP3Exporter::GetOutBufferSize()
@@ -1373,6 +1409,66 @@ bool MP3Exporter::PutInfoTag(wxFFile & f, wxFileOffset off)
    return true;
 }
 
+bool MP3Exporter::CanEncodeChunks() const
+{
+   // The bit reservoir lets a frame begin its data in frames before it, and
+   // must be disabled so frames can be cut apart; VBR and ABR would also
+   // allot bits differently to each chunk.  The info tag of the first chunk
+   // is needed to describe the whole stream.
+#if defined(DISABLE_DYNAMIC_LOADING_LAME)
+   return mMode == MODE_CBR;
+#else
+   return mMode == MODE_CBR && lame_get_lametag_frame != NULL;
+#endif
+}
+
+auto MP3Exporter::InitializeChunk(bool first) -> ChunkEncoder
+{
+   ChunkEncoder encoder{ lame_init(), [this](lame_global_flags *gf) {
+      lame_close(gf);
+   } };
+   if (!encoder || ConfigureEncoder(encoder.get(), false, first) < 0)
+      throw ExportException(_("Unable to initialize MP3 stream"));
+   return encoder;
+}
+
+std::vector<unsigned char> MP3Exporter::EncodeChunk(ChunkEncoder encoder,
+   const std::vector<float> &samples,
+   std::vector<unsigned char> *infoTag) const
+{
+   const auto gf = encoder.get();
+   std::vector<unsigned char> result;
+   ArrayOf<unsigned char> buffer{ mOutBufferSize };
+   const auto append = [&](int bytes) {
+      if (bytes < 0)
+         throw ExportException(XO("Error %ld returned from MP3 encoder")
+            .Format( bytes )
+            .Translation());
+      result.insert(result.end(), buffer.get(), buffer.get() + bytes);
+   };
+
+   const size_t length = samples.size() / mChannels;
+   for (size_t start = 0; start < length; start += mSamplesPerChunk) {
+      const auto nSamples =
+         static_cast<int>(std::min<size_t>(mSamplesPerChunk, length - start));
+      const auto input = samples.data() + start * mChannels;
+      append(mChannels > 1
+         ? lame_encode_buffer_interleaved_ieee_float(
+            gf, input, nSamples, buffer.get(), mOutBufferSize)
+         : lame_encode_buffer_ieee_float(
+            gf, input, input, nSamples, buffer.get(), mOutBufferSize));
+   }
+   append(lame_encode_flush(gf, buffer.get(), mOutBufferSize));
+
+   if (infoTag) {
+      // See MAXFRAMESIZE in libmp3lame/VbrTag.c for explanation of 2880.
+      infoTag->resize(2880);
+      infoTag->resize(
+         lame_get_lametag_frame(gf, infoTag->data(), infoTag->size()));
+   }
+   return result;
+}
+
 #if defined(__WXMSW__)
 /* values for Windows */
 
@@ -1590,6 +1686,26 @@ static void dump_config( 	lame_global_flags*	gfp )
 }
 #endif
 
+BoolSetting MP3ParallelEncoding{
+   L"/FileFormats/MP3ParallelEncoding", false };
+
+namespace
+{
+// Chunks are about this many samples per channel, a whole number of frames
+constexpr size_t ChunkSamples = 1 << 18;
+static_assert(ChunkSamples <= ExportChunkBudget::MaxChunkSamples);
+// Exports shorter than this many chunks are encoded on one thread
+constexpr size_t MinChunks = 4;
+
+struct EncodedChunk
+{
+   LibImportExport::MP3ChunkJoiner::Chunk chunk;
+   std::vector<unsigned char> bytes;
+   //! Empty but for the first chunk
+   std::vector<unsigned char> infoTag;
+};
+}
+
 class MP3ExportProcessor final : public ExportProcessor
 {
    struct
@@ -1605,7 +1721,9 @@ class MP3ExportProcessor final : public ExportProcessor
       wxFileOffset infoTagPos;
       size_t bufferSize;
       int inSamples;
-      std::unique_ptr<Mixer> mixer;
+      int rate;
+      bool chunked{ false };
+      std::unique_ptr<ExportPipeline> mixer;
    } context;
 
 public:
@@ -1621,6 +1739,8 @@ public:
 
 private:
 
+   ExportResult ProcessChunks(ExportProcessorDelegate& delegate);
+
    static int AskResample(int bitrate, int rate, int lowrate, int highrate);
    static unsigned long AddTags(ArrayOf<char> &buffer, bool *endOfFile, const Tags *tags);
 #ifdef USE_LIBID3TAG
@@ -1903,6 +2023,12 @@ bool MP3ExportProcessor::Initialize(AudacityProject& project,
       throw ExportException(_("Unable to initialize MP3 stream"));
    }
 
+   context.rate = rate;
+   context.chunked = MP3ParallelEncoding.Read() &&
+      exporter.CanEncodeChunks() &&
+      ExportChunkQueue<EncodedChunk>::DefaultConcurrency() > 1 &&
+      (t1 - t0) * rate >= MinChunks * ChunkSamples;
+
    // Put ID3 tags at beginning of file
    if (metadata == nullptr)
       metadata = &Tags::Get( project );
@@ -1950,7 +2076,7 @@ bool MP3ExportProcessor::Initialize(AudacityProject& project,
             .Format( bitrate );
    }
 
-   context.mixer = ExportPluginHelpers::CreateMixer(tracks, selectionOnly,
+   context.mixer = ExportPluginHelpers::CreatePipeline(tracks, selectionOnly,
          t0, t1,
          channels, context.inSamples, true,
          rate, floatSample, mixerSpec);
@@ -1962,6 +2088,9 @@ ExportResult MP3ExportProcessor::Process(ExportProcessorDelegate& delegate)
 {
    delegate.SetStatusString(context.status);
 
+   if (context.chunked)
+      return ProcessChunks(delegate);
+
    auto& exporter = context.exporter;
    int bytes = 0;
 
@@ -2051,6 +2180,112 @@ ExportResult MP3ExportProcessor::Process(ExportProcessorDelegate& delegate)
    return exportResult;
 }
 
+ExportResult MP3ExportProcessor::ProcessChunks(
+   ExportProcessorDelegate& delegate)
+{
+   using LibImportExport::MP3ChunkJoiner;
+
+   auto& exporter = context.exporter;
+   const auto channels = context.channels;
+   const auto samplesPerFrame = MP3ChunkJoiner::SamplesPerFrame(context.rate);
+   const auto chunkFrames = std::max<size_t>(1, ChunkSamples / samplesPerFrame);
+
+   MP3ChunkJoiner joiner;
+   std::vector<unsigned char> infoTag;
+   const auto write = [&](EncodedChunk encoded) {
+      const auto bytes = joiner.Join(encoded.bytes, encoded.chunk);
+      if (!bytes)
+         throw ExportException(
+            _("The MP3 encoder made frames that could not be joined"));
+      if (bytes->size() > context.outFile.Write(bytes->data(), bytes->size()))
+         throw ExportDiskFullError(context.outFile.GetName());
+      if (!encoded.infoTag.empty())
+         infoTag = move(encoded.infoTag);
+   };
+   ExportChunkQueue<EncodedChunk> queue{
+      ExportChunkQueue<EncodedChunk>::DefaultConcurrency(), write };
+
+   // Interleaved samples from pendingStart on, which the chunks not yet
+   // submitted need, including the overlap before the next
+   std::vector<float> pending;
+   uint64_t pendingStart = 0;
+   uint64_t totalSamples = 0;
+   uint64_t nextFrame = 0;
+   const auto submit = [&](std::optional<size_t> frames) {
+      const auto chunk =
+         MP3ChunkJoiner::PlanChunk(nextFrame, frames, samplesPerFrame);
+      const auto first = pending.begin() +
+         (chunk.inputStart - pendingStart) * channels;
+      const auto last = frames
+         ? pending.begin() + (chunk.inputEnd - pendingStart) * channels
+         : pending.end();
+      std::vector<float> samples(first, last);
+      auto encoder = exporter.InitializeChunk(nextFrame == 0);
+      const bool withTag = nextFrame == 0;
+      queue.Add([&exporter, chunk, withTag, encoder = move(encoder),
+         samples = move(samples)]() mutable {
+            EncodedChunk result{ chunk };
+            result.bytes = exporter.EncodeChunk(move(encoder), samples,
+               withTag ? &result.infoTag : nullptr);
+            return result;
+         });
+
+      if (frames) {
+         nextFrame += *frames;
+         // Keep what the next chunk overlaps
+         const auto start = MP3ChunkJoiner::PlanChunk(
+            nextFrame, {}, samplesPerFrame).inputStart;
+         pending.erase(pending.begin(),
+            pending.begin() + (start - pendingStart) * channels);
+         pendingStart = start;
+      }
+   };
+
+   auto exportResult = ExportResult::Success;
+   while (exportResult == ExportResult::Success) {
+      auto blockLen = context.mixer->Process();
+      if (blockLen == 0)
+         break;
+
+      const auto mixed =
+         reinterpret_cast<const float *>(context.mixer->GetBuffer());
+      pending.insert(pending.end(), mixed, mixed + blockLen * channels);
+      totalSamples += blockLen;
+
+      // Start a chunk once all of its input is mixed
+      while (MP3ChunkJoiner::PlanChunk(
+                nextFrame, chunkFrames, samplesPerFrame).inputEnd <=
+             totalSamples)
+         submit(chunkFrames);
+
+      exportResult = ExportPluginHelpers::UpdateProgress(
+         delegate, *context.mixer, context.t0, context.t1);
+   }
+
+   if (exportResult != ExportResult::Success)
+      return exportResult;
+
+   submit({});
+   queue.Finish();
+
+   // Write ID3 tag if it was supposed to be at the end of the file
+   if (context.id3len > 0 &&
+       context.id3len > context.outFile.Write(context.id3buffer.get(), context.id3len))
+      throw ExportDiskFullError(context.outFile.GetName());
+
+   // The encoder of the first chunk counted only its own frames
+   if (!joiner.FixInfoTag(infoTag, totalSamples))
+      throw ExportException(
+         _("The MP3 encoder made an info tag that could not be updated"));
+   if (!context.outFile.Seek(context.infoTagPos, wxFromStart) ||
+       infoTag.size() > context.outFile.Write(infoTag.data(), infoTag.size()) ||
+       !context.outFile.SeekEnd() ||
+       !context.outFile.Flush() ||
+       !context.outFile.Close())
+      throw ExportDiskFullError(context.outFile.GetName());
+   return exportResult;
+}
+
 int MP3ExportProcessor::AskResample(int bitrate, int rate, int lowrate, int highrate)
 {
    wxDialogWrapper d(nullptr, wxID_ANY, XO("Invalid sample rate"));
@@ -26,9 +26,14 @@ enum MP3RateMode : unsigned {
 #define MP3_EXPORT_BUILT_IN 1
 #endif
 
+class BoolSetting;
 class TranslatableString;
 class wxWindow;
 
+//! When true, long CBR exports are cut into chunks that separate encoders
+//! encode on several threads, without the bit reservoir
+extern BoolSetting MP3ParallelEncoding;
+
 //----------------------------------------------------------------------------
 // Get MP3 library version
 //----------------------------------------------------------------------------
@@ -11,6 +11,7 @@
 
 #include "ExportMP3.h"
 #include "Internat.h"
+#include "Prefs.h"
 #include "ShuttleGui.h"
 #include "prefs/LibraryPrefs.h"
 #include "HelpSystem.h"
@@ -30,6 +31,11 @@ void AddControls( ShuttleGui &S )
          MP3Version->SetValue(GetMP3Version(S.GetParent(), false));
       }
       S.EndTwoColumn();
+      /* i18n-hint: CBR is constant bit rate; the reservoir is what lets
+         an MP3 frame borrow space that the frames before it left over */
+      S.TieCheckBox(XXO("Encode long &constant bit rate exports on several "
+                        "threads (without the bit reservoir)"),
+         MP3ParallelEncoding);
    }
    S.EndStatic();
 }
@@ -12,12 +12,14 @@
 #include <wx/defs.h>
 #include <cstddef>
 #include <cstring>
+#include <vector>
 
 #include "Import.h"
 #include "BasicUI.h"
 #include "ImportPlugin.h"
 #include "ImportUtils.h"
 #include "ImportProgressListener.h"
+#include "MPG123Ranges.h"
 #include "Project.h"
 
 #define DESC XO("MP3 files")
@@ -33,6 +35,7 @@
 
 #include "CodeConversions.h"
 #include "FromChars.h"
+#include "concurrency/ThreadPool.h"
 
 namespace
 {
@@ -93,6 +96,9 @@ wxString GetId3v2Genre(Tags& tags, const char* genre)
    return audacity::ToWXString(genre);
 }
 
+//! Samples per channel that one task decodes when importing in parallel
+constexpr off_t RangeLength = 1 << 20;
+
 class MP3ImportPlugin final : public ImportPlugin
 {
 public:
@@ -144,6 +150,14 @@ public:
 private:
    bool Open();
 
+   bool GetFrameIndex(LibImportExport::MPG123FrameIndex& index) const;
+
+   //! Decode ranges of the file on several threads, and append them in order
+   //! @return false if the import failed or was cancelled, and the result
+   //! was reported
+   bool DecodeRanges(ImportProgressListener& progressListener,
+      const LibImportExport::MPG123FrameIndex& index, off_t length);
+
 private:
    static ptrdiff_t ReadCallback(void* handle, void* buffer, size_t size);
    static off_t SeekCallback(void* handle, off_t offset, int whence);
@@ -280,46 +294,111 @@ void MP3ImportFileHandle::Import(
       return;
    }
 
-   off_t frameIndex { 0 };
-   unsigned char* data { nullptr };
-   size_t dataSize { 0 };
-
-   std::vector<float> conversionBuffer;
+   const off_t length = mpg123_length(mHandle);
+   LibImportExport::MPG123FrameIndex index;
+   if (length > 2 * RangeLength &&
+       audacity::concurrency::ThreadPool::Get().GetThreadCount() > 1 &&
+       GetFrameIndex(index))
+   {
+      if (!DecodeRanges(progressListener, index, length))
+         return;
+   }
+   else
+   {
+      off_t frameIndex { 0 };
+      unsigned char* data { nullptr };
+      size_t dataSize { 0 };
 
-   int ret = MPG123_OK;
+      std::vector<float> conversionBuffer;
 
-   while ((ret = mpg123_decode_frame(mHandle, &frameIndex, &data, &dataSize)) ==
-                 MPG123_OK)
-   {
-      if(framesCount > 0)
-         progressListener.OnImportProgress(static_cast<double>(frameIndex) / static_cast<double>(framesCount));
+      int ret = MPG123_OK;
 
-      if(IsCancelled())
+      while ((ret = mpg123_decode_frame(mHandle, &frameIndex, &data, &dataSize)) ==
+                    MPG123_OK)
       {
-         progressListener.OnImportResult(ImportProgressListener::ImportResult::Cancelled);
-         return;
-      }
-      //VS: doesn't implement Stop behavior...
+         if(framesCount > 0)
+            progressListener.OnImportProgress(static_cast<double>(frameIndex) / static_cast<double>(framesCount));
 
-      constSamplePtr samples = reinterpret_cast<constSamplePtr>(data);
-      const size_t samplesCount = dataSize / sizeof(float) / mNumChannels;
+         if(IsCancelled())
+         {
+            progressListener.OnImportResult(ImportProgressListener::ImportResult::Cancelled);
+            return;
+         }
+         //VS: doesn't implement Stop behavior...
 
-      // libmpg123 picks up the format based on some "internal" precision.
-      // This case is not expected to happen
-      if (mFloat64Output)
-      {
-         conversionBuffer.resize(samplesCount * mNumChannels);
+         constSamplePtr samples = reinterpret_cast<constSamplePtr>(data);
+         const size_t samplesCount = dataSize / sizeof(float) / mNumChannels;
 
-         for (size_t sampleIndex = 0; sampleIndex < conversionBuffer.size();
-              ++sampleIndex)
+         // libmpg123 picks up the format based on some "internal" precision.
+         // This case is not expected to happen
+         if (mFloat64Output)
          {
-            conversionBuffer[sampleIndex] = static_cast<float>(
-               reinterpret_cast<const double*>(data)[sampleIndex]);
+            conversionBuffer.resize(samplesCount * mNumChannels);
+
+            for (size_t sampleIndex = 0; sampleIndex < conversionBuffer.size();
+                 ++sampleIndex)
+            {
+               conversionBuffer[sampleIndex] = static_cast<float>(
+                  reinterpret_cast<const double*>(data)[sampleIndex]);
+            }
+
+            samples = reinterpret_cast<constSamplePtr>(conversionBuffer.data());
          }
+         // Just copy the interleaved data to the channels
+         unsigned chn = 0;
+         ImportUtils::ForEachChannel(*mTrack, [&](auto& channel)
+         {
+            channel.AppendBuffer(
+               samples + sizeof(float) * chn,
+               floatSample, samplesCount,
+               mNumChannels,
+               floatSample);
+            ++chn;
+         });
+      }
 
-         samples = reinterpret_cast<constSamplePtr>(conversionBuffer.data());
+      if (ret != MPG123_DONE)
+      {
+         wxLogError(
+            "Failed to decode MP3 file: %s", mpg123_plain_strerror(ret));
+
+         progressListener.OnImportResult(ImportProgressListener::ImportResult::Error);
+         return;
       }
-      // Just copy the interleaved data to the channels
+   }
+
+   ImportUtils::FinalizeImport(outTracks, *mTrack);
+
+   ReadTags(tags);
+
+   progressListener.OnImportResult(ImportProgressListener::ImportResult::Success);
+}
+
+bool MP3ImportFileHandle::GetFrameIndex(LibImportExport::MPG123FrameIndex& index) const
+{
+   off_t* offsets { nullptr };
+   off_t step { 0 };
+   size_t fill { 0 };
+   if (mpg123_index(mHandle, &offsets, &step, &fill) != MPG123_OK ||
+       fill == 0)
+      return false;
+
+   index.offsets.assign(offsets, offsets + fill);
+   index.step = step;
+   return true;
+}
+
+bool MP3ImportFileHandle::DecodeRanges(
+   ImportProgressListener& progressListener,
+   const LibImportExport::MPG123FrameIndex& index, off_t length)
+{
+   bool cancelled = false;
+   const auto result = LibImportExport::DecodeMPG123Ranges(
+      GetFilename(), index, length, mNumChannels, RangeLength,
+      [&](const std::vector<float>& range, off_t end)
+   {
+      const size_t samplesCount = range.size() / mNumChannels;
+      const auto samples = reinterpret_cast<constSamplePtr>(range.data());
       unsigned chn = 0;
       ImportUtils::ForEachChannel(*mTrack, [&](auto& channel)
       {
@@ -330,22 +409,30 @@ void MP3ImportFileHandle::Import(
             floatSample);
          ++chn;
       });
-   }
 
-   if (ret != MPG123_DONE)
+      progressListener.OnImportProgress(
+         static_cast<double>(end) / static_cast<double>(length));
+
+      cancelled = IsCancelled();
+      return !cancelled;
+   });
+
+   if (result != MPG123_OK)
    {
       wxLogError(
-         "Failed to decode MP3 file: %s", mpg123_plain_strerror(ret));
+         "Failed to decode MP3 file: %s", mpg123_plain_strerror(result));
 
       progressListener.OnImportResult(ImportProgressListener::ImportResult::Error);
-      return;
+      return false;
    }
 
-   ImportUtils::FinalizeImport(outTracks, *mTrack);
-
-   ReadTags(tags);
+   if (cancelled)
+   {
+      progressListener.OnImportResult(ImportProgressListener::ImportResult::Cancelled);
+      return false;
+   }
 
-   progressListener.OnImportResult(ImportProgressListener::ImportResult::Success);
+   return true;
 }
 
 bool MP3ImportFileHandle::SetupOutputFormat()
@@ -19,6 +19,7 @@
 #include <vorbis/vorbisenc.h>
 
 #include "wxFileNameWrapper.h"
+#include "ExportPipeline.h"
 #include "ExportPluginHelpers.h"
 #include "ExportPluginRegistry.h"
 #include "FileIO.h"
@@ -107,7 +108,7 @@ class OGGExportProcessor final : public ExportProcessor
       double t0;
       double t1;
       unsigned numChannels;
-      std::unique_ptr<Mixer> mixer;
+      std::unique_ptr<ExportPipeline> mixer;
       std::unique_ptr<FileIO> outFile;
       wxFileNameWrapper fName;
 
@@ -269,7 +270,7 @@ bool OGGExportProcessor::Initialize(AudacityProject& project,
       }
    }
 
-   context.mixer = ExportPluginHelpers::CreateMixer(tracks, selectionOnly,
+   context.mixer = ExportPluginHelpers::CreatePipeline(tracks, selectionOnly,
          t0, t1,
          numChannels, SAMPLES_PER_RUN, false,
          sampleRate, floatSample, mixerSpec);
@@ -298,9 +299,11 @@ ExportResult OGGExportProcessor::Process(ExportProcessorDelegate& delegate)
          }
          else {
 
+            // libvorbis lends its buffer only for this call, so it can't be
+            // filled ahead of time, as the pipeline fills its own
             for (size_t i = 0; i < context.numChannels; i++) {
                float *temp = (float *)context.mixer->GetBuffer(i);
-               memcpy(vorbis_buffer[i], temp, sizeof(float)*SAMPLES_PER_RUN);
+               memcpy(vorbis_buffer[i], temp, sizeof(float)*samplesThisRun);
             }
 
             // tell the encoder how many samples we have
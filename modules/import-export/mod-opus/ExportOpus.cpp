@@ -27,6 +27,7 @@
 #include "Track.h"
 #include "Tags.h"
 
+#include "ExportPipeline.h"
 #include "ExportPluginHelpers.h"
 #include "ExportOptionsEditor.h"
 #include "ExportPluginRegistry.h"
@@ -346,7 +347,7 @@ class OpusExportProcessor final : public ExportProcessor
       unsigned numChannels {};
       wxFileNameWrapper fName;
       wxFile outFile;
-      std::unique_ptr<Mixer> mixer;
+      std::unique_ptr<ExportPipeline> mixer;
       std::unique_ptr<Tags> metadata;
 
       // Encoder properties
@@ -757,7 +758,7 @@ bool OpusExportProcessor::Initialize(
 
    const auto& tracks = TrackList::Get(project);
 
-   context.mixer = ExportPluginHelpers::CreateMixer(
+   context.mixer = ExportPluginHelpers::CreatePipeline(
       tracks, selectionOnly, t0, t1, numChannels, context.opus.frameSize, true,
       sampleRate, floatSample, mixerSpec);
 
@@ -27,6 +27,7 @@
 #include "Export.h"
 #include "ExportOptionsEditor.h"
 
+#include "ExportPipeline.h"
 #include "ExportPluginHelpers.h"
 #include "ExportPluginRegistry.h"
 
@@ -384,7 +385,7 @@ class PCMExportProcessor final : public ExportProcessor
       int subformat;
       double t0;
       double t1;
-      std::unique_ptr<Mixer> mixer;
+      std::unique_ptr<ExportPipeline> mixer;
       TranslatableString status;
       SF_INFO info;
       sampleFormat format;
@@ -680,7 +681,7 @@ bool PCMExportProcessor::Initialize(AudacityProject& project,
 
       
       wxASSERT(info.channels >= 0);
-      context.mixer = ExportPluginHelpers::CreateMixer(tracks, selectionOnly,
+      context.mixer = ExportPluginHelpers::CreatePipeline(tracks, selectionOnly,
                                t0, t1,
                                info.channels, maxBlockLen, true,
                                sampleRate, context.format, mixerSpec);
@@ -33,14 +33,21 @@
 #error Requires libsndfile 1.0 or higher
 #endif
 
+#include "FileException.h"
 #include "FileFormats.h"
 #include "GetAcidizerTags.h"
 #include "ImportPlugin.h"
 #include "ImportProgressListener.h"
 #include "ImportUtils.h"
+#include "InterleavedPCM.h"
+#include "SampleBlock.h"
+#include "SampleFileRange.h"
+#include "WaveClip.h"
 #include "WaveTrack.h"
 
 #include <algorithm>
+#include <future>
+#include <optional>
 
 #ifdef USE_LIBID3TAG
    #include <id3tag.h>
@@ -98,6 +105,18 @@ public:
    {}
 
 private:
+   //! Append blocks that read the file in place
+   //! @return false, having appended nothing, if the file can't be read
+   bool ImportDeferred(
+      ImportProgressListener& progressListener, WaveTrack &track,
+      const SampleFileRange::Layout &layout);
+
+   //! Copy samples out of large reads of the file, bypassing libsndfile
+   //! @return false, having appended nothing, if the file can't be read
+   bool ImportInterleaved(
+      ImportProgressListener& progressListener, WaveTrack &track,
+      const SampleFileRange::Layout &layout);
+
    SFFile                mFile;
    const SF_INFO         mInfo;
    sampleFormat          mEffectiveFormat;
@@ -271,6 +290,122 @@ auto PCMImportFileHandle::GetFileUncompressedBytes() -> ByteCount
    return mInfo.frames * mInfo.channels * SAMPLE_SIZE(mFormat);
 }
 
+namespace {
+//! Where the samples of one channel begin, at the given frame
+SampleFileRange::Layout ChannelLayout(
+   const SampleFileRange::Layout &layout, sampleCount frame, size_t channel)
+{
+   auto result = layout;
+   result.offset += frame.as_long_long() * layout.stride +
+      channel * SampleFileRange::GetEncodedSize(layout.encoding);
+   return result;
+}
+}
+
+bool PCMImportFileHandle::ImportDeferred(
+   ImportProgressListener& progressListener, WaveTrack &track,
+   const SampleFileRange::Layout &layout)
+{
+   const auto totalFrames = sampleCount{ mInfo.frames };
+
+   // Open the file and check that it holds all of the samples, before
+   // appending anything.  This range also keeps the file open for the others.
+   std::optional<SampleFileRange> whole;
+   try {
+      whole.emplace(GetFilename(),
+         ChannelLayout(layout, 0, mInfo.channels - 1),
+         totalFrames.as_size_t());
+   }
+   catch (const FileException &) {
+      return false;
+   }
+
+   const auto &pFactory = track.GetSampleBlockFactory();
+   const auto maxBlockSize = track.GetMaxBlockSize();
+   std::vector<SampleBlockPtr> blocks(mInfo.channels);
+   sampleCount framesCompleted = 0;
+   while (framesCompleted < totalFrames && !IsCancelled() && !IsStopped()) {
+      const auto block =
+         limitSampleBufferSize(maxBlockSize, totalFrames - framesCompleted);
+      for (size_t c = 0; c < blocks.size(); ++c)
+         blocks[c] = pFactory->CreateDeferred(
+            std::make_shared<const SampleFileRange>(GetFilename(),
+               ChannelLayout(layout, framesCompleted, c), block),
+            mFormat);
+      track.RightmostOrNewClip()->AppendSharedBlocks(blocks, mEffectiveFormat);
+      framesCompleted += block;
+      progressListener.OnImportProgress(
+         framesCompleted.as_double() / totalFrames.as_double());
+   }
+   return true;
+}
+
+bool PCMImportFileHandle::ImportInterleaved(
+   ImportProgressListener& progressListener, WaveTrack &track,
+   const SampleFileRange::Layout &layout)
+{
+   // Two buffers of a block for each channel must fit easily in memory
+   constexpr int MaxChannels = 32;
+   if (mInfo.channels > MaxChannels)
+      return false;
+
+   const auto totalFrames = sampleCount{ mInfo.frames };
+   const auto maxBlockSize = track.GetMaxBlockSize();
+   std::optional<LibImportExport::InterleavedPCMReader> reader;
+   try {
+      reader.emplace(GetFilename(), layout, mInfo.channels,
+         totalFrames.as_long_long(), maxBlockSize);
+   }
+   catch (const FileException &) {
+      return false;
+   }
+
+   // Deinterleave the next block on another thread while the blocks of this
+   // one are written, which must happen on this thread
+   std::vector<SampleBuffer> buffers, nextBuffers;
+   for (int c = 0; c < mInfo.channels; ++c) {
+      buffers.emplace_back(maxBlockSize, mFormat);
+      nextBuffers.emplace_back(maxBlockSize, mFormat);
+   }
+   const auto read = [&](std::vector<SampleBuffer> &dest,
+      sampleCount start, size_t len)
+   {
+      reader->Read(dest, mFormat, start.as_long_long(), len);
+   };
+
+   sampleCount framesCompleted = 0;
+   auto block = limitSampleBufferSize(maxBlockSize, totalFrames);
+   read(buffers, 0, block);
+   while (block > 0) {
+      const auto nextStart = framesCompleted + block;
+      const auto nextBlock =
+         limitSampleBufferSize(maxBlockSize, totalFrames - nextStart);
+      // The destructor of the future waits, even if appending throws
+      std::future<void> pending;
+      if (nextBlock > 0)
+         pending = std::async(std::launch::async,
+            read, std::ref(nextBuffers), nextStart, nextBlock);
+
+      size_t c = 0;
+      ImportUtils::ForEachChannel(track, [&](auto& channel)
+      {
+         channel.AppendBuffer(
+            buffers[c++].ptr(), mFormat, block, 1, mEffectiveFormat);
+      });
+      framesCompleted = nextStart;
+      progressListener.OnImportProgress(
+         framesCompleted.as_double() / totalFrames.as_double());
+
+      if (pending.valid())
+         pending.get();
+      if (IsCancelled() || IsStopped())
+         break;
+      std::swap(buffers, nextBuffers);
+      block = nextBlock;
+   }
+   return true;
+}
+
 #ifdef USE_LIBID3TAG
 struct id3_tag_deleter {
    void operator () (id3_tag *p) const { if (p) id3_tag_delete(p); }
@@ -299,7 +434,17 @@ void PCMImportFileHandle::Import(
       (sampleCount)mInfo.frames; // convert from sf_count_t
    auto maxBlockSize = track->GetMaxBlockSize();
 
-   {
+   const auto layout = mInfo.channels >= 1 && mInfo.frames >= 1
+      ? LibImportExport::FindPCMSamples(GetFilename(), mInfo)
+      : std::nullopt;
+   if (layout && DeferPCMImport.Read() &&
+       ImportDeferred(progressListener, *track, *layout)) {
+      // The blocks read the file in place until the project copies them
+   }
+   else if (layout && ImportInterleaved(progressListener, *track, *layout)) {
+      // Samples were copied without the staging buffer of libsndfile
+   }
+   else {
       // Otherwise, we're in the "copy" mode, where we read in the actual
       // samples from the file and store our own local copy of the
       // samples in the tracks.
@@ -25,9 +25,12 @@
 #include "Track.h"
 #include "Tags.h"
 
+#include "ExportChunkQueue.h"
+#include "ExportPipeline.h"
 #include "ExportPluginHelpers.h"
 #include "ExportOptionsEditor.h"
 #include "ExportPluginRegistry.h"
+#include "WavPackBlocks.h"
 
 namespace
 {
@@ -241,6 +244,63 @@ struct WriteId final
    std::unique_ptr<wxFile> file;
 };
 
+namespace
+{
+// Long exports are cut into chunks of this many samples per channel, which
+// are packed on several threads.  Each chunk is packed by its own context,
+// which numbers its samples from zero, so its blocks are then moved to where
+// the chunk starts in the file.
+constexpr size_t ChunkSamples = 1 << 20;
+static_assert(ChunkSamples <= ExportChunkBudget::MaxChunkSamples);
+// Exports shorter than this many chunks are packed on one thread
+constexpr size_t MinChunks = 4;
+
+struct PackedChunk
+{
+   size_t samples;
+   std::vector<unsigned char> wv, wvc;
+};
+
+int WriteToMemory(void *id, void *data, int32_t length)
+{
+   auto &bytes = *static_cast<std::vector<unsigned char>*>(id);
+   const auto begin = static_cast<const unsigned char*>(data);
+   bytes.insert(bytes.end(), begin, begin + length);
+   return true;
+}
+
+PackedChunk PackChunk(WavpackConfig config, bool correction,
+   std::vector<int32_t> samples)
+{
+   PackedChunk result;
+   result.samples = samples.size() / config.num_channels;
+   const auto wpc = WavpackOpenFileOutput(
+      WriteToMemory, &result.wv, correction ? &result.wvc : nullptr);
+   auto cleanup = finally([&]{ WavpackCloseFile(wpc); });
+   if (!WavpackSetConfiguration64(wpc, &config, -1, nullptr) ||
+       !WavpackPackInit(wpc) ||
+       !WavpackPackSamples(wpc, samples.data(), result.samples) ||
+       !WavpackFlushSamples(wpc))
+      throw ExportErrorException(WavpackGetErrorMessage(wpc));
+   return result;
+}
+
+void WidenSamples(constSamplePtr mixed, sampleFormat format, size_t count,
+   int32_t *dst)
+{
+   if (format == int16Sample) {
+      const auto samples = reinterpret_cast<const int16_t*>(mixed);
+      for (size_t ii = 0; ii < count; ii++)
+         dst[ii] = (static_cast<int32_t>(samples[ii]) * 65536) >> 16;
+   }
+   else {
+      // Float samples go to WavPack as their bits
+      const auto samples = reinterpret_cast<const int*>(mixed);
+      std::copy(samples, samples + count, dst);
+   }
+}
+}
+
 class WavPackExportProcessor final : public ExportProcessor
 {
    // Samples to write per run
@@ -256,7 +316,10 @@ class WavPackExportProcessor final : public ExportProcessor
       sampleFormat format;
       WriteId outWvFile, outWvcFile;
       WavpackContext *wpc{};
-      std::unique_ptr<Mixer> mixer;
+      WavpackConfig config{};
+      bool chunked{ false };
+      int64_t samplesWritten{ 0 };
+      std::unique_ptr<ExportPipeline> mixer;
       std::unique_ptr<Tags> metadata;
    } context;
 public:
@@ -274,6 +337,8 @@ public:
    ExportResult Process(ExportProcessorDelegate& delegate) override;
 
 private:
+   ExportResult PackChunks(ExportProcessorDelegate& delegate);
+
    static int WriteBlock(void *id, void *data, int32_t length);
 };
 
@@ -474,6 +539,10 @@ bool WavPackExportProcessor::Initialize(AudacityProject& project,
    if (!WavpackSetConfiguration64(context.wpc, &config, -1, nullptr) || !WavpackPackInit(context.wpc)) {
       throw ExportErrorException( WavpackGetErrorMessage(context.wpc) );
    }
+   context.config = config;
+   context.chunked =
+      ExportChunkQueue<PackedChunk>::DefaultConcurrency() > 1 &&
+      (t1 - t0) * sampleRate >= MinChunks * ChunkSamples;
    
    context.status = selectionOnly
       ? XO("Exporting selected audio as WavPack")
@@ -485,7 +554,7 @@ bool WavPackExportProcessor::Initialize(AudacityProject& project,
          : *metadata
       );
 
-   context.mixer = ExportPluginHelpers::CreateMixer(tracks, selectionOnly,
+   context.mixer = ExportPluginHelpers::CreatePipeline(tracks, selectionOnly,
          t0, t1,
          numChannels, SAMPLES_PER_RUN, true,
          sampleRate, context.format, mixerSpec);
@@ -497,12 +566,16 @@ ExportResult WavPackExportProcessor::Process(ExportProcessorDelegate& delegate)
 {
    delegate.SetStatusString(context.status);
 
-   const size_t bufferSize = SAMPLES_PER_RUN * context.numChannels;
-
-   ArrayOf<int32_t> wavpackBuffer{ bufferSize };
-
    auto exportResult = ExportResult::Success;
-   {
+   if (context.chunked) {
+      exportResult = PackChunks(delegate);
+      if (exportResult == ExportResult::Cancelled || exportResult == ExportResult::Error)
+         return exportResult;
+   }
+   else {
+      const size_t bufferSize = SAMPLES_PER_RUN * context.numChannels;
+
+      ArrayOf<int32_t> wavpackBuffer{ bufferSize };
 
       while (exportResult == ExportResult::Success) {
          auto samplesThisRun = context.mixer->Process();
@@ -510,21 +583,8 @@ ExportResult WavPackExportProcessor::Process(ExportProcessorDelegate& delegate)
          if (samplesThisRun == 0)
             break;
          
-         if (context.format == int16Sample) {
-            const int16_t *mixed = reinterpret_cast<const int16_t*>(context.mixer->GetBuffer());
-            for (decltype(samplesThisRun) j = 0; j < samplesThisRun; j++) {
-               for (size_t i = 0; i < context.numChannels; i++) {
-                  wavpackBuffer[j*context.numChannels + i] = (static_cast<int32_t>(*mixed++) * 65536) >> 16;
-               }
-            }
-         } else {
-            const int *mixed = reinterpret_cast<const int*>(context.mixer->GetBuffer());
-            for (decltype(samplesThisRun) j = 0; j < samplesThisRun; j++) {
-               for (size_t i = 0; i < context.numChannels; i++) {
-                  wavpackBuffer[j*context.numChannels + i] = *mixed++;
-               }
-            }
-         }
+         WidenSamples(context.mixer->GetBuffer(), context.format,
+            samplesThisRun * context.numChannels, wavpackBuffer.get());
 
          if (!WavpackPackSamples(context.wpc, wavpackBuffer.get(), samplesThisRun)) {
             throw ExportErrorException(WavpackGetErrorMessage(context.wpc));
@@ -570,7 +630,13 @@ ExportResult WavPackExportProcessor::Process(ExportProcessorDelegate& delegate)
    context.outWvFile.file->Read(firstBlockBuffer.get(), context.outWvFile.firstBlockSize);
 
    // Update the first block written with the actual number of samples written
-   WavpackUpdateNumSamples(context.wpc, firstBlockBuffer.get());
+   if (context.chunked)
+      LibImportExport::UpdateWavPackNumSamples(
+         reinterpret_cast<uint8_t*>(firstBlockBuffer.get()),
+         context.outWvFile.firstBlockSize, context.samplesWritten,
+         context.config.num_channels * context.config.bytes_per_sample);
+   else
+      WavpackUpdateNumSamples(context.wpc, firstBlockBuffer.get());
    context.outWvFile.file->Seek(0);
    context.outWvFile.file->Write(firstBlockBuffer.get(), context.outWvFile.firstBlockSize);
 
@@ -580,6 +646,67 @@ ExportResult WavPackExportProcessor::Process(ExportProcessorDelegate& delegate)
    return exportResult;
 }
 
+ExportResult WavPackExportProcessor::PackChunks(ExportProcessorDelegate& delegate)
+{
+   const auto numChannels = context.numChannels;
+   const bool correction = context.config.flags & CONFIG_CREATE_WVC;
+
+   // Chunks are written in order on this thread, each block in its own call,
+   // as if the main context packed them
+   const auto write = [&](PackedChunk chunk) {
+      const auto firstSample = context.samplesWritten;
+      const auto relocate = [&](const std::vector<unsigned char> &blocks, WriteId &id) {
+         if (!LibImportExport::RelocateWavPackBlocks(
+                blocks, firstSample, firstSample == 0,
+                [&](const std::vector<uint8_t> &block) {
+                   if (!WriteBlock(&id, const_cast<uint8_t*>(block.data()),
+                          block.size()))
+                      throw ExportDiskFullError(context.fName);
+                }))
+            throw ExportErrorException("WavPack:block");
+      };
+      relocate(chunk.wv, context.outWvFile);
+      relocate(chunk.wvc, context.outWvcFile);
+      context.samplesWritten += chunk.samples;
+   };
+   ExportChunkQueue<PackedChunk> queue{
+      ExportChunkQueue<PackedChunk>::DefaultConcurrency(), write };
+
+   std::vector<int32_t> pending;
+   const auto submit = [&]{
+      queue.Add([config = context.config, correction,
+         samples = move(pending)]() mutable {
+         return PackChunk(config, correction, move(samples));
+      });
+      pending.clear();
+   };
+
+   auto exportResult = ExportResult::Success;
+   while (exportResult == ExportResult::Success) {
+      auto samplesThisRun = context.mixer->Process();
+
+      if (samplesThisRun == 0)
+         break;
+
+      const auto size = pending.size();
+      pending.resize(size + samplesThisRun * numChannels);
+      WidenSamples(context.mixer->GetBuffer(), context.format,
+         samplesThisRun * numChannels, pending.data() + size);
+      if (pending.size() >= ChunkSamples * numChannels)
+         submit();
+
+      exportResult = ExportPluginHelpers::UpdateProgress(
+         delegate, *context.mixer, context.t0, context.t1);
+   }
+
+   if (exportResult == ExportResult::Cancelled || exportResult == ExportResult::Error)
+      return exportResult;
+
+   if (!pending.empty())
+      submit();
+   queue.Finish();
+   return exportResult;
+}
 
 // Based on the implementation of write_block in dbry/WavPack
 // src: https://github.com/dbry/WavPack/blob/master/cli/wavpack.c
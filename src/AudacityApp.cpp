@@ -71,12 +71,14 @@ It handles initialization and termination by subclassing wxApp.
 #include "Benchmark.h"
 #include "Clipboard.h"
 #include "CommandLineArgs.h"
+#include "CommandLineRender.h"
 #include "CrashReport.h" // for HAS_CRASH_REPORT
 #include "commands/CommandHandler.h"
 #include "commands/AppCommandEvent.h"
 #include "widgets/ASlider.h"
 #include "Journal.h"
 #include "Languages.h"
+#include "MacroBatch.h"
 #include "MenuCreator.h"
 #include "PathList.h"
 #include "PendingTracks.h"
@@ -158,6 +160,7 @@ It handles initialization and termination by subclassing wxApp.
 
 #include "../images/Audacity-splash.xpm"
 
+#include <optional>
 #include <thread>
 
 #include "ExportPluginRegistry.h"
@@ -862,6 +865,9 @@ int main(int argc, char *argv[])
    CommandLineArgs::argc = argc;
    CommandLineArgs::argv = argv;
 
+   if (CommandLineRender::RunsWithoutDisplay())
+      return CommandLineRender::Run();
+
    if(PluginHost::IsHostProcess())
    {
       sOSXIsGUIApplication = false;
@@ -886,13 +892,20 @@ int main(int argc, char *argv[])
 
    wxDISABLE_DEBUG_SUPPORT();
 
+   if (CommandLineRender::RunsWithoutDisplay())
+      return CommandLineRender::Run();
+
    // Bug #1986 workaround - This doesn't actually reduce the number of 
    // messages, it simply hides them in Release builds. We'll probably
    // never be able to get rid of the messages entirely, but we should
    // look into what's causing them, so allow them to show in Debug
    // builds.
-   freopen("/dev/null", "w", stdout);
-   freopen("/dev/null", "w", stderr);
+   // But a worker for "Apply Macro to Files" answers on standard output, and
+   // rendering from the command line reports errors on standard error.
+   if (!MacroBatch::IsWorker() && !CommandLineRender::IsRequested()) {
+      freopen("/dev/null", "w", stdout);
+      freopen("/dev/null", "w", stderr);
+   }
 
    return wxEntry(argc, argv);
 }
@@ -909,6 +922,9 @@ int main(int argc, char *argv[])
 
    wxDISABLE_DEBUG_SUPPORT();
 
+   if (CommandLineRender::RunsWithoutDisplay())
+      return CommandLineRender::Run();
+
    return wxEntry(argc, argv);
 }
 wxIMPLEMENT_APP_NO_MAIN(AudacityApp);
@@ -927,6 +943,9 @@ extern "C" int WINAPI WinMain(HINSTANCE hInstance,
 
    wxDISABLE_DEBUG_SUPPORT();
 
+   if (CommandLineRender::RunsWithoutDisplay())
+      return CommandLineRender::Run();
+
    return wxEntry(hInstance, hPrevInstance, lpCmdLine, nCmdShow);
 }
 wxIMPLEMENT_APP_NO_MAIN(AudacityApp);
@@ -1424,12 +1443,20 @@ bool AudacityApp::InitPart2()
    SetExitOnFrameDelete(false);
 #endif
 
+   // A worker for "Apply Macro to Files" shares the temp dir and the plug-in
+   // registry with the instance that started it; so may rendering from the
+   // command line share them with a running instance
+   const bool batchWorker = MacroBatch::IsWorker();
+   const bool rendering = CommandLineRender::IsRequested();
+   const bool unattended = batchWorker || rendering;
+
    // Make sure the temp dir isn't locked by another process.
    {
       auto key =
          PreferenceKey(FileNames::Operation::Temp, FileNames::PathType::_None);
       auto temp = gPrefs->Read(key);
-      if (temp.empty() || !CreateSingleInstanceChecker(temp)) {
+      if (temp.empty() ||
+          (!unattended && !CreateSingleInstanceChecker(temp))) {
          FinishPreferences();
          return false;
       }
@@ -1447,6 +1474,7 @@ bool AudacityApp::InitPart2()
    ModuleManager::Get().Initialize();
 
    // Initialize the PluginManager
+   PluginManager::Get().SetReadOnly(unattended);
    PluginManager::Get().Initialize( [](const FilePath &localFileName){
       return std::make_unique<SettingsWX>(
          AudacityFileConfig::Create({}, {}, localFileName)
@@ -1508,34 +1536,38 @@ bool AudacityApp::InitPart2()
       bool bIconized = false;
       GetNextWindowPlacement(&wndRect, &bMaximized, &bIconized);
 
-      wxSplashScreen temporarywindow(
-         logo,
-         wxSPLASH_CENTRE_ON_SCREEN | wxSPLASH_NO_TIMEOUT,
-         0,
-         NULL,
-         wxID_ANY,
-         wndRect.GetTopLeft(),
-         wxDefaultSize,
-         wxSTAY_ON_TOP);
-
-      // Unfortunately with the Windows 10 Creators update, the splash screen 
-      // now appears before setting its position.
-      // On a dual monitor screen it will appear on one screen and then 
-      // possibly jump to the second.
-      // We could fix this by writing our own splash screen and using Hide() 
-      // until the splash scren was correctly positioned, then Show()
-
-      // Possibly move it on to the second screen...
-      temporarywindow.SetPosition( wndRect.GetTopLeft() );
-      // Centered on whichever screen it is on.
-      temporarywindow.Center();
-      temporarywindow.SetTitle(_("Audacity is starting up..."));
-      SetTopWindow(&temporarywindow);
-      temporarywindow.Raise();
-
-      // ANSWER-ME: Why is YieldFor needed at all?
-      //wxEventLoopBase::GetActive()->YieldFor(wxEVT_CATEGORY_UI|wxEVT_CATEGORY_USER_INPUT|wxEVT_CATEGORY_UNKNOWN);
-      wxEventLoopBase::GetActive()->YieldFor(wxEVT_CATEGORY_UI);
+      // Processes that run unattended show no window at all
+      std::optional<wxSplashScreen> temporarywindow;
+      if (!unattended) {
+         temporarywindow.emplace(
+            logo,
+            wxSPLASH_CENTRE_ON_SCREEN | wxSPLASH_NO_TIMEOUT,
+            0,
+            nullptr,
+            wxID_ANY,
+            wndRect.GetTopLeft(),
+            wxDefaultSize,
+            wxSTAY_ON_TOP);
+
+         // Unfortunately with the Windows 10 Creators update, the splash screen 
+         // now appears before setting its position.
+         // On a dual monitor screen it will appear on one screen and then 
+         // possibly jump to the second.
+         // We could fix this by writing our own splash screen and using Hide() 
+         // until the splash scren was correctly positioned, then Show()
+
+         // Possibly move it on to the second screen...
+         temporarywindow->SetPosition( wndRect.GetTopLeft() );
+         // Centered on whichever screen it is on.
+         temporarywindow->Center();
+         temporarywindow->SetTitle(_("Audacity is starting up..."));
+         SetTopWindow(&*temporarywindow);
+         temporarywindow->Raise();
+
+         // ANSWER-ME: Why is YieldFor needed at all?
+         //wxEventLoopBase::GetActive()->YieldFor(wxEVT_CATEGORY_UI|wxEVT_CATEGORY_USER_INPUT|wxEVT_CATEGORY_UNKNOWN);
+         wxEventLoopBase::GetActive()->YieldFor(wxEVT_CATEGORY_UI);
+      }
 
       //JKC: Would like to put module loading here.
 
@@ -1571,12 +1603,13 @@ bool AudacityApp::InitPart2()
       recentFiles.UseMenu(recentMenu);
 
 #endif //__WXMAC__
-      temporarywindow.Show(false);
+      if (temporarywindow)
+         temporarywindow->Show(false);
    }
 
    //Search for the new plugins
    std::vector<wxString> failedPlugins;
-   if(!playingJournal && !SkipEffectsScanAtStartup.Read())
+   if(!playingJournal && !unattended && !SkipEffectsScanAtStartup.Read())
    {
       auto newPlugins = PluginManager::Get().CheckPluginUpdates();
       if(!newPlugins.empty())
@@ -1601,10 +1634,11 @@ bool AudacityApp::InitPart2()
    // Root cause is problem with wxSplashScreen and other dialogs co-existing, that
    // seemed to arrive with wx3.
    {
-      project = ProjectManager::New();
+      project = ProjectManager::New(!unattended);
    }
 
-   if (!playingJournal && ProjectSettings::Get(*project).GetShowSplashScreen())
+   if (!playingJournal && !unattended &&
+       ProjectSettings::Get(*project).GetShowSplashScreen())
    {
       // This may do a check-for-updates at every start up.
       // Mainly this is to tell users of ALPHAS who don't know that they have an ALPHA.
@@ -1622,6 +1656,19 @@ bool AudacityApp::InitPart2()
 
    // Bug1561: delay the recovery dialog, to avoid crashes.
    CallAfter( [=] () mutable {
+      if (batchWorker) {
+         wxString macroName;
+         parser->Found(MacroBatch::WorkerOption, &macroName);
+         MacroBatch::RunWorker(*project, macroName);
+         QuitAudacity(true);
+         return;
+      }
+      if (rendering) {
+         CommandLineRender::RunInWindow(*project, *parser);
+         QuitAudacity(true);
+         return;
+      }
+
       // Remove duplicate shortcuts when there's a change of version
       int vMajorInit, vMinorInit, vMicroInit;
       GetPreferencesVersion(vMajorInit, vMinorInit, vMicroInit);
@@ -1751,6 +1798,8 @@ int AudacityApp::OnRun()
    if (result == 0)
       // If not otherwise abnormal, report any journal sync failure
       result = Journal::GetExitCode();
+   if (result == 0)
+      result = CommandLineRender::GetExitCode();
    return result;
 }
 
@@ -2386,6 +2435,12 @@ std::unique_ptr<wxCmdLineParser> AudacityApp::ParseCommandLine()
                     wxCMD_LINE_VAL_STRING,
                     wxCMD_LINE_PARAM_MULTIPLE | wxCMD_LINE_PARAM_OPTIONAL);
 
+   // Not for users, but for "Apply Macro to Files" to start its workers
+   parser->AddOption(wxEmptyString, MacroBatch::WorkerOption,
+      wxEmptyString, wxCMD_LINE_VAL_STRING, wxCMD_LINE_HIDDEN);
+
+   CommandLineRender::AddOptions(*parser);
+
 #ifdef HAS_CUSTOM_URL_HANDLING
    /* i18n-hint: This option is used to handle custom URLs in Audacity */
    parser->AddOption(wxT("u"), wxT("url"), _("Handle 'audacity://' url"));
@@ -2743,10 +2798,15 @@ static audacity::ApplicationSettings::Scope applicationSettingsScope {
       static std::once_flag configSetupFlag;
       std::call_once(configSetupFlag, [&]{
          const auto configFileName = wxFileName { FileNames::Configuration() };
-         gConfig = AudacityFileConfig::Create(
+         auto config = AudacityFileConfig::Create(
             wxTheApp->GetAppName(), wxEmptyString,
             configFileName.GetFullPath(),
             wxEmptyString, wxCONFIG_USE_LOCAL_FILE);
+         // Workers for "Apply Macro to Files" and command line rendering
+         // may run beside the instance that owns the configuration
+         if (MacroBatch::IsWorker() || CommandLineRender::IsRequested())
+            config->DisableWriting();
+         gConfig = std::move(config);
          wxConfigBase::Set(gConfig.get());
       });
       return std::make_unique<SettingsWX>(gConfig);
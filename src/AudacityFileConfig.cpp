@@ -103,6 +103,13 @@ bool AudacityFileConfig::Flush(bool bCurrentOnly)
       return true;
    }
 
+   if (mWritingDisabled)
+   {
+      // Changes stay in memory only
+      mDirty = false;
+      return true;
+   }
+
    while (true)
    {
       FilePath backup = mLocalFilename + ".bkp";
@@ -140,6 +147,11 @@ bool AudacityFileConfig::Flush(bool bCurrentOnly)
    }
 }
 
+void AudacityFileConfig::DisableWriting()
+{
+   mWritingDisabled = true;
+}
+
 void AudacityFileConfig::Warn() const
 {
    wxDialogWrapper dlg(nullptr, wxID_ANY, XO("Audacity Configuration Error"));
@@ -31,6 +31,10 @@ public:
 
    bool Flush(bool bCurrentOnly) override;
 
+   //! Keep all changes in memory, never writing the file
+   /*! For processes that share the file with another instance, which owns it */
+   void DisableWriting();
+
    ~AudacityFileConfig() override;
 
    bool RenameEntry(const wxString& oldName, const wxString& newName) override;
@@ -62,6 +66,7 @@ private:
 
    //wxFileConfig already has m_isDirty flag, but it's inaccessible
    bool mDirty{false};
+   bool mWritingDisabled{false};
    const wxString mLocalFilename;
 };
 #endif
@@ -33,6 +33,7 @@
 #include <wx/button.h>
 #include <wx/imaglist.h>
 #include <wx/settings.h>
+#include <wx/spinctrl.h>
 
 #include "Clipboard.h"
 #include "ShuttleGui.h"
@@ -58,6 +59,7 @@
 #include "FileDialog/FileDialog.h"
 #include "FileNames.h"
 #include "Import.h"
+#include "MacroBatch.h"
 #include "AudacityMessageBox.h"
 #include "AudacityTextEntryDialog.h"
 #include "HelpSystem.h"
@@ -170,6 +172,10 @@ void ApplyMacroDialog::PopulateOrExchange(ShuttleGui &S)
       // so that name can be set on a standard control
       btn->SetAccessible(safenew WindowAccessible(btn));
 #endif
+      mConcurrentFiles = S
+         .Name(XO("Files to process at once"))
+         .AddSpinCtrl(XXO("&At once:"),
+            MacroBatch::ConcurrentFiles.Read(), 64, 1);
    }
    S.EndHorizontalLay();
 
@@ -337,6 +343,10 @@ void ApplyMacroDialog::OnApplyToFiles(wxCommandEvent & WXUNUSED(event))
 
    wxString name = mMacros->GetItemText(item);
    gPrefs->Write(wxT("/Batch/ActiveMacro"), name);
+   const int nConcurrent = mConcurrentFiles
+      ? mConcurrentFiles->GetValue()
+      : MacroBatch::ConcurrentFiles.Read();
+   MacroBatch::ConcurrentFiles.Write(nConcurrent);
    gPrefs->Flush();
 
    AudacityProject *project = &mProject;
@@ -369,7 +379,7 @@ void ApplyMacroDialog::OnApplyToFiles(wxCommandEvent & WXUNUSED(event))
    }
    Raise();
 
-   wxArrayString files;
+   FilePaths files;
    dlog.GetPaths(files);
 
    files.Sort();
@@ -393,7 +403,8 @@ void ApplyMacroDialog::OnApplyToFiles(wxCommandEvent & WXUNUSED(event))
          fileList = S.Id(CommandsListID)
             .Style(wxSUNKEN_BORDER | wxLC_REPORT | wxLC_HRULES | wxLC_VRULES |
                 wxLC_SINGLE_SEL)
-            .AddListControlReportMode( { XO("File") } );
+            .AddListControlReportMode(
+               { XO("File"), XO("Seconds"), XO("Result") } );
          // AssignImageList takes ownership
          fileList->AssignImageList(imageList.release(), wxIMAGE_LIST_SMALL);
       }
@@ -409,7 +420,7 @@ void ApplyMacroDialog::OnApplyToFiles(wxCommandEvent & WXUNUSED(event))
 
    int i;
    for (i = 0; i < (int)files.size(); i++ ) {
-      fileList->InsertItem(i, files[i], i == 0);
+      fileList->InsertItem(i, files[i], 0);
    }
 
    // Set the column size for the files list.
@@ -453,37 +464,28 @@ void ApplyMacroDialog::OnApplyToFiles(wxCommandEvent & WXUNUSED(event))
       Clipboard::Scope scope;
 
       wxWindowDisabler wd(&activityWin);
-      for (i = 0; i < (int)files.size(); i++) {
-         if (i > 0) {
-            //Clear the arrow in previous item.
-            fileList->SetItemImage(i - 1, 0, 0);
-         }
-         fileList->SetItemImage(i, 1, 1);
-         fileList->EnsureVisible(i);
-
-         auto success = GuardedCall<bool>([&] {
-            ProjectFileManager::Get(*project).Import(files[i]);
-            Viewport::Get(*project).ZoomFitHorizontallyAndShowTrack(nullptr);
-            SelectUtilities::DoSelectAll(*project);
-            if (!mMacroCommands.ApplyMacro(mCatalog))
-               return false;
-
-            if (!activityWin.IsShown() || mAbort)
-               return false;
-
-            return true;
-         });
-
-         // Ensure project is completely reset
-         ProjectManager::Get(*project).ResetProjectToEmpty();
-         // Bug2567:
-         // Must also destroy the clipboard, to be sure sample blocks are
-         // all freed and their ids can be reused safely in the next pass
-         globalClipboard.Clear();
-
-         if (!success)
-            break;
-      }
+      const auto started = [&](size_t iFile) {
+         fileList->SetItemImage(iFile, 1, 1);
+         fileList->EnsureVisible(iFile);
+      };
+      const auto done = [&](size_t iFile, const MacroBatch::Result &result) {
+         fileList->SetItemImage(iFile, 0, 0);
+         fileList->SetItem(iFile, 1,
+            wxString::Format(wxT("%.1f"), result.seconds));
+         fileList->SetItem(iFile, 2,
+            result.success ? _("Done") : result.message);
+         wxLogMessage(wxT("Macro '%s' on '%s': %s, %.3f seconds"),
+            name, result.path,
+            result.success ? wxT("done") : result.message, result.seconds);
+         // Give out no more files after a failure or cancellation
+         return result.success && activityWin.IsShown() && !mAbort;
+      };
+
+      if (nConcurrent > 1)
+         MacroBatch::ApplyInWorkers(name, files, nConcurrent, started, done);
+      else
+         MacroBatch::ApplyToFiles(
+            *project, mMacroCommands, mCatalog, files, started, done);
    }
 
    Show();
@@ -702,6 +704,10 @@ void MacrosWindow::PopulateOrExchange(ShuttleGui & S)
       // so that name can be set on a standard control
       btn->SetAccessible(safenew WindowAccessible(btn));
 #endif
+      mConcurrentFiles = S
+         .Name(XO("Files to process at once"))
+         .AddSpinCtrl(XXO("&At once:"),
+            MacroBatch::ConcurrentFiles.Read(), 64, 1);
       S.AddSpace( 10,10,1 );
       // Bug 2524 OK button does much the same as cancel, so remove it.
       // OnCancel prompts you if there has been a change.
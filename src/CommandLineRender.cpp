@@ -0,0 +1,593 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  CommandLineRender.cpp
+
+**********************************************************************/
+#include "CommandLineRender.h"
+
+#include <algorithm>
+#include <iostream>
+#include <tuple>
+#include <wx/app.h>
+#include <wx/cmdline.h>
+#include <wx/ffile.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+#include <wx/init.h>
+#ifdef __WXMSW__
+#include <wx/msw/wrapwin.h>
+#endif
+
+#include "AudacityException.h"
+#include "AudacityFileConfig.h"
+#include "BasicSettings.h"
+#include "BatchCommands.h"
+#include "CommandLineArgs.h"
+#include "Export.h"
+#include "ExportPlugin.h"
+#include "ExportPluginRegistry.h"
+#include "ExportUtils.h"
+#include "FileException.h"
+#include "FileNames.h"
+#include "Import.h"
+#include "ImportPlugin.h"
+#include "ImportProgressListener.h"
+#include "MemoryX.h"
+#include "ModuleConstants.h"
+#include "ModuleManager.h"
+#include "PluginManager.h"
+#include "Prefs.h"
+#include "Project.h"
+#include "ProjectFileIO.h"
+#include "ProjectFileManager.h"
+#include "ProjectRate.h"
+#include "SampleFormat.h"
+#include "SelectUtilities.h"
+#include "SettingsWX.h"
+#include "Tags.h"
+#include "TempDirectory.h"
+#include "WaveTrack.h"
+#include "WaveTrackUtilities.h"
+
+namespace {
+const auto FormatOption = wxT("format");
+const auto ExportOptionOption = wxT("export-option");
+const auto RateOption = wxT("rate");
+const auto ChannelsOption = wxT("channels");
+const auto MacroOption = wxT("macro");
+
+int sExitCode = 0;
+
+#ifdef __WXMSW__
+//! A WinMain process has no standard error, unless the caller redirected it;
+//! then write to the console of the parent process, if any, else to a log
+void Write(const wxString &text)
+{
+   struct Output {
+      HANDLE handle{ INVALID_HANDLE_VALUE };
+      bool console{ false };
+   };
+   // Decide once, because attaching the console may give standard handles
+   static const Output output = []{
+      if (const auto handle = ::GetStdHandle(STD_ERROR_HANDLE);
+          handle && handle != INVALID_HANDLE_VALUE)
+         return Output{ handle, false };
+      if (::AttachConsole(ATTACH_PARENT_PROCESS))
+         return Output{ ::CreateFileW(L"CONOUT$", GENERIC_WRITE,
+            FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0,
+            nullptr), true };
+      return Output{};
+   }();
+
+   const auto line = text + wxT("\r\n");
+   DWORD written;
+   if (output.console) {
+      if (output.handle != INVALID_HANDLE_VALUE && ::WriteConsoleW(
+            output.handle, line.wc_str(), line.length(), &written, nullptr))
+         return;
+   }
+   else if (output.handle != INVALID_HANDLE_VALUE) {
+      const auto bytes = line.ToUTF8();
+      if (::WriteFile(
+            output.handle, bytes.data(), bytes.length(), &written, nullptr))
+         return;
+   }
+
+   wxFFile log{ CommandLineRender::GetLogPath(), wxT("a") };
+   if (log.IsOpened())
+      log.Write(line, wxConvUTF8);
+}
+#else
+void Write(const wxString &text)
+{
+   std::cerr << text.ToUTF8().data() << std::endl;
+}
+#endif
+
+void Report(const TranslatableString &message)
+{
+   Write(message.Translation());
+}
+
+bool HasOption(const wxString &name)
+{
+   const auto option = wxT("--") + name;
+   for (int ii = 1; ii < CommandLineArgs::argc; ++ii) {
+      const wxString arg = CommandLineArgs::argv[ii];
+      if (arg == option || arg.StartsWith(option + wxT("=")))
+         return true;
+   }
+   return false;
+}
+
+//! Nobody is asked which streams of a file to import, so import all of them
+class ImportListener final : public ImportProgressListener
+{
+public:
+   bool OnImportFileOpened(ImportFileHandle &importFileHandle) override
+   {
+      for (wxInt32 ii = 0; ii < importFileHandle.GetStreamCount(); ++ii)
+         importFileHandle.SetStreamUsage(ii, true);
+      return true;
+   }
+   void OnImportProgress(double) override {}
+   void OnImportResult(ImportResult) override {}
+};
+
+//! Never cancels, and reports nothing
+class ExportDelegate final : public ExportProcessorDelegate
+{
+public:
+   bool IsCancelled() const override { return false; }
+   bool IsStopped() const override { return false; }
+   void SetStatusString(const TranslatableString &) override {}
+   void OnProgress(double) override {}
+};
+
+bool Parse(const wxString &text, bool &value)
+{
+   if (text == wxT("1") || text.IsSameAs(wxT("true"), false))
+      value = true;
+   else if (text == wxT("0") || text.IsSameAs(wxT("false"), false))
+      value = false;
+   else
+      return false;
+   return true;
+}
+
+bool Parse(const wxString &text, int &value)
+{
+   long result;
+   if (!text.ToLong(&result))
+      return false;
+   value = result;
+   return true;
+}
+
+bool Parse(const wxString &text, double &value)
+{
+   return text.ToCDouble(&value);
+}
+
+bool Parse(const wxString &text, std::string &value)
+{
+   value = text.ToUTF8().data();
+   return true;
+}
+
+//! Set one value, written `id=value`, in the editor
+bool SetOption(ExportOptionsEditor &editor, const wxString &assignment)
+{
+   const auto key = assignment.BeforeFirst('=');
+   const auto text = assignment.AfterFirst('=');
+   for (int ii = 0, nn = editor.GetOptionsCount(); ii < nn; ++ii) {
+      ExportOption option;
+      if (!editor.GetOption(ii, option))
+         continue;
+      if (key != wxString::Format(wxT("%d"), option.id) &&
+          key != option.title.MSGID().GET())
+         continue;
+      // The type of the default value is the type of the option
+      auto value = option.defaultValue;
+      return std::visit([&](auto &v){ return Parse(text, v); }, value) &&
+         editor.SetValue(option.id, value);
+   }
+   return false;
+}
+
+//! Split `format:id=value` into the format and `id=value`; the format is
+//! empty if not given
+std::pair<wxString, wxString> SplitFormat(const wxString &option)
+{
+   const auto colon = option.find(':');
+   if (colon == wxString::npos || colon > option.find('='))
+      return { {}, option };
+   return { option.Left(colon), option.Mid(colon + 1) };
+}
+
+bool IsProject(const FilePath &path)
+{
+   return wxFileName{ path }.GetExt().IsSameAs(wxT("aup3"), false);
+}
+
+//! Copy a project file to a new file in the temporary directory, with its
+//! write-ahead log if it has one, as when another instance has it open
+/*! @return the name of the copy, or empty on failure */
+FilePath CopyToTemp(const FilePath &path)
+{
+   const auto copy = TempDirectory::UnsavedProjectFileName();
+   if (!wxCopyFile(path, copy))
+      return {};
+   const auto log = path + wxT("-wal");
+   if (wxFileExists(log) && !wxCopyFile(log, copy + wxT("-wal"))) {
+      wxRemoveFile(copy);
+      return {};
+   }
+   return copy;
+}
+
+//! Import the input, or read it if it is a project, into an empty project
+//! that has no window
+bool Load(
+   AudacityProject &project, const CommandLineRender::Settings &settings)
+{
+   auto &tracks = TrackList::Get(project);
+   if (IsProject(settings.input)) {
+      auto &projectFileIO = ProjectFileIO::Get(project);
+      auto conn = projectFileIO.LoadProject(settings.input, true);
+      if (!conn) {
+         Report(projectFileIO.GetLastError());
+         return false;
+      }
+      conn->Commit();
+      // Never delete sample blocks from the file, when the tracks go away
+      for (auto pTrack : tracks.Any<WaveTrack>())
+         WaveTrackUtilities::CloseLock(*pTrack);
+      return true;
+   }
+
+   TrackHolders newTracks;
+   std::optional<LibFileFormats::AcidizerTags> acidTags;
+   TranslatableString errorMessage;
+   ImportListener listener;
+   if (!Importer::Get().Import(project, settings.input, &listener,
+      &WaveTrackFactory::Get(project), newTracks, &Tags::Get(project),
+      acidTags, errorMessage)) {
+      Report(errorMessage.empty()
+         ? XO("Could not import \"%s\"").Format(settings.input)
+         : errorMessage);
+      return false;
+   }
+
+   double rate = 0;
+   for (auto &pTrack : newTracks) {
+      if (const auto pWave = dynamic_cast<WaveTrack*>(pTrack.get());
+          pWave && rate == 0)
+         rate = pWave->GetRate();
+      tracks.Add(pTrack);
+   }
+   if (rate > 0)
+      ProjectRate::Get(project).SetRate(rate);
+   return true;
+}
+
+//! Export all tracks of the project, to each of the outputs
+/*! With more than one output, the tracks are mixed only once, and the files
+    are encoded at once */
+bool Export(
+   AudacityProject &project, const CommandLineRender::Settings &settings)
+{
+   const auto &tracks = TrackList::Get(project);
+   const auto waveTracks = tracks.Any<const WaveTrack>();
+   if (waveTracks.empty()) {
+      Report(XO("There is no audio to export"));
+      return false;
+   }
+   auto nChannels = settings.channels;
+   if (nChannels <= 0)
+      nChannels = (waveTracks + [](const WaveTrack *pTrack){
+         return pTrack->NChannels() > 1;
+      }).empty() ? 1 : 2;
+   const double rate = settings.rate > 0
+      ? settings.rate : ProjectRate::Get(project).GetRate();
+
+   using Format = std::tuple<const ExportPlugin*, int>;
+   const auto findFormat = [](const wxString &name) -> Format {
+      return ExportPluginRegistry::Get().FindFormat(name);
+   };
+
+   std::vector<ExportTaskBuilder::Target> targets;
+   std::vector<Format> formats;
+   for (const auto &output : settings.outputs) {
+      ExportTaskBuilder::Target target;
+      target.fileName = output;
+      target.fileName.MakeAbsolute();
+      const auto format = settings.format.empty()
+         ? target.fileName.GetExt().Upper() : settings.format;
+      std::tie(target.plugin, target.format) = findFormat(format);
+      if (!target.plugin) {
+         Report(XO("Unknown export format \"%s\"").Format(format));
+         return false;
+      }
+      target.sampleRate = rate;
+      target.numChannels = nChannels;
+      const Format targetFormat{ target.plugin, target.format };
+      if (std::find(formats.begin(), formats.end(), targetFormat) ==
+          formats.end())
+         formats.push_back(targetFormat);
+      targets.push_back(std::move(target));
+   }
+
+   // Ids of options mean different things in different formats, so with
+   // more than one format, each option must name the format it is for
+   struct Option {
+      wxString text;
+      std::optional<Format> format;
+      wxString assignment;
+      bool used{ false };
+   };
+   std::vector<Option> options;
+   for (const auto &text : settings.options) {
+      auto [name, assignment] = SplitFormat(text);
+      std::optional<Format> format;
+      if (!name.empty()) {
+         format = findFormat(name);
+         if (!std::get<0>(*format)) {
+            Report(XO("Unknown export format \"%s\"").Format(name));
+            return false;
+         }
+      }
+      else if (formats.size() > 1) {
+         Report(XO(
+"The export option \"%s\" must name its format, as in flac:%s, when rendering to several formats")
+            .Format(text, text));
+         return false;
+      }
+      options.push_back({ text, format, assignment });
+   }
+
+   for (auto &target : targets) {
+      const auto editor =
+         target.plugin->CreateOptionsEditor(target.format, nullptr);
+      if (!editor)
+         continue;
+      editor->Load(*gPrefs);
+      const Format targetFormat{ target.plugin, target.format };
+      for (auto &option : options)
+         if ((!option.format || *option.format == targetFormat) &&
+             SetOption(*editor, option.assignment))
+            option.used = true;
+      target.parameters = ExportUtils::ParametersFromEditor(*editor);
+   }
+   for (const auto &option : options)
+      if (!option.used) {
+         Report(XO("Invalid export option \"%s\"").Format(option.text));
+         return false;
+      }
+
+   auto result = ExportResult::Error;
+   try {
+      const auto &first = targets.front();
+      ExportTaskBuilder builder;
+      builder
+         .SetParameters(first.parameters)
+         .SetNumChannels(nChannels)
+         .SetSampleRate(rate)
+         .SetPlugin(first.plugin, first.format)
+         .SetFileName(first.fileName)
+         .SetRange(tracks.GetStartTime(), tracks.GetEndTime(), false)
+         .SetTags(&Tags::Get(project));
+      for (auto iter = targets.begin() + 1; iter != targets.end(); ++iter)
+         builder.AddTarget(*iter);
+      auto task = builder.Build(project);
+      auto future = task.get_future();
+      ExportDelegate delegate;
+      task(delegate);
+      result = future.get();
+   }
+   catch (const ExportDiskFullError &e) {
+      Report(FileException::WriteFailureMessage(e.GetFileName()));
+   }
+   catch (const ExportErrorException &e) {
+      Report(e.GetMessage());
+   }
+   catch (const ExportException &e) {
+      Report(Verbatim(e.What()));
+   }
+   catch (const AudacityException &) {
+      Report(XO("Export error"));
+   }
+   return result == ExportResult::Success;
+}
+}
+
+void CommandLineRender::AddOptions(wxCmdLineParser &parser)
+{
+   /*i18n-hint: brief help message for Audacity's command-line options */
+   parser.AddOption(wxEmptyString, RenderOption,
+      _("export the audio or project file to this file, and exit; may be repeated"));
+   /*i18n-hint: brief help message for Audacity's command-line options */
+   parser.AddOption(wxEmptyString, FormatOption,
+      _("export format, if not the extension of the rendered files"));
+   /*i18n-hint: brief help message for Audacity's command-line options;
+     do not translate "id=value" */
+   parser.AddOption(wxEmptyString, ExportOptionOption,
+      _("set an option of the export format, as id=value or format:id=value; may be repeated"));
+   /*i18n-hint: brief help message for Audacity's command-line options */
+   parser.AddOption(wxEmptyString, RateOption,
+      _("sample rate of the rendered file"), wxCMD_LINE_VAL_NUMBER);
+   /*i18n-hint: brief help message for Audacity's command-line options */
+   parser.AddOption(wxEmptyString, ChannelsOption,
+      _("number of channels of the rendered file"), wxCMD_LINE_VAL_NUMBER);
+   /*i18n-hint: brief help message for Audacity's command-line options */
+   parser.AddOption(wxEmptyString, MacroOption,
+      _("name of a macro to apply before rendering"));
+}
+
+auto CommandLineRender::GetSettings(const wxCmdLineParser &parser)
+   -> std::optional<Settings>
+{
+   Settings settings;
+   // Found() gives only the last of repeated options
+   for (const auto &arg : parser.GetArguments())
+      if (arg.GetKind() == wxCMD_LINE_OPTION &&
+          arg.GetLongName() == RenderOption)
+         settings.outputs.push_back(arg.GetStrVal());
+   if (settings.outputs.empty())
+      return {};
+   if (parser.GetParamCount() != 1) {
+      Report(XO("Give exactly one audio or project file to render"));
+      return {};
+   }
+   settings.input = parser.GetParam(0);
+   parser.Found(FormatOption, &settings.format);
+   parser.Found(MacroOption, &settings.macro);
+   parser.Found(RateOption, &settings.rate);
+   parser.Found(ChannelsOption, &settings.channels);
+   for (const auto &arg : parser.GetArguments())
+      if (arg.GetKind() == wxCMD_LINE_OPTION &&
+          arg.GetLongName() == ExportOptionOption)
+         settings.options.push_back(arg.GetStrVal());
+   return settings;
+}
+
+bool CommandLineRender::IsRequested()
+{
+   return HasOption(RenderOption);
+}
+
+bool CommandLineRender::RunsWithoutDisplay()
+{
+   return IsRequested() && !HasOption(MacroOption);
+}
+
+int CommandLineRender::Run()
+{
+   // With no application object, wxWidgets initializes only what a console
+   // program needs
+   wxApp::SetInitializerFunction(nullptr);
+#ifdef __WXMSW__
+   // Parse the wide command line, so that file names need not be ASCII
+   int argc = 0;
+   const auto argv = ::CommandLineToArgvW(::GetCommandLineW(), &argc);
+   if (!argv)
+      return EXIT_FAILURE;
+   auto freeArgv = finally([argv]{ ::LocalFree(argv); });
+#else
+   int argc = CommandLineArgs::argc;
+   const auto argv = const_cast<char **>(CommandLineArgs::argv);
+#endif
+   wxInitializer initializer{ argc, argv };
+   if (!initializer.IsOk())
+      return EXIT_FAILURE;
+   wxTheApp->SetAppName(AppName);
+   wxTheApp->SetVendorName(AppName);
+
+   wxCmdLineParser parser{ argc, argv };
+   AddOptions(parser);
+   parser.AddParam(_("audio or project file name"), wxCMD_LINE_VAL_STRING);
+   if (parser.Parse() != 0)
+      return EXIT_FAILURE;
+   const auto settings = GetSettings(parser);
+   if (!settings)
+      return EXIT_FAILURE;
+
+   // Initialize as AudacityApp does, but without anything that shows
+   if (!ProjectFileIO::InitializeSQL()) {
+      Report(XO("SQLite library failed to initialize."));
+      return EXIT_FAILURE;
+   }
+   FileNames::InitializePathList();
+   InitPreferences(audacity::ApplicationSettings::Call());
+   auto cleanup = finally([]{
+      Importer::Get().Terminate();
+      PluginManager::Get().Terminate();
+      FinishPreferences();
+   });
+   if (TempDirectory::TempDir().empty()) {
+      const auto &temp = TempDirectory::DefaultTempDir();
+      wxFileName::Mkdir(temp, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+      FileNames::UpdateDefaultPath(FileNames::Operation::Temp, temp);
+      TempDirectory::ResetTempDir();
+   }
+   InitDitherers();
+
+   ModuleManager::Get().Initialize();
+   // Another instance may be running, and owns the plug-in registry
+   PluginManager::Get().SetReadOnly(true);
+   PluginManager::Get().Initialize([](const FilePath &localFileName){
+      return std::make_unique<SettingsWX>(
+         AudacityFileConfig::Create({}, {}, localFileName)
+      );
+   });
+   Importer::Get().Initialize();
+   ExportPluginRegistry::Get().Initialize();
+
+   // Attached objects are built on demand, so no window is made
+   const auto project = AudacityProject::Create(false);
+   auto &projectFileIO = ProjectFileIO::Get(*project);
+   if (!projectFileIO.OpenProject()) {
+      Report(projectFileIO.GetLastError());
+      return EXIT_FAILURE;
+   }
+   const bool success =
+      Load(*project, *settings) && Export(*project, *settings);
+   TrackList::Get(*project).Clear();
+   projectFileIO.CloseProject();
+   return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void CommandLineRender::RunInWindow(
+   AudacityProject &project, const wxCmdLineParser &parser)
+{
+   const auto settings = GetSettings(parser);
+   const bool success = settings && GuardedCall<bool>([&] {
+      // The macro edits the project, so open a copy of a project file, lest
+      // the edits or the autosave reach the file of the user
+      auto input = settings->input;
+      const bool isProject = IsProject(input);
+      if (isProject && (input = CopyToTemp(input)).empty()) {
+         Report(XO("Could not copy \"%s\"").Format(settings->input));
+         return false;
+      }
+      if (!ProjectFileManager::OpenFile(
+         [&](bool) -> AudacityProject & { return project; },
+         input, false)) {
+         if (isProject) {
+            wxRemoveFile(input);
+            wxRemoveFile(input + wxT("-wal"));
+         }
+         Report(XO("Could not open \"%s\"").Format(settings->input));
+         return false;
+      }
+      // Closing the project removes the copy
+      if (isProject)
+         ProjectFileIO::Get(project).MarkTemporary();
+      if (!settings->macro.empty()) {
+         SelectUtilities::DoSelectAll(project);
+         MacroCommands commands{ project };
+         commands.ReadMacro(settings->macro);
+         if (!commands.ApplyMacro(MacroCommandsCatalog{ &project })) {
+            Report(XO("Applying the macro \"%s\" failed")
+               .Format(settings->macro));
+            return false;
+         }
+      }
+      return Export(project, *settings);
+   });
+   sExitCode = success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+FilePath CommandLineRender::GetLogPath()
+{
+   return wxFileName{
+      wxFileName::GetTempDir(), wxT("audacity-render.log") }.GetFullPath();
+}
+
+int CommandLineRender::GetExitCode()
+{
+   return sExitCode;
+}
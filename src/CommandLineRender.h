@@ -0,0 +1,107 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  CommandLineRender.h
+
+**********************************************************************/
+#ifndef __AUDACITY_COMMAND_LINE_RENDER__
+#define __AUDACITY_COMMAND_LINE_RENDER__
+
+#include <optional>
+#include <vector>
+#include "Identifier.h"
+
+class AudacityProject;
+class wxCmdLineParser;
+
+//! Loads a project or audio file, optionally applies a macro, exports, and
+//! exits, all directed by the command line
+/*!
+ For example:
+
+    audacity --render=out.flac --format=FLAC --export-option=1=5 in.wav
+
+ The render option may be repeated, to export to several files, in the
+ formats of their extensions, from one mix of the tracks:
+
+    audacity --render=out.flac --render=out.mp3 in.wav
+
+ Then export options must name their formats, because the ids of options
+ mean different things in different formats:
+
+    audacity --render=out.flac --render=out.mp3 --export-option=flac:0=24
+       --export-option=mp3:0=CBR in.wav
+
+ Without a macro, nothing of the graphical user interface is initialized, so
+ no display is needed.  Applying a macro needs the commands of a project
+ window, so then the window is made but not shown.
+
+ An .aup3 project is never changed.  Without a macro it is only read; with
+ one, the macro edits a temporary copy.
+
+ Errors are written to standard error.  On Windows, where the application has
+ no console of its own, they go to standard error only if the caller
+ redirected it, else to the console of the parent process, and if there is
+ none, they are appended to the file at GetLogPath().
+ */
+namespace CommandLineRender {
+
+//! Name of the option that gives the output file, and asks for rendering
+inline const wxString RenderOption = wxT("render");
+
+struct Settings {
+   FilePath input;
+   //! At least one
+   std::vector<FilePath> outputs;
+   //! Export format identifier, as in ExportPluginRegistry::FindFormat(), of
+   //! all outputs; if empty, taken from the extension of each output
+   wxString format;
+   //! Name of a macro to apply first, or empty
+   wxString macro;
+   //! Values for the options of the formats, each written `id=value` or
+   //! `format:id=value`, where `id` is the number or the untranslated title of
+   //! the option; each is set for every output of its format, or of any
+   //! format if none is given, which is allowed only when all outputs have
+   //! one format; each must fit at least one output
+   std::vector<wxString> options;
+   //! If not positive, the project rate
+   long rate{ 0 };
+   //! If not positive, two if any track is stereo, else one
+   long channels{ 0 };
+};
+
+//! Describe the options to a command line parser
+void AddOptions(wxCmdLineParser &parser);
+
+//! @return nothing if the parser did not find the render option
+std::optional<Settings> GetSettings(const wxCmdLineParser &parser);
+
+//! Whether the command line of the process has RenderOption
+/*! Looks before parsing, which may forward file names to another instance
+    @pre CommandLineArgs are assigned */
+bool IsRequested();
+
+//! Whether the command line of the process asks for rendering without a
+//! macro, which Run() can do without a display
+bool RunsWithoutDisplay();
+
+//! Initializes only what rendering needs, renders, and cleans up
+/*! @pre RunsWithoutDisplay()
+    @return the exit code of the process */
+int Run();
+
+//! Open the input in the empty project, apply the macro if any, and export
+/*! The window of the project should not be shown.
+    The result is given to GetExitCode() */
+void RunInWindow(AudacityProject &project, const wxCmdLineParser &parser);
+
+//! Where errors are appended when there is no standard error or console
+FilePath GetLogPath();
+
+//! Nonzero if RunInWindow() failed
+int GetExitCode();
+}
+
+#endif
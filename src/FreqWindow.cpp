@@ -34,6 +34,7 @@ the mouse around.
 #include "FreqWindow.h"
 
 #include <algorithm>
+#include <atomic>
 
 #include <wx/setup.h> // for wxUSE_* macros
 
@@ -197,6 +198,7 @@ FrequencyPlotDialog::FrequencyPlotDialog(wxWindow * parent, wxWindowID id,
    mMouseX = 0;
    mMouseY = 0;
    mRate = 0;
+   mStart = 0;
    mDataLen = 0;
 
    gPrefs->Read(wxT("/FrequencyPlotDialog/DrawGrid"), &mDrawGrid, true);
@@ -583,83 +585,36 @@ bool FrequencyPlotDialog::Show(bool show)
 
 bool FrequencyPlotDialog::GetAudio()
 {
-   mData.reset();
+   mTracks.clear();
    mDataLen = 0;
 
-   int selcount = 0;
-   bool warning = false;
    for (auto track :
       TrackList::Get(*mProject).Selected<const WaveTrack>()
    ) {
       auto &selectedRegion = ViewInfo::Get(*mProject).selectedRegion;
       auto start = track->TimeToLongSamples(selectedRegion.t0());
-      if (selcount == 0) {
+      if (mTracks.empty()) {
          mRate = track->GetRate();
          auto end = track->TimeToLongSamples(selectedRegion.t1());
-         auto dataLen = end - start;
-         // Permit approximately 46.60 minutes of selected samples at
-         // a sampling frequency of 48 kHz (11.65 minutes at 192 kHz).
-         auto maxDataLen = size_t(2) << 26;
-         if (dataLen > maxDataLen) {
-            warning = true;
-            mDataLen = maxDataLen;
-         }
-         else
-            mDataLen = dataLen.as_size_t();
-         mData = Floats{ mDataLen };
+         mStart = start;
+         mDataLen = end - start;
       }
-      const auto nChannels = track->NChannels();
       if (track->GetRate() != mRate) {
          using namespace BasicUI;
          ShowMessageBox(
             XO("To plot the spectrum, all selected tracks must have the same sample rate."),
             MessageBoxOptions {}.Caption(XO("Error")).IconStyle(Icon::Error));
-         mData.reset();
+         mTracks.clear();
          mDataLen = 0;
          return false;
       }
-      Floats buffer1{ mDataLen };
-      Floats buffer2{ mDataLen };
-      float *const buffers[]{ buffer1.get(), buffer2.get() };
-      // Don't allow throw for bad reads
-      if (!track->GetFloats(
-             0, nChannels, buffers, start, mDataLen, false,
-             FillFormat::fillZero, false))
-      {
-         using namespace BasicUI;
-         ShowMessageBox(
-            XO("Audio could not be analyzed. This may be due to a stretched or pitch-shifted clip.\nTry resetting any stretched clips, or mixing and rendering the tracks before analyzing"),
-            MessageBoxOptions {}.Caption(XO("Error")).IconStyle(Icon::Error));
-         mData.reset();
-         mDataLen = 0;
-         return false;
-      }
-      size_t iChannel = 0;
-      if (selcount == 0) {
-         // First channel -- assign into mData
-         for (size_t i = 0; i < mDataLen; i++)
-            mData[i] = buffers[0][i];
-         ++iChannel;
-      }
-      // Later channels -- accumulate
-      for (; iChannel < nChannels; ++iChannel) {
-         const auto buffer = buffers[iChannel];
-         for (size_t i = 0; i < mDataLen; i++)
-            mData[i] += buffer[i];
-      }
-      ++selcount;
+      // Samples are read later, a chunk at a time; a copy keeps them as they
+      // are now
+      mTracks.push_back(
+         std::static_pointer_cast<const WaveTrack>(track->Duplicate()));
    }
 
-   if (selcount == 0)
-      return false;
-
-   if (warning) {
-      auto msg = XO(
-"Too much audio was selected. Only the first %.1f seconds of audio will be analyzed.")
-         .Format(mDataLen / mRate);
-      AudacityMessageBox( msg );
-   }
-   return true;
+   return !mTracks.empty();
 }
 
 void FrequencyPlotDialog::OnSize(wxSizeEvent & WXUNUSED(event))
@@ -695,7 +650,8 @@ void FrequencyPlotDialog::DrawBackground(wxMemoryDC & dc)
 
 void FrequencyPlotDialog::DrawPlot()
 {
-   if (!mData || mDataLen < mWindowSize || mAnalyst->GetProcessedSize() == 0) {
+   if (mTracks.empty() || mDataLen < mWindowSize ||
+       mAnalyst->GetProcessedSize() == 0) {
       wxMemoryDC memDC;
 
       vRuler->ruler.SetUpdater(&LinearUpdater::Instance());
@@ -913,7 +869,7 @@ void FrequencyPlotDialog::PlotPaint(wxPaintEvent & event)
 
    dc.DrawBitmap( *mBitmap, 0, 0, true );
    // Fix for Bug 1226 "Plot Spectrum freezes... if insufficient samples selected"
-   if (!mData || mDataLen < mWindowSize)
+   if (mTracks.empty() || mDataLen < mWindowSize)
       return;
 
    dc.SetFont(mFreqFont);
@@ -1023,7 +979,7 @@ void FrequencyPlotDialog::OnCloseButton(wxCommandEvent & WXUNUSED(event))
    gPrefs->Write(wxT("/FrequencyPlotDialog/FuncChoice"), mFuncChoice->GetSelection());
    gPrefs->Write(wxT("/FrequencyPlotDialog/AxisChoice"), mAxisChoice->GetSelection());
    gPrefs->Flush();
-   mData.reset();
+   mTracks.clear();
    Show(false);
 }
 
@@ -1035,7 +991,7 @@ void FrequencyPlotDialog::SendRecalcEvent()
 
 void FrequencyPlotDialog::Recalc()
 {
-   if (!mData || mDataLen < mWindowSize) {
+   if (mTracks.empty() || mDataLen < mWindowSize) {
       DrawPlot();
       return;
    }
@@ -1045,6 +1001,8 @@ void FrequencyPlotDialog::Recalc()
    int windowFunc = mFuncChoice->GetSelection();
 
    wxWindow *hadFocus = FindFocus();
+   bool calculated = false;
+   std::atomic<bool> readFailed{ false };
    // In wxMac, the skipped window MUST be a top level window.  I'd originally made it
    // just the mProgress window with the idea of preventing user interaction with the
    // controls while the plot was being recalculated.  This doesn't appear to be necessary
@@ -1055,14 +1013,46 @@ void FrequencyPlotDialog::Recalc()
          blocker.emplace(this);
       wxYieldIfNeeded();
 
-      mAnalyst->Calculate(alg, windowFunc, mWindowSize, mRate,
-         mData.get(), mDataLen,
+      // Mix down the channels of all tracks
+      const auto source =
+      [this, &readFailed](float *buffer, sampleCount start, size_t len){
+         std::fill(buffer, buffer + len, 0.0f);
+         Floats buffer1{ len };
+         Floats buffer2{ len };
+         float *const buffers[]{ buffer1.get(), buffer2.get() };
+         for (const auto &pTrack : mTracks) {
+            const auto nChannels = pTrack->NChannels();
+            // Don't allow throw for bad reads
+            if (!pTrack->GetFloats(0, nChannels, buffers, mStart + start, len,
+                  false, FillFormat::fillZero, false)) {
+               readFailed = true;
+               return false;
+            }
+            for (size_t iChannel = 0; iChannel < nChannels; ++iChannel)
+               for (size_t i = 0; i < len; i++)
+                  buffer[i] += buffers[iChannel][i];
+         }
+         return true;
+      };
+      calculated = mAnalyst->Calculate(alg, windowFunc, mWindowSize, mRate,
+         source, mDataLen,
          &mYMin, &mYMax, mProgress);
    }
    if (hadFocus) {
       hadFocus->SetFocus();
    }
 
+   if (!calculated && readFailed) {
+      using namespace BasicUI;
+      ShowMessageBox(
+         XO("Audio could not be analyzed. This may be due to a stretched or pitch-shifted clip.\nTry resetting any stretched clips, or mixing and rendering the tracks before analyzing"),
+         MessageBoxOptions {}.Caption(XO("Error")).IconStyle(Icon::Error));
+      mTracks.clear();
+      mDataLen = 0;
+      DrawPlot();
+      return;
+   }
+
    if (alg == SpectrumAnalyst::Spectrum) {
       if(mYMin < -dBRange)
          mYMin = -dBRange;
@@ -29,6 +29,7 @@ class wxChoice;
 
 class AudacityProject;
 class FrequencyPlotDialog;
+class WaveTrack;
 class FreqGauge;
 class RulerPanel;
 
@@ -137,8 +138,11 @@ private:
 
 
    double mRate;
-   size_t mDataLen;
-   Floats mData;
+   //! Copies of the selected tracks, which share their sample blocks, and
+   //! are mixed down as needed
+   std::vector<std::shared_ptr<const WaveTrack>> mTracks;
+   sampleCount mStart;
+   sampleCount mDataLen;
    size_t mWindowSize;
 
    bool mLogAxis;
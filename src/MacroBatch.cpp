@@ -0,0 +1,310 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  MacroBatch.cpp
+
+**********************************************************************/
+#include "MacroBatch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <wx/process.h>
+#include <wx/stream.h>
+#include <wx/utils.h>
+
+#include "AudacityException.h"
+#include "BasicUI.h"
+#include "BatchCommands.h"
+#include "BatchFileResult.h"
+#include "Clipboard.h"
+#include "CommandLineArgs.h"
+#include "PlatformCompatibility.h"
+#include "ProjectFileManager.h"
+#include "ProjectManager.h"
+#include "SelectUtilities.h"
+#include "Viewport.h"
+
+IntSetting MacroBatch::ConcurrentFiles{ L"/Batch/ConcurrentFiles", 1 };
+IntSetting MacroBatch::FileTimeout{ L"/Batch/FileTimeout", 3600 };
+
+bool MacroBatch::IsWorker()
+{
+   const auto option = wxT("--") + WorkerOption;
+   for (int ii = 1; ii < CommandLineArgs::argc; ++ii) {
+      const wxString arg = CommandLineArgs::argv[ii];
+      if (arg == option || arg.StartsWith(option + wxT("=")))
+         return true;
+   }
+   return false;
+}
+
+auto MacroBatch::ApplyToFile(AudacityProject &project,
+   MacroCommands &commands, const MacroCommandsCatalog &catalog,
+   const FilePath &path) -> Result
+{
+   using namespace std::chrono;
+   const auto begin = steady_clock::now();
+
+   Result result{ path };
+   result.success = GuardedCall<bool>([&] {
+      ProjectFileManager::Get(project).Import(path);
+      Viewport::Get(project).ZoomFitHorizontallyAndShowTrack(nullptr);
+      SelectUtilities::DoSelectAll(project);
+      return commands.ApplyMacro(catalog);
+   });
+   if (!result.success)
+      result.message = _("Applying the macro failed or was cancelled");
+
+   // Ensure project is completely reset
+   ProjectManager::Get(project).ResetProjectToEmpty();
+   // Bug2567:
+   // Must also destroy the clipboard, to be sure sample blocks are
+   // all freed and their ids can be reused safely in the next pass
+   Clipboard::Get().Clear();
+
+   result.seconds =
+      duration_cast<duration<double>>(steady_clock::now() - begin).count();
+   return result;
+}
+
+bool MacroBatch::ApplyToFiles(AudacityProject &project,
+   MacroCommands &commands, const MacroCommandsCatalog &catalog,
+   const FilePaths &files,
+   const FileStarted &started, const FileDone &done)
+{
+   for (size_t ii = 0; ii < files.size(); ++ii) {
+      if (started)
+         started(ii);
+      const auto result = ApplyToFile(project, commands, catalog, files[ii]);
+      if (done && !done(ii, result))
+         return false;
+   }
+   return true;
+}
+
+namespace {
+//! A child process running MacroBatch::RunWorker()
+class Worker final : public wxProcess
+{
+public:
+   Worker() { Redirect(); }
+
+   void OnTerminate(int, int) override { mExited = true; }
+
+   bool Start(const wxString &macroName)
+   {
+      const auto command = wxString::Format(wxT("\"%s\" \"--%s=%s\""),
+         PlatformCompatibility::GetExecutablePath(),
+         MacroBatch::WorkerOption, macroName);
+      // Leading a group lets Kill() reach the processes the worker starts
+      mPid = wxExecute(command,
+         wxEXEC_ASYNC | wxEXEC_HIDE_CONSOLE | wxEXEC_MAKE_GROUP_LEADER, this);
+      return mPid != 0;
+   }
+
+   void Send(size_t iFile, const FilePath &path)
+   {
+      mFile = iFile;
+      mSent = std::chrono::steady_clock::now();
+      const auto utf8 = path.ToUTF8();
+      const auto out = GetOutputStream();
+      out->Write(utf8.data(), utf8.length());
+      out->PutC('\n');
+   }
+
+   //! Whether the file sent last has taken longer than the timeout, if it
+   //! is positive
+   bool TimedOut(std::chrono::seconds timeout) const
+   {
+      return mFile && timeout.count() > 0 &&
+         std::chrono::steady_clock::now() - mSent > timeout;
+   }
+
+   //! Kill the worker and the processes it started; OnTerminate() follows
+   void Kill()
+   {
+      if (!mKilled && !mExited)
+         wxProcess::Kill(static_cast<int>(mPid), wxSIGKILL, wxKILL_CHILDREN);
+      mKilled = true;
+   }
+
+   //! Discards what the worker writes to its standard error, so that it
+   //! never blocks on a full pipe
+   void DrainErrors()
+   {
+      char buffer[256];
+      while (IsErrorAvailable()) {
+         GetErrorStream()->Read(buffer, sizeof(buffer));
+         if (GetErrorStream()->LastRead() == 0)
+            break;
+      }
+   }
+
+   //! Accumulates available output; returns a result, if a line that
+   //! reports one is completed; other lines are discarded
+   std::optional<LibImportExport::BatchFileResult> Receive()
+   {
+      while (IsInputAvailable()) {
+         const auto c = GetInputStream()->GetC();
+         if (GetInputStream()->LastRead() == 0)
+            break;
+         if (c == '\n') {
+            const auto line = wxString::FromUTF8(mPending);
+            mPending.clear();
+            if (auto result = LibImportExport::ParseBatchFileResult(line))
+               return result;
+            continue;
+         }
+         mPending.push_back(c);
+      }
+      return {};
+   }
+
+   //! Whether the process ended, or was killed and will end
+   bool Exited() const { return mExited || mKilled; }
+   //! Whether the process has really ended
+   bool Ended() const { return mExited; }
+
+   //! Index of the file being processed
+   std::optional<size_t> mFile;
+
+private:
+   std::string mPending;
+   std::chrono::steady_clock::time_point mSent;
+   long mPid{ 0 };
+   bool mExited{ false };
+   bool mKilled{ false };
+};
+}
+
+bool MacroBatch::ApplyInWorkers(const wxString &macroName,
+   const FilePaths &files, size_t nWorkers,
+   const FileStarted &started, const FileDone &done)
+{
+   if (files.empty())
+      return true;
+
+   const std::chrono::seconds timeout{ FileTimeout.Read() };
+
+   std::vector<std::unique_ptr<Worker>> workers;
+   const auto startWorker = [&] {
+      auto pWorker = std::make_unique<Worker>();
+      if (!pWorker->Start(macroName))
+         return false;
+      workers.push_back(std::move(pWorker));
+      return true;
+   };
+   nWorkers = std::clamp<size_t>(nWorkers, 1, files.size());
+   for (size_t ii = 0; ii < nWorkers; ++ii)
+      if (!startWorker())
+         break;
+   if (workers.empty())
+      return false;
+
+   size_t next = 0;
+   bool stopped = false;
+   const auto finish = [&](Worker &worker, Result result) {
+      const auto iFile = *worker.mFile;
+      worker.mFile.reset();
+      result.path = files[iFile];
+      if (done && !done(iFile, result))
+         stopped = true;
+   };
+
+   while (true) {
+      bool busy = false;
+      // Workers lost with their files are replaced after this pass
+      size_t lost = 0;
+      for (auto &pWorker : workers) {
+         auto &worker = *pWorker;
+         worker.DrainErrors();
+         if (worker.mFile) {
+            if (const auto received = worker.Receive()) {
+               Result result;
+               result.success = received->success;
+               result.seconds = received->seconds;
+               result.message = received->message;
+               finish(worker, result);
+            }
+            else if (worker.Exited()) {
+               ++lost;
+               Result result;
+               result.message = _("The worker process exited");
+               finish(worker, result);
+            }
+            else if (worker.TimedOut(timeout)) {
+               worker.Kill();
+               ++lost;
+               Result result;
+               result.seconds = timeout.count();
+               result.message = wxString::Format(
+                  _("Processing took longer than %d seconds and was stopped"),
+                  static_cast<int>(timeout.count()));
+               finish(worker, result);
+            }
+         }
+         if (!worker.mFile && !worker.Exited() &&
+             !stopped && next < files.size()) {
+            if (started)
+               started(next);
+            worker.Send(next, files[next]);
+            ++next;
+         }
+         busy = busy || worker.mFile.has_value();
+      }
+      // Files that a lost worker would have taken go to another
+      for (; lost > 0 && !stopped && next < files.size(); --lost) {
+         if (!startWorker())
+            break;
+         busy = true;
+      }
+      if (!busy)
+         break;
+      BasicUI::Yield();
+      wxMilliSleep(10);
+   }
+
+   // End of input lets the workers quit
+   for (auto &pWorker : workers)
+      if (!pWorker->Exited())
+         pWorker->CloseOutput();
+   // The objects must outlive the processes, which notify them
+   for (auto &pWorker : workers)
+      while (!pWorker->Ended()) {
+         pWorker->DrainErrors();
+         BasicUI::Yield();
+         wxMilliSleep(10);
+      }
+
+   // Files are left over if all workers quit early
+   return !stopped && next == files.size();
+}
+
+void MacroBatch::RunWorker(AudacityProject &project, const wxString &macroName)
+{
+   MacroCommands commands{ project };
+   commands.ReadMacro(macroName);
+   const MacroCommandsCatalog catalog{ &project };
+
+   std::string line;
+   while (std::getline(std::cin, line)) {
+      if (!line.empty() && line.back() == '\r')
+         line.pop_back();
+      const auto result =
+         ApplyToFile(project, commands, catalog, wxString::FromUTF8(line));
+      LibImportExport::BatchFileResult reported;
+      reported.success = result.success;
+      reported.seconds = result.seconds;
+      reported.message = result.message;
+      // Begin a line, in case a library printed part of one
+      std::cout << '\n'
+         << LibImportExport::FormatBatchFileResult(reported).ToUTF8().data()
+         << std::endl;
+   }
+}
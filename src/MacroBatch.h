@@ -0,0 +1,99 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  MacroBatch.h
+
+**********************************************************************/
+#ifndef __AUDACITY_MACRO_BATCH__
+#define __AUDACITY_MACRO_BATCH__
+
+#include <functional>
+#include <vector>
+#include "Identifier.h"
+#include "Prefs.h"
+
+class AudacityProject;
+class MacroCommands;
+class MacroCommandsCatalog;
+
+//! Applies a macro to many files, each imported alone into an empty project
+/*!
+ Files may be processed one at a time in a given project, or by several worker
+ processes of this program, each with its own project.  Workers share the
+ preferences and the plug-in registry, which they only read.
+ */
+namespace MacroBatch {
+
+//! How many files "Apply Macro to Files" processes at once
+extern AUDACITY_DLL_API IntSetting ConcurrentFiles;
+
+//! Seconds that a worker may spend on one file, or if not positive, no limit
+extern AUDACITY_DLL_API IntSetting FileTimeout;
+
+//! Name of the command line option that makes this program a worker
+inline const wxString WorkerOption = wxT("batch-worker");
+
+//! Whether the command line of the process has WorkerOption
+/*! Looks before parsing, which may forward file names to another instance
+    @pre CommandLineArgs are assigned */
+AUDACITY_DLL_API bool IsWorker();
+
+struct Result {
+   FilePath path;
+   bool success{ false };
+   //! Time to import the file, apply the macro, and reset the project
+   double seconds{ 0 };
+   //! Explains a failure
+   wxString message;
+};
+
+//! Called on the main thread when processing of a file begins
+using FileStarted = std::function<void(size_t iFile)>;
+//! Called on the main thread when processing of a file ends
+/*! @return false to stop starting more files */
+using FileDone = std::function<bool(size_t iFile, const Result &result)>;
+
+//! Import, apply the macro, and reset the project to empty, for one file
+/*! @pre the project is empty */
+AUDACITY_DLL_API Result ApplyToFile(AudacityProject &project,
+   MacroCommands &commands, const MacroCommandsCatalog &catalog,
+   const FilePath &path);
+
+//! Process files one at a time in the project
+/*!
+ @pre the project is empty
+ @param commands holds the macro already read
+ @return false if stopped by `done`
+ */
+AUDACITY_DLL_API bool ApplyToFiles(AudacityProject &project,
+   MacroCommands &commands, const MacroCommandsCatalog &catalog,
+   const FilePaths &files,
+   const FileStarted &started, const FileDone &done);
+
+//! Process files in up to `nWorkers` worker processes, each given another
+//! file as soon as it finishes one
+/*!
+ Macro semantics are those of ApplyToFile(), in each worker's own project.
+ A worker that takes longer than FileTimeout on a file is killed, and one
+ that exits or is killed fails its file and is replaced by another.
+ Yields to the event loop while waiting.
+ @return false if stopped by `done`, or if workers could not be started or
+ quit before all files were given out
+ */
+AUDACITY_DLL_API bool ApplyInWorkers(const wxString &macroName,
+   const FilePaths &files, size_t nWorkers,
+   const FileStarted &started, const FileDone &done);
+
+//! Main loop of a worker process
+/*!
+ Reads paths of files from standard input, one in each line, until its end,
+ and for each, writes one line with the result to standard output, as
+ LibImportExport::FormatBatchFileResult() makes it
+ */
+AUDACITY_DLL_API void RunWorker(
+   AudacityProject &project, const wxString &macroName);
+}
+
+#endif
@@ -44,7 +44,9 @@ public:
    ~ProjectManager() override;
 
    // This is the factory for projects:
-   static AudacityProject *New();
+   //! @param show false for a project whose window is never shown, as for
+   //! applying a macro from the command line or in a batch worker
+   static AudacityProject *New(bool show = true);
 
    // The function that imports files can act as a factory too, and for that
    // reason remains in this class, not in ProjectFileManager
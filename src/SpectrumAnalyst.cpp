@@ -26,6 +26,10 @@ and in the spectrogram spectral selection.
 #include "FFT.h"
 
 #include "SampleFormat.h"
+#include "concurrency/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <limits>
 #include <wx/dcclient.h>
 
 FreqGauge::FreqGauge(wxWindow * parent, wxWindowID winid)
@@ -88,12 +92,132 @@ SpectrumAnalyst::~SpectrumAnalyst()
 {
 }
 
+namespace {
+//! Approximate number of samples that each job of Calculate reads
+constexpr size_t ChunkSize = 1 << 20;
+
+//! Sums the results of the chosen algorithm over windows of data
+class WindowAccumulator
+{
+public:
+   WindowAccumulator(
+      SpectrumAnalyst::Algorithm alg, const float *win, size_t windowSize)
+      : mAlg{ alg }, mWin{ win }, mWindowSize{ windowSize }
+      , mSums(windowSize / 2)
+      , in{ windowSize }, out{ windowSize }, out2{ windowSize }
+   {}
+
+   void Add(const float *data);
+
+   const SpectrumAnalyst::Algorithm mAlg;
+   const float *const mWin;
+   const size_t mWindowSize;
+   std::vector<float> mSums;
+
+private:
+   Floats in, out, out2;
+};
+
+void WindowAccumulator::Add(const float *data)
+{
+   const auto half = mWindowSize / 2;
+   for (size_t i = 0; i < mWindowSize; i++)
+      in[i] = mWin[i] * data[i];
+
+   switch (mAlg) {
+      case SpectrumAnalyst::Spectrum:
+         PowerSpectrum(mWindowSize, in.get(), out.get());
+
+         for (size_t i = 0; i < half; i++)
+            mSums[i] += out[i];
+         break;
+
+      case SpectrumAnalyst::Autocorrelation:
+      case SpectrumAnalyst::CubeRootAutocorrelation:
+      case SpectrumAnalyst::EnhancedAutocorrelation:
+
+         // Take FFT
+         RealFFT(mWindowSize, in.get(), out.get(), out2.get());
+         // Compute power
+         for (size_t i = 0; i < mWindowSize; i++)
+            in[i] = (out[i] * out[i]) + (out2[i] * out2[i]);
+
+         if (mAlg == SpectrumAnalyst::Autocorrelation) {
+            for (size_t i = 0; i < mWindowSize; i++)
+               in[i] = sqrt(in[i]);
+         }
+         if (mAlg == SpectrumAnalyst::CubeRootAutocorrelation ||
+             mAlg == SpectrumAnalyst::EnhancedAutocorrelation) {
+            // Tolonen and Karjalainen recommend taking the cube root
+            // of the power, instead of the square root
+
+            for (size_t i = 0; i < mWindowSize; i++)
+               in[i] = pow(in[i], 1.0f / 3.0f);
+         }
+         // Take FFT
+         RealFFT(mWindowSize, in.get(), out.get(), out2.get());
+
+         // Take real part of result
+         for (size_t i = 0; i < half; i++)
+            mSums[i] += out[i];
+         break;
+
+      case SpectrumAnalyst::Cepstrum:
+         RealFFT(mWindowSize, in.get(), out.get(), out2.get());
+
+         // Compute log power
+         // Set a sane lower limit assuming maximum time amplitude of 1.0
+         {
+            float power;
+            float minpower = 1e-20*mWindowSize*mWindowSize;
+            for (size_t i = 0; i < mWindowSize; i++)
+            {
+               power = (out[i] * out[i]) + (out2[i] * out2[i]);
+               if(power < minpower)
+                  in[i] = log(minpower);
+               else
+                  in[i] = log(power);
+            }
+            // Take IFFT
+            InverseRealFFT(mWindowSize, in.get(), NULL, out.get());
+
+            // Take real part of result
+            for (size_t i = 0; i < half; i++)
+               mSums[i] += out[i];
+         }
+
+         break;
+
+      default:
+         wxASSERT(false);
+         break;
+   }                         //switch
+}
+}
+
 bool SpectrumAnalyst::Calculate(Algorithm alg, int windowFunc,
                                 size_t windowSize, double rate,
                                 const float *data, size_t dataLen,
                                 float *pYMin, float *pYMax,
                                 FreqGauge *progress)
 {
+   return Calculate(alg, windowFunc, windowSize, rate,
+      [data](float *buffer, sampleCount start, size_t len) {
+         std::copy(data + start.as_size_t(), data + start.as_size_t() + len,
+            buffer);
+         return true;
+      }, dataLen, pYMin, pYMax, progress);
+}
+
+bool SpectrumAnalyst::Calculate(Algorithm alg, int windowFunc,
+                                size_t windowSize, double rate,
+                                const SampleSource &source,
+                                sampleCount dataLen,
+                                float *pYMin, float *pYMax,
+                                FreqGauge *progress)
+{
+   using namespace audacity::concurrency;
+
    // Wipe old data
    mProcessed.resize(0);
    mRate = 0.0;
@@ -121,9 +245,7 @@ bool SpectrumAnalyst::Calculate(Algorithm alg, int windowFunc,
    auto half = mWindowSize / 2;
    mProcessed.resize(mWindowSize);
 
-   Floats in{ mWindowSize };
    Floats out{ mWindowSize };
-   Floats out2{ mWindowSize };
    Floats win{ mWindowSize };
 
    for (size_t i = 0; i < mWindowSize; i++) {
@@ -143,92 +265,64 @@ bool SpectrumAnalyst::Calculate(Algorithm alg, int windowFunc,
    else
       wss = 1.0;
 
+   // Windows overlap by half; divide them among jobs that each read a chunk
+   const auto windows =
+      ((dataLen - windowSize) / half).as_long_long() + 1;
+   const long long windowsPerChunk = std::max<size_t>(1, ChunkSize / half);
+   const auto nChunks = (windows + windowsPerChunk - 1) / windowsPerChunk;
+
+   // The gauge counts in ints; scale it for very long data
+   const auto progressScale = std::max(1.0,
+      dataLen.as_double() / std::numeric_limits<int>::max());
    if (progress) {
-      progress->SetRange(dataLen);
+      progress->SetRange(static_cast<int>(dataLen.as_double() / progressScale));
    }
 
-   size_t start = 0;
-   int windows = 0;
-   while (start + mWindowSize <= dataLen) {
-      for (size_t i = 0; i < mWindowSize; i++)
-         in[i] = win[i] * data[start + i];
-
-      switch (alg) {
-         case Spectrum:
-            PowerSpectrum(mWindowSize, in.get(), out.get());
-
-            for (size_t i = 0; i < half; i++)
-               mProcessed[i] += out[i];
-            break;
-
-         case Autocorrelation:
-         case CubeRootAutocorrelation:
-         case EnhancedAutocorrelation:
-
-            // Take FFT
-            RealFFT(mWindowSize, in.get(), out.get(), out2.get());
-            // Compute power
-            for (size_t i = 0; i < mWindowSize; i++)
-               in[i] = (out[i] * out[i]) + (out2[i] * out2[i]);
-
-            if (alg == Autocorrelation) {
-               for (size_t i = 0; i < mWindowSize; i++)
-                  in[i] = sqrt(in[i]);
-            }
-            if (alg == CubeRootAutocorrelation ||
-                alg == EnhancedAutocorrelation) {
-               // Tolonen and Karjalainen recommend taking the cube root
-               // of the power, instead of the square root
-
-               for (size_t i = 0; i < mWindowSize; i++)
-                  in[i] = pow(in[i], 1.0f / 3.0f);
-            }
-            // Take FFT
-            RealFFT(mWindowSize, in.get(), out.get(), out2.get());
-
-            // Take real part of result
-            for (size_t i = 0; i < half; i++)
-               mProcessed[i] += out[i];
-            break;
-
-         case Cepstrum:
-            RealFFT(mWindowSize, in.get(), out.get(), out2.get());
-
-            // Compute log power
-            // Set a sane lower limit assuming maximum time amplitude of 1.0
-            {
-               float power;
-               float minpower = 1e-20*mWindowSize*mWindowSize;
-               for (size_t i = 0; i < mWindowSize; i++)
-               {
-                  power = (out[i] * out[i]) + (out2[i] * out2[i]);
-                  if(power < minpower)
-                     in[i] = log(minpower);
-                  else
-                     in[i] = log(power);
-               }
-               // Take IFFT
-               InverseRealFFT(mWindowSize, in.get(), NULL, out.get());
-
-               // Take real part of result
-               for (size_t i = 0; i < half; i++)
-                  mProcessed[i] += out[i];
-            }
-
-            break;
-
-         default:
-            wxASSERT(false);
-            break;
-      }                         //switch
-
-      // Update the progress bar
-      if (progress) {
-         progress->SetValue(start);
+   std::atomic<long long> done{ 0 };
+   const auto analyze = [&](long long chunk, std::vector<float> &sums) {
+      const auto first = chunk * windowsPerChunk;
+      const auto count = std::min(windowsPerChunk, windows - first);
+      Floats data{ (count - 1) * half + mWindowSize };
+      if (!source(data.get(), sampleCount{ first } * half,
+            (count - 1) * half + mWindowSize))
+         return false;
+      WindowAccumulator accumulator{ alg, win.get(), mWindowSize };
+      for (long long ii = 0; ii < count; ++ii) {
+         accumulator.Add(data.get() + ii * half);
+         done += half;
       }
-
-      start += half;
-      windows++;
+      sums = std::move(accumulator.mSums);
+      return true;
+   };
+
+   // Bound the memory for chunks by working in waves of jobs, and sum the
+   // results in a fixed order
+   auto &pool = ThreadPool::Get();
+   const auto waveSize = std::max<size_t>(1, 2 * pool.GetThreadCount());
+   std::vector<std::vector<float>> sums(waveSize);
+   const auto success = ParallelFor(pool, nChunks, waveSize,
+      [&](size_t chunk, const std::atomic<bool> &){
+         return analyze(chunk, sums[chunk % waveSize]);
+      },
+      [&]{
+         if (progress)
+            progress->SetValue(static_cast<int>(done.load() / progressScale));
+         return true;
+      },
+      [&](size_t first, size_t last){
+         for (auto chunk = first; chunk < last; ++chunk) {
+            auto &chunkSums = sums[chunk % waveSize];
+            for (size_t i = 0; i < half; i++)
+               mProcessed[i] += chunkSums[i];
+            chunkSums = {};
+         }
+         return true;
+      });
+   if (!success) {
+      if (progress)
+         progress->Reset();
+      mProcessed.resize(0);
+      return false;
    }
 
    if (progress) {
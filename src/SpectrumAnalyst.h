@@ -12,8 +12,10 @@
 #ifndef __AUDACITY_SPECTRUM_ANALYST__
 #define __AUDACITY_SPECTRUM_ANALYST__
 
+#include <functional>
 #include <vector>
 #include <wx/statusbr.h>
+#include "SampleCount.h"
 
 class FreqGauge;
 
@@ -31,6 +33,13 @@ public:
       NumAlgorithms
    };
 
+   //! Fills a buffer with len samples from start; returns success
+   /*! Called concurrently from worker threads.  Ranges of different calls
+    may overlap, by up to half a window where one chunk ends and the next
+    begins, so the source must allow concurrent reads of the same samples */
+   using SampleSource =
+      std::function<bool(float *buffer, sampleCount start, size_t len)>;
+
    SpectrumAnalyst();
    ~SpectrumAnalyst();
 
@@ -42,6 +51,15 @@ public:
       float *pYMin = NULL, float *pYMax = NULL, // outputs
       FreqGauge *progress = NULL);
 
+   //! Average over windows of samples read a chunk at a time, so that memory
+   //! use does not depend on dataLen; chunks are analyzed concurrently
+   bool Calculate(Algorithm alg,
+      int windowFunc, // see FFT.h for values
+      size_t windowSize, double rate,
+      const SampleSource &source, sampleCount dataLen,
+      float *pYMin = NULL, float *pYMax = NULL, // outputs
+      FreqGauge *progress = NULL);
+
    const float *GetProcessed() const;
    int GetProcessedSize() const;
 
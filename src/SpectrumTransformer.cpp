@@ -11,8 +11,20 @@ Edward Hui
 #include "SpectrumTransformer.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cassert>
 #include "FFT.h"
+#include "RealFFTfBatch.h"
 #include "WaveTrack.h"
+#include "concurrency/ThreadPool.h"
+
+namespace {
+//! Most windows to transform together
+constexpr size_t BatchSize = 16;
+
+//! Approximate length of the pieces ProcessParallel cuts channels into
+constexpr size_t ParallelChunkSize = 1 << 20;
+}
 
 SpectrumTransformer::SpectrumTransformer( bool needsOutput,
    eWindowFunctions inWindowType,
@@ -82,6 +94,11 @@ SpectrumTransformer::SpectrumTransformer( bool needsOutput,
       wxASSERT(false);
    for (size_t ii = 0; ii < mWindowSize; ++ii)
       *pWindow++ /= denom;
+
+   mBatch = std::make_unique<RealFFTfBatch>(mWindowSize,
+      mInWindow.empty() ? nullptr : mInWindow.data());
+   mBatchInput.resize(mWindowSize + (BatchSize - 1) * mStepSize);
+   mBatchSpectra.resize(BatchSize * mWindowSize);
 }
 
 auto SpectrumTransformer::NewWindow(size_t windowSize)
@@ -103,7 +120,21 @@ bool SpectrumTransformer::DoFinish()
 void
 TrackSpectrumTransformer::DoOutput(const float *outBuffer, size_t mStepSize)
 {
-   mOutputTrack->Append((constSamplePtr)outBuffer, floatSample, mStepSize);
+   if (!mpOutputBuffer) {
+      mOutputTrack->Append((constSamplePtr)outBuffer, floatSample, mStepSize);
+      return;
+   }
+
+   // Discard the leading margin, keep up to mOutputCount samples
+   size_t offset = 0;
+   if (mOutputSkip > 0) {
+      offset = limitSampleBufferSize(mStepSize, mOutputSkip);
+      mOutputSkip -= offset;
+   }
+   auto &output = *mpOutputBuffer;
+   const auto nKeep =
+      std::min(mStepSize - offset, mOutputCount - output.size());
+   output.insert(output.end(), outBuffer + offset, outBuffer + offset + nKeep);
 }
 
 bool SpectrumTransformer::Start(size_t queueLength)
@@ -146,6 +177,7 @@ bool SpectrumTransformer::Start(size_t queueLength)
    }
 
    mInSampleCount = 0;
+   mBatchCount = mBatchPos = 0;
 
    return true;
 }
@@ -169,7 +201,7 @@ bool SpectrumTransformer::ProcessSamples( const WindowProcessor &processor,
       mInWavePos += avail;
 
       if (mInWavePos == mWindowSize) {
-         FillFirstWindow();
+         FillFirstWindow(buffer, len);
 
          // invoke derived method
          if ( (success = processor(*this)), success )
@@ -185,6 +217,9 @@ bool SpectrumTransformer::ProcessSamples( const WindowProcessor &processor,
       }
    }
 
+   // Transforms of windows that the loop did not reach are not reusable
+   mBatchCount = mBatchPos = 0;
+
    return success;
 }
 
@@ -198,20 +233,32 @@ void SpectrumTransformer::ResizeQueue(size_t queueLength)
       mQueue[ii] = NewWindow(mWindowSize);
 }
 
-void SpectrumTransformer::FillFirstWindow()
+void SpectrumTransformer::TransformBatch(const float *buffer, size_t len)
 {
+   // The loop in ProcessSamples will make later windows from the input
+   // remaining in buffer (or zeroes, if it is null), a step at a time, so
+   // transform as many of them as there are now
+   const auto more = std::min(BatchSize - 1, len / mStepSize);
+   const auto extra = more * mStepSize;
+   auto pInput = std::copy(mInWaveBuffer.begin(), mInWaveBuffer.end(),
+      mBatchInput.begin());
+   if (buffer)
+      std::copy(buffer, buffer + extra, pInput);
+   else
+      std::fill(pInput, pInput + extra, 0.0f);
+
+   mBatchCount = 1 + more;
+   mBatchPos = 0;
    // Transform samples to frequency domain, windowed as needed
-   {
-      auto pFFTBuffer = mFFTBuffer.data(), pInWaveBuffer = mInWaveBuffer.data();
-      if (mInWindow.size() > 0) {
-         auto pInWindow = mInWindow.data();
-         for (size_t ii = 0; ii < mWindowSize; ++ii)
-            *pFFTBuffer++ = *pInWaveBuffer++ * *pInWindow++;
-      }
-      else
-         memmove(pFFTBuffer, pInWaveBuffer, mWindowSize * sizeof(float));
-   }
-   RealFFTf(mFFTBuffer.data(), hFFT.get());
+   mBatch->Forward(mBatchInput.data(), mStepSize,
+      mBatchSpectra.data(), mWindowSize, mBatchCount);
+}
+
+void SpectrumTransformer::FillFirstWindow(const float *buffer, size_t len)
+{
+   if (mBatchPos == mBatchCount)
+      TransformBatch(buffer, len);
+   const auto pSpectrum = &mBatchSpectra[mWindowSize * mBatchPos++];
 
    auto &record = Nth(0);
 
@@ -223,14 +270,14 @@ void SpectrumTransformer::FillFirstWindow()
       const auto last = mSpectrumSize - 1;
       for (size_t ii = 1; ii < last; ++ii) {
          const int kk = *pBitReversed++;
-         *pReal++ = mFFTBuffer[kk];
-         *pImag++ = mFFTBuffer[kk + 1];
+         *pReal++ = pSpectrum[kk];
+         *pImag++ = pSpectrum[kk + 1];
       }
       // DC and Fs/2 bins need to be handled specially
-      const float dc = mFFTBuffer[0];
+      const float dc = pSpectrum[0];
       record.mRealFFTs[0] = dc;
 
-      const float nyquist = mFFTBuffer[1];
+      const float nyquist = pSpectrum[1];
       record.mImagFFTs[0] = nyquist; // For Fs/2, not really imaginary
    }
 }
@@ -342,6 +389,7 @@ bool TrackSpectrumTransformer::Process(const WindowProcessor &processor,
    const WaveChannel &channel, size_t queueLength, sampleCount start,
    sampleCount len)
 {
+   assert(!NeedsOutput() || mOutputTrack || mpOutputBuffer);
    mpChannel = &channel;
 
    if (!Start(queueLength))
@@ -370,6 +418,131 @@ bool TrackSpectrumTransformer::Process(const WindowProcessor &processor,
    return bLoopSuccess;
 }
 
+bool TrackSpectrumTransformer::ProcessToBuffer(
+   const WindowProcessor &processor, const WaveChannel &channel,
+   size_t queueLength, sampleCount start, sampleCount len,
+   sampleCount skip, size_t count, FloatVector &output)
+{
+   assert(NeedsOutput());
+   output.clear();
+   output.reserve(count);
+   mpOutputBuffer = &output;
+   mOutputSkip = skip;
+   mOutputCount = count;
+   const auto result = Process(processor, channel, queueLength, start, len);
+   mpOutputBuffer = nullptr;
+   return result && output.size() == count;
+}
+
+bool TrackSpectrumTransformer::ProcessParallel(const Factory &factory,
+   const WindowProcessor &processor, const std::vector<ChannelTask> &tasks,
+   size_t queueLength, size_t extraWindows,
+   const std::function<bool(double)> &progress)
+{
+   using namespace audacity::concurrency;
+
+   if (tasks.empty())
+      return true;
+
+   const auto pFirst = factory(nullptr);
+   assert(pFirst && pFirst->NeedsOutput());
+   if (!(pFirst->mLeadingPadding && pFirst->mTrailingPadding)) {
+      // Windows are not aligned with the start of the input, so the result
+      // of a piece would differ from the result of the whole; do it serially
+      sampleCount done = 0, total = 0;
+      for (const auto &task : tasks)
+         total += task.len;
+      for (const auto &task : tasks) {
+         const auto pTransformer = factory(task.pOutput);
+         if (!pTransformer->Process(processor, *task.pInput, queueLength,
+               task.start, task.len))
+            return false;
+         done += task.len;
+         if (!progress(
+            done.as_double() / std::max<sampleCount>(1, total).as_double()))
+            return false;
+      }
+      return true;
+   }
+
+   // Output is exact after this many samples of lead-in, and before this
+   // many samples of lead-out:  windows overlapping an output sample, the
+   // queue around them, and older windows that can still influence them
+   const auto stepSize = pFirst->mStepSize;
+   const sampleCount margin =
+      (queueLength + pFirst->mStepsPerWindow + extraWindows) * stepSize;
+   const auto chunkSize =
+      std::max<size_t>(1, ParallelChunkSize / stepSize) * stepSize;
+
+   struct Job {
+      size_t iTask;
+      //! Input range, relative to the task's start
+      sampleCount begin, end;
+      //! Output range within the input range
+      sampleCount skip;
+      size_t count;
+   };
+   std::vector<Job> jobs;
+   sampleCount total = 0;
+   for (size_t iTask = 0; iTask < tasks.size(); ++iTask) {
+      const auto len = tasks[iTask].len;
+      for (sampleCount pos = 0; pos < len; pos += chunkSize) {
+         const auto count = limitSampleBufferSize(chunkSize, len - pos);
+         const auto begin = std::max<sampleCount>(0, pos - margin);
+         const auto end = std::min(len, pos + count + margin);
+         jobs.push_back({ iTask, begin, end, pos - begin, count });
+         total += end - begin;
+      }
+   }
+
+   std::atomic<long long> done{ 0 };
+   const auto fraction = [&]{
+      return std::min(1.0,
+         done.load() / std::max<sampleCount>(1, total).as_double());
+   };
+
+   // Bound the memory for outputs by working in waves of jobs
+   auto &pool = ThreadPool::Get();
+   const auto waveSize = std::max<size_t>(1, 2 * pool.GetThreadCount());
+   std::vector<FloatVector> outputs(waveSize);
+   // Make transformers on this thread, for a wave at a time
+   std::vector<std::shared_ptr<TrackSpectrumTransformer>>
+      transformers(waveSize);
+   const auto makeTransformers = [&](size_t first){
+      for (auto iJob = first;
+           iJob < std::min(jobs.size(), first + waveSize); ++iJob)
+         transformers[iJob % waveSize] = factory(nullptr);
+   };
+   makeTransformers(0);
+   return ParallelFor(pool, jobs.size(), waveSize,
+      [&](size_t iJob, const std::atomic<bool> &cancelled){
+         const auto &job = jobs[iJob];
+         const auto &task = tasks[job.iTask];
+         const WindowProcessor wrapped =
+         [&](SpectrumTransformer &transformer){
+            if (cancelled.load(std::memory_order_relaxed))
+               return false;
+            done += stepSize;
+            return processor(transformer);
+         };
+         return transformers[iJob % waveSize]->ProcessToBuffer(wrapped,
+            *task.pInput, queueLength, task.start + job.begin,
+            job.end - job.begin, job.skip, job.count,
+            outputs[iJob % waveSize]);
+      },
+      [&]{ return progress(fraction()); },
+      [&](size_t first, size_t last){
+         for (auto iJob = first; iJob < last; ++iJob) {
+            auto &output = outputs[iJob % waveSize];
+            tasks[jobs[iJob].iTask].pOutput->Append(
+               (constSamplePtr)output.data(), floatSample, output.size());
+            output = {};
+         }
+         makeTransformers(last);
+         return true;
+      });
+}
+
 bool TrackSpectrumTransformer::DoFinish()
 {
    return SpectrumTransformer::DoFinish();
@@ -21,6 +21,7 @@ Paul Licameli
 
 enum eWindowFunctions : int;
 
+class RealFFTfBatch;
 class WaveChannel;
 
 /*!
@@ -147,7 +148,8 @@ public:
 
 private:
    void ResizeQueue(size_t queueLength);
-   void FillFirstWindow();
+   void TransformBatch(const float *buffer, size_t len);
+   void FillFirstWindow(const float *buffer, size_t len);
    void RotateWindows();
    void OutputStep();
 
@@ -177,6 +179,16 @@ private:
    FloatVector mInWindow;
    FloatVector mOutWindow;
 
+   //! Forward transforms of several windows at once, when the input allows
+   std::unique_ptr<RealFFTfBatch> mBatch;
+   //! Input of the batch; later windows overlap input not yet consumed
+   FloatVector mBatchInput;
+   //! Transforms of the batch, each of size mWindowSize
+   FloatVector mBatchSpectra;
+   size_t mBatchCount = 0;
+   //! How many of the batch FillFirstWindow has used
+   size_t mBatchPos = 0;
+
    const bool mNeedsOutput;
 };
 
@@ -188,7 +200,8 @@ public:
    /*!
     @copydoc SpectrumTransformer::SpectrumTransformer(bool,
        eWindowFunctions, eWindowFunctions, size_t, unsigned, bool, bool)
-    @pre `!needsOutput || pOutputTrack != nullptr`
+    @pre `!needsOutput || pOutputTrack != nullptr`, unless only
+    ProcessToBuffer() is used
     */
    TrackSpectrumTransformer(WaveChannel *pOutputTrack,
       bool needsOutput, eWindowFunctions inWindowType,
@@ -199,7 +212,6 @@ public:
       }
       , mOutputTrack{ pOutputTrack }
    {
-      assert(!needsOutput || pOutputTrack != nullptr);
    }
    ~TrackSpectrumTransformer() override;
 
@@ -207,6 +219,57 @@ public:
    bool Process(const WindowProcessor &processor, const WaveChannel &channel,
       size_t queueLength, sampleCount start, sampleCount len);
 
+   //! Like Process(), but output goes to a buffer and not to the track
+   /*!
+    @param skip how many output samples to discard first
+    @param count how many output samples to keep after those
+    @post on success, `output.size() == count`
+    */
+   bool ProcessToBuffer(const WindowProcessor &processor,
+      const WaveChannel &channel, size_t queueLength,
+      sampleCount start, sampleCount len,
+      sampleCount skip, size_t count, FloatVector &output);
+
+   //! Makes transformers for ProcessParallel, one per job
+   /*! The argument is null for jobs that use ProcessToBuffer() */
+   using Factory = std::function<
+      std::unique_ptr<TrackSpectrumTransformer>(WaveChannel *pOutputTrack)>;
+
+   //! One channel's input range and where its output is appended
+   struct ChannelTask {
+      const WaveChannel *pInput;
+      WaveChannel *pOutput;
+      sampleCount start;
+      sampleCount len;
+   };
+
+   //! Process several channels, and long ranges in overlapping pieces,
+   //! on the shared thread pool
+   /*!
+    Each channel is cut into chunks, and each chunk is processed with a margin
+    of extra input on either side, which is transformed but not output.  The
+    result is the same as from Process() if the processor's state depends on
+    no more than `extraWindows` windows older than its queue.
+
+    Only transformers with output and with leading and trailing padding are
+    cut and run in parallel; others process the channels one after another,
+    as Process() does.
+
+    `processor` is called on worker threads, must not touch the user
+    interface, and may share with other jobs only read-only state.  Output is
+    appended to the tasks' output channels on the calling thread.
+
+    @param progress called on the calling thread with the fraction done;
+    returns false to cancel
+    @pre `factory` makes transformers that need output
+    @return success
+    */
+   static bool ProcessParallel(const Factory &factory,
+      const WindowProcessor &processor,
+      const std::vector<ChannelTask> &tasks,
+      size_t queueLength, size_t extraWindows,
+      const std::function<bool(double)> &progress);
+
    //! Final flush and trimming of tail samples
    static bool PostProcess(WaveTrack &outputTrack, sampleCount len);
 
@@ -218,6 +281,11 @@ protected:
 private:
    WaveChannel *const mOutputTrack;
    const WaveChannel *mpChannel = nullptr;
+
+   //! When not null, DoOutput() fills this instead of the track
+   FloatVector *mpOutputBuffer = nullptr;
+   sampleCount mOutputSkip = 0;
+   size_t mOutputCount = 0;
 };
 
 #endif
@@ -138,6 +138,11 @@ EffectType EffectAmplify::GetType() const
    return EffectTypeProcess;
 }
 
+bool EffectAmplify::ProcessesTracksConcurrently() const
+{
+   return true;
+}
+
 unsigned EffectAmplify::GetAudioInCount() const
 {
    return 1;
@@ -43,6 +43,7 @@ public:
    // EffectDefinitionInterface implementation
 
    EffectType GetType() const override;
+   bool ProcessesTracksConcurrently() const override;
    OptionalMessage LoadFactoryDefaults(EffectSettings &settings)
       const override;
    OptionalMessage DoLoadFactoryDefaults(EffectSettings &settings);
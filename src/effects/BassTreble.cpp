@@ -144,7 +144,9 @@ struct EffectBassTreble::Instance
    static void Coefficients(double hz, double slope, double gain, double samplerate, int type,
       double& a0, double& a1, double& a2, double& b0, double& b1, double& b2);
 
-   static float DoFilter(EffectBassTrebleState& data, float in);
+   //! Set the coefficients of one shelf filter, keeping its state
+   static void SetShelf(Biquad &shelf,
+      double hz, double slope, double gain, double samplerate, int type);
 
    EffectBassTrebleState mState;
    std::vector<EffectBassTreble::Instance> mSlaves;
@@ -191,6 +193,11 @@ EffectType EffectBassTreble::GetType() const
    return EffectTypeProcess;
 }
 
+bool EffectBassTreble::ProcessesTracksConcurrently() const
+{
+   return true;
+}
+
 auto EffectBassTreble::RealtimeSupport() const -> RealtimeSince
 {
    return RealtimeSince::After_3_1;
@@ -390,29 +397,7 @@ void EffectBassTreble::Instance::InstanceInit(EffectSettings& settings, EffectBa
    data.hzBass = 250.0f;   // could be tunable in a more advanced version
    data.hzTreble = 4000.0f;   // could be tunable in a more advanced version
 
-   data.a0Bass = 1;
-   data.a1Bass = 0;
-   data.a2Bass = 0;
-   data.b0Bass = 0;
-   data.b1Bass = 0;
-   data.b2Bass = 0;
-
-   data.a0Treble = 1;
-   data.a1Treble = 0;
-   data.a2Treble = 0;
-   data.b0Treble = 0;
-   data.b1Treble = 0;
-   data.b2Treble = 0;
-
-   data.xn1Bass = 0;
-   data.xn2Bass = 0;
-   data.yn1Bass = 0;
-   data.yn2Bass = 0;
-
-   data.xn1Treble = 0;
-   data.xn2Treble = 0;
-   data.yn1Treble = 0;
-   data.yn2Treble = 0;
+   data.shelves[0] = data.shelves[1] = Biquad{};
 
    data.bass = -1;
    data.treble = -1;
@@ -437,18 +422,17 @@ size_t EffectBassTreble::Instance::InstanceProcess(EffectSettings &settings,
 
    // Compute coefficients of the low shelf biquand IIR filter
    if (data.bass != oldBass)
-      Coefficients(data.hzBass, data.slope, ms.mBass, data.samplerate, kBass,
-                  data.a0Bass, data.a1Bass, data.a2Bass,
-                  data.b0Bass, data.b1Bass, data.b2Bass);
+      SetShelf(data.shelves[0],
+         data.hzBass, data.slope, ms.mBass, data.samplerate, kBass);
 
    // Compute coefficients of the high shelf biquand IIR filter
    if (data.treble != oldTreble)
-      Coefficients(data.hzTreble, data.slope, ms.mTreble, data.samplerate, kTreble,
-                  data.a0Treble, data.a1Treble, data.a2Treble,
-                  data.b0Treble, data.b1Treble, data.b2Treble);
+      SetShelf(data.shelves[1],
+         data.hzTreble, data.slope, ms.mTreble, data.samplerate, kTreble);
 
+   Biquad::ProcessCascade(data.shelves, 2, ibuf, obuf, blockLen);
    for (decltype(blockLen) i = 0; i < blockLen; i++) {
-      obuf[i] = DoFilter(data, ibuf[i]) * data.gain;
+      obuf[i] *= data.gain;
    }
 
    return blockLen;
@@ -487,26 +471,16 @@ void EffectBassTreble::Instance::Coefficients(double hz, double slope, double ga
    }
 }
 
-float EffectBassTreble::Instance::DoFilter(EffectBassTrebleState & data, float in)
+void EffectBassTreble::Instance::SetShelf(Biquad &shelf,
+   double hz, double slope, double gain, double samplerate, int type)
 {
-   // Bass filter
-   float out = (data.b0Bass * in + data.b1Bass * data.xn1Bass + data.b2Bass * data.xn2Bass -
-         data.a1Bass * data.yn1Bass - data.a2Bass * data.yn2Bass) / data.a0Bass;
-   data.xn2Bass = data.xn1Bass;
-   data.xn1Bass = in;
-   data.yn2Bass = data.yn1Bass;
-   data.yn1Bass = out;
-
-   // Treble filter
-   in = out;
-   out = (data.b0Treble * in + data.b1Treble * data.xn1Treble + data.b2Treble * data.xn2Treble -
-         data.a1Treble * data.yn1Treble - data.a2Treble * data.yn2Treble) / data.a0Treble;
-   data.xn2Treble = data.xn1Treble;
-   data.xn1Treble = in;
-   data.yn2Treble = data.yn1Treble;
-   data.yn1Treble = out;
-
-   return out;
+   double a0, a1, a2, b0, b1, b2;
+   Coefficients(hz, slope, gain, samplerate, type, a0, a1, a2, b0, b1, b2);
+   shelf.fNumerCoeffs[Biquad::B0] = b0 / a0;
+   shelf.fNumerCoeffs[Biquad::B1] = b1 / a0;
+   shelf.fNumerCoeffs[Biquad::B2] = b2 / a0;
+   shelf.fDenomCoeffs[Biquad::A1] = a1 / a0;
+   shelf.fDenomCoeffs[Biquad::A2] = a2 / a0;
 }
 
 
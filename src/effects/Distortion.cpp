@@ -353,6 +353,11 @@ EffectType EffectDistortion::GetType() const
    return EffectTypeProcess;
 }
 
+bool EffectDistortion::ProcessesTracksConcurrently() const
+{
+   return true;
+}
+
 auto EffectDistortion::RealtimeSupport() const -> RealtimeSince
 {
    return RealtimeSince::After_3_1;
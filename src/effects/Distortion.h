@@ -90,6 +90,7 @@ public:
    // EffectDefinitionInterface implementation
 
    EffectType GetType() const override;
+   bool ProcessesTracksConcurrently() const override;
    RealtimeSince RealtimeSupport() const override;
    RegistryPaths GetFactoryPresets() const override;
    OptionalMessage LoadFactoryPreset(int id, EffectSettings &settings)
@@ -116,6 +116,11 @@ EffectType EffectEcho::GetType() const
    return EffectTypeProcess;
 }
 
+bool EffectEcho::ProcessesTracksConcurrently() const
+{
+   return true;
+}
+
 bool EffectEcho::Instance::ProcessInitialize(
    EffectSettings& settings, double sampleRate, ChannelNames)
 {
@@ -41,6 +41,10 @@
 
 #include "WaveClip.h"
 #include "WaveTrack.h"
+#include "FIRConvolver.h"
+#include "concurrency/ThreadPool.h"
+
+#include <atomic>
 
 const EffectParameterMethods& EffectEqualization::Parameters() const
 {
@@ -363,50 +367,31 @@ bool EffectEqualization::Init()
    return(true);
 }
 
-struct EffectEqualization::Task {
-   Task(size_t M, size_t idealBlockLen, WaveChannel &channel)
-      : buffer{ idealBlockLen }
-      , idealBlockLen{ idealBlockLen }
-      , output{ channel }
-      , leftTailRemaining{ (M - 1) / 2 }
-   {
-      memset(lastWindow, 0, windowSize * sizeof(float));
-   }
-
-   void AccumulateSamples(constSamplePtr buffer, size_t len)
-   {
-      auto leftTail = std::min(len, leftTailRemaining);
-      leftTailRemaining -= leftTail;
-      len -= leftTail;
-      buffer += leftTail * sizeof(float);
-      output.Append(buffer, floatSample, len);
-   }
-
-   static constexpr auto windowSize = EqualizationFilter::windowSize;
-   Floats window1{ windowSize };
-   Floats window2{ windowSize };
-
-   Floats buffer;
-   const size_t idealBlockLen;
-
-   // These pointers are swapped after each FFT window
-   float *thisWindow{ window1.get() };
-   float *lastWindow{ window2.get() };
+namespace {
+//! Approximate length of the pieces of a channel filtered concurrently
+constexpr size_t ChunkSize = 1 << 20;
+}
 
-   // a new WaveChannel to hold all of the output,
-   // including 'tails' each end
+struct EffectEqualization::Task {
+   const WaveChannel &input;
+   // a new WaveChannel to hold all of the output
    WaveChannel &output;
-
-   size_t leftTailRemaining;
+   sampleCount start;
+   sampleCount len;
 };
 
 bool EffectEqualization::Process(EffectInstance &, EffectSettings &)
 {
    EffectOutputTracks outputs { *mTracks, GetType(), { { mT0, mT1 } } };
    mParameters.CalcFilter();
-   bool bGoodResult = true;
 
-   int count = 0;
+   struct TrackTask {
+      WaveTrack &track;
+      WaveTrack::Holder pTempTrack;
+      double t0, t1;
+   };
+   std::vector<TrackTask> trackTasks;
+   std::vector<Task> tasks;
    for (auto track : outputs.Get().Selected<WaveTrack>()) {
       double trackStart = track->GetStartTime();
       double trackEnd = track->GetEndTime();
@@ -421,35 +406,23 @@ bool EffectEqualization::Process(EffectInstance &, EffectSettings &)
          auto pTempTrack = track->EmptyCopy();
          pTempTrack->ConvertToSampleFormat(floatSample);
          auto iter0 = pTempTrack->Channels().begin();
+         for (const auto pChannel : track->Channels())
+            tasks.push_back({ *pChannel, **iter0++, start, len });
+         trackTasks.push_back({ *track, std::move(pTempTrack), t0, t1 });
+      }
+   }
 
-         for (const auto pChannel : track->Channels()) {
-            constexpr auto windowSize = EqualizationFilter::windowSize;
-            const auto &M = mParameters.mM;
-
-            wxASSERT(M - 1 < windowSize);
-            size_t L = windowSize - (M - 1);   //Process L samples at a go
-            auto s = start;
-            auto idealBlockLen = pChannel->GetMaxBlockSize() * 4;
-            if (idealBlockLen % L != 0)
-               idealBlockLen += (L - (idealBlockLen % L));
-            auto pNewChannel = *iter0++;
-            Task task{ M, idealBlockLen, *pNewChannel };
-            bGoodResult = ProcessOne(task, count, *pChannel, start, len);
-            if (!bGoodResult)
-               goto done;
-         }
+   bool bGoodResult = ProcessTasks(tasks);
+   if (bGoodResult) {
+      for (auto &task : trackTasks) {
+         auto &pTempTrack = task.pTempTrack;
          pTempTrack->Flush();
          // Remove trailing data from the temp track
-         pTempTrack->Clear(t1 - t0, pTempTrack->GetEndTime());
-         track->ClearAndPaste(t0, t1, *pTempTrack, true, true);
+         pTempTrack->Clear(task.t1 - task.t0, pTempTrack->GetEndTime());
+         task.track.ClearAndPaste(task.t0, task.t1, *pTempTrack, true, true);
       }
-
-      count++;
-   }
-   done:
-
-   if (bGoodResult)
       outputs.Commit();
+   }
 
    return bGoodResult;
 }
@@ -472,85 +445,83 @@ bool EffectEqualization::TransferDataToWindow(const EffectSettings &settings)
 
 // EffectEqualization implementation
 
-bool EffectEqualization::ProcessOne(Task &task,
-   int count, const WaveChannel &t, sampleCount start, sampleCount len)
+bool EffectEqualization::ProcessTasks(const std::vector<Task> &tasks)
 {
-   constexpr auto windowSize = EqualizationFilter::windowSize;
-
-   const auto &M = mParameters.mM;
-
-   wxASSERT(M - 1 < windowSize);
-   size_t L = windowSize - (M - 1);   //Process L samples at a go
-   auto s = start;
-
-   auto &buffer = task.buffer;
-   auto &window1 = task.window1;
-   auto &window2 = task.window2;
-   auto &thisWindow = task.thisWindow;
-   auto &lastWindow = task.lastWindow;
-
-   auto originalLen = len;
-
-   auto &output = task.output;
-
-   TrackProgress(count, 0.);
-   bool bLoopSuccess = true;
-   size_t wcopy = 0;
-
-   while (len != 0)
-   {
-      auto block = limitSampleBufferSize( task.idealBlockLen, len );
-
-      t.GetFloats(buffer.get(), s, block);
-
-      for(size_t i = 0; i < block; i += L)   //go through block in lumps of length L
-      {
-         wcopy = std::min <size_t> (L, block - i);
-         for(size_t j = 0; j < wcopy; j++)
-            thisWindow[j] = buffer[i+j];   //copy the L (or remaining) samples
-         for(auto j = wcopy; j < windowSize; j++)
-            thisWindow[j] = 0;   //this includes the padding
-
-         mParameters.Filter(windowSize, thisWindow);
-
-         // Overlap - Add
-         for(size_t j = 0; (j < M - 1) && (j < wcopy); j++)
-            buffer[i+j] = thisWindow[j] + lastWindow[L + j];
-         for(size_t j = M - 1; j < wcopy; j++)
-            buffer[i+j] = thisWindow[j];
-
-         std::swap( thisWindow, lastWindow );
-      }  //next i, lump of this block
-
-      task.AccumulateSamples((samplePtr)buffer.get(), block);
-      len -= block;
-      s += block;
-
-      if (TrackProgress(count, ( s - start ).as_double() /
-                        originalLen.as_double()))
-      {
-         bLoopSuccess = false;
-         break;
-      }
+   using namespace audacity::concurrency;
+
+   // The response is symmetrical about its center, so output aligns with
+   // input after discarding the left half of it, and the output of each
+   // chunk is exact given the other half as lead-in
+   const auto &impulse = mParameters.mImpulseResponse;
+   const size_t M = impulse.size();
+   const size_t leftTail = (M - 1) / 2;
+   const size_t leadIn = M - 1 - leftTail;
+   const auto blockSize = FIRConvolver::DefaultBlockSize(M);
+   const size_t chunkSize =
+      std::max<size_t>(1, ChunkSize / blockSize) * blockSize;
+
+   struct Job {
+      const Task &task;
+      //! Output range, relative to the start of the task
+      sampleCount begin;
+      size_t count;
+   };
+   std::vector<Job> jobs;
+   sampleCount total = 0;
+   for (const auto &task : tasks) {
+      for (sampleCount pos = 0; pos < task.len; pos += chunkSize)
+         jobs.push_back(
+            { task, pos, limitSampleBufferSize(chunkSize, task.len - pos) });
+      total += task.len;
    }
 
-   if (bLoopSuccess) {
-      // M-1 samples of 'tail' left in lastWindow, get them now
-      if(wcopy < (M - 1)) {
-         // Still have some overlap left to process
-         // (note that lastWindow and thisWindow have been exchanged at this point
-         //  so that 'thisWindow' is really the window prior to 'lastWindow')
-         size_t j = 0;
-         for(; j < M - 1 - wcopy; j++)
-            buffer[j] = lastWindow[wcopy + j] + thisWindow[L + wcopy + j];
-         // And fill in the remainder after the overlap
-         for( ; j < M - 1; j++)
-            buffer[j] = lastWindow[wcopy + j];
-      } else {
-         for(size_t j = 0; j < M - 1; j++)
-            buffer[j] = lastWindow[wcopy + j];
+   std::atomic<long long> done{ 0 };
+   const auto filter = [&](const Job &job, std::vector<float> &output,
+      const std::atomic<bool> &cancelled) {
+      const auto &task = job.task;
+      // Input before and after the selection counts as silence
+      const auto count = job.count + M - 1;
+      const auto nBlocks = (count + blockSize - 1) / blockSize;
+      std::vector<float> buffer(nBlocks * blockSize);
+      const auto first = job.begin - leadIn;
+      const auto readBegin = std::max<sampleCount>(first, 0);
+      const auto readEnd = std::min<sampleCount>(first + count, task.len);
+      if (readBegin < readEnd)
+         task.input.GetFloats(&buffer[(readBegin - first).as_size_t()],
+            task.start + readBegin, (readEnd - readBegin).as_size_t());
+
+      FIRConvolver convolver{ impulse.data(), M, blockSize };
+      for (size_t ii = 0; ii < nBlocks; ++ii) {
+         if (cancelled.load(std::memory_order_relaxed))
+            return false;
+         const auto pBlock = &buffer[ii * blockSize];
+         convolver.ProcessBlock(pBlock, pBlock);
+         done += blockSize;
       }
-      task.AccumulateSamples((samplePtr)buffer.get(), M - 1);
-   }
-   return bLoopSuccess;
+      output.assign(&buffer[M - 1], &buffer[M - 1] + job.count);
+      return true;
+   };
+   const auto fraction = [&]{
+      return std::min(1.0,
+         done.load() / std::max<sampleCount>(1, total).as_double());
+   };
+
+   // Bound the memory for outputs by working in waves of jobs
+   auto &pool = ThreadPool::Get();
+   const auto waveSize = std::max<size_t>(1, 2 * pool.GetThreadCount());
+   std::vector<std::vector<float>> outputs(waveSize);
+   return ParallelFor(pool, jobs.size(), waveSize,
+      [&](size_t iJob, const std::atomic<bool> &cancelled){
+         return filter(jobs[iJob], outputs[iJob % waveSize], cancelled);
+      },
+      [&]{ return !TotalProgress(fraction()); },
+      [&](size_t first, size_t last){
+         for (auto iJob = first; iJob < last; ++iJob) {
+            auto &output = outputs[iJob % waveSize];
+            jobs[iJob].task.output.Append(
+               (constSamplePtr)output.data(), floatSample, output.size());
+            output = {};
+         }
+         return true;
+      });
 }
@@ -69,9 +69,9 @@ private:
    // EffectEqualization implementation
 
    struct Task;
-   bool ProcessOne(Task &task, int count, const WaveChannel &t,
-      sampleCount start, sampleCount len);
-   
+   //! Filter channels, in pieces, concurrently
+   bool ProcessTasks(const std::vector<Task> &tasks);
+
    wxWeakRef<wxWindow> mUIParent{};
    EqualizationFilter mParameters;
    EqualizationCurvesList mCurvesList{ mParameters };
@@ -16,7 +16,8 @@
 
 #include "EqualizationParameters.h" // base class
 #include "Envelope.h" // member
-#include "RealFFTf.h" // member
+#include "MemoryX.h"
+#include <vector>
 using Floats = ArrayOf<float>;
 
 //! Extend EqualizationParameters with frequency domain coefficients computed
@@ -37,10 +38,6 @@ struct EqualizationFilter : EqualizationParameters {
    //! domain
    bool CalcFilter();
 
-   //! Transform a given buffer of time domain signal, which should be zero
-   //! padded left and right for the tails
-   void Filter(size_t len, float *buffer) const;
-
    const Envelope &ChooseEnvelope() const
    { return mLin ? mLinEnvelope : mLogEnvelope; }
    Envelope &ChooseEnvelope()
@@ -51,9 +48,9 @@ struct EqualizationFilter : EqualizationParameters {
    { return IsLinear() ? mLinEnvelope : mLogEnvelope; }
 
    Envelope mLinEnvelope, mLogEnvelope;
-   HFFT hFFT{ GetFFT(windowSize) };
-   Floats mFFTBuffer{ windowSize };
    Floats mFilterFuncR{ windowSize }, mFilterFuncI{ windowSize };
+   //! mM coefficients, with the center of symmetry at (mM - 1) / 2
+   std::vector<float> mImpulseResponse;
    double mLoFreq{ loFreqI };
    double mHiFreq{ mLoFreq };
    size_t mWindowSize{ windowSize };
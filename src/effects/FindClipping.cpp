@@ -31,6 +31,7 @@
 #include "AudacityMessageBox.h"
 
 #include "../LabelTrack.h"
+#include "WaveChannelUtilities.h"
 #include "WaveTrack.h"
 
 const EffectParameterMethods& EffectFindClipping::Parameters() const
@@ -162,7 +163,23 @@ bool EffectFindClipping::ProcessOne(LabelTrack &lt,
             bGoodResult = false;
             break;
          }
-         block = limitSampleBufferSize( blockSize, len - s );
+         // Stop chunks at sample block boundaries, so that summaries of whole
+         // blocks answer for them
+         const auto span =
+            limitSampleBufferSize(wt.GetBestBlockSize(start + s), len - s);
+         if (startrun < mStart) {
+            // No run needs ending, so skip audio that summaries show cannot
+            // start one, without reading its samples
+            const auto [min, max] = WaveChannelUtilities::GetMinMax(wt,
+               wt.LongSamplesToTime(start + s),
+               wt.LongSamplesToTime(start + s + span));
+            if (min > -MAX_AUDIO && max < MAX_AUDIO) {
+               startrun = 0;
+               s += span;
+               continue;
+            }
+         }
+         block = std::min(span, limitSampleBufferSize( blockSize, len - s ));
          wt.GetFloats(buffer.get(), start + s, block);
          ptr = buffer.get();
       }
@@ -51,6 +51,11 @@ EffectType EffectInvert::GetType() const
    return EffectTypeProcess;
 }
 
+bool EffectInvert::ProcessesTracksConcurrently() const
+{
+   return true;
+}
+
 bool EffectInvert::IsInteractive() const
 {
    return false;
@@ -31,6 +31,7 @@ public:
    // EffectDefinitionInterface implementation
 
    EffectType GetType() const override;
+   bool ProcessesTracksConcurrently() const override;
    bool IsInteractive() const override;
 
    unsigned GetAudioInCount() const override;
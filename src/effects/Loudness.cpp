@@ -471,13 +471,9 @@ void EffectLoudness::LoadBufferBlock(WaveChannel &track, size_t nChannels,
 /// (for loudness).
 bool EffectLoudness::AnalyseBufferBlock(EBUR128 &loudnessProcessor)
 {
-   for(size_t i = 0; i < mTrackBufferLen; i++)
-   {
-      loudnessProcessor.ProcessSampleFromChannel(mTrackBuffer[0][i], 0);
-      if (mProcStereo)
-         loudnessProcessor.ProcessSampleFromChannel(mTrackBuffer[1][i], 1);
-      loudnessProcessor.NextSample();
-   }
+   const float *const channels[]{
+      mTrackBuffer[0].get(), mTrackBuffer[1].get() };
+   loudnessProcessor.ProcessSamples(channels, mTrackBufferLen);
 
    if (!UpdateProgress())
       return false;
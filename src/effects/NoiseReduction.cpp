@@ -262,6 +262,7 @@ struct MyTransformer : TrackSpectrumTransformer {
          windowSize, stepsPerWindow, leadingPadding, trailingPadding
       }
       , mWorker{ worker }
+      , mFreqSmoothingScratch(windowSize / 2 + 1)
    {
    }
    struct MyWindow : public Window
@@ -283,6 +284,8 @@ struct MyTransformer : TrackSpectrumTransformer {
    bool DoFinish() override;
 
    EffectNoiseReduction::Worker &mWorker;
+   //! Per transformer, so that several can run concurrently
+   FloatVector mFreqSmoothingScratch;
 };
 
 //----------------------------------------------------------------------------
@@ -306,10 +309,17 @@ public:
 
    bool Process(eWindowFunctions inWindowType, eWindowFunctions outWindowType,
       TrackList &tracks, double mT0, double mT1);
+   //! Reduce all channels of all tracks at once, on the thread pool
+   bool ReduceConcurrently(
+      eWindowFunctions inWindowType, eWindowFunctions outWindowType,
+      TrackList &tracks, double mT0, double mT1);
 
    static bool Processor(SpectrumTransformer &transformer);
+   //! Like Processor but without progress, which is reported otherwise
+   static bool ConcurrentProcessor(SpectrumTransformer &transformer);
 
-   void ApplyFreqSmoothing(FloatVector &gains);
+   void ProcessWindow(MyTransformer &transformer);
+   void ApplyFreqSmoothing(FloatVector &gains, FloatVector &scratch) const;
    void GatherStatistics(MyTransformer &transformer);
    inline bool Classify(
       MyTransformer &transformer, unsigned nWindows, int band);
@@ -322,7 +332,6 @@ public:
    const Settings &mSettings;
    Statistics &mStatistics;
 
-   FloatVector mFreqSmoothingScratch;
    const size_t mFreqSmoothingBins;
    // When spectral selection limits the affected band:
    size_t mBinLow;  // inclusive lower bound
@@ -340,6 +349,8 @@ public:
    unsigned  mNWindowsToExamine;
    unsigned  mCenter;
    unsigned  mHistoryLen;
+   //! Windows after which the release of any gain has reached the floor
+   unsigned  mReleaseLen;
 
    // Following are for progress indicator only:
    unsigned  mProgressTrackCount = 0;
@@ -722,17 +733,15 @@ bool EffectNoiseReduction::Worker::Process(
    eWindowFunctions inWindowType, eWindowFunctions outWindowType,
    TrackList &tracks, double inT0, double inT1)
 {
+   if (!mDoProfile)
+      return ReduceConcurrently(inWindowType, outWindowType, tracks, inT0, inT1);
+
    mProgressTrackCount = 0;
    for (auto track : tracks.Selected<WaveTrack>()) {
       mProgressWindowCount = 0;
       if (track->GetRate() != mStatistics.mRate) {
-         if (mDoProfile)
-            EffectUIServices::DoMessageBox(mEffect,
-               XO("All noise profile data must have the same sample rate.") );
-         else
-            EffectUIServices::DoMessageBox(mEffect,
-               XO(
-"The sample rate of the noise profile must match that of the sound to be processed.") );
+         EffectUIServices::DoMessageBox(mEffect,
+            XO("All noise profile data must have the same sample rate.") );
          return false;
       }
 
@@ -746,60 +755,97 @@ bool EffectNoiseReduction::Worker::Process(
          auto end = track->TimeToLongSamples(t1);
          const auto len = end - start;
          mLen = len;
-         const auto extra =
-            (mSettings.StepsPerWindow() - 1) * mSettings.SpectrumSize();
-         // Adjust denominator for presence or absence of padding,
-         // which makes the number of windows visited either more or less
-         // than the number of window steps in the data.
-         if (mDoProfile)
-            mLen -= extra;
-         else
-            mLen += extra;
-
-         auto t0 = track->LongSamplesToTime(start);
-         auto tLen = track->LongSamplesToTime(len);
-         std::optional<WaveTrack::Holder> ppTempTrack;
-         std::optional<ChannelGroup::ChannelIterator<WaveChannel>> pIter;
-         WaveTrack *pFirstTrack{};
-         if (!mSettings.mDoProfile) {
-            ppTempTrack.emplace(track->EmptyCopy());
-            pFirstTrack = ppTempTrack->get();
-            pIter.emplace(pFirstTrack->Channels().begin());
-         }
+         // Adjust denominator for absence of padding, which makes the
+         // number of windows visited less than the number of window steps in
+         // the data.
+         mLen -= (mSettings.StepsPerWindow() - 1) * mSettings.SpectrumSize();
+
          for (const auto pChannel : track->Channels()) {
-            auto pOutputTrack = pIter ? *(*pIter)++ : nullptr;
-            MyTransformer transformer{ *this, pOutputTrack.get(),
-               !mSettings.mDoProfile, inWindowType, outWindowType,
+            MyTransformer transformer{ *this, nullptr,
+               false, inWindowType, outWindowType,
                mSettings.WindowSize(), mSettings.StepsPerWindow(),
-               !mSettings.mDoProfile, !mSettings.mDoProfile
+               false, false
             };
             if (!transformer
                .Process(Processor, *pChannel, mHistoryLen, start, len))
                return false;
             ++mProgressTrackCount;
          }
-         if (ppTempTrack) {
-            TrackSpectrumTransformer::PostProcess(*pFirstTrack, len);
-            constexpr auto preserveSplits = true;
-            constexpr auto merge = true;
-            track->ClearAndPaste(
-               t0, t0 + tLen, **ppTempTrack, preserveSplits, merge);
-         }
       }
    }
 
-   if (mDoProfile) {
-      if (mStatistics.mTotalWindows == 0) {
+   if (mStatistics.mTotalWindows == 0) {
+      EffectUIServices::DoMessageBox(mEffect,
+         XO("Selected noise profile is too short."));
+      return false;
+   }
+
+   return true;
+}
+
+bool EffectNoiseReduction::Worker::ReduceConcurrently(
+   eWindowFunctions inWindowType, eWindowFunctions outWindowType,
+   TrackList &tracks, double inT0, double inT1)
+{
+   struct TrackTask {
+      WaveTrack &track;
+      WaveTrack::Holder pTempTrack;
+      sampleCount start, len;
+   };
+   std::vector<TrackTask> trackTasks;
+   std::vector<TrackSpectrumTransformer::ChannelTask> channelTasks;
+
+   for (auto track : tracks.Selected<WaveTrack>()) {
+      if (track->GetRate() != mStatistics.mRate) {
          EffectUIServices::DoMessageBox(mEffect,
-            XO("Selected noise profile is too short."));
+            XO(
+"The sample rate of the noise profile must match that of the sound to be processed.") );
          return false;
       }
+
+      double trackStart = track->GetStartTime();
+      double trackEnd = track->GetEndTime();
+      double t0 = std::max(trackStart, inT0);
+      double t1 = std::min(trackEnd, inT1);
+
+      if (t1 > t0) {
+         auto start = track->TimeToLongSamples(t0);
+         auto end = track->TimeToLongSamples(t1);
+         auto pTempTrack = track->EmptyCopy();
+         auto iter = pTempTrack->Channels().begin();
+         for (const auto pChannel : track->Channels())
+            channelTasks.push_back(
+               { pChannel.get(), (*iter++).get(), start, end - start });
+         trackTasks.push_back(
+            { *track, std::move(pTempTrack), start, end - start });
+      }
+   }
+
+   const auto factory = [&](WaveChannel *pOutputTrack) {
+      return std::make_unique<MyTransformer>(*this, pOutputTrack,
+         true, inWindowType, outWindowType,
+         mSettings.WindowSize(), mSettings.StepsPerWindow(), true, true);
+   };
+   if (!TrackSpectrumTransformer::ProcessParallel(factory,
+      ConcurrentProcessor, channelTasks, mHistoryLen, mReleaseLen,
+      [this](double fraction){ return !mEffect.TotalProgress(fraction); }))
+      return false;
+
+   for (auto &task : trackTasks) {
+      auto &track = task.track;
+      TrackSpectrumTransformer::PostProcess(*task.pTempTrack, task.len);
+      constexpr auto preserveSplits = true;
+      constexpr auto merge = true;
+      const auto t0 = track.LongSamplesToTime(task.start);
+      track.ClearAndPaste(t0, t0 + track.LongSamplesToTime(task.len),
+         *task.pTempTrack, preserveSplits, merge);
    }
 
    return true;
 }
 
-void EffectNoiseReduction::Worker::ApplyFreqSmoothing(FloatVector &gains)
+void EffectNoiseReduction::Worker::ApplyFreqSmoothing(
+   FloatVector &gains, FloatVector &scratch) const
 {
    // Given an array of gain mutipliers, average them
    // GEOMETRICALLY.  Don't multiply and take nth root --
@@ -811,7 +857,7 @@ void EffectNoiseReduction::Worker::ApplyFreqSmoothing(FloatVector &gains)
    const auto spectrumSize = mSettings.SpectrumSize();
 
    {
-      auto pScratch = mFreqSmoothingScratch.data();
+      auto pScratch = scratch.data();
       std::fill(pScratch, pScratch + spectrumSize, 0.0f);
    }
 
@@ -823,13 +869,13 @@ void EffectNoiseReduction::Worker::ApplyFreqSmoothing(FloatVector &gains)
       const int j0 = std::max(0, ii - (int)mFreqSmoothingBins);
       const int j1 = std::min(spectrumSize - 1, ii + mFreqSmoothingBins);
       for(int jj = j0; jj <= j1; ++jj) {
-         mFreqSmoothingScratch[ii] += gains[jj];
+         scratch[ii] += gains[jj];
       }
-      mFreqSmoothingScratch[ii] /= (j1 - j0 + 1);
+      scratch[ii] /= (j1 - j0 + 1);
    }
 
    for (size_t ii = 0; ii < spectrumSize; ++ii)
-      gains[ii] = exp(mFreqSmoothingScratch[ii]);
+      gains[ii] = exp(scratch[ii]);
 }
 
 EffectNoiseReduction::Worker::Worker(EffectNoiseReduction &effect,
@@ -844,7 +890,6 @@ EffectNoiseReduction::Worker::Worker(EffectNoiseReduction &effect,
 , mSettings{ settings }
 , mStatistics{ statistics }
 
-, mFreqSmoothingScratch(mSettings.SpectrumSize())
 , mFreqSmoothingBins{ size_t(std::max(0.0, settings.mFreqSmoothingBands)) }
 , mBinLow{ 0 }
 , mBinHigh{ mSettings.SpectrumSize() }
@@ -880,6 +925,8 @@ EffectNoiseReduction::Worker::Worker(EffectNoiseReduction &effect,
    // Apply to gain factors which apply to amplitudes, divide by 20:
    mOneBlockAttack = DB_TO_LINEAR(noiseGain / nAttackBlocks);
    mOneBlockRelease = DB_TO_LINEAR(noiseGain / nReleaseBlocks);
+   // One more for roundoff in the repeated multiplications
+   mReleaseLen = nReleaseBlocks + 1;
    // Applies to power, divide by 10:
    mOldSensitivityFactor = pow(10.0, settings.mOldSensitivity / 10.0);
 
@@ -919,6 +966,25 @@ bool EffectNoiseReduction::Worker::Processor(SpectrumTransformer &trans)
 {
    auto &transformer = static_cast<MyTransformer &>(trans);
    auto &worker = transformer.mWorker;
+   worker.ProcessWindow(transformer);
+
+   // Update the Progress meter, let user cancel
+   return !worker.mEffect.TrackProgress(worker.mProgressTrackCount,
+      std::min(1.0,
+         ((++worker.mProgressWindowCount).as_double() *
+          worker.mSettings.StepSize()) / worker.mLen.as_double()));
+}
+
+bool EffectNoiseReduction::Worker::ConcurrentProcessor(
+   SpectrumTransformer &trans)
+{
+   auto &transformer = static_cast<MyTransformer &>(trans);
+   transformer.mWorker.ProcessWindow(transformer);
+   return true;
+}
+
+void EffectNoiseReduction::Worker::ProcessWindow(MyTransformer &transformer)
+{
    // Compute power spectrum in the newest window
    {
       auto &record = transformer.NthWindow(0);
@@ -926,7 +992,7 @@ bool EffectNoiseReduction::Worker::Processor(SpectrumTransformer &trans)
       const double dc = record.mRealFFTs[0];
       *pSpectrum++ = dc * dc;
       float *pReal = &record.mRealFFTs[1], *pImag = &record.mImagFFTs[1];
-      for (size_t nn = worker.mSettings.SpectrumSize() - 2; nn--;) {
+      for (size_t nn = mSettings.SpectrumSize() - 2; nn--;) {
          const double re = *pReal++, im = *pImag++;
          *pSpectrum++ = re * re + im * im;
       }
@@ -934,16 +1000,10 @@ bool EffectNoiseReduction::Worker::Processor(SpectrumTransformer &trans)
       *pSpectrum = nyquist * nyquist;
    }
 
-   if (worker.mDoProfile)
-      worker.GatherStatistics(transformer);
+   if (mDoProfile)
+      GatherStatistics(transformer);
    else
-      worker.ReduceNoise(transformer);
-
-   // Update the Progress meter, let user cancel
-   return !worker.mEffect.TrackProgress(worker.mProgressTrackCount,
-      std::min(1.0,
-         ((++worker.mProgressWindowCount).as_double() *
-          worker.mSettings.StepSize()) / worker.mLen.as_double()));
+      ReduceNoise(transformer);
 }
 
 void EffectNoiseReduction::Worker::FinishTrackStatistics()
@@ -1169,7 +1229,7 @@ void EffectNoiseReduction::Worker::ReduceNoise(MyTransformer &transformer)
       if (mNoiseReductionChoice != NRC_ISOLATE_NOISE)
          // Apply frequency smoothing to output gain
          // Gains are not less than mNoiseAttenFactor
-         ApplyFreqSmoothing(record.mGains);
+         ApplyFreqSmoothing(record.mGains, transformer.mFreqSmoothingScratch);
 
       // Apply gain to FFT
       {
@@ -368,14 +368,21 @@ bool EffectNormalize::AnalyseTrackData(const WaveChannel &track,
          end - s
       );
 
-      //Get the samples from the track and put them in the buffer
-      track.GetFloats(
-         buffer.get(), s, block, FillFormat::fillZero, true, &blockSamples);
+      //Sums of whole sample blocks are cached, so that analysing the same
+      //audio again reads only the samples at the ends of the selection
+      double blockSum;
+      if (WaveChannelUtilities::GetSum(track, s, block, blockSum, &blockSamples))
+         sum += blockSum;
+      else {
+         //Get the samples from the track and put them in the buffer
+         track.GetFloats(
+            buffer.get(), s, block, FillFormat::fillZero, true, &blockSamples);
+
+         //Process the buffer.
+         sum = AnalyseDataDC(buffer.get(), block, sum);
+      }
       totalSamples += blockSamples;
 
-      //Process the buffer.
-      sum = AnalyseDataDC(buffer.get(), block, sum);
-
       //Increment s one blockfull of samples
       s += block;
 
@@ -19,6 +19,8 @@
 #include "LoadEffects.h"
 
 #include <algorithm>
+#include <random>
+#include <vector>
 
 #include <math.h>
 
@@ -31,6 +33,7 @@
 #include "Prefs.h"
 #include "SyncLock.h"
 #include "TimeWarper.h"
+#include "concurrency/ThreadPool.h"
 
 #include "WaveTrack.h"
 
@@ -42,6 +45,12 @@ const EffectParameterMethods& EffectPaulstretch::Parameters() const
    return parameters;
 }
 
+namespace {
+//! Bound on the floats of input, output, and scratch held for a batch of
+//! windows transformed concurrently
+constexpr size_t MaxBatchSamples = 1 << 24;
+}
+
 /// \brief Class that helps EffectPaulStretch.  It does the FFTs and inner loop
 /// of the effect.
 class PaulStretch
@@ -51,13 +60,30 @@ public:
    //in_bufsize is also a half of a FFT buffer (in samples)
    virtual ~PaulStretch();
 
-   void process(float *smps, size_t nsmps);
+   //! Scratch space for transform(), one for each concurrent call
+   struct Workspace {
+      explicit Workspace(size_t poolsize);
+      Floats fft_c, fft_s, fft_freq;
+   };
+
+   //! Window and transform poolsize samples of input, randomize phases, and
+   //! transform back
+   /*!
+    Does not change this, so calls with distinct workspaces may be concurrent
+    @param seed determines the random phases
+    @param[out] smps receives poolsize samples
+    */
+   void transform(const float *pool, unsigned seed, Workspace &workspace,
+      float *smps) const;
+
+   //! Make out_buf by overlapping a result of transform() with the previous
+   void overlap(const float *smps);
 
    size_t get_nsamples();//how many samples are required to be added in the pool next time
    size_t get_nsamples_for_fill();//how many samples are required to be added for a complete buffer refill (at start of the song or after seek)
 
 private:
-   void process_spectrum(float *WXUNUSED(freq)) {};
+   void process_spectrum(float *WXUNUSED(freq)) const {};
 
    const float samplerate;
    const float rap;
@@ -74,11 +100,7 @@ public:
    const size_t poolsize;//how many samples are inside the input_pool size (need to know how many samples to fill when seeking)
 
 private:
-   const Floats in_pool;//de marimea in_bufsize
-
    double remained_samples;//how many fraction of samples has remained (0..1)
-
-   const Floats fft_smps, fft_c, fft_s, fft_freq, fft_tmp;
 };
 
 //
@@ -349,11 +371,29 @@ bool EffectPaulstretch::ProcessOne(const WaveChannel &track,
 
       PaulStretch stretch(amount, stretch_buf_size, rate);
 
-      auto nget = stretch.get_nsamples_for_fill();
-
-      auto bufsize = stretch.poolsize;
-      Floats buffer0{ bufsize };
-      float *bufferptr0 = buffer0.get();
+      const auto poolsize = stretch.get_nsamples_for_fill();
+      const auto bufsize = stretch.poolsize;
+
+      // Windows are transformed concurrently in batches, then overlapped and
+      // appended in order, so memory stays bounded however long the output
+      auto &pool = audacity::concurrency::ThreadPool::Get();
+      // The first batch holds the first window twice, so take at least two
+      const auto batchSize = std::clamp<size_t>(
+         MaxBatchSamples / (5 * poolsize), 2, 2 * pool.GetThreadCount());
+      std::vector<PaulStretch::Workspace> workspaces;
+      workspaces.reserve(batchSize);
+      for (size_t ii = 0; ii < batchSize; ++ii)
+         workspaces.emplace_back(poolsize);
+      // Input windows of a batch overlap, each ending at most poolsize after
+      // the one before
+      Floats input{ batchSize * poolsize };
+      Floats results{ batchSize * poolsize };
+      // Windows end at these positions, relative to start
+      std::vector<sampleCount> ends;
+      ends.reserve(batchSize);
+
+      const unsigned seed = rand();
+      unsigned nWindows = 0;
       bool first_time = true;
 
       const auto fade_len = std::min<size_t>(100, bufsize / 2 - 1);
@@ -364,38 +404,60 @@ bool EffectPaulstretch::ProcessOne(const WaveChannel &track,
          decltype(len) s=0;
 
          while (s < len) {
-            track.GetFloats(bufferptr0, start + s, nget);
-            stretch.process(buffer0.get(), nget);
-
+            ends.clear();
             if (first_time) {
-               stretch.process(buffer0.get(), 0);
-            };
-
-            s += nget;
-
-            if (first_time){//blend the start of the selection
-               track.GetFloats(fade_track_smps.get(), start, fade_len);
-               first_time = false;
-               for (size_t i = 0; i < fade_len; i++){
-                  float fi = (float)i / (float)fade_len;
-                  stretch.out_buf[i] =
-                     stretch.out_buf[i] * fi + (1.0 - fi) * fade_track_smps[i];
-               }
+               // The first window is transformed twice, and only the second
+               // result makes output
+               s += poolsize;
+               ends.push_back(s);
+               ends.push_back(s);
             }
-            if (s >= len){//blend the end of the selection
-               track.GetFloats(fade_track_smps.get(), end - fade_len, fade_len);
-               for (size_t i = 0; i < fade_len; i++){
-                  float fi = (float)i / (float)fade_len;
-                  auto i2 = bufsize / 2 - 1 - i;
-                  stretch.out_buf[i2] =
-                     stretch.out_buf[i2] * fi + (1.0 - fi) *
-                     fade_track_smps[fade_len - 1 - i];
-               }
+            while (ends.size() < batchSize && s < len) {
+               s += stretch.get_nsamples();
+               ends.push_back(s);
             }
 
-            outputTrack.Append((samplePtr)stretch.out_buf.get(), floatSample, stretch.out_bufsize);
+            const auto inputStart = ends.front() - poolsize;
+            track.GetFloats(input.get(), start + inputStart,
+               (ends.back() - inputStart).as_size_t());
+            audacity::concurrency::ParallelFor(pool, ends.size(),
+            [&](size_t ii){
+               stretch.transform(
+                  input.get() + (ends[ii] - inputStart).as_size_t() - poolsize,
+                  seed + nWindows + ii, workspaces[ii],
+                  results.get() + ii * poolsize);
+            });
+            nWindows += ends.size();
+
+            for (size_t ii = 0; ii < ends.size(); ++ii) {
+               stretch.overlap(results.get() + ii * poolsize);
+               if (first_time) {
+                  if (ii == 0)
+                     continue;
+
+                  //blend the start of the selection
+                  track.GetFloats(fade_track_smps.get(), start, fade_len);
+                  first_time = false;
+                  for (size_t i = 0; i < fade_len; i++){
+                     float fi = (float)i / (float)fade_len;
+                     stretch.out_buf[i] =
+                        stretch.out_buf[i] * fi + (1.0 - fi) * fade_track_smps[i];
+                  }
+               }
+               if (ends[ii] >= len){//blend the end of the selection
+                  track.GetFloats(fade_track_smps.get(), end - fade_len, fade_len);
+                  for (size_t i = 0; i < fade_len; i++){
+                     float fi = (float)i / (float)fade_len;
+                     auto i2 = bufsize / 2 - 1 - i;
+                     stretch.out_buf[i2] =
+                        stretch.out_buf[i2] * fi + (1.0 - fi) *
+                        fade_track_smps[fade_len - 1 - i];
+                  }
+               }
+
+               outputTrack.Append((samplePtr)stretch.out_buf.get(), floatSample, stretch.out_bufsize);
+            }
 
-            nget = stretch.get_nsamples();
             if (TrackProgress(count,
                s.as_double() / len.as_double()
             )) {
@@ -425,13 +487,7 @@ PaulStretch::PaulStretch(float rap_, size_t in_bufsize_, float samplerate_ )
    , out_buf { out_bufsize }
    , old_out_smp_buf { out_bufsize * 2, true }
    , poolsize { in_bufsize_ * 2 }
-   , in_pool { poolsize, true }
    , remained_samples { 0.0 }
-   , fft_smps { poolsize, true }
-   , fft_c { poolsize, true }
-   , fft_s { poolsize, true }
-   , fft_freq { poolsize, true }
-   , fft_tmp { poolsize }
 {
 }
 
@@ -439,40 +495,36 @@ PaulStretch::~PaulStretch()
 {
 }
 
-void PaulStretch::process(float *smps, size_t nsmps)
+PaulStretch::Workspace::Workspace(size_t poolsize)
+   : fft_c { poolsize, true }
+   , fft_s { poolsize, true }
+   , fft_freq { poolsize, true }
 {
-   //add NEW samples to the pool
-   if ((smps != NULL) && (nsmps != 0)) {
-      if (nsmps > poolsize) {
-         nsmps = poolsize;
-      }
-      int nleft = poolsize - nsmps;
-
-      //move left the samples from the pool to make room for NEW samples
-      for (int i = 0; i < nleft; i++)
-         in_pool[i] = in_pool[i + nsmps];
+}
 
-      //add NEW samples to the pool
-      for (size_t i = 0; i < nsmps; i++)
-         in_pool[i + nleft] = smps[i];
-   }
+void PaulStretch::transform(const float *pool, unsigned seed,
+   Workspace &workspace, float *smps) const
+{
+   const auto fft_c = workspace.fft_c.get();
+   const auto fft_s = workspace.fft_s.get();
+   const auto fft_freq = workspace.fft_freq.get();
 
    //get the samples from the pool
-   for (size_t i = 0; i < poolsize; i++)
-      fft_smps[i] = in_pool[i];
-   WindowFunc(eWinFuncHann, poolsize, fft_smps.get());
+   std::copy(pool, pool + poolsize, smps);
+   WindowFunc(eWinFuncHann, poolsize, smps);
 
-   RealFFT(poolsize, fft_smps.get(), fft_c.get(), fft_s.get());
+   RealFFT(poolsize, smps, fft_c, fft_s);
 
    for (size_t i = 0; i < poolsize / 2; i++)
       fft_freq[i] = sqrt(fft_c[i] * fft_c[i] + fft_s[i] * fft_s[i]);
-   process_spectrum(fft_freq.get());
+   process_spectrum(fft_freq);
 
 
    //put randomize phases to frequencies and do a IFFT
+   std::mt19937 engine{ seed };
    float inv_2p15_2pi = 1.0 / 16384.0 * (float)M_PI;
    for (size_t i = 1; i < poolsize / 2; i++) {
-      unsigned int random = (rand()) & 0x7fff;
+      unsigned int random = engine() & 0x7fff;
       float phase = random * inv_2p15_2pi;
       float s = fft_freq[i] * sin(phase);
       float c = fft_freq[i] * cos(phase);
@@ -484,15 +536,12 @@ void PaulStretch::process(float *smps, size_t nsmps)
    fft_c[0] = fft_s[0] = 0.0;
    fft_c[poolsize / 2] = fft_s[poolsize / 2] = 0.0;
 
-   FFT(poolsize, true, fft_c.get(), fft_s.get(), fft_smps.get(), fft_tmp.get());
-
-   float max = 0.0, max2 = 0.0;
-   for (size_t i = 0; i < poolsize; i++) {
-      max = std::max(max, fabsf(fft_tmp[i]));
-      max2 = std::max(max2, fabsf(fft_smps[i]));
-   }
-
+   // The spectrum is conjugate-symmetric, so the inverse is real
+   InverseRealFFT(poolsize, fft_c, fft_s, smps);
+}
 
+void PaulStretch::overlap(const float *smps)
+{
    //make the output buffer
    float tmp = 1.0 / (float) out_bufsize * M_PI;
    float hinv_sqrt2 = 0.853553390593f;//(1.0+1.0/sqrt(2))*0.5;
@@ -505,7 +554,7 @@ void PaulStretch::process(float *smps, size_t nsmps)
 
    for (size_t i = 0; i < out_bufsize; i++) {
       float a = (0.5 + 0.5 * cos(i * tmp));
-      float out = fft_smps[i + out_bufsize] * (1.0 - a) + old_out_smp_buf[i] * a;
+      float out = smps[i + out_bufsize] * (1.0 - a) + old_out_smp_buf[i] * a;
       out_buf[i] =
          out * (hinv_sqrt2 - (1.0 - hinv_sqrt2) * cos(i * 2.0 * tmp)) *
          ampfactor;
@@ -513,7 +562,7 @@ void PaulStretch::process(float *smps, size_t nsmps)
 
    //copy the current output buffer to old buffer
    for (size_t i = 0; i < out_bufsize * 2; i++)
-      old_out_smp_buf[i] = fft_smps[i];
+      old_out_smp_buf[i] = smps[i];
 }
 
 size_t PaulStretch::get_nsamples()
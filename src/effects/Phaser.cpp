@@ -213,6 +213,11 @@ EffectType EffectPhaser::GetType() const
    return EffectTypeProcess;
 }
 
+bool EffectPhaser::ProcessesTracksConcurrently() const
+{
+   return true;
+}
+
 auto EffectPhaser::RealtimeSupport() const -> RealtimeSince
 {
    return RealtimeSince::After_3_1;
@@ -352,6 +352,11 @@ EffectType EffectReverb::GetType() const
    return EffectTypeProcess;
 }
 
+bool EffectReverb::ProcessesTracksConcurrently() const
+{
+   return true;
+}
+
 auto EffectReverb::RealtimeSupport() const -> RealtimeSince
 {
    return RealtimeSince::After_3_1;
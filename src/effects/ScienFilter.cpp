@@ -35,6 +35,7 @@ a graph for EffectScienFilter.
 #include "EffectEditor.h"
 #include "LoadEffects.h"
 
+#include <algorithm>
 #include <math.h>
 
 #include <wx/setup.h> // for wxUSE_* macros
@@ -185,33 +186,40 @@ EffectType EffectScienFilter::GetType() const
    return EffectTypeProcess;
 }
 
+// Both channels of a stereo track are filtered at once
 unsigned EffectScienFilter::GetAudioInCount() const
 {
-   return 1;
+   return 2;
 }
 
 unsigned EffectScienFilter::GetAudioOutCount() const
 {
-   return 1;
+   return 2;
 }
 
 bool EffectScienFilter::ProcessInitialize(
    EffectSettings &, double, ChannelNames chanMap)
 {
-   for (int iPair = 0; iPair < (mOrder + 1) / 2; iPair++)
+   mStereo = chanMap && chanMap[0] != ChannelNameEOL &&
+      chanMap[1] == ChannelNameFrontRight;
+   const auto nPairs = (mOrder + 1) / 2;
+   for (int iPair = 0; iPair < nPairs; iPair++)
       mpBiquad[iPair].Reset();
+   mpBiquadRight.reinit(nPairs);
+   std::copy(mpBiquad.get(), mpBiquad.get() + nPairs, mpBiquadRight.get());
    return true;
 }
 
 size_t EffectScienFilter::ProcessBlock(EffectSettings &,
    const float *const *inBlock, float *const *outBlock, size_t blockLen)
 {
-   const float *ibuf = inBlock[0];
-   for (int iPair = 0; iPair < (mOrder + 1) / 2; iPair++)
-   {
-      mpBiquad[iPair].Process(ibuf, outBlock[0], blockLen);
-      ibuf = outBlock[0];
-   }
+   // A mono track filters only the channel it has
+   if (mStereo)
+      Biquad::ProcessCascade(mpBiquad.get(), mpBiquadRight.get(),
+         (mOrder + 1) / 2, inBlock, outBlock, blockLen);
+   else
+      Biquad::ProcessCascade(mpBiquad.get(), (mOrder + 1) / 2,
+         inBlock[0], outBlock[0], blockLen);
 
    return blockLen;
 }
@@ -100,6 +100,10 @@ private:
    int mOrder;
    int mOrderIndex;
    ArrayOf<Biquad> mpBiquad;
+   //! Copy of mpBiquad, for the state of a second channel
+   ArrayOf<Biquad> mpBiquadRight;
+   //! Whether the track being processed has a second channel
+   bool mStereo{ false };
 
    double mdBMax;
    double mdBMin;
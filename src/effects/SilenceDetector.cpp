@@ -0,0 +1,149 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  SilenceDetector.cpp
+
+**********************************************************************/
+#include "SilenceDetector.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include "MemoryX.h"
+#include "WaveChannelUtilities.h"
+#include "WaveTrack.h"
+#include "concurrency/ThreadPool.h"
+
+namespace {
+//! Approximate length of the pieces tracks are cut into
+constexpr size_t ChunkSize = 1 << 22;
+
+struct Job {
+   size_t iTrack;
+   sampleCount start, end;
+   //! Runs within [start, end), including any that touch either end
+   SilenceDetector::Runs runs;
+};
+
+//! Find runs in one chunk of one track
+bool Analyze(const WaveTrack &track, double threshold, Job &job,
+   const std::atomic<bool> &cancelled, std::atomic<long long> &done)
+{
+   const auto channels = track.Channels();
+   const auto nChannels = track.NChannels();
+   const auto blockLen = track.GetMaxBlockSize();
+   std::vector<Floats> buffers(nChannels);
+   for (auto &buffer : buffers)
+      buffer.reinit(blockLen);
+
+   // Start of the current run, or negative
+   sampleCount runStart = -1;
+   auto s = job.start;
+   while (s < job.end) {
+      if (cancelled.load(std::memory_order_relaxed))
+         return false;
+
+      // Stop at sample block boundaries, so that summaries of whole blocks
+      // answer for spans
+      const auto span = limitSampleBufferSize(
+         std::min(track.GetBestBlockSize(s), blockLen), job.end - s);
+      const auto t0 = track.LongSamplesToTime(s);
+      const auto t1 = track.LongSamplesToTime(s + span);
+      const bool quiet = std::all_of(channels.begin(), channels.end(),
+      [&](const auto &pChannel){
+         const auto [min, max] =
+            WaveChannelUtilities::GetMinMax(*pChannel, t0, t1);
+         return -threshold < min && max < threshold;
+      });
+
+      if (quiet) {
+         if (runStart < 0)
+            runStart = s;
+      }
+      else {
+         size_t iChannel = 0;
+         for (const auto pChannel : channels)
+            pChannel->GetFloats(buffers[iChannel++].get(), s, span);
+         for (size_t ii = 0; ii < span; ++ii) {
+            const bool silent = std::all_of(buffers.begin(), buffers.end(),
+            [&](const Floats &buffer){
+               return fabs(buffer[ii]) < threshold;
+            });
+            if (silent) {
+               if (runStart < 0)
+                  runStart = s + ii;
+            }
+            else if (runStart >= 0) {
+               job.runs.push_back({ runStart, s + ii });
+               runStart = -1;
+            }
+         }
+      }
+      s += span;
+      done += span;
+   }
+   if (runStart >= 0)
+      job.runs.push_back({ runStart, job.end });
+   return true;
+}
+}
+
+bool SilenceDetector::FindSilences(
+   const std::vector<const WaveTrack *> &tracks,
+   double t0, double t1, double threshold, double minDuration,
+   const std::function<bool(double)> &progress,
+   std::vector<Runs> &results)
+{
+   using namespace audacity::concurrency;
+
+   results.clear();
+   results.resize(tracks.size());
+
+   std::vector<Job> jobs;
+   sampleCount total = 0;
+   for (size_t iTrack = 0; iTrack < tracks.size(); ++iTrack) {
+      const auto &track = *tracks[iTrack];
+      const auto start = track.TimeToLongSamples(t0);
+      const auto end = track.TimeToLongSamples(t1);
+      for (auto pos = start; pos < end; pos += ChunkSize)
+         jobs.push_back(
+            { iTrack, pos, std::min<sampleCount>(end, pos + ChunkSize) });
+      total += std::max<sampleCount>(0, end - start);
+   }
+
+   std::atomic<long long> done{ 0 };
+   const auto fraction = [&]{
+      return std::min(1.0,
+         done.load() / std::max<sampleCount>(1, total).as_double());
+   };
+
+   // Results are small, so all jobs can be queued at once
+   if (!ParallelFor(ThreadPool::Get(), jobs.size(), jobs.size(),
+      [&](size_t iJob, const std::atomic<bool> &cancelled){
+         auto &job = jobs[iJob];
+         return Analyze(*tracks[job.iTrack], threshold, job, cancelled, done);
+      },
+      [&]{ return progress(fraction()); }))
+      return false;
+
+   // Join runs across chunk boundaries, and drop short runs
+   for (auto &job : jobs) {
+      auto &runs = results[job.iTrack];
+      auto first = job.runs.begin();
+      if (first != job.runs.end() &&
+          !runs.empty() && runs.back().end == first->start)
+         runs.back().end = (first++)->end;
+      runs.insert(runs.end(), first, job.runs.end());
+   }
+   for (size_t iTrack = 0; iTrack < tracks.size(); ++iTrack) {
+      const auto minLength =
+         sampleCount(minDuration * tracks[iTrack]->GetRate());
+      auto &runs = results[iTrack];
+      runs.erase(std::remove_if(runs.begin(), runs.end(),
+         [&](const Run &run){ return run.end - run.start < minLength; }),
+         runs.end());
+   }
+   return true;
+}
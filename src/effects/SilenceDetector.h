@@ -0,0 +1,52 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  SilenceDetector.h
+
+**********************************************************************/
+#ifndef __AUDACITY_SILENCE_DETECTOR__
+#define __AUDACITY_SILENCE_DETECTOR__
+
+#include <functional>
+#include <vector>
+#include "SampleCount.h"
+
+class WaveTrack;
+
+//! Finds runs of samples where every channel of a track is below a threshold
+namespace SilenceDetector {
+
+//! Half-open range of sample positions of a track
+struct Run {
+   sampleCount start;
+   sampleCount end;
+};
+using Runs = std::vector<Run>;
+
+//! Find silences in several tracks at once, on the shared thread pool
+/*!
+ Each track is cut into chunks, analysed concurrently; runs crossing the
+ boundaries of chunks are joined.  Spans of sample blocks whose min/max
+ summaries are below the threshold are taken as silent without reading them.
+
+ A sample is silent when its magnitude in every channel is less than
+ `threshold`.
+
+ @param t0, t1 the time range to search in every track
+ @param minDuration runs shorter than this many seconds (rounded down to
+ samples at each track's rate) are omitted
+ @param progress called on the calling thread with the fraction done;
+ returns false to cancel
+ @param[out] results for each track, its silent runs in increasing order
+ @return false if cancelled
+ */
+bool FindSilences(const std::vector<const WaveTrack *> &tracks,
+   double t0, double t1, double threshold, double minDuration,
+   const std::function<bool(double)> &progress,
+   std::vector<Runs> &results);
+
+}
+
+#endif
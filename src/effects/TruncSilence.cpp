@@ -19,6 +19,7 @@
 #include "EffectEditor.h"
 #include "EffectOutputTracks.h"
 #include "LoadEffects.h"
+#include "SilenceDetector.h"
 
 #include <algorithm>
 #include <list>
@@ -278,13 +279,19 @@ bool EffectTruncSilence::ProcessIndependently()
    };
    double newT1 = 0.0;
 
+   // Each group has one selected track, not changed by removals from other
+   // groups, so detect the silences of all of them at once
+   std::vector<RegionList> trackSilences;
+   if (!DetectSilences(trackSilences,
+      outputs.Get().Selected<const WaveTrack>()))
+      return false;
+
    {
       unsigned iGroup = 0;
       for (auto track : outputs.Get().Selected<WaveTrack>()) {
          RegionList silences;
-         if (!FindSilences(silences,
-            TrackList::SingletonRange(&as_const(*track))))
-            return false;
+         silences.push_back(Region(mT0, mT1));
+         Intersect(silences, trackSilences[iGroup]);
          // Treat tracks in the sync lock group only
          Track *groupFirst, *groupLast;
          auto range = syncLock
@@ -331,49 +338,45 @@ bool EffectTruncSilence::ProcessAll()
    return false;
 }
 
+bool EffectTruncSilence::DetectSilences(std::vector<RegionList> &trackSilences,
+   const TrackIterRange<const WaveTrack> &range)
+{
+   std::vector<const WaveTrack *> tracks;
+   for (auto wt : range)
+      tracks.push_back(wt);
+
+   // Smallest silent region to detect
+   const auto minSilence = std::max(mInitialAllowedSilence, DEF_MinTruncMs);
+   std::vector<SilenceDetector::Runs> runs;
+   if (!SilenceDetector::FindSilences(tracks, mT0, mT1,
+      DB_TO_LINEAR(mThresholdDB), minSilence,
+      [this](double frac){ return !TotalProgress(detectFrac * frac); },
+      runs))
+      return false;
+
+   trackSilences.resize(tracks.size());
+   for (size_t ii = 0; ii < tracks.size(); ++ii)
+      for (const auto &run : runs[ii])
+         trackSilences[ii].push_back(Region(
+            tracks[ii]->LongSamplesToTime(run.start),
+            tracks[ii]->LongSamplesToTime(run.end)
+         ));
+   return true;
+}
+
 bool EffectTruncSilence::FindSilences(RegionList &silences,
    const TrackIterRange<const WaveTrack> &range)
 {
    // Start with the whole selection silent
    silences.push_back(Region(mT0, mT1));
 
-   // Remove non-silent regions in each track
-   int whichTrack = 0;
-   for (auto wt : range) {
-      // Smallest silent region to detect in frames
-      auto minSilenceFrames =
-         sampleCount(std::max(mInitialAllowedSilence, DEF_MinTruncMs)
-            * wt->GetRate());
-
-      //
-      // Scan the track for silences
-      //
-      RegionList trackSilences;
-
-      auto index = wt->TimeToLongSamples(mT0);
-      sampleCount silentFrame = 0;
-
-      // Detect silences
-      bool cancelled = !(Analyze(
-         silences, trackSilences, *wt, &silentFrame, &index, whichTrack));
-
-      // Buffer has been freed, so we're OK to return if cancelled
-      if (cancelled)
-         return false;
-
-      if (silentFrame >= minSilenceFrames)
-      {
-         // Track ended in silence -- record region
-         trackSilences.push_back(Region(
-            wt->LongSamplesToTime(index - silentFrame),
-            wt->LongSamplesToTime(index)
-         ));
-      }
+   std::vector<RegionList> trackSilences;
+   if (!DetectSilences(trackSilences, range))
+      return false;
 
-      // Intersect with the overall silent region list
-      Intersect(silences, trackSilences);
-      whichTrack++;
-   }
+   // Remove non-silent regions in each track
+   for (const auto &regions : trackSilences)
+      Intersect(silences, regions);
 
    return true;
 }
@@ -20,6 +20,7 @@
 #include "StatefulEffect.h"
 #include "ShuttleAutomation.h"
 #include "Track.h"
+#include <vector>
 #include <wx/weakref.h>
 
 class ShuttleGui;
@@ -85,6 +86,10 @@ private:
 
    bool ProcessIndependently();
    bool ProcessAll();
+   //! Silences of each track, found concurrently
+   bool DetectSilences(std::vector<RegionList> &trackSilences,
+      const TrackIterRange<const WaveTrack> &range);
+   //! Silences common to all tracks
    bool FindSilences(RegionList &silences,
       const TrackIterRange<const WaveTrack> &range);
    bool DoRemoval(const RegionList &silences,
@@ -205,6 +205,11 @@ EffectType EffectWahwah::GetType() const
    return EffectTypeProcess;
 }
 
+bool EffectWahwah::ProcessesTracksConcurrently() const
+{
+   return true;
+}
+
 auto EffectWahwah::RealtimeSupport() const -> RealtimeSince
 {
    return RealtimeSince::After_3_1;
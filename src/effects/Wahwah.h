@@ -87,6 +87,7 @@ public:
    // EffectDefinitionInterface implementation
 
    EffectType GetType() const override;
+   bool ProcessesTracksConcurrently() const override;
    RealtimeSince RealtimeSupport() const override;
 
    // Effect implementation
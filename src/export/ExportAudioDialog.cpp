@@ -12,11 +12,15 @@
 
 #include "ExportAudioDialog.h"
 
+#include <algorithm>
 #include <numeric>
+#include <optional>
+#include <thread>
 
 #include <wx/frame.h>
 
 #include "Export.h"
+#include "ExportChunkQueue.h"
 #include "ExportUtils.h"
 #include "WaveTrack.h"
 #include "LabelTrack.h"
@@ -863,42 +867,120 @@ void ExportAudioDialog::UpdateTrackExportSettings(const ExportPlugin& plugin, in
    std::swap(mExportSettings, exportSettings);
 }
 
+namespace
+{
+// How much memory the exports of multiple files may take together
+constexpr size_t ConcurrentExportMemoryBudget = 512 * 1024 * 1024;
+// Mixers and encoders buffer a few seconds of audio at most
+constexpr size_t BufferedSecondsPerExport = 10;
+
+size_t GetMaxConcurrentExports(unsigned channels, double sampleRate)
+{
+   // Exporters that encode in chunks each hold one chunk being filled and one
+   // being encoded, and all of them share a budget of more pending chunks
+   const auto chunkBytes =
+      channels * ExportChunkBudget::MaxChunkSamples * sizeof(float);
+   const auto sharedChunkBytes = ExportChunkBudget::Capacity() * chunkBytes;
+   const auto budget = ConcurrentExportMemoryBudget > sharedChunkBytes
+      ? ConcurrentExportMemoryBudget - sharedChunkBytes : 0;
+   const auto perExport = std::max<size_t>(1,
+      channels * size_t(sampleRate) * sizeof(float) * BufferedSecondsPerExport
+         + 2 * chunkBytes);
+   const auto cores = std::max(1u, std::thread::hardware_concurrency());
+   return std::clamp<size_t>(budget / perExport, 1, cores);
+}
+
+///\brief Chooses the name of one of the files, backing up any file it
+///replaces, which is restored unless the export succeeds
+class ExportedFile final
+{
+public:
+   ExportedFile(const wxFileName& filename, bool overwrite,
+                const FilePaths& reserved)
+   {
+      wxFileName name;
+      if (overwrite) {
+         name = filename;
+         mBackup.Assign(name);
+
+         int suffix = 0;
+         do {
+            mBackup.SetName(name.GetName() +
+                              wxString::Format(wxT("%d"), suffix));
+            ++suffix;
+         }
+         while (mBackup.FileExists());
+         ::wxRenameFile(filename.GetFullPath(), mBackup.GetFullPath());
+      }
+      else {
+         name = filename;
+         int i = 2;
+         wxString base(name.GetName());
+         while (name.FileExists() ||
+            make_iterator_range(reserved).contains(name.GetFullPath())) {
+            name.SetName(wxString::Format(wxT("%s-%d"), base, i++));
+         }
+      }
+      mFullPath = name.GetFullPath();
+   }
+
+   ExportedFile(const ExportedFile&) = delete;
+   ExportedFile& operator=(const ExportedFile&) = delete;
+
+   ~ExportedFile()
+   {
+      if (!mFinished)
+         Finish(false);
+   }
+
+   const wxString& GetFullPath() const
+   {
+      return mFullPath;
+   }
+
+   void Finish(bool success)
+   {
+      mFinished = true;
+      if (mBackup.IsOk()) {
+         if ( success )
+            // Remove backup
+            ::wxRemoveFile(mBackup.GetFullPath());
+         else {
+            // Restore original
+            ::wxRemoveFile(mFullPath);
+            ::wxRenameFile(mBackup.GetFullPath(), mFullPath);
+         }
+      }
+      else {
+         if ( ! success )
+            // Remove any new, and only partially written, file.
+            ::wxRemoveFile(mFullPath);
+      }
+   }
+
+private:
+   wxFileName mBackup;
+   wxString mFullPath;
+   bool mFinished{ false };
+};
+}
+
 ExportResult ExportAudioDialog::DoExportSplitByLabels(const ExportPlugin& plugin,
                                                       int formatIndex,
                                                       const ExportProcessor::Parameters& parameters,
                                                       FilePaths& exporterFiles)
 {
-   auto ok = ExportResult::Success;   // did it work?
-   /* Go round again and do the exporting (so this run is slow but
-    * non-interactive) */
+   std::vector<ExportJob> jobs;
    for(auto& activeSetting : mExportSettings)
    {
       /* get the settings to use for the export from the array */
       // Bug 1440 fix.
       if( activeSetting.filename.GetName().empty() )
          continue;
-
-      // Export it
-      ok = DoExport(plugin, formatIndex, parameters, activeSetting.filename, activeSetting.channels,
-         activeSetting.t0, activeSetting.t1, false, activeSetting.tags, exporterFiles);
-      
-      if (ok == ExportResult::Stopped) {
-         AudacityMessageDialog dlgMessage(
-            nullptr,
-            XO("Continue to export remaining files?"),
-            XO("Export"),
-            wxYES_NO | wxNO_DEFAULT | wxICON_WARNING);
-         if (dlgMessage.ShowModal() != wxID_YES ) {
-            // User decided not to continue - bail out!
-            break;
-         }
-      }
-      else if (ok != ExportResult::Success) {
-         break;
-      }
+      jobs.push_back({ &activeSetting, nullptr });
    }
 
-   return ok;
+   return DoExport(plugin, formatIndex, parameters, jobs, exporterFiles);
 }
 
 ExportResult ExportAudioDialog::DoExportSplitByTracks(const ExportPlugin& plugin,
@@ -921,131 +1003,111 @@ ExportResult ExportAudioDialog::DoExportSplitByTracks(const ExportPlugin& plugin
    for (auto tr : tracks.Selected<WaveTrack>())
       tr->SetSelected(false);
 
-   auto ok = ExportResult::Success;
-
+   std::vector<ExportJob> jobs;
    int count = 0;
    for (auto tr : waveTracks) {
 
       wxLogDebug( "Get setting %i", count );
       /* get the settings to use for the export from the array */
       auto& activeSetting = mExportSettings[count];
-      if( activeSetting.filename.GetName().empty() ){
-         count++;
-         continue;
-      }
-
-      /* Select the track */
-      SelectionStateChanger changer2{ selectionState, tracks };
-      tr->SetSelected(true);
-
-      // Export the data. "channels" are per track.
-      ok = DoExport(plugin, formatIndex, parameters, activeSetting.filename, activeSetting.channels,
-         activeSetting.t0, activeSetting.t1, true, activeSetting.tags, exporterFiles);
-      
-      if (ok == ExportResult::Stopped) {
-         AudacityMessageDialog dlgMessage(
-            nullptr,
-            XO("Continue to export remaining files?"),
-            XO("Export"),
-            wxYES_NO | wxNO_DEFAULT | wxICON_WARNING);
-         if (dlgMessage.ShowModal() != wxID_YES ) {
-            // User decided not to continue - bail out!
-            break;
-         }
-      }
-      
-      else if (ok != ExportResult::Success) {
-         break;
-      }
       // increment export counter
       count++;
+      if( activeSetting.filename.GetName().empty() )
+         continue;
+      jobs.push_back({ &activeSetting, tr });
    }
-   
-   
-   return ok ;
+
+   return DoExport(plugin, formatIndex, parameters, jobs, exporterFiles);
 }
 
 ExportResult ExportAudioDialog::DoExport(const ExportPlugin& plugin,
                                          int formatIndex,
                                          const ExportProcessor::Parameters& parameters,
-                                         const wxFileName& filename,
-                                         int channels,
-                                         double t0, double t1, bool selectedOnly,
-                                         const Tags& tags,
+                                         const std::vector<ExportJob>& jobs,
                                          FilePaths& exportedFiles)
 {
-   wxFileName name;
+   auto& tracks = TrackList::Get(mProject);
+   auto& selectionState = SelectionState::Get( mProject );
+   const auto sampleRate = mExportOptionsPanel->GetSampleRate();
+   const auto overwrite = mOverwriteExisting->GetValue();
+
+   unsigned channels = 1;
+   for (auto& job : jobs)
+      channels = std::max(channels, job.setting->channels);
+   const auto maxConcurrent = GetMaxConcurrentExports(channels, sampleRate);
+
+   // Names given to files that might not be written yet
+   FilePaths reserved;
+
+   auto result = ExportResult::Success;
+   size_t begin = 0;
+   while (begin < jobs.size()) {
+      const auto count = jobs.size() - begin;
+      std::vector<std::optional<ExportedFile>> files(count);
+      std::vector<bool> succeeded(count);
+      size_t made = 0;
+
+      result = ExportProgressUI::ShowConcurrent(count, maxConcurrent,
+         [&](size_t i)
+         {
+            const auto& job = jobs[begin + i];
+            const auto& setting = *job.setting;
+            const auto selectedOnly = job.track != nullptr;
+            ++made;
+
+            wxLogDebug(wxT("Doing multiple Export: File name \"%s\""), (setting.filename.GetFullName()));
+            wxLogDebug(wxT("Channels: %i, Start: %lf, End: %lf "), setting.channels, setting.t0, setting.t1);
+            if (selectedOnly)
+               wxLogDebug(wxT("Selected Region Only"));
+            else
+               wxLogDebug(wxT("Whole Project"));
 
-   wxLogDebug(wxT("Doing multiple Export: File name \"%s\""), (filename.GetFullName()));
-   wxLogDebug(wxT("Channels: %i, Start: %lf, End: %lf "), channels, t0, t1);
-   if (selectedOnly)
-      wxLogDebug(wxT("Selected Region Only"));
-   else
-      wxLogDebug(wxT("Whole Project"));
-
-   wxFileName backup;
-   if (mOverwriteExisting->GetValue()) {
-      name = filename;
-      backup.Assign(name);
-
-      int suffix = 0;
-      do {
-         backup.SetName(name.GetName() +
-                           wxString::Format(wxT("%d"), suffix));
-         ++suffix;
-      }
-      while (backup.FileExists());
-      ::wxRenameFile(filename.GetFullPath(), backup.GetFullPath());
-   }
-   else {
-      name = filename;
-      int i = 2;
-      wxString base(name.GetName());
-      while (name.FileExists()) {
-         name.SetName(wxString::Format(wxT("%s-%d"), base, i++));
-      }
-   }
+            auto& file = files[i].emplace(setting.filename, overwrite, reserved);
+            reserved.push_back(file.GetFullPath());
 
-   bool success{false};
-   const wxString fullPath{name.GetFullPath()};
+            /* Select the track */
+            std::optional<SelectionStateChanger> changer;
+            if (selectedOnly) {
+               changer.emplace(selectionState, tracks);
+               job.track->SetSelected(true);
+            }
 
-   auto cleanup = finally( [&] {
-      if (backup.IsOk()) {
-         if ( success )
-            // Remove backup
-            ::wxRemoveFile(backup.GetFullPath());
-         else {
-            // Restore original
-            ::wxRemoveFile(fullPath);
-            ::wxRenameFile(backup.GetFullPath(), fullPath);
-         }
-      }
-      else {
-         if ( ! success )
-            // Remove any new, and only partially written, file.
-            ::wxRemoveFile(fullPath);
+            // Export the data. "channels" are per track.
+            return ExportTaskBuilder{}.SetPlugin(&plugin, formatIndex)
+               .SetParameters(parameters)
+               .SetRange(setting.t0, setting.t1, selectedOnly)
+               .SetTags(&setting.tags)
+               .SetNumChannels(setting.channels)
+               .SetFileName(file.GetFullPath())
+               .SetSampleRate(sampleRate)
+               .Build(mProject);
+         },
+         [&](size_t i, ExportResult taskResult)
+         {
+            succeeded[i] =
+               taskResult == ExportResult::Success || taskResult == ExportResult::Stopped;
+            if (files[i])
+               files[i]->Finish(succeeded[i]);
+         });
+
+      // List the files in order, though they may finish in any order
+      for (size_t i = 0; i < made; ++i)
+         if (succeeded[i])
+            exportedFiles.push_back(files[i]->GetFullPath());
+      begin += made;
+
+      if (result != ExportResult::Stopped || begin == jobs.size())
+         break;
+      AudacityMessageDialog dlgMessage(
+         nullptr,
+         XO("Continue to export remaining files?"),
+         XO("Export"),
+         wxYES_NO | wxNO_DEFAULT | wxICON_WARNING);
+      if (dlgMessage.ShowModal() != wxID_YES ) {
+         // User decided not to continue - bail out!
+         break;
       }
-   } );
-   
-   auto result = ExportResult::Error;
-   ExportProgressUI::ExceptionWrappedCall([&]
-   {
-      result = ExportProgressUI::Show(ExportTaskBuilder{}.SetPlugin(&plugin, formatIndex)
-                                    .SetParameters(parameters)
-                                    .SetRange(t0, t1, selectedOnly)
-                                    .SetTags(&tags)
-                                    .SetNumChannels(channels)
-                                    .SetFileName(fullPath)
-                                    .SetSampleRate(mExportOptionsPanel->GetSampleRate())
-                                    .Build(mProject));
-   });
-
-   success = result == ExportResult::Success || result == ExportResult::Stopped;
-
-   if(success)
-      exportedFiles.push_back(fullPath);
-   
+   }
+
    return result;
 }
-
-
@@ -20,6 +20,7 @@
 class ExportFilePanel;
 class AudacityProject;
 class ShuttleGui;
+class WaveTrack;
 
 class Exporter;
 class ExportPlugin;
@@ -51,6 +52,13 @@ class ExportAudioDialog final : public wxDialogWrapper
       Tags tags; /**< The set of metadata to use for the export */
    };
 
+   ///\brief One file of a split export
+   struct ExportJob
+   {
+      const ExportSetting* setting;
+      WaveTrack* track; /**< The only track to export, or null for all */
+   };
+
 public:
    ExportAudioDialog(wxWindow* parent,
                      AudacityProject& project,
@@ -95,13 +103,11 @@ private:
                                       const ExportProcessor::Parameters& parameters,
                                       FilePaths& exporterFiles);
    
+   ///\brief Exports the jobs in order, several at once
    ExportResult DoExport(const ExportPlugin& plugin,
                          int formatIndex,
                          const ExportProcessor::Parameters& parameters,
-                         const wxFileName& filename,
-                         int channels,
-                         double t0, double t1, bool selectedOnly,
-                         const Tags& tags,
+                         const std::vector<ExportJob>& jobs,
                          FilePaths& exportedFiles);
    
    AudacityProject& mProject;
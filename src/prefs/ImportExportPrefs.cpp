@@ -22,6 +22,7 @@
 #include <wx/statbox.h>
 #include <wx/stattext.h>
 
+#include "Import.h"
 #include "NoteTrack.h"
 #include "Prefs.h"
 #include "ShuttleGui.h"
@@ -129,6 +130,14 @@ void ImportExportPrefs::PopulateOrExchange(ShuttleGui & S)
       &top, &PopulatorItem::Registry());
 
 
+   S.StartStatic(XO("Uncompressed Imports"));
+   {
+      S.TieCheckBox(
+         XXO("&Read WAV and AIFF files in place, copying their audio into the project later"),
+         DeferPCMImport);
+   }
+   S.EndStatic();
+
    auto musicImportsBox = S.StartStatic(XO("Music Imports"));
    {
       const auto header = S.AddVariableText(
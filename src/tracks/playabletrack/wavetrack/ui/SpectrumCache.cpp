@@ -12,6 +12,7 @@
 
 #include "../../../../prefs/SpectrogramSettings.h"
 #include "RealFFTf.h"
+#include "RealFFTfBatch.h"
 #include "Sequence.h"
 #include "Spectrum.h"
 #include "WaveClipUIUtilities.h"
@@ -21,18 +22,11 @@
 
 namespace {
 
-static void ComputeSpectrumUsingRealFFTf
-   (float * __restrict buffer, const FFTParam *hFFT,
-    const float * __restrict window, size_t len, float * __restrict out)
+static void ComputePowerDBFromRealFFTf
+   (const float * __restrict buffer, const FFTParam *hFFT,
+    float * __restrict out)
 {
    size_t i;
-   if(len > hFFT->Points * 2)
-      len = hFFT->Points * 2;
-   for(i = 0; i < len; i++)
-      buffer[i] *= window[i];
-   for( ; i < (hFFT->Points * 2); i++)
-      buffer[i] = 0; // zero pad as needed
-   RealFFTf(buffer, hFFT);
    // Handle the (real-only) DC
    float power = buffer[0] * buffer[0];
    if(power <= 0)
@@ -50,6 +44,21 @@ static void ComputeSpectrumUsingRealFFTf
    }
 }
 
+static void ComputeSpectrumUsingRealFFTf
+   (float * __restrict buffer, const FFTParam *hFFT,
+    const float * __restrict window, size_t len, float * __restrict out)
+{
+   size_t i;
+   if(len > hFFT->Points * 2)
+      len = hFFT->Points * 2;
+   for(i = 0; i < len; i++)
+      buffer[i] *= window[i];
+   for( ; i < (hFFT->Points * 2); i++)
+      buffer[i] = 0; // zero pad as needed
+   RealFFTf(buffer, hFFT);
+   ComputePowerDBFromRealFFTf(buffer, hFFT, out);
+}
+
 void ComputeSpectrogramGainFactors
    (size_t fftLen, double rate, int frequencyGain, std::vector<float> &gainFactors)
 {
@@ -91,15 +100,10 @@ bool SpecCache::Matches(
       algorithm == settings.algorithm;
 }
 
-bool SpecCache::CalculateOneSpectrum(
+bool SpecCache::FillColumnSamples(
    const SpectrogramSettings& settings, const WaveChannelInterval& clip,
-   const int xx, double pixelsPerSecond, int lowerBoundX, int upperBoundX,
-   const std::vector<float>& gainFactors, float* __restrict scratch,
-   float* __restrict out) const
+   const int xx, double pixelsPerSecond, float* __restrict scratch) const
 {
-   bool result = false;
-   const bool reassignment =
-      (settings.algorithm == SpectrogramSettings::algReassignment);
    const size_t windowSizeSetting = settings.WindowSize();
 
    sampleCount from;
@@ -119,14 +123,64 @@ bool SpecCache::CalculateOneSpectrum(
    else
       from = where[xx];
 
+   if (from < 0 || from >= numSamples)
+      return false;
+
+   const size_t zeroPaddingFactorSetting = settings.ZeroPaddingFactor();
+   const size_t padding = (windowSizeSetting * (zeroPaddingFactorSetting - 1)) / 2;
+   float *adj = scratch + padding;
+
+   auto myLen = windowSizeSetting;
+   // Take a window of the track centered at this sample.
+   from -= windowSizeSetting >> 1;
+   if (from < 0) {
+      // Near the start of the clip, pad left with zeroes as needed.
+      // from is at least -windowSize / 2
+      for (auto ii = from; ii < 0; ++ii)
+         *adj++ = 0;
+      myLen += from.as_long_long(); // add a negative
+      from = 0;
+   }
+
+   if (from + myLen >= numSamples) {
+      // Near the end of the clip, pad right with zeroes as needed.
+      // newlen is bounded by myLen:
+      auto newlen = ( numSamples - from ).as_size_t();
+      for (decltype(myLen) ii = newlen; ii < myLen; ++ii)
+         adj[ii] = 0;
+      myLen = newlen;
+   }
+
+   if (myLen > 0) {
+      constexpr auto mayThrow = false; // Don't throw just for display
+      mSampleCacheHolder.emplace(
+         clip.GetSampleView(from, myLen, mayThrow));
+      mSampleCacheHolder->Copy(adj, myLen);
+   }
+
+   return true;
+}
+
+bool SpecCache::CalculateOneSpectrum(
+   const SpectrogramSettings& settings, const WaveChannelInterval& clip,
+   const int xx, double pixelsPerSecond, int lowerBoundX, int upperBoundX,
+   const std::vector<float>& gainFactors, float* __restrict scratch,
+   float* __restrict out) const
+{
+   bool result = false;
+   const bool reassignment =
+      (settings.algorithm == SpectrogramSettings::algReassignment);
+   const size_t windowSizeSetting = settings.WindowSize();
+
+   const auto sampleRate = clip.GetRate();
+
    const bool autocorrelation =
       settings.algorithm == SpectrogramSettings::algPitchEAC;
    const size_t zeroPaddingFactorSetting = settings.ZeroPaddingFactor();
-   const size_t padding = (windowSizeSetting * (zeroPaddingFactorSetting - 1)) / 2;
    const size_t fftLen = windowSizeSetting * zeroPaddingFactorSetting;
    auto nBins = settings.NBins();
 
-   if (from < 0 || from >= numSamples) {
+   if (!FillColumnSamples(settings, clip, xx, pixelsPerSecond, scratch)) {
       if (xx >= 0 && xx < (int)len) {
          // Pixel column is out of bounds of the clip!  Should not happen.
          float *const results = &out[nBins * xx];
@@ -134,57 +188,7 @@ bool SpecCache::CalculateOneSpectrum(
       }
    }
    else {
-
-
-      // We can avoid copying memory when ComputeSpectrum is used below
-      bool copy = !autocorrelation || (padding > 0) || reassignment;
-      std::vector<float> floats;
-      float* useBuffer = 0;
-      float *adj = scratch + padding;
-
-      {
-         auto myLen = windowSizeSetting;
-         // Take a window of the track centered at this sample.
-         from -= windowSizeSetting >> 1;
-         if (from < 0) {
-            // Near the start of the clip, pad left with zeroes as needed.
-            // from is at least -windowSize / 2
-            for (auto ii = from; ii < 0; ++ii)
-               *adj++ = 0;
-            myLen += from.as_long_long(); // add a negative
-            from = 0;
-            copy = true;
-         }
-
-         if (from + myLen >= numSamples) {
-            // Near the end of the clip, pad right with zeroes as needed.
-            // newlen is bounded by myLen:
-            auto newlen = ( numSamples - from ).as_size_t();
-            for (decltype(myLen) ii = newlen; ii < myLen; ++ii)
-               adj[ii] = 0;
-            myLen = newlen;
-            copy = true;
-         }
-
-         if (myLen > 0) {
-            constexpr auto iChannel = 0u;
-            constexpr auto mayThrow = false; // Don't throw just for display
-            mSampleCacheHolder.emplace(
-               clip.GetSampleView(from, myLen, mayThrow));
-            floats.resize(myLen);
-            mSampleCacheHolder->Copy(floats.data(), myLen);
-            useBuffer = floats.data();
-            if (copy) {
-               if (useBuffer)
-                  memcpy(adj, useBuffer, myLen * sizeof(float));
-               else
-                  memset(adj, 0, myLen * sizeof(float));
-            }
-         }
-      }
-
-      if (copy || !useBuffer)
-         useBuffer = scratch;
+      float* useBuffer = scratch;
 
       if (autocorrelation) {
          // not reassignment, xx is surely within bounds.
@@ -315,6 +319,57 @@ bool SpecCache::CalculateOneSpectrum(
    return result;
 }
 
+void SpecCache::CalculateSpectra(
+   const SpectrogramSettings& settings, const WaveChannelInterval& clip,
+   int lowerBoundX, int upperBoundX, double pixelsPerSecond,
+   const std::vector<float>& gainFactors, float* __restrict out) const
+{
+   // Columns to transform together
+   constexpr size_t BatchSize = 16;
+
+   const auto hFFT = settings.hFFT.get();
+   const size_t fftLen = hFFT->Points * 2;
+   const auto nBins = settings.NBins();
+   RealFFTfBatch batch{ fftLen, settings.window.get() };
+
+   // Frames are never written in the zero padding zones, where the window
+   // is also zero
+   std::vector<float> frames(BatchSize * fftLen);
+   std::vector<float> spectra(BatchSize * fftLen);
+   const float *inputs[BatchSize];
+   float *outputs[BatchSize];
+   int columns[BatchSize];
+
+   for (auto xx = lowerBoundX; xx < upperBoundX;) {
+      size_t nFrames = 0;
+      for (; xx < upperBoundX && nFrames < BatchSize; ++xx) {
+         const auto frame = &frames[nFrames * fftLen];
+         if (!FillColumnSamples(settings, clip, xx, pixelsPerSecond, frame)) {
+            // Pixel column is out of bounds of the clip!  Should not happen.
+            float *const results = &out[nBins * xx];
+            std::fill(results, results + nBins, 0.0f);
+            continue;
+         }
+         inputs[nFrames] = frame;
+         outputs[nFrames] = &spectra[nFrames * fftLen];
+         columns[nFrames] = xx;
+         ++nFrames;
+      }
+
+      batch.Forward(inputs, outputs, nFrames);
+
+      for (size_t ii = 0; ii < nFrames; ++ii) {
+         float *const results = &out[nBins * columns[ii]];
+         ComputePowerDBFromRealFFTf(outputs[ii], hFFT, results);
+         if (!gainFactors.empty()) {
+            // Apply a frequency-dependent gain factor
+            for (size_t jj = 0; jj < nBins; ++jj)
+               results[jj] += gainFactors[jj];
+         }
+      }
+   }
+}
+
 void SpecCache::Grow(
    size_t len_, SpectrogramSettings& settings, double samplesPerPixel,
    double start_)
@@ -372,6 +427,12 @@ void SpecCache::Populate(
       const int lowerBoundX = jj == 0 ? 0 : copyEnd;
       const int upperBoundX = jj == 0 ? copyBegin : numPixels;
 
+      if (!autocorrelation && !reassignment) {
+         CalculateSpectra(settings, clip, lowerBoundX, upperBoundX,
+            pixelsPerSecond, gainFactors, &freq[0]);
+         continue;
+      }
+
 // todo(mhodgkinson): I don't find an option to define _OPENMP anywhere. Is this
 // still of interest?
 #ifdef _OPENMP
@@ -71,6 +71,13 @@ public:
    int          dirty;
 
 private:
+   // Copy the samples for one column into scratch, after any zero padding
+   // zone, and padded with zeroes beyond the ends of the clip
+   // Returns false if the column is out of bounds of the clip
+   bool FillColumnSamples(
+      const SpectrogramSettings& settings, const WaveChannelInterval &clip,
+      const int xx, double pixelsPerSecond, float* __restrict scratch) const;
+
    // Calculate one column of the spectrum
    bool CalculateOneSpectrum(
       const SpectrogramSettings& settings, const WaveChannelInterval &clip,
@@ -78,6 +85,13 @@ private:
       const std::vector<float>& gainFactors, float* __restrict scratch,
       float* __restrict out) const;
 
+   // Calculate a range of columns of the spectrum by the plain short time
+   // Fourier transform, in batches
+   void CalculateSpectra(
+      const SpectrogramSettings& settings, const WaveChannelInterval &clip,
+      int lowerBoundX, int upperBoundX, double pixelsPerSecond,
+      const std::vector<float>& gainFactors, float* __restrict out) const;
+
    mutable std::optional<AudioSegmentSampleView> mSampleCacheHolder;
 };
 
@@ -0,0 +1,31 @@
+## Audacity Paulstretch effect unit test
+#
+# This tests the Paulstretch effect with Time Resolutions long enough that
+# each batch of windows has room for only one or two of them.
+#
+
+printf("Running Paulstretch effect tests.\n");
+
+## Test Paulstretch with a huge Time Resolution
+fs = 44100;
+randn("seed", 1);
+x = 0.1 * randn(ceil(fs*120), 2);
+audiowrite(TMP_FILENAME, x, fs);
+
+for time_res = [50 95]
+  CURRENT_TEST = sprintf("Paulstretch, Time Resolution %d s", time_res);
+  remove_all_tracks();
+  aud_do(cstrcat("Import2: Filename=\"", TMP_FILENAME, "\"\n"));
+  select_tracks(0, 100);
+  aud_do(sprintf("Paulstretch: Stretch_Factor=2 Time_Resolution=%d\n", time_res));
+  aud_do(cstrcat("Export2: Filename=\"", TMP_FILENAME, "\" NumChannels=2\n"));
+  system("sync");
+
+  y = audioread(TMP_FILENAME);
+  do_test_gte(size(y)(1), size(x)(1), "stretched length");
+  do_test(all(all(isfinite(y))), "finite samples");
+  do_test_gte(rms(y), 0.01, "not silent");
+
+  # Restore the input for the next pass
+  audiowrite(TMP_FILENAME, x, fs);
+end